@@ -0,0 +1,88 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =================
+#include "common.hlsl"
+#include "common_culling.hlsl"
+//============================
+
+// a range of the index buffer with its bounds in mesh space, as built by Mesh::BuildClusters() (MeshCluster)
+struct Cluster
+{
+    float3 center;
+    float radius;
+    float3 cone_axis;
+    float cone_cutoff;
+    uint index_offset;
+    uint index_count;
+};
+
+RWStructuredBuffer<uint> indirect_args : register(u21); // two sets of RHI_IndirectDrawArgsIndexed, as many as there are clusters
+RWStructuredBuffer<Cluster> clusters   : register(u24);
+RWStructuredBuffer<uint> draw_count    : register(u25); // two counts, one per set of draw arguments
+
+[numthreads(THREAD_GROUP_COUNT, 1, 1)]
+void mainCS(uint3 thread_id : SV_DispatchThreadID)
+{
+    uint4 draw    = pass_get_u4_value();  // cluster offset, cluster count, vertex offset, draw arguments index
+    uint4 culling = pass_get_u4_value2(); // hi-z mip count (0 when disabled), hi-z width, hi-z height, back face culling
+
+    // the first thread resets the count of the set which the next dispatch will use
+    if (thread_id.x == 0)
+    {
+        draw_count[1 - draw.w] = 0;
+    }
+
+    if (thread_id.x >= draw.y)
+        return;
+
+    // transform the bounding sphere, the transform is the one which the geometry passes draw with
+    Cluster cluster  = clusters[draw.x + thread_id.x];
+    matrix transform = GetDraw().transform;
+    float3 scale     = float3(length(transform[0].xyz), length(transform[1].xyz), length(transform[2].xyz));
+    float3 center    = mul(float4(cluster.center, 1.0f), transform).xyz;
+    float radius     = cluster.radius * max(scale.x, max(scale.y, scale.z));
+
+    // back face culling with the normal cone, which a non-uniform scale or a mirroring transform would distort
+    bool scale_uniform = max(scale.x, max(scale.y, scale.z)) - min(scale.x, min(scale.y, scale.z)) < 0.001f * scale.x;
+    bool mirrored      = dot(cross(transform[0].xyz, transform[1].xyz), transform[2].xyz) < 0.0f;
+    if (culling.w != 0 && scale_uniform && !mirrored)
+    {
+        float3 cone_axis = normalize(mul(cluster.cone_axis, (float3x3)transform));
+        float3 to_center = center - buffer_frame.camera_position;
+        if (dot(to_center, cone_axis) >= cluster.cone_cutoff * length(to_center) + radius)
+            return;
+    }
+
+    // frustum and hi-z, with the box which bounds the sphere
+    if (!is_visible(center, radius, culling.x, culling.yz))
+        return;
+
+    uint index;
+    InterlockedAdd(draw_count[draw.w], 1, index);
+
+    uint args = (draw.w * draw.y + index) * args_stride;
+    indirect_args[args + 0] = cluster.index_count;
+    indirect_args[args + 1] = 1;
+    indirect_args[args + 2] = cluster.index_offset;
+    indirect_args[args + 3] = draw.z;
+    indirect_args[args + 4] = 0;
+}
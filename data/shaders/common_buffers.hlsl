@@ -55,7 +55,7 @@ struct FrameBufferData
     float2 padding_1;
 
     float3 camera_position_previous;
-    uint material_index;
+    float padding_2;
 };
 
 // 128 byte push constant buffer used by everything in the engine
@@ -75,14 +75,17 @@ bool is_ssr_enabled()  { return buffer_frame.options & uint(1U << 0); }
 bool is_ssgi_enabled() { return buffer_frame.options & uint(1U << 1); }
 
 // easy access to the push constant properties
-matrix pass_get_transform_previous() { return buffer_pass.values; }
 float2 pass_get_resolution_in()      { return float2(buffer_pass.values._m03, buffer_pass.values._m22); }
 float2 pass_get_resolution_out()     { return float2(buffer_pass.values._m23, buffer_pass.values._m30); }
 float3 pass_get_f3_value()           { return float3(buffer_pass.values._m00, buffer_pass.values._m01, buffer_pass.values._m02); }
 float3 pass_get_f3_value2()          { return float3(buffer_pass.values._m20, buffer_pass.values._m21, buffer_pass.values._m31); }
 float4 pass_get_f4_value()           { return float4(buffer_pass.values._m10, buffer_pass.values._m11, buffer_pass.values._m12, buffer_pass.values._m13); }
 bool pass_is_transparent()           { return buffer_pass.values._m33; }
+uint4 pass_get_u4_value()            { return asuint(float4(buffer_pass.transform._m00, buffer_pass.transform._m01, buffer_pass.transform._m02, buffer_pass.transform._m03)); } // compute only, shares the transform
+uint4 pass_get_u4_value2()           { return asuint(float4(buffer_pass.transform._m10, buffer_pass.transform._m11, buffer_pass.transform._m12, buffer_pass.transform._m13)); } // compute only, shares the transform
+uint4 pass_get_u4_value3()           { return asuint(float4(buffer_pass.transform._m20, buffer_pass.transform._m21, buffer_pass.transform._m22, buffer_pass.transform._m23)); } // compute only, shares the transform
+uint4 pass_get_u4_value4()           { return asuint(float4(buffer_pass.transform._m30, buffer_pass.transform._m31, buffer_pass.transform._m32, buffer_pass.transform._m33)); } // compute only, shares the transform
+uint pass_get_draw_index()           { return asuint(buffer_pass.values._m32); }
 bool pass_is_opaque()                { return !pass_is_transparent(); }
-// _m32 is available for use
 
 #endif // SPARTAN_COMMON_BUFFERS
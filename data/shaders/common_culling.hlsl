@@ -0,0 +1,109 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef SPARTAN_COMMON_CULLING
+#define SPARTAN_COMMON_CULLING
+
+// shared by the gpu culling passes, instance_culling.hlsl and cluster_culling.hlsl
+
+RWStructuredBuffer<float> hi_z : register(u22); // OcclusionBuffer, 1/w, packed mip after mip
+
+// these match OcclusionBuffer.cpp, so that the cpu and the gpu agree on what's occluded
+static const float near_w     = 0.01f;
+static const float depth_bias = 0.01f;
+static const float depth_max  = 3.402823466e+38f;
+
+// the uints in RHI_IndirectDrawArgsIndexed
+static const uint args_stride = 5;
+
+bool is_visible(float3 center, float3 extents, uint hi_z_mip_count, uint2 hi_z_size)
+{
+    // project the corners, and find the screen space rectangle and the nearest depth
+    uint outcode_all    = 0x3F;
+    bool crosses_near   = false;
+    float2 rect_min     = depth_max;
+    float2 rect_max     = -depth_max;
+    float depth_nearest = 0.0f;
+    for (uint i = 0; i < 8; i++)
+    {
+        float3 corner = center + extents * float3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+        float4 clip   = mul(float4(corner, 1.0f), buffer_frame.view_projection_unjittered);
+
+        // a box is outside of the frustum if all of its corners are outside of the same plane
+        uint outcode = 0;
+        outcode     |= clip.x < -clip.w ? 1  : 0;
+        outcode     |= clip.x >  clip.w ? 2  : 0;
+        outcode     |= clip.y < -clip.w ? 4  : 0;
+        outcode     |= clip.y >  clip.w ? 8  : 0;
+        outcode     |= clip.z <  0.0f   ? 16 : 0;
+        outcode     |= clip.z >  clip.w ? 32 : 0;
+        outcode_all &= outcode;
+
+        if (clip.w < near_w)
+        {
+            crosses_near = true;
+            continue;
+        }
+
+        float w_inv   = 1.0f / clip.w;
+        float2 uv     = float2(clip.x * w_inv * 0.5f + 0.5f, 0.5f - clip.y * w_inv * 0.5f);
+        rect_min      = min(rect_min, uv);
+        rect_max      = max(rect_max, uv);
+        depth_nearest = max(depth_nearest, w_inv);
+    }
+
+    // frustum
+    if (outcode_all != 0)
+        return false;
+
+    // hi-z, boxes which intersect the near plane can't be occluded
+    if (hi_z_mip_count == 0 || crosses_near)
+        return true;
+
+    int2 texel_min = clamp(int2(rect_min * float2(hi_z_size)), 0, int2(hi_z_size) - 1);
+    int2 texel_max = clamp(int2(rect_max * float2(hi_z_size)), 0, int2(hi_z_size) - 1);
+
+    // pick the mip at which the rectangle covers about 2x2 texels
+    uint size   = uint(max(texel_max.x - texel_min.x, texel_max.y - texel_min.y)) + 1;
+    uint mip    = 0;
+    uint offset = 0;
+    while ((size >> mip) > 2 && mip + 1 < hi_z_mip_count)
+    {
+        offset += (hi_z_size.x >> mip) * (hi_z_size.y >> mip);
+        mip++;
+    }
+
+    // find the farthest occluder depth within the rectangle
+    uint mip_width       = hi_z_size.x >> mip;
+    float depth_occluder = depth_max;
+    for (int y = texel_min.y >> mip; y <= (texel_max.y >> mip); y++)
+    {
+        for (int x = texel_min.x >> mip; x <= (texel_max.x >> mip); x++)
+        {
+            depth_occluder = min(depth_occluder, hi_z[offset + y * mip_width + x]);
+        }
+    }
+
+    // visible if the nearest point of the box is in front of the farthest occluder
+    return depth_nearest * (1.0f + depth_bias) >= depth_occluder;
+}
+
+#endif // SPARTAN_COMMON_CULLING
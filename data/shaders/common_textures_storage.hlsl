@@ -63,6 +63,22 @@ Texture2D tex_font_atlas         : register(t26);
 TextureCube tex_reflection_probe : register(t27);
 Texture2DArray tex_sss           : register(t28);
 
+//= DRAWS =================================================================================
+// per draw data of all the renderables, written once per frame
+struct Draw
+{
+    matrix transform;
+    matrix transform_previous;
+
+    uint material_index;
+    uint flags;
+    uint2 padding;
+};
+
+RWStructuredBuffer<Draw> buffer_draws : register(u23);
+Draw GetDraw() { return buffer_draws[pass_get_draw_index()]; }
+//===========================================================================================
+
 //= MATERIALS ===============================================================================
 // texture array containing all material present int the world
 static const uint material_albedo    = 0; 
@@ -75,7 +91,7 @@ static const uint material_height    = 24;
 static const uint material_mask      = 28;
 
 Texture2D tex_materials[] : register(t29, space1);
-#define GET_TEXTURE(index_texture) tex_materials[buffer_frame.material_index + index_texture]
+#define GET_TEXTURE(index_texture) tex_materials[GetDraw().material_index + index_texture]
 
 // property buffer containg all materials present in the world
 struct Material
@@ -105,7 +121,7 @@ struct Material
 };
 
 RWStructuredBuffer<Material> buffer_materials : register(u0);
-Material GetMaterial() { return buffer_materials[buffer_frame.material_index]; }
+Material GetMaterial() { return buffer_materials[GetDraw().material_index]; }
 //===========================================================================================
 
 //= LIGHTS =============================================
@@ -32,7 +32,7 @@ float4 compute_screen_space_position(Vertex_PosUvNorTan input, uint instance_id,
     surface.flags = GetMaterial().flags;
     
     #if INSTANCED // implies vegetation
-    matrix instance = input.instance_transform;
+    matrix instance = vertex_processing::instancing::get_transform(input.instance_position_scale, input.instance_rotation);
     world_position  = mul(float4(world_position, 1.0f), instance).xyz;
     if (surface.vertex_animate_wind()) // vegetation
     {
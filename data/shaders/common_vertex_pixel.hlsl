@@ -48,10 +48,10 @@ struct Vertex_PosUvNorTan
 {
     float4 position           : POSITION0;
     float2 uv                 : TEXCOORD0;
-    float3 normal             : NORMAL0;
-    float3 tangent            : TANGENT0;
+    float4 normal_tangent     : NORMAL0; // octahedral encoded, see vertex_processing::unpack_octahedral()
     #if INSTANCED
-    matrix instance_transform : INSTANCE_TRANSFORM0;
+    float4 instance_position_scale : INSTANCE_POSITION_SCALE0;
+    float4 instance_rotation       : INSTANCE_ROTATION0;
     #endif
 };
 
@@ -21,6 +21,17 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 struct vertex_processing
 {
+    // the mesh vertex normal and tangent (RHI_Vertex_PosTexNorTanPacked), directions folded onto an octahedron
+    static float3 unpack_octahedral(float2 packed)
+    {
+        float3 direction = float3(packed.x, packed.y, 1.0f - abs(packed.x) - abs(packed.y));
+        float fold       = saturate(-direction.z);
+        direction.x     += direction.x >= 0.0f ? -fold : fold;
+        direction.y     += direction.y >= 0.0f ? -fold : fold;
+
+        return normalize(direction);
+    }
+
     struct vegetation
     {
         static float hash(float n)
@@ -44,7 +55,8 @@ struct vertex_processing
             const float  wind_vertex_sway_speed  = 4.0f; // oscillation frequency
         
             // base oscillation, a combination of two sine waves with a phase difference
-            float phase_offset = float(instance_id) * PI_HALF;
+            // the phase offset comes from the pivot and not the instance id, since gpu culling changes the order of the instances every frame
+            float phase_offset = hash(dot(animation_pivot, float3(12.9898f, 78.233f, 37.719f))) * PI2;
             float phase1       = (time * wind_vertex_sway_speed) + position_vertex.x + phase_offset;
             
             // phase difference to ensure continuous motion
@@ -175,4 +187,33 @@ struct vertex_processing
             return position_vertex;
         }
     };
+
+    // the compact instance (RHI_Instance), a position, a uniform scale and a quaternion
+    struct instancing
+    {
+        // the quaternion as two uints of snorm16 pairs, as the storage buffers see it
+        static float4 unpack_rotation(uint2 packed)
+        {
+            int4 value = int4(int(packed.x << 16) >> 16, int(packed.x) >> 16, int(packed.y << 16) >> 16, int(packed.y) >> 16);
+            return max(float4(value) / 32767.0f, -1.0f);
+        }
+
+        // matches Matrix(translation, rotation, scale) on the cpu, rows as in the row vector convention
+        static matrix get_transform(float4 position_scale, float4 rotation)
+        {
+            float4 q = normalize(rotation);
+            float s  = position_scale.w;
+
+            float xx = q.x * q.x; float yy = q.y * q.y; float zz = q.z * q.z;
+            float xy = q.x * q.y; float zw = q.z * q.w; float zx = q.z * q.x;
+            float yw = q.y * q.w; float yz = q.y * q.z; float xw = q.x * q.w;
+
+            return matrix(
+                float4(s * (1.0f - 2.0f * (yy + zz)), s * 2.0f * (xy + zw),          s * 2.0f * (zx - yw),          0.0f),
+                float4(s * 2.0f * (xy - zw),          s * (1.0f - 2.0f * (zz + xx)), s * 2.0f * (yz + xw),          0.0f),
+                float4(s * 2.0f * (zx + yw),          s * 2.0f * (yz - xw),          s * (1.0f - 2.0f * (yy + xx)), 0.0f),
+                float4(position_scale.xyz, 1.0f)
+            );
+        }
+    };
 };
@@ -31,7 +31,7 @@ Pixel_PosNor mainVS(Vertex_PosUvNorTan input)
 
     input.position.w = 1.0f;
     output.position  = mul(input.position, wvp);
-    output.normal    = normalize(mul(input.normal, (float3x3)buffer_pass.transform)).xyz;
+    output.normal    = normalize(mul(vertex_processing::unpack_octahedral(input.normal_tangent.xy), (float3x3)buffer_pass.transform)).xyz;
 
     return output;
 }
@@ -31,7 +31,7 @@ Pixel_PosUv mainVS(Vertex_PosUvNorTan input, uint instance_id : SV_InstanceID)
     uint index_array = (uint)pass_get_f3_value2().x;
     Light_ light     = buffer_lights[index_light];
     
-    output.position  = compute_screen_space_position(input, instance_id, buffer_pass.transform, light.view_projection[index_array], buffer_frame.time);
+    output.position  = compute_screen_space_position(input, instance_id, GetDraw().transform, light.view_projection[index_array], buffer_frame.time);
     output.uv        = input.uv;
 
     return output;
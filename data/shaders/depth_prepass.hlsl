@@ -34,7 +34,7 @@ PixelIn mainVS(Vertex_PosUvNorTan input, uint instance_id : SV_InstanceID)
 {
     PixelIn output;
     
-    output.position = compute_screen_space_position(input, instance_id, buffer_pass.transform, buffer_frame.view_projection, buffer_frame.time, output.world_position);
+    output.position = compute_screen_space_position(input, instance_id, GetDraw().transform, buffer_frame.view_projection, buffer_frame.time, output.world_position);
     output.uv       = input.uv;
     
     return output;
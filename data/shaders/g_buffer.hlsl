@@ -179,25 +179,29 @@ struct sampling
 PixelInputType mainVS(Vertex_PosUvNorTan input, uint instance_id : SV_InstanceID)
 {
     PixelInputType output;
+    Draw draw = GetDraw();
 
     // position
-    output.position             = compute_screen_space_position(input, instance_id, buffer_pass.transform, buffer_frame.view_projection, buffer_frame.time);
+    output.position             = compute_screen_space_position(input, instance_id, draw.transform, buffer_frame.view_projection, buffer_frame.time);
     output.position_ss_current  = output.position;
-    output.position_ss_previous = compute_screen_space_position(input, instance_id, pass_get_transform_previous(), buffer_frame.view_projection_previous, buffer_frame.time - buffer_frame.delta_time, output.position_world);
+    output.position_ss_previous = compute_screen_space_position(input, instance_id, draw.transform_previous, buffer_frame.view_projection_previous, buffer_frame.time - buffer_frame.delta_time, output.position_world);
     
     // normal
+    float3 normal  = vertex_processing::unpack_octahedral(input.normal_tangent.xy);
+    float3 tangent = vertex_processing::unpack_octahedral(input.normal_tangent.zw);
     #if INSTANCED
-    float3 normal_transformed  = mul(input.normal, (float3x3)buffer_pass.transform);
-    normal_transformed         = mul(normal_transformed, (float3x3)input.instance_transform);
+    float3x3 instance          = (float3x3)vertex_processing::instancing::get_transform(input.instance_position_scale, input.instance_rotation);
+    float3 normal_transformed  = mul(normal, (float3x3)draw.transform);
+    normal_transformed         = mul(normal_transformed, instance);
     output.normal_world        = normalize(normal_transformed);
     
-    float3 tangent_transformed = mul(input.tangent, (float3x3)buffer_pass.transform);
-    tangent_transformed        = mul(tangent_transformed, (float3x3)input.instance_transform);
+    float3 tangent_transformed = mul(tangent, (float3x3)draw.transform);
+    tangent_transformed        = mul(tangent_transformed, instance);
     output.tangent_world       = normalize(tangent_transformed);
     
     #else
-    output.normal_world = normalize(mul(input.normal, (float3x3)buffer_pass.transform));
-    output.tangent_world = normalize(mul(input.tangent, (float3x3)buffer_pass.transform));
+    output.normal_world = normalize(mul(normal, (float3x3)draw.transform));
+    output.tangent_world = normalize(mul(tangent, (float3x3)draw.transform));
     #endif
 
     // uv
@@ -286,8 +290,9 @@ PixelOutputType mainPS(PixelInputType input)
         if (surface.has_texture_normal())
         {
             // get tangent space normal and apply the user defined intensity, then transform it to world space
-            float3 normal_sample       = sampling::smart(surface, material_normal, uv, input.position_world, input.normal_world).xyz;
-            float3 tangent_normal      = normalize(unpack(normal_sample));
+            // z is reconstructed, since compressed normal maps only keep x and y
+            float2 normal_sample       = unpack(sampling::smart(surface, material_normal, uv, input.position_world, input.normal_world).xy);
+            float3 tangent_normal      = float3(normal_sample, sqrt(saturate(1.0f - dot(normal_sample, normal_sample))));
             float normal_intensity     = clamp(GetMaterial().normal, 0.012f, GetMaterial().normal);
             tangent_normal.xy         *= saturate(normal_intensity);
             float3x3 tangent_to_world  = make_tangent_to_world_matrix(input.normal_world, input.tangent_world);
@@ -343,7 +348,7 @@ PixelOutputType mainPS(PixelInputType input)
     // write to g-buffer
     PixelOutputType g_buffer;
     g_buffer.albedo   = albedo;
-    g_buffer.normal   = float4(normal, buffer_frame.material_index);
+    g_buffer.normal   = float4(normal, GetDraw().material_index);
     g_buffer.material = float4(roughness, metalness, emission, occlusion);
     g_buffer.velocity = velocity;
 
@@ -0,0 +1,95 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =================
+#include "common.hlsl"
+#include "common_culling.hlsl"
+//============================
+
+// an instance transform, as uploaded by Renderable::SetInstances() (RHI_Instance)
+struct Instance
+{
+    float4 position_scale;
+    uint2 rotation; // snorm16 quaternion
+};
+
+RWStructuredBuffer<Instance> instances         : register(u19);
+RWStructuredBuffer<Instance> instances_visible : register(u20); // a region per lod, each as large as the instances
+RWStructuredBuffer<uint> indirect_args         : register(u21); // two sets of RHI_IndirectDrawArgsIndexed, one per lod
+
+// matches mesh_lod_count_max in Mesh.h
+static const uint lod_count_max = 4;
+
+// matches get_lod() in Renderer_Passes.cpp, so that the shadows (which are culled on the cpu) use the same lods
+uint get_lod(float3 center, float radius, uint lod_count, float lod_screen_size)
+{
+    float distance    = max(length(buffer_frame.camera_position - center), 0.001f);
+    float screen_size = radius * buffer_frame.projection[1][1] / distance;
+    float lod         = floor(log2(lod_screen_size / screen_size)) + 1.0f;
+
+    return (uint)clamp(lod, 0.0f, (float)(lod_count - 1));
+}
+
+[numthreads(THREAD_GROUP_COUNT, 1, 1)]
+void mainCS(uint3 thread_id : SV_DispatchThreadID)
+{
+    uint4 draw            = pass_get_u4_value();  // instance count, vertex offset, lod count
+    uint4 culling         = pass_get_u4_value2(); // draw arguments index, hi-z mip count (0 when disabled), hi-z width, hi-z height
+    uint4 index_offsets   = pass_get_u4_value3(); // per lod
+    uint4 index_counts    = pass_get_u4_value4(); // per lod
+    float lod_screen_size = pass_get_f4_value().x;
+    uint args_current     = culling.x * lod_count_max * args_stride;
+    uint args_next        = (1 - culling.x) * lod_count_max * args_stride;
+
+    // the first thread writes the draw arguments and resets the instance counts of the set which the next dispatch will use
+    if (thread_id.x == 0)
+    {
+        for (uint lod = 0; lod < draw.z; lod++)
+        {
+            uint args = args_current + lod * args_stride;
+            indirect_args[args + 0] = index_counts[lod];
+            indirect_args[args + 2] = index_offsets[lod];
+            indirect_args[args + 3] = draw.y;
+            indirect_args[args + 4] = lod * draw.x;
+            indirect_args[args_next + lod * args_stride + 1] = 0;
+        }
+    }
+
+    if (thread_id.x >= draw.x)
+        return;
+
+    // transform the bounding box (which is in entity space) by the instance
+    Instance instance = instances[thread_id.x];
+    matrix transform  = vertex_processing::instancing::get_transform(instance.position_scale, vertex_processing::instancing::unpack_rotation(instance.rotation));
+    float3 c          = pass_get_f3_value();
+    float3 e          = pass_get_f3_value2();
+    float3 center     = c.x * transform[0].xyz + c.y * transform[1].xyz + c.z * transform[2].xyz + transform[3].xyz;
+    float3 extents    = e.x * abs(transform[0].xyz) + e.y * abs(transform[1].xyz) + e.z * abs(transform[2].xyz);
+
+    if (is_visible(center, extents, culling.y, culling.zw))
+    {
+        uint lod = get_lod(center, length(extents), draw.z, lod_screen_size);
+
+        uint index;
+        InterlockedAdd(indirect_args[args_current + lod * args_stride + 1], 1, index);
+        instances_visible[lod * draw.x + index] = instance;
+    }
+}
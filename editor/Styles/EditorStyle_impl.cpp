@@ -13,7 +13,7 @@ namespace
     bool m_editor_begun = false;
     std::string name = "##main_window";
 
-    static void process_event(Spartan::sp_variant data)
+    static void process_event(const Spartan::sp_variant& data)
     {
         SDL_Event* event_sdl = static_cast<SDL_Event*>(get<void*>(data));
         ImGui_ImplSDL2_ProcessEvent(event_sdl);
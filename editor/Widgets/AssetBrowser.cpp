@@ -104,6 +104,21 @@ namespace
                     "Optimize overdraw (slower import)",
                     "Minimize overdraw by reordering triangles, aiming to reduce pixel shader invocations"
                 );
+
+                mesh_import_dialog_checkbox(MeshFlags::ImportClusters,
+                    "Build clusters",
+                    "Split the mesh into clusters (meshlets), large meshes can then be culled a cluster at a time on the GPU"
+                );
+
+                mesh_import_dialog_checkbox(MeshFlags::ImportLods,
+                    "Generate LODs",
+                    "Generate simplified levels of detail, which the renderer picks from based on how large the mesh is on screen"
+                );
+
+                mesh_import_dialog_checkbox(MeshFlags::CompressEngineFormat,
+                    "Compress",
+                    "Save the mesh in the engine format with meshoptimizer's vertex and index codecs, it's decoded when loaded"
+                );
     
                 // Ok button
                 if (ImGuiSp::button_centered_on_line("Ok", 0.5f))
@@ -221,6 +221,7 @@ void RenderOptions::OnTickVisible()
     bool do_debanding            = Renderer::GetOption<bool>(Renderer_Option::Debanding);
     bool do_hdr                  = Renderer::GetOption<bool>(Renderer_Option::Hdr);
     bool do_vsync                = Renderer::GetOption<bool>(Renderer_Option::Vsync);
+    bool do_occlusion_culling    = Renderer::GetOption<bool>(Renderer_Option::OcclusionCulling);
     bool debug_physics           = Renderer::GetOption<bool>(Renderer_Option::Debug_Physics);
     bool debug_aabb              = Renderer::GetOption<bool>(Renderer_Option::Debug_Aabb);
     bool debug_light             = Renderer::GetOption<bool>(Renderer_Option::Debug_Lights);
@@ -379,6 +380,16 @@ void RenderOptions::OnTickVisible()
             // vsync
             option_check_box("VSync", do_vsync, "Vertical Synchronization");
 
+            // occlusion culling
+            option_check_box("Occlusion culling", do_occlusion_culling, "Skips objects which are hidden behind large occluders, tested on the cpu");
+
+            // texture streaming
+            option_value("Texture streaming budget", Renderer_Option::TextureStreamingBudget, "The fraction of the GPU memory budget which streamed textures can use, textures drop their most detailed mips when it's exceeded", 0.05f, 0.05f, 1.0f);
+
+            // resource cache
+            option_value("Resource cache budget (CPU)", Renderer_Option::ResourceCacheBudgetCpu, "The memory, in MB, which cached resources can use before those which nothing references are evicted, 0 is unlimited", 256.0f, 0.0f);
+            option_value("Resource cache budget (GPU)", Renderer_Option::ResourceCacheBudgetGpu, "The fraction of the GPU memory budget which cached resources can use before those which nothing references are evicted, 0 is unlimited", 0.05f, 0.0f, 1.0f);
+
             // fps Limit
             {
                 option_first_column();
@@ -435,6 +446,7 @@ void RenderOptions::OnTickVisible()
     Renderer::SetOption(Renderer_Option::Debanding,                     do_debanding);
     Renderer::SetOption(Renderer_Option::Hdr,                           do_hdr);
     Renderer::SetOption(Renderer_Option::Vsync,                         do_vsync);
+    Renderer::SetOption(Renderer_Option::OcclusionCulling,              do_occlusion_culling);
     Renderer::SetOption(Renderer_Option::Debug_TransformHandle,         debug_transform);
     Renderer::SetOption(Renderer_Option::Debug_SelectionOutline,        debug_selection_outline);
     Renderer::SetOption(Renderer_Option::Debug_Physics,                 debug_physics);
@@ -174,6 +174,30 @@ namespace Spartan
         #endif
     }
 
+    bool Audio::CreateSound(const void* data, const uint32_t size, int sound_mode, void*& sound)
+    {
+        #if defined(_MSC_VER)
+        FMOD_CREATESOUNDEXINFO info = {};
+        info.cbsize                 = sizeof(FMOD_CREATESOUNDEXINFO);
+        info.length                 = size;
+        return Audio::HandleErrorFmod(fmod_system->createSound(static_cast<const char*>(data), sound_mode | FMOD_OPENMEMORY, &info, reinterpret_cast<FMOD::Sound**>(&sound)));
+        #else
+        return true;
+        #endif
+    }
+
+    bool Audio::CreateStream(const void* data, const uint32_t size, int sound_mode, void*& sound)
+    {
+        #if defined(_MSC_VER)
+        FMOD_CREATESOUNDEXINFO info = {};
+        info.cbsize                 = sizeof(FMOD_CREATESOUNDEXINFO);
+        info.length                 = size;
+        return Audio::HandleErrorFmod(fmod_system->createStream(static_cast<const char*>(data), sound_mode | FMOD_OPENMEMORY_POINT, &info, reinterpret_cast<FMOD::Sound**>(&sound)));
+        #else
+        return true;
+        #endif
+    }
+
     bool Audio::PlaySound(void* sound, void*& channel)
     {
         if (MUTE == 0)
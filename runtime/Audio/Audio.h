@@ -44,6 +44,8 @@ namespace Spartan
         static bool HandleErrorFmod(int result);
         static bool CreateSound(const std::string& file_path, int sound_mode, void*& sound);
         static bool CreateStream(const std::string& file_path, int sound_mode, void*& sound);
+        static bool CreateSound(const void* data, const uint32_t size, int sound_mode, void*& sound);  // the data is copied
+        static bool CreateStream(const void* data, const uint32_t size, int sound_mode, void*& sound); // the data must outlive the sound
         static bool PlaySound(void* sound, void*& channel);
     };
 }
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "AudioClip.h"
 #include "Audio.h"
 #include "../IO/FileStream.h"
+#include "../IO/AssetArchive.h"
 #include "../World/Entity.h"
 #if defined(_MSC_VER)
 #include <fmod.hpp>
@@ -82,7 +83,8 @@ namespace Spartan
     {
         #if defined(_MSC_VER)
 
-        // native
+        // native, the audio follows the path (older files only have the path)
+        span<const std::byte> data;
         if (FileSystem::GetExtensionFromFilePath(file_path) == EXTENSION_AUDIO)
         {
             auto file = make_unique<FileStream>(file_path, FileStream_Read);
@@ -90,6 +92,11 @@ namespace Spartan
                 return false;
 
             SetResourceFilePath(file->ReadAs<string>());
+            data = file->ReadSpan();
+            if (!data.empty())
+            {
+                m_mapping = file->GetMapping();
+            }
 
             file->Close();
         }
@@ -99,7 +106,7 @@ namespace Spartan
             SetResourceFilePath(file_path);
         }
 
-        return (m_playMode == PlayMode::Memory) ? CreateSound(GetResourceFilePath()) : CreateStream(GetResourceFilePath());
+        return (m_playMode == PlayMode::Memory) ? CreateSound(GetResourceFilePath(), data) : CreateStream(GetResourceFilePath(), data);
 
         #else
         return 0;
@@ -110,11 +117,19 @@ namespace Spartan
     {
         #if defined(_MSC_VER)
 
+        // a clip which was loaded from this file already has its audio embedded (and mapped)
+        if (m_mapping && AssetArchive::Exists(file_path))
+            return true;
+
+        // embedded, so that loading reads a single file (which can be packed, see AssetArchive)
+        shared_ptr<FileMapping> audio = AssetArchive::Map(GetResourceFilePath());
+
         auto file = make_unique<FileStream>(file_path, FileStream_Write);
         if (!file->IsOpen())
             return false;
 
         file->Write(GetResourceFilePath());
+        file->Write(audio ? audio->GetBytes() : span<const std::byte>());
 
         file->Close();
         #endif
@@ -344,11 +359,14 @@ namespace Spartan
         return is_paused;
     }
 
-    bool AudioClip::CreateSound(const string& file_path)
+    bool AudioClip::CreateSound(const string& file_path, span<const std::byte> data)
     {
         #if defined(_MSC_VER)
         // Create sound
-        if (!Audio::CreateSound(file_path, GetSoundMode(), m_fmod_sound))
+        const bool created = data.empty() ?
+            Audio::CreateSound(file_path, GetSoundMode(), m_fmod_sound) :
+            Audio::CreateSound(data.data(), static_cast<uint32_t>(data.size()), GetSoundMode(), m_fmod_sound);
+        if (!created)
             return false;
 
         // Set 3D min max distance
@@ -359,11 +377,14 @@ namespace Spartan
         return true;
     }
 
-    bool AudioClip::CreateStream(const string& file_path)
+    bool AudioClip::CreateStream(const string& file_path, span<const std::byte> data)
     {
         #if defined(_MSC_VER)
-        // Create sound
-        if (!Audio::CreateStream(file_path, GetSoundMode(), m_fmod_sound))
+        // Create sound, the mapping outlives it since the destructor releases the sound first
+        const bool created = data.empty() ?
+            Audio::CreateStream(file_path, GetSoundMode(), m_fmod_sound) :
+            Audio::CreateStream(data.data(), static_cast<uint32_t>(data.size()), GetSoundMode(), m_fmod_sound);
+        if (!created)
             return false;
 
         // Set 3D min max distance
@@ -22,12 +22,15 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES =============================
+#include <span>
 #include "../Resource/IResource.h"
 #include "../Math/Vector3.h"
 //========================================
 
 namespace Spartan
 {
+    class FileMapping;
+
     enum class PlayMode
     {
         Memory,
@@ -85,11 +88,14 @@ namespace Spartan
 
     private:
         //= CREATION ===================================
-        bool CreateSound(const std::string& file_path);
-        bool CreateStream(const std::string& file_path);
+        bool CreateSound(const std::string& file_path, std::span<const std::byte> data);
+        bool CreateStream(const std::string& file_path, std::span<const std::byte> data);
         //==============================================
         int GetSoundMode() const;
 
+        // the engine file which the audio was loaded from (embedded), streams read from it as they play
+        std::shared_ptr<FileMapping> m_mapping;
+
         Entity* m_entity     = nullptr;
         void* m_fmod_sound   = nullptr;
         void* m_fmod_channel = nullptr;
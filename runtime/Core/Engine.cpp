@@ -104,6 +104,7 @@ namespace Spartan
         Audio::Tick();
         Physics::Tick();
         World::Tick();
+        ResourceCache::Tick();
         Renderer::Tick();
 
         // post-tick
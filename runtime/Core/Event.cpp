@@ -48,7 +48,7 @@ namespace Spartan
         event_subscribers[static_cast<uint32_t>(event_type)].push_back(forward<subscriber>(function));
     }
 
-    void Event::Fire(const EventType event_type, sp_variant data /*= 0*/)
+    void Event::Fire(const EventType event_type, const sp_variant& data /*= 0*/)
     {
         for (const auto& subscriber : event_subscribers[static_cast<uint32_t>(event_type)])
         {
@@ -38,14 +38,14 @@ Note: This is a blocking event system
 */
 
 //= MACROS ===============================================================================================
-#define SP_EVENT_HANDLER_EXPRESSION(expression)        [this](Spartan::sp_variant var)  { expression }
-#define SP_EVENT_HANDLER_EXPRESSION_STATIC(expression) [](Spartan::sp_variant var)      { expression }
+#define SP_EVENT_HANDLER_EXPRESSION(expression)        [this](const Spartan::sp_variant& var) { expression }
+#define SP_EVENT_HANDLER_EXPRESSION_STATIC(expression) [](const Spartan::sp_variant& var)     { expression }
 
-#define SP_EVENT_HANDLER(function)                     [this](Spartan::sp_variant var)  { function(); }
-#define SP_EVENT_HANDLER_STATIC(function)              [](Spartan::sp_variant var)      { function(); }
+#define SP_EVENT_HANDLER(function)                     [this](const Spartan::sp_variant& var) { function(); }
+#define SP_EVENT_HANDLER_STATIC(function)              [](const Spartan::sp_variant& var)     { function(); }
                                                                                      
-#define SP_EVENT_HANDLER_VARIANT(function)             [this](Spartan::sp_variant var)  { function(var); }
-#define SP_EVENT_HANDLER_VARIANT_STATIC(function)      [](Spartan::sp_variant var)      { function(var); }
+#define SP_EVENT_HANDLER_VARIANT(function)             [this](const Spartan::sp_variant& var) { function(var); }
+#define SP_EVENT_HANDLER_VARIANT_STATIC(function)      [](const Spartan::sp_variant& var)     { function(var); }
                                                        
 #define SP_FIRE_EVENT(event_enum)                      Spartan::Event::Fire(event_enum)
 #define SP_FIRE_EVENT_DATA(event_enum, data)           Spartan::Event::Fire(event_enum, data)
@@ -72,6 +72,8 @@ namespace Spartan
         WorldClear,                    // The world is about to clear everything
         WorldResolve,                  // The world is resolving
         WorldResolved,                 // The world has finished resolving
+        WorldEntitiesChanged,          // Some entities gained or lost components, since the last tick
+        WorldEntitiesRemoved,          // Some entities were removed, since the last tick
         // SDL                         
         Sdl,                           // An SDL event
         // Window                      
@@ -81,17 +83,19 @@ namespace Spartan
         MaterialOnChanged,
         LightOnChanged,
         CameraOnChanged,
+        EntityOnChanged,
         // Max
         Max
     };
 
     class Entity;
 
+    // entity lists are passed by pointer, so that firing an event doesn't copy them
     using sp_variant = std::variant<
         int,
         void*,
-        std::vector<std::shared_ptr<Entity>>
-
+        Entity*,
+        const std::vector<std::shared_ptr<Entity>>*
     >;
     using subscriber = std::function<void(const sp_variant&)>;
 
@@ -100,6 +104,6 @@ namespace Spartan
     public:
         static void Shutdown();
         static void Subscribe(const EventType event_type, subscriber&& function);
-        static void Fire(const EventType event_type, sp_variant data = 0);
+        static void Fire(const EventType event_type, const sp_variant& data = 0);
     };
 }
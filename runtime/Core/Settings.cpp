@@ -85,6 +85,10 @@ namespace Spartan
                 case Renderer_Option::Sharpness:                     return "Sharpness";
                 case Renderer_Option::Hdr:                           return "Hdr";
                 case Renderer_Option::Vsync:                         return "Vsync";
+                case Renderer_Option::OcclusionCulling:              return "OcclusionCulling";
+                case Renderer_Option::TextureStreamingBudget:        return "TextureStreamingBudget";
+                case Renderer_Option::ResourceCacheBudgetCpu:        return "ResourceCacheBudgetCpu";
+                case Renderer_Option::ResourceCacheBudgetGpu:        return "ResourceCacheBudgetGpu";
                 default:
                 {
                     SP_ASSERT_MSG(false, "Renderer_Option not handled");
@@ -30,65 +30,274 @@ using namespace std;
 
 namespace Spartan
 {
+    struct Job
+    {
+        Task task;
+        JobHandle self;                          // keeps the job alive while it's queued or waiting on dependencies
+        atomic<uint32_t> dependency_count = 1;   // starts at 1 so that the job can't be scheduled while dependencies are being registered
+        atomic<bool> done                 = false;
+        bool cancelled                    = false;
+        bool is_batch                     = false; // part of a parallel for
+        mutex continuations_mutex;
+        vector<Job*> continuations;              // jobs which depend on this one
+    };
+
     namespace
     {
-        // Stats
+        // a chase-lev work stealing deque, the owning thread pushes and pops from the
+        // bottom while any other thread can steal from the top, without taking locks
+        class JobDeque
+        {
+        public:
+            bool Push(Job* job)
+            {
+                int64_t bottom = m_bottom.load(memory_order_relaxed);
+                int64_t top    = m_top.load(memory_order_acquire);
+                if (bottom - top >= static_cast<int64_t>(capacity))
+                    return false;
+
+                m_jobs[bottom & mask].store(job, memory_order_relaxed);
+                atomic_thread_fence(memory_order_release);
+                m_bottom.store(bottom + 1, memory_order_relaxed);
+
+                return true;
+            }
+
+            Job* Pop()
+            {
+                int64_t bottom = m_bottom.load(memory_order_relaxed) - 1;
+                m_bottom.store(bottom, memory_order_relaxed);
+                atomic_thread_fence(memory_order_seq_cst);
+                int64_t top = m_top.load(memory_order_relaxed);
+
+                if (top > bottom)
+                {
+                    m_bottom.store(bottom + 1, memory_order_relaxed);
+                    return nullptr;
+                }
+
+                Job* job = m_jobs[bottom & mask].load(memory_order_relaxed);
+                if (top == bottom)
+                {
+                    // last job, race against the stealers for it
+                    if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+                    {
+                        job = nullptr;
+                    }
+                    m_bottom.store(bottom + 1, memory_order_relaxed);
+                }
+
+                return job;
+            }
+
+            Job* Steal()
+            {
+                int64_t top = m_top.load(memory_order_acquire);
+                atomic_thread_fence(memory_order_seq_cst);
+                int64_t bottom = m_bottom.load(memory_order_acquire);
+
+                if (top >= bottom)
+                    return nullptr;
+
+                Job* job = m_jobs[top & mask].load(memory_order_relaxed);
+                if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+                    return nullptr;
+
+                return job;
+            }
+
+        private:
+            static const uint32_t capacity = 4096; // must be a power of two
+            static const uint32_t mask     = capacity - 1;
+
+            alignas(64) atomic<int64_t> m_top    = 0;
+            alignas(64) atomic<int64_t> m_bottom = 0;
+            array<atomic<Job*>, capacity> m_jobs;
+        };
+
+        // stats
         static uint32_t thread_count                 = 0;
         static atomic<uint32_t> working_thread_count = 0;
 
-        // Sync objects
-        static mutex mutex_tasks;
-        static condition_variable condition_var;
-
-        // Threads
+        // threads
         static vector<thread> threads;
+        static thread_local uint32_t thread_index = numeric_limits<uint32_t>::max(); // index of the deque the thread owns, if any
+        static thread_local bool is_worker        = false;
+
+        // one deque per worker plus one for the thread which initialized the pool (the main thread)
+        static vector<unique_ptr<JobDeque>> deques;
 
-        // Tasks
-        static deque<Task> tasks;
+        // jobs added from threads which don't own a deque (or when the owner's deque is full)
+        static mutex mutex_injected;
+        static deque<Job*> jobs_injected;
 
-        // Misc
-        static bool is_stopping;
+        // sleeping
+        static mutex mutex_sleep;
+        static condition_variable condition_var;
+        static atomic<uint32_t> jobs_queued      = 0; // jobs which can be picked up right now
+        static atomic<uint32_t> jobs_in_flight   = 0; // jobs which have been added but haven't completed yet
+        static atomic<uint32_t> sleeping_threads = 0;
+        static atomic<bool> is_stopping          = false;
+
+        // how many times a parallel for splits its range per thread, more batches balance uneven work better
+        static const uint32_t parallel_for_batches_per_thread = 4;
+        static const uint32_t spin_count_before_sleep         = 64;
     }
 
-    static void thread_loop()
+    static void schedule(Job* job)
     {
-        while (true)
+        jobs_queued++;
+
+        // workers push to their own deque, the main thread only does so for parallel for batches (see help())
+        bool pushed = thread_index < deques.size() && (is_worker || job->is_batch) && deques[thread_index]->Push(job);
+        if (!pushed)
         {
-            // Lock tasks mutex
-            unique_lock<mutex> lock(mutex_tasks);
+            lock_guard<mutex> lock(mutex_injected);
+            jobs_injected.emplace_back(job);
+        }
+
+        // wake up a thread, only if there is someone to wake
+        if (sleeping_threads > 0)
+        {
+            lock_guard<mutex> lock(mutex_sleep);
+            condition_var.notify_one();
+        }
+    }
 
-            // Check condition on notification
-            condition_var.wait(lock, [] { return !tasks.empty() || is_stopping; });
+    static Job* get_job(bool steal)
+    {
+        Job* job = nullptr;
 
-            // If m_stopping is true, it's time to shut everything down
-            if (is_stopping && tasks.empty())
-                return;
+        // 1. own deque
+        if (thread_index < deques.size())
+        {
+            job = deques[thread_index]->Pop();
+        }
 
-            // Get next task in the queue.
-            Task task = tasks.front();
+        if (!job && steal)
+        {
+            // 2. injected jobs
+            {
+                lock_guard<mutex> lock(mutex_injected);
+                if (!jobs_injected.empty())
+                {
+                    job = jobs_injected.front();
+                    jobs_injected.pop_front();
+                }
+            }
 
-            // Remove it from the queue.
-            tasks.pop_front();
+            // 3. steal from other threads, starting from a different victim per thread to spread contention
+            const uint32_t deque_count = static_cast<uint32_t>(deques.size());
+            const uint32_t start       = thread_index < deque_count ? thread_index + 1 : 0;
+            for (uint32_t i = 0; i < deque_count && !job; i++)
+            {
+                uint32_t victim = (start + i) % deque_count;
+                if (victim != thread_index)
+                {
+                    job = deques[victim]->Steal();
+                }
+            }
+        }
 
-            // Unlock the mutex
-            lock.unlock();
+        if (job)
+        {
+            jobs_queued--;
+        }
 
-            // Execute the task.
+        return job;
+    }
+
+    static void execute(Job* job)
+    {
+        if (!job->cancelled)
+        {
             working_thread_count++;
-            task();
+            job->task();
             working_thread_count--;
         }
+
+        // complete and release any jobs that were waiting on this one
+        vector<Job*> continuations;
+        {
+            lock_guard<mutex> lock(job->continuations_mutex);
+            job->done = true;
+            continuations.swap(job->continuations);
+        }
+
+        for (Job* continuation : continuations)
+        {
+            if (--continuation->dependency_count == 0)
+            {
+                schedule(continuation);
+            }
+        }
+
+        jobs_in_flight--;
+
+        // drop the queue's reference, this can delete the job
+        job->self.reset();
+    }
+
+    // executes a single job, if one is available, returns false otherwise
+    static bool help()
+    {
+        // the main thread only helps with its own parallel for batches, this way it won't pick up long
+        // running background tasks (e.g. resource loading) while waiting on something frame critical
+        if (Job* job = get_job(is_worker))
+        {
+            execute(job);
+            return true;
+        }
+
+        return false;
+    }
+
+    static void thread_loop(uint32_t index)
+    {
+        thread_index = index;
+        is_worker    = true;
+
+        uint32_t spin_count = 0;
+        while (!is_stopping)
+        {
+            if (help())
+            {
+                spin_count = 0;
+                continue;
+            }
+
+            if (++spin_count < spin_count_before_sleep)
+            {
+                this_thread::yield();
+                continue;
+            }
+
+            // nothing to do for a while, go to sleep until a job is scheduled
+            unique_lock<mutex> lock(mutex_sleep);
+            sleeping_threads++;
+            condition_var.wait(lock, [] { return jobs_queued > 0 || is_stopping; });
+            sleeping_threads--;
+            spin_count = 0;
+        }
     }
 
     void ThreadPool::Initialize()
     {
         is_stopping                      = false;
         uint32_t concurrent_thread_count = thread::hardware_concurrency();
-        thread_count                     = concurrent_thread_count - 1; // exclude the calling thread
+        thread_count                     = concurrent_thread_count > 1 ? concurrent_thread_count - 1 : 1; // exclude the calling thread
+
+        for (uint32_t i = 0; i < thread_count + 1; i++)
+        {
+            deques.emplace_back(make_unique<JobDeque>());
+        }
+
+        // the calling thread owns the last deque
+        thread_index = thread_count;
 
         for (uint32_t i = 0; i < thread_count; i++)
         {
-            threads.emplace_back(thread(&thread_loop));
+            threads.emplace_back(thread(&thread_loop, i));
         }
 
         SP_LOG_INFO("%d threads have been created", thread_count);
@@ -98,100 +307,156 @@ namespace Spartan
     {
         Flush(true);
 
-        // Put unique lock on task mutex.
-        unique_lock<mutex> lock(mutex_tasks);
-
-        // Set termination flag to true.
-        is_stopping = true;
-
-        // Unlock the mutex
-        lock.unlock();
-
-        // Wake up all threads.
+        // set termination flag to true and wake up all threads
+        {
+            lock_guard<mutex> lock(mutex_sleep);
+            is_stopping = true;
+        }
         condition_var.notify_all();
 
-        // Join all threads.
+        // join all threads
         for (auto& thread : threads)
         {
             thread.join();
         }
 
-        // Empty worker threads.
         threads.clear();
+        deques.clear();
     }
 
-    void ThreadPool::AddTask(Task&& task)
+    static JobHandle add_job(Task&& task, const vector<JobHandle>& dependencies, const bool is_batch)
     {
-        // Lock tasks mutex
-        unique_lock<mutex> lock(mutex_tasks);
+        JobHandle job = make_shared<Job>();
+        job->task     = move(task);
+        job->self     = job;
+        job->is_batch = is_batch;
+        jobs_in_flight++;
+
+        // register with any dependencies that haven't completed yet
+        for (const JobHandle& dependency : dependencies)
+        {
+            if (!dependency)
+                continue;
 
-        // Save the task
-        tasks.emplace_back(bind(forward<Task>(task)));
+            lock_guard<mutex> lock(dependency->continuations_mutex);
+            if (!dependency->done)
+            {
+                job->dependency_count++;
+                dependency->continuations.emplace_back(job.get());
+            }
+        }
+
+        // release the registration guard, if all dependencies are met, the job can run
+        if (--job->dependency_count == 0)
+        {
+            schedule(job.get());
+        }
 
-        // Unlock the mutex
-        lock.unlock();
+        return job;
+    }
 
-        // Wake up a thread
-        condition_var.notify_one();
+    JobHandle ThreadPool::AddTask(Task&& task, const vector<JobHandle>& dependencies /*= {}*/)
+    {
+        return add_job(move(task), dependencies, false);
     }
 
-    void ThreadPool::ParallelLoop(function<void(uint32_t work_index_start, uint32_t work_index_end)>&& function, const uint32_t work_total)
+    void ThreadPool::ParallelFor(const function<void(uint32_t work_index_start, uint32_t work_index_end)>& function, const uint32_t work_total)
     {
-        SP_ASSERT_MSG(work_total > 1, "A parallel loop can't have a range of 1 or smaller");
+        if (work_total == 0)
+            return;
+
+        // split the work into batches, the first one is done by the calling thread
+        uint32_t batch_count = min(work_total, (thread_count + 1) * parallel_for_batches_per_thread);
+        if (batch_count <= 1 || deques.empty())
+        {
+            function(0, work_total);
+            return;
+        }
 
-        uint32_t available_threads = GetIdleThreadCount();
-        uint32_t work_per_thread   = work_total / available_threads;
-        uint32_t work_remainder    = work_total % available_threads;
-        uint32_t work_index        = 0;
-        atomic<uint32_t> work_done = 0;
-        condition_variable cv;
-        mutex cv_m;
+        uint32_t work_per_batch = work_total / batch_count;
+        uint32_t work_remainder = work_total % batch_count;
+        atomic<uint32_t> batches_remaining = batch_count - 1;
 
-        // split work into multiple tasks
-        while (work_index < work_total)
+        // the remainder is spread one item per batch, starting from the first ones
+        auto get_batch_range = [work_per_batch, work_remainder](uint32_t batch, uint32_t& start, uint32_t& end)
         {
-            uint32_t work_to_do = work_per_thread;
+            start = batch * work_per_batch + min(batch, work_remainder);
+            end   = start + work_per_batch + (batch < work_remainder ? 1 : 0);
+        };
 
-            // if the work doesn't divide evenly across threads, add the remainder work to the first thread.
-            if (work_remainder != 0)
-            {
-                work_to_do     += work_remainder;
-                work_remainder = 0;
-            }
+        for (uint32_t batch = 1; batch < batch_count; batch++)
+        {
+            uint32_t start = 0;
+            uint32_t end   = 0;
+            get_batch_range(batch, start, end);
 
-            AddTask([&function, &work_done, &cv, work_index, work_to_do]()
+            add_job([&function, &batches_remaining, start, end]()
             {
-                function(work_index, work_index + work_to_do);
-                work_done += work_to_do;
+                function(start, end);
+                batches_remaining--;
+            }, {}, true);
+        }
 
-                cv.notify_one(); // notify that a thread has finished its work
-            });
+        // do our share
+        {
+            uint32_t start = 0;
+            uint32_t end   = 0;
+            get_batch_range(0, start, end);
+            function(start, end);
+        }
 
-            work_index += work_to_do;
+        // help until the rest is done, this is what makes nested calls safe
+        while (batches_remaining > 0)
+        {
+            if (!help())
+            {
+                this_thread::yield();
+            }
         }
+    }
+
+    void ThreadPool::Wait(const JobHandle& job)
+    {
+        while (job && !job->done)
+        {
+            if (!help())
+            {
+                this_thread::yield();
+            }
+        }
+    }
 
-        // wait for threads to finish work
-        unique_lock<mutex> lk(cv_m);
-        cv.wait(lk, [&]() { return work_done == work_total; });
+    bool ThreadPool::IsDone(const JobHandle& job)
+    {
+        return !job || job->done;
     }
 
     void ThreadPool::Flush(bool remove_queued /*= false*/)
     {
-        // Clear any queued tasks
+        SP_ASSERT_MSG(!is_worker, "Flushing from within a task would wait on itself");
+
+        // cancel any queued jobs, they still complete (without running) so that their dependents are released
         if (remove_queued)
         {
-            tasks.clear();
+            while (Job* job = get_job(true))
+            {
+                job->cancelled = true;
+                execute(job);
+            }
         }
 
-        // If so, wait for them
-        while (AreTasksRunning())
+        // wait for the rest
+        while (jobs_in_flight > 0)
         {
-            this_thread::sleep_for(chrono::milliseconds(16));
+            if (!help())
+            {
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
         }
     }
 
     uint32_t ThreadPool::GetThreadCount()        { return thread_count; }
     uint32_t ThreadPool::GetWorkingThreadCount() { return working_thread_count; }
-    uint32_t ThreadPool::GetIdleThreadCount()    { return thread_count - working_thread_count; }
-    bool ThreadPool::AreTasksRunning()           { return GetIdleThreadCount() != GetThreadCount(); }
+    uint32_t ThreadPool::GetIdleThreadCount()    { return thread_count - min(working_thread_count.load(), thread_count); }
+    bool ThreadPool::AreTasksRunning()           { return jobs_in_flight > 0; }
 }
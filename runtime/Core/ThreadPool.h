@@ -24,11 +24,15 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ===========
 #include "Definitions.h"
 #include <functional>
+#include <memory>
+#include <vector>
 //======================
 
 namespace Spartan
 {
-    using Task = std::function<void()>;
+    struct Job;
+    using Task      = std::function<void()>;
+    using JobHandle = std::shared_ptr<Job>;
 
     class SP_CLASS ThreadPool
     {
@@ -36,13 +40,18 @@ namespace Spartan
         static void Initialize();
         static void Shutdown();
 
-        // add a task
-        static void AddTask(Task&& task);
+        // add a task, it will only start executing once all of its dependencies have completed
+        static JobHandle AddTask(Task&& task, const std::vector<JobHandle>& dependencies = {});
 
-        // spread execution of a given function across all available threads
-        static void ParallelLoop(std::function<void(uint32_t work_index_start, uint32_t work_index_end)>&& function, const uint32_t work_total);
+        // spread execution of a given function across all threads, the calling thread participates
+        // and the call is safe to make from within a task (nested parallelism doesn't deadlock)
+        static void ParallelFor(const std::function<void(uint32_t work_index_start, uint32_t work_index_end)>& function, const uint32_t work_total);
 
-        // wait for all threads to finish work
+        // wait for a task to complete, the calling thread executes other work while it waits
+        static void Wait(const JobHandle& job);
+        static bool IsDone(const JobHandle& job);
+
+        // wait for all threads to finish work (can't be called from within a task)
         static void Flush(bool remove_queued = false);
 
         // stats
@@ -0,0 +1,448 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==============
+#include "pch.h"
+#include "AssetArchive.h"
+#if defined(_MSC_VER)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+//=========================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    namespace
+    {
+        const uint32_t archive_magic     = 0x4B415053; // "SPAK"
+        const uint32_t archive_version   = 1;
+        const uint64_t archive_alignment = 64;         // every file starts on a cache line
+
+        struct Header
+        {
+            uint32_t magic       = archive_magic;
+            uint32_t version     = archive_version;
+            uint32_t entry_count = 0;
+            uint32_t padding     = 0;
+            uint64_t toc_offset  = 0;
+        };
+
+        struct Entry
+        {
+            uint64_t offset = 0;
+            uint64_t size   = 0;
+        };
+
+        mutex archive_mutex;
+        shared_ptr<FileMapping> archive;
+        string archive_path_mounted;
+        unordered_map<string, Entry> entries;
+
+        // the key of a file in the table of contents
+        string get_key(const string& file_path)
+        {
+            string key = FileSystem::GetRelativePath(file_path);
+            replace(key.begin(), key.end(), '\\', '/');
+
+            return key;
+        }
+
+        // a new archive is written under a new version, rather than replacing the previous one, which views may still map (windows doesn't allow replacing it then)
+        // "<name>.pak" is version 0, "<name>.<version>.pak" are the ones which followed it, the latest is the one which is mounted
+        string get_version_path(const string& archive_path, const uint32_t version)
+        {
+            if (version == 0)
+                return archive_path;
+
+            return FileSystem::GetFilePathWithoutExtension(archive_path) + "." + to_string(version) + FileSystem::GetExtensionFromFilePath(archive_path);
+        }
+
+        // the versions of the archive which are on the drive, oldest first
+        vector<uint32_t> get_versions(const string& archive_path)
+        {
+            vector<uint32_t> versions;
+
+            const string directory = FileSystem::GetDirectoryFromFilePath(archive_path);
+            if (!FileSystem::IsDirectory(directory))
+                return versions;
+
+            const string name      = FileSystem::GetFileNameFromFilePath(archive_path);
+            const string prefix    = FileSystem::GetFileNameWithoutExtensionFromFilePath(archive_path) + ".";
+            const string extension = FileSystem::GetExtensionFromFilePath(archive_path);
+            for (const string& file_path : FileSystem::GetFilesInDirectory(directory))
+            {
+                const string file_name = FileSystem::GetFileNameFromFilePath(file_path);
+                if (file_name == name)
+                {
+                    versions.emplace_back(0);
+                    continue;
+                }
+
+                if (file_name.size() <= prefix.size() + extension.size() || !file_name.starts_with(prefix) || !file_name.ends_with(extension))
+                    continue;
+
+                const string digits = file_name.substr(prefix.size(), file_name.size() - prefix.size() - extension.size());
+                if (digits.size() > 9 || !all_of(digits.begin(), digits.end(), [](const char c) { return c >= '0' && c <= '9'; }))
+                    continue;
+
+                versions.emplace_back(static_cast<uint32_t>(stoul(digits)));
+            }
+
+            sort(versions.begin(), versions.end());
+
+            return versions;
+        }
+
+        // what is still mapped can't be deleted (on windows), it's deleted by a later pack instead, and never mounted since it's not the latest
+        void delete_versions(const string& archive_path, const vector<uint32_t>& versions)
+        {
+            for (uint32_t version : versions)
+            {
+                error_code error;
+                filesystem::remove(get_version_path(archive_path, version), error);
+            }
+        }
+
+        template <typename T>
+        bool read(const FileMapping& mapping, uint64_t& offset, T* value)
+        {
+            if (offset + sizeof(T) > mapping.GetSize())
+                return false;
+
+            memcpy(value, mapping.GetData() + offset, sizeof(T));
+            offset += sizeof(T);
+
+            return true;
+        }
+    }
+
+    FileMapping::~FileMapping()
+    {
+        if (!m_address)
+            return;
+
+        #if defined(_MSC_VER)
+        UnmapViewOfFile(m_address);
+        #else
+        munmap(m_address, static_cast<size_t>(m_address_size));
+        #endif
+    }
+
+    shared_ptr<FileMapping> FileMapping::Open(const string& path)
+    {
+        shared_ptr<FileMapping> mapping = make_shared<FileMapping>();
+
+        #if defined(_MSC_VER)
+        HANDLE file = CreateFileW(FileSystem::StringToWstring(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return nullptr;
+
+        LARGE_INTEGER size = {};
+        if (!GetFileSizeEx(file, &size))
+        {
+            CloseHandle(file);
+            return nullptr;
+        }
+
+        // empty files can't be mapped, they are valid nonetheless
+        if (size.QuadPart != 0)
+        {
+            // the view keeps the mapping alive, so the handles can be closed right away
+            HANDLE handle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            void* address = handle ? MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            if (handle)
+            {
+                CloseHandle(handle);
+            }
+            CloseHandle(file);
+
+            if (!address)
+                return nullptr;
+
+            mapping->m_address      = address;
+            mapping->m_address_size = static_cast<uint64_t>(size.QuadPart);
+        }
+        else
+        {
+            CloseHandle(file);
+        }
+        #else
+        int file = open(path.c_str(), O_RDONLY);
+        if (file == -1)
+            return nullptr;
+
+        struct stat status = {};
+        if (fstat(file, &status) != 0)
+        {
+            close(file);
+            return nullptr;
+        }
+
+        // empty files can't be mapped, they are valid nonetheless
+        if (status.st_size != 0)
+        {
+            // the mapping keeps the file open, so the descriptor can be closed right away
+            void* address = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+            close(file);
+
+            if (address == MAP_FAILED)
+                return nullptr;
+
+            mapping->m_address      = address;
+            mapping->m_address_size = static_cast<uint64_t>(status.st_size);
+        }
+        else
+        {
+            close(file);
+        }
+        #endif
+
+        mapping->m_data = static_cast<const byte*>(mapping->m_address);
+        mapping->m_size = mapping->m_address_size;
+
+        return mapping;
+    }
+
+    shared_ptr<FileMapping> FileMapping::View(const shared_ptr<FileMapping>& parent, const uint64_t offset, const uint64_t size)
+    {
+        if (!parent || offset + size > parent->GetSize())
+            return nullptr;
+
+        shared_ptr<FileMapping> mapping = make_shared<FileMapping>();
+        mapping->m_parent               = parent;
+        mapping->m_data                 = parent->GetData() + offset;
+        mapping->m_size                 = size;
+
+        return mapping;
+    }
+
+    bool AssetArchive::Pack(const string& archive_path, const vector<string>& file_paths)
+    {
+        // written to a temporary file, so that a failure doesn't leave a broken archive behind
+        const string archive_path_temp = archive_path + ".tmp";
+        {
+            ofstream file(archive_path_temp, ios::binary | ios::trunc);
+            if (!file)
+            {
+                SP_LOG_ERROR("Failed to open \"%s\" for writing", archive_path_temp.c_str());
+                return false;
+            }
+
+            // the header is written last, once the table of contents is known
+            Header header;
+            file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+            vector<pair<string, Entry>> toc;
+            uint64_t offset = sizeof(Header);
+            for (const string& file_path : file_paths)
+            {
+                // the files can come from the archive which is being replaced, if they were never saved loose
+                shared_ptr<FileMapping> mapping = Map(file_path);
+                if (!mapping)
+                {
+                    SP_LOG_WARNING("Failed to pack \"%s\"", file_path.c_str());
+                    continue;
+                }
+
+                const uint64_t offset_aligned = (offset + archive_alignment - 1) & ~(archive_alignment - 1);
+                const char padding[archive_alignment] = {};
+                file.write(padding, static_cast<streamsize>(offset_aligned - offset));
+                file.write(reinterpret_cast<const char*>(mapping->GetData()), static_cast<streamsize>(mapping->GetSize()));
+
+                toc.emplace_back(get_key(file_path), Entry{ offset_aligned, mapping->GetSize() });
+                offset = offset_aligned + mapping->GetSize();
+            }
+
+            for (const auto& [key, entry] : toc)
+            {
+                const uint32_t length = static_cast<uint32_t>(key.size());
+                file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+                file.write(key.data(), length);
+                file.write(reinterpret_cast<const char*>(&entry.offset), sizeof(entry.offset));
+                file.write(reinterpret_cast<const char*>(&entry.size), sizeof(entry.size));
+            }
+
+            header.entry_count = static_cast<uint32_t>(toc.size());
+            header.toc_offset  = offset;
+            file.seekp(0);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+            if (!file)
+            {
+                SP_LOG_ERROR("Failed to write \"%s\"", archive_path_temp.c_str());
+                file.close();
+                FileSystem::Delete(archive_path_temp);
+                return false;
+            }
+        }
+
+        const vector<uint32_t> versions = get_versions(archive_path);
+        const string archive_path_new   = get_version_path(archive_path, versions.empty() ? 0 : versions.back() + 1);
+
+        // the previous archive can't stay mapped once it's deleted, it's up to the caller to mount the new one
+        bool is_mounted = false;
+        {
+            lock_guard lock(archive_mutex);
+            for (uint32_t version : versions)
+            {
+                is_mounted |= archive && archive_path_mounted == get_version_path(archive_path, version);
+            }
+        }
+
+        error_code error;
+        filesystem::rename(archive_path_temp, archive_path_new, error);
+        if (error)
+        {
+            SP_LOG_ERROR("Failed to write \"%s\": %s", archive_path_new.c_str(), error.message().c_str());
+            FileSystem::Delete(archive_path_temp);
+
+            // the previous archive would shadow the files which were saved since it was packed
+            if (is_mounted)
+            {
+                Unmount();
+            }
+            delete_versions(archive_path, versions);
+            for (uint32_t version : get_versions(archive_path))
+            {
+                SP_LOG_ERROR("Failed to delete the stale \"%s\", delete it manually", get_version_path(archive_path, version).c_str());
+            }
+
+            return false;
+        }
+
+        if (is_mounted)
+        {
+            Unmount();
+        }
+        delete_versions(archive_path, versions);
+
+        return true;
+    }
+
+    bool AssetArchive::Mount(const string& archive_path_base)
+    {
+        // the latest version
+        const vector<uint32_t> versions = get_versions(archive_path_base);
+        if (versions.empty())
+            return false;
+        const string archive_path = get_version_path(archive_path_base, versions.back());
+
+        shared_ptr<FileMapping> mapping = FileMapping::Open(archive_path);
+        if (!mapping)
+        {
+            SP_LOG_ERROR("Failed to open \"%s\"", archive_path.c_str());
+            return false;
+        }
+
+        Header header;
+        uint64_t offset = 0;
+        if (!read(*mapping, offset, &header) || header.magic != archive_magic || header.version != archive_version || header.toc_offset > mapping->GetSize())
+        {
+            SP_LOG_ERROR("\"%s\" is not a valid archive", archive_path.c_str());
+            return false;
+        }
+
+        unordered_map<string, Entry> toc;
+        toc.reserve(header.entry_count);
+        offset = header.toc_offset;
+        for (uint32_t i = 0; i < header.entry_count; i++)
+        {
+            uint32_t length = 0;
+            Entry entry;
+            if (!read(*mapping, offset, &length) || offset + length > mapping->GetSize())
+                break;
+
+            string key(reinterpret_cast<const char*>(mapping->GetData() + offset), length);
+            offset += length;
+            if (!read(*mapping, offset, &entry.offset) || !read(*mapping, offset, &entry.size) || entry.offset + entry.size > header.toc_offset)
+                break;
+
+            toc[move(key)] = entry;
+        }
+
+        if (toc.size() != header.entry_count)
+        {
+            SP_LOG_ERROR("The table of contents of \"%s\" is corrupt", archive_path.c_str());
+            return false;
+        }
+
+        lock_guard lock(archive_mutex);
+        archive              = mapping;
+        archive_path_mounted = archive_path;
+        entries              = move(toc);
+
+        SP_LOG_INFO("Mounted \"%s\" (%u files)", archive_path.c_str(), header.entry_count);
+
+        return true;
+    }
+
+    void AssetArchive::Unmount()
+    {
+        // views which are still in use keep the mapping alive
+        lock_guard lock(archive_mutex);
+        archive.reset();
+        archive_path_mounted.clear();
+        entries.clear();
+    }
+
+    bool AssetArchive::Contains(const string& file_path)
+    {
+        lock_guard lock(archive_mutex);
+        return archive && entries.find(get_key(file_path)) != entries.end();
+    }
+
+    bool AssetArchive::Exists(const string& file_path)
+    {
+        return Contains(file_path) || FileSystem::IsFile(file_path);
+    }
+
+    shared_ptr<FileMapping> AssetArchive::Map(const string& file_path)
+    {
+        {
+            lock_guard lock(archive_mutex);
+            if (archive)
+            {
+                auto it = entries.find(get_key(file_path));
+                if (it != entries.end())
+                    return FileMapping::View(archive, it->second.offset, it->second.size);
+            }
+        }
+
+        return FileMapping::Open(file_path);
+    }
+
+    void AssetArchive::Invalidate(const string& file_path)
+    {
+        lock_guard lock(archive_mutex);
+        if (archive)
+        {
+            entries.erase(get_key(file_path));
+        }
+    }
+}
@@ -0,0 +1,73 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ======
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <span>
+//=================
+
+namespace Spartan
+{
+    // a read only view of a file, which the os pages in on demand, views into it keep it alive
+    class SP_CLASS FileMapping
+    {
+    public:
+        FileMapping() = default;
+        ~FileMapping();
+
+        static std::shared_ptr<FileMapping> Open(const std::string& path);
+        static std::shared_ptr<FileMapping> View(const std::shared_ptr<FileMapping>& parent, const uint64_t offset, const uint64_t size);
+
+        const std::byte* GetData()            const { return m_data; }
+        uint64_t GetSize()                    const { return m_size; }
+        std::span<const std::byte> GetBytes() const { return std::span<const std::byte>(m_data, static_cast<size_t>(m_size)); }
+
+    private:
+        std::shared_ptr<FileMapping> m_parent;
+        const std::byte* m_data = nullptr;
+        uint64_t m_size         = 0;
+        void* m_address         = nullptr; // of the mapping, only when this is not a view
+        uint64_t m_address_size = 0;
+    };
+
+    // engine files packed into a single file, a header, the files (aligned) and a table of contents which maps their paths to them
+    // while mounted, the files which it contains are read from it, unless they have been saved again since it was packed
+    // packing writes a new version of the archive ("<name>.<version>.pak") and deletes the previous ones, instead of replacing a file which
+    // views may still map (windows doesn't allow it), mounting an archive mounts its latest version
+    class SP_CLASS AssetArchive
+    {
+    public:
+        static bool Pack(const std::string& archive_path, const std::vector<std::string>& file_paths);
+        static bool Mount(const std::string& archive_path);
+        static void Unmount();
+
+        // any thread
+        static bool Contains(const std::string& file_path);
+        static bool Exists(const std::string& file_path); // in the archive or on the drive
+        static std::shared_ptr<FileMapping> Map(const std::string& file_path);
+        static void Invalidate(const std::string& file_path); // the file was saved again, so what the archive has is stale
+    };
+}
@@ -22,6 +22,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =================
 #include "pch.h"
 #include "FileStream.h"
+#include "AssetArchive.h"
 #include "../RHI/RHI_Vertex.h"
 //============================
 
@@ -36,24 +37,25 @@ namespace Spartan
         m_is_open = false;
         m_flags   = flags;
 
-        ios_base::openmode ios_flags = ios::binary;
-        if(flags & FileStream_Read)   ios_flags |= ios::in;
-        if(flags & FileStream_Write)  ios_flags |= ios::out;
-        if(flags & FileStream_Append) ios_flags |= ios::app;
-
         if (m_flags & FileStream_Write)
         {
+            ios_base::openmode ios_flags = ios::binary | ios::out;
+            if (flags & FileStream_Append) ios_flags |= ios::app;
+
             out.open(path, ios_flags);
             if (out.fail())
             {
                 SP_LOG_ERROR("Failed to open \"%s\" for writing", path.c_str());
                 return;
             }
+
+            // the archive would otherwise keep serving the previous version
+            AssetArchive::Invalidate(path);
         }
         else if (m_flags & FileStream_Read)
         {
-            in.open(path, ios_flags);
-            if(in.fail())
+            m_mapping = AssetArchive::Map(path);
+            if (!m_mapping)
             {
                 SP_LOG_ERROR("Failed to open \"%s\" for reading", path.c_str());
                 return;
@@ -77,8 +79,8 @@ namespace Spartan
         }
         else if (m_flags & FileStream_Read)
         {
-            in.clear();
-            in.close();
+            m_mapping.reset();
+            m_position = 0;
         }
     }
 
@@ -129,6 +131,13 @@ namespace Spartan
         out.write(reinterpret_cast<const char*>(&value[0]), sizeof(std::byte) * size);
     }
 
+    void FileStream::Write(span<const byte> value)
+    {
+        const auto size = static_cast<uint32_t>(value.size());
+        Write(size);
+        out.write(reinterpret_cast<const char*>(value.data()), sizeof(std::byte) * size);
+    }
+
     void FileStream::Write(const atomic<bool>& value)
     {
         out.write(reinterpret_cast<const char*>(&value), sizeof(bool));
@@ -143,7 +152,7 @@ namespace Spartan
         }
         else if (m_flags & FileStream_Read)
         {
-            in.ignore(n, ios::cur);
+            m_position += n;
         }
     }
 
@@ -153,7 +162,7 @@ namespace Spartan
         Read(&length);
 
         value->resize(length);
-        in.read(const_cast<char*>(value->c_str()), length);
+        ReadBytes(value->data(), length);
     }
 
     void FileStream::Read(vector<string>* vec)
@@ -186,7 +195,7 @@ namespace Spartan
         vec->reserve(length);
         vec->resize(length);
 
-        in.read(reinterpret_cast<char*>(vec->data()), sizeof(RHI_Vertex_PosTexNorTan) * length);
+        ReadBytes(vec->data(), sizeof(RHI_Vertex_PosTexNorTan) * length);
     }
 
     void FileStream::Read(vector<uint32_t>* vec)
@@ -201,7 +210,7 @@ namespace Spartan
         vec->reserve(length);
         vec->resize(length);
 
-        in.read(reinterpret_cast<char*>(vec->data()), sizeof(uint32_t) * length);
+        ReadBytes(vec->data(), sizeof(uint32_t) * length);
     }
 
     void FileStream::Read(vector<unsigned char>* vec)
@@ -216,7 +225,7 @@ namespace Spartan
         vec->reserve(length);
         vec->resize(length);
 
-        in.read(reinterpret_cast<char*>(vec->data()), sizeof(unsigned char) * length);
+        ReadBytes(vec->data(), sizeof(unsigned char) * length);
     }
 
     void FileStream::Read(vector<std::byte>* vec)
@@ -231,11 +240,39 @@ namespace Spartan
         vec->reserve(length);
         vec->resize(length);
 
-        in.read(reinterpret_cast<char*>(vec->data()), sizeof(std::byte) * length);
+        ReadBytes(vec->data(), sizeof(std::byte) * length);
     }
 
     void FileStream::Read(std::atomic<bool>* value)
     {
-        in.read(reinterpret_cast<char*>(value), sizeof(bool));
+        bool value_read = false;
+        ReadBytes(&value_read, sizeof(bool));
+        value->store(value_read);
+    }
+
+    span<const byte> FileStream::ReadSpan()
+    {
+        const auto length = ReadAs<uint32_t>();
+        if (!m_mapping || m_position + length > m_mapping->GetSize())
+            return span<const byte>();
+
+        span<const byte> value(m_mapping->GetData() + m_position, length);
+        m_position += length;
+
+        return value;
+    }
+
+    void FileStream::ReadBytes(void* data, const uint64_t size)
+    {
+        // reading past the end, of a truncated or an older version of a file, yields zeros
+        if (!m_mapping || m_position + size > m_mapping->GetSize())
+        {
+            memset(data, 0, static_cast<size_t>(size));
+            m_position = m_mapping ? m_mapping->GetSize() : 0;
+            return;
+        }
+
+        memcpy(data, m_mapping->GetData() + m_position, static_cast<size_t>(size));
+        m_position += size;
     }
 }
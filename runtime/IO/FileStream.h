@@ -24,6 +24,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ===================
 #include <vector>
 #include <fstream>
+#include <span>
+#include <memory>
 #include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
 #include "../Math/Vector4.h"
@@ -34,6 +36,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace Spartan
 {
+    class FileMapping;
+
     enum FileStream_Mode : uint32_t
     {
         FileStream_Read   = 1 << 0,
@@ -85,6 +89,7 @@ namespace Spartan
         void Write(const std::vector<uint32_t>& value);
         void Write(const std::vector<unsigned char>& value);
         void Write(const std::vector<std::byte>& value);
+        void Write(std::span<const std::byte> value);
         void Write(const std::atomic<bool>& value);
         void Skip(uint64_t n);
         //===========================================================
@@ -116,7 +121,7 @@ namespace Spartan
         >::type>
         void Read(T* value)
         {
-            in.read(reinterpret_cast<char*>(value), sizeof(T));
+            ReadBytes(value, sizeof(T));
         }
         void Read(std::string* value);
         void Read(std::vector<std::string>* vec);
@@ -126,6 +131,10 @@ namespace Spartan
         void Read(std::vector<std::byte>* vec);
         void Read(std::atomic<bool>* value);
 
+        // a view of what Write(std::vector<std::byte>) wrote, valid for as long as the mapping is held (see GetMapping())
+        std::span<const std::byte> ReadSpan();
+        const std::shared_ptr<FileMapping>& GetMapping() const { return m_mapping; }
+
         // Reading with explicit type definition
         template <class T, class = typename std::enable_if
         <
@@ -155,8 +164,12 @@ namespace Spartan
         //=====================================================
 
     private:
+        void ReadBytes(void* data, const uint64_t size);
+
+        // reading is done from a mapping of the file (or of its copy in a mounted archive, see AssetArchive)
         std::ofstream out;
-        std::ifstream in;
+        std::shared_ptr<FileMapping> m_mapping;
+        uint64_t m_position = 0;
         uint32_t m_flags;
         bool m_is_open;
     };
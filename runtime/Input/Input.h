@@ -96,7 +96,7 @@ namespace Spartan
         static void PollController();
 
         // event driven input
-        static void OnEvent(sp_variant data);
+        static void OnEvent(const sp_variant& data);
         static void OnEventMouse(void* event_mouse);
         static void OnEventController(void* event_controller);
 
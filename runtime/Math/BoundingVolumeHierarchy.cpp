@@ -0,0 +1,482 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ======================
+#include "pch.h"
+#include "BoundingVolumeHierarchy.h"
+#include "Frustum.h"
+#include "Ray.h"
+//=================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan::Math
+{
+    namespace
+    {
+        BoundingBox merge(const BoundingBox& a, const BoundingBox& b)
+        {
+            BoundingBox box = a;
+            box.Merge(b);
+            return box;
+        }
+
+        // the insertion cost, proportional to the probability of a random ray hitting the box
+        float surface_area(const BoundingBox& box)
+        {
+            const Vector3 size = box.GetSize();
+            return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+
+        bool contains(const BoundingBox& outer, const BoundingBox& inner)
+        {
+            return outer.GetMin().x <= inner.GetMin().x && outer.GetMin().y <= inner.GetMin().y && outer.GetMin().z <= inner.GetMin().z &&
+                   outer.GetMax().x >= inner.GetMax().x && outer.GetMax().y >= inner.GetMax().y && outer.GetMax().z >= inner.GetMax().z;
+        }
+
+        bool overlaps(const BoundingBox& a, const BoundingBox& b)
+        {
+            return a.GetMin().x <= b.GetMax().x && a.GetMax().x >= b.GetMin().x &&
+                   a.GetMin().y <= b.GetMax().y && a.GetMax().y >= b.GetMin().y &&
+                   a.GetMin().z <= b.GetMax().z && a.GetMax().z >= b.GetMin().z;
+        }
+
+        BoundingBox fatten(const BoundingBox& box)
+        {
+            // a tenth of the size, so that both small props and large buildings can move a bit without reinsertion
+            const Vector3 margin = box.GetExtents() * 0.1f + Vector3(0.05f);
+            return BoundingBox(box.GetMin() - margin, box.GetMax() + margin);
+        }
+
+        thread_local vector<uint32_t> stack;
+    }
+
+    uint32_t BoundingVolumeHierarchy::Insert(const BoundingBox& box)
+    {
+        SP_ASSERT(box != BoundingBox::Undefined);
+
+        const uint32_t leaf     = AllocateNode();
+        m_nodes[leaf].box       = fatten(box);
+        m_nodes[leaf].box_tight = box;
+        m_nodes[leaf].height    = 0;
+
+        InsertLeaf(leaf);
+        m_leaf_count++;
+
+        return leaf;
+    }
+
+    void BoundingVolumeHierarchy::Remove(const uint32_t leaf)
+    {
+        SP_ASSERT(leaf < m_nodes.size() && m_nodes[leaf].IsLeaf() && m_nodes[leaf].height == 0);
+
+        RemoveLeaf(leaf);
+        FreeNode(leaf);
+        m_leaf_count--;
+    }
+
+    void BoundingVolumeHierarchy::Update(const uint32_t leaf, const BoundingBox& box)
+    {
+        SP_ASSERT(leaf < m_nodes.size() && m_nodes[leaf].IsLeaf() && m_nodes[leaf].height == 0);
+        SP_ASSERT(box != BoundingBox::Undefined);
+
+        m_nodes[leaf].box_tight = box;
+
+        // still within the margin, the tree is unaffected
+        if (contains(m_nodes[leaf].box, box))
+            return;
+
+        RemoveLeaf(leaf);
+        m_nodes[leaf].box = fatten(box);
+        InsertLeaf(leaf);
+    }
+
+    void BoundingVolumeHierarchy::Clear()
+    {
+        m_nodes.clear();
+        m_root       = node_invalid;
+        m_free       = node_invalid;
+        m_leaf_count = 0;
+    }
+
+    void BoundingVolumeHierarchy::QueryFrustum(const Frustum& frustum, const bool ignore_depth, const function<void(uint32_t leaf)>& callback) const
+    {
+        if (m_root == node_invalid)
+            return;
+
+        stack.clear();
+        stack.emplace_back(m_root);
+        while (!stack.empty())
+        {
+            const uint32_t index = stack.back();
+            stack.pop_back();
+
+            const Node& node = m_nodes[index];
+            if (node.IsLeaf())
+            {
+                if (frustum.IsVisible(node.box_tight.GetCenter(), node.box_tight.GetExtents(), ignore_depth))
+                {
+                    callback(index);
+                }
+
+                continue;
+            }
+
+            const Intersection intersection = frustum.CheckCube(node.box.GetCenter(), node.box.GetExtents(), ignore_depth);
+            if (intersection == Intersection::Outside)
+                continue;
+
+            // fully inside, so is everything below it, no more tests are needed
+            if (intersection == Intersection::Inside)
+            {
+                ReportLeaves(index, callback);
+                continue;
+            }
+
+            stack.emplace_back(node.child_a);
+            stack.emplace_back(node.child_b);
+        }
+    }
+
+    void BoundingVolumeHierarchy::QueryRay(const Ray& ray, const function<void(uint32_t leaf, float distance)>& callback) const
+    {
+        if (m_root == node_invalid)
+            return;
+
+        stack.clear();
+        stack.emplace_back(m_root);
+        while (!stack.empty())
+        {
+            const uint32_t index = stack.back();
+            stack.pop_back();
+
+            const Node& node = m_nodes[index];
+            if (node.IsLeaf())
+            {
+                const float distance = ray.HitDistance(node.box_tight);
+                if (distance != Helper::INFINITY_)
+                {
+                    callback(index, distance);
+                }
+
+                continue;
+            }
+
+            if (ray.HitDistance(node.box) == Helper::INFINITY_)
+                continue;
+
+            stack.emplace_back(node.child_a);
+            stack.emplace_back(node.child_b);
+        }
+    }
+
+    void BoundingVolumeHierarchy::QueryBox(const BoundingBox& box, const function<void(uint32_t leaf)>& callback) const
+    {
+        if (m_root == node_invalid)
+            return;
+
+        stack.clear();
+        stack.emplace_back(m_root);
+        while (!stack.empty())
+        {
+            const uint32_t index = stack.back();
+            stack.pop_back();
+
+            const Node& node = m_nodes[index];
+            if (!overlaps(node.IsLeaf() ? node.box_tight : node.box, box))
+                continue;
+
+            if (node.IsLeaf())
+            {
+                callback(index);
+                continue;
+            }
+
+            stack.emplace_back(node.child_a);
+            stack.emplace_back(node.child_b);
+        }
+    }
+
+    uint32_t BoundingVolumeHierarchy::AllocateNode()
+    {
+        if (m_free == node_invalid)
+        {
+            m_nodes.emplace_back();
+            return static_cast<uint32_t>(m_nodes.size() - 1);
+        }
+
+        const uint32_t index = m_free;
+        m_free               = m_nodes[index].parent;
+        m_nodes[index]       = Node();
+
+        return index;
+    }
+
+    void BoundingVolumeHierarchy::FreeNode(const uint32_t index)
+    {
+        m_nodes[index]        = Node();
+        m_nodes[index].parent = m_free;
+        m_free                = index;
+    }
+
+    void BoundingVolumeHierarchy::InsertLeaf(const uint32_t leaf)
+    {
+        if (m_root == node_invalid)
+        {
+            m_root               = leaf;
+            m_nodes[leaf].parent = node_invalid;
+            return;
+        }
+
+        // descend towards the sibling which grows the least, as measured by the surface area heuristic
+        const BoundingBox box = m_nodes[leaf].box;
+        uint32_t index        = m_root;
+        while (!m_nodes[index].IsLeaf())
+        {
+            const Node& node = m_nodes[index];
+
+            const float area          = surface_area(node.box);
+            const float area_combined = surface_area(merge(node.box, box));
+
+            // creating a new parent for this node and the leaf
+            const float cost = 2.0f * area_combined;
+
+            // pushing the leaf further down, which grows this node
+            const float cost_inheritance = 2.0f * (area_combined - area);
+
+            auto cost_descend = [this, &box, cost_inheritance](const uint32_t child)
+            {
+                const Node& node_child = m_nodes[child];
+                const float area_new   = surface_area(merge(box, node_child.box));
+                return (node_child.IsLeaf() ? area_new : area_new - surface_area(node_child.box)) + cost_inheritance;
+            };
+
+            const float cost_a = cost_descend(node.child_a);
+            const float cost_b = cost_descend(node.child_b);
+
+            if (cost < cost_a && cost < cost_b)
+                break;
+
+            index = cost_a < cost_b ? node.child_a : node.child_b;
+        }
+
+        // create a new parent for the sibling and the leaf
+        const uint32_t sibling    = index;
+        const uint32_t parent_old = m_nodes[sibling].parent;
+        const uint32_t parent_new = AllocateNode();
+
+        m_nodes[parent_new].parent  = parent_old;
+        m_nodes[parent_new].box     = merge(box, m_nodes[sibling].box);
+        m_nodes[parent_new].height  = m_nodes[sibling].height + 1;
+        m_nodes[parent_new].child_a = sibling;
+        m_nodes[parent_new].child_b = leaf;
+        m_nodes[sibling].parent     = parent_new;
+        m_nodes[leaf].parent        = parent_new;
+
+        if (parent_old == node_invalid)
+        {
+            m_root = parent_new;
+        }
+        else if (m_nodes[parent_old].child_a == sibling)
+        {
+            m_nodes[parent_old].child_a = parent_new;
+        }
+        else
+        {
+            m_nodes[parent_old].child_b = parent_new;
+        }
+
+        Refit(m_nodes[leaf].parent);
+    }
+
+    void BoundingVolumeHierarchy::RemoveLeaf(const uint32_t leaf)
+    {
+        if (leaf == m_root)
+        {
+            m_root = node_invalid;
+            return;
+        }
+
+        // the sibling takes the place of the parent
+        const uint32_t parent       = m_nodes[leaf].parent;
+        const uint32_t grand_parent = m_nodes[parent].parent;
+        const uint32_t sibling      = m_nodes[parent].child_a == leaf ? m_nodes[parent].child_b : m_nodes[parent].child_a;
+
+        if (grand_parent == node_invalid)
+        {
+            m_root                  = sibling;
+            m_nodes[sibling].parent = node_invalid;
+            FreeNode(parent);
+            return;
+        }
+
+        if (m_nodes[grand_parent].child_a == parent)
+        {
+            m_nodes[grand_parent].child_a = sibling;
+        }
+        else
+        {
+            m_nodes[grand_parent].child_b = sibling;
+        }
+        m_nodes[sibling].parent = grand_parent;
+        FreeNode(parent);
+
+        Refit(grand_parent);
+    }
+
+    void BoundingVolumeHierarchy::Refit(uint32_t index)
+    {
+        // walk up, re-balancing and recomputing the boxes and the heights
+        while (index != node_invalid)
+        {
+            index = Balance(index);
+
+            Node& node  = m_nodes[index];
+            node.height = 1 + max(m_nodes[node.child_a].height, m_nodes[node.child_b].height);
+            node.box    = merge(m_nodes[node.child_a].box, m_nodes[node.child_b].box);
+
+            index = node.parent;
+        }
+    }
+
+    uint32_t BoundingVolumeHierarchy::Balance(const uint32_t index_a)
+    {
+        // a is the node, b and c its children, if one side is more than one level deeper, its child with the larger height is rotated up
+        Node& a = m_nodes[index_a];
+        if (a.IsLeaf() || a.height < 2)
+            return index_a;
+
+        const uint32_t index_b = a.child_a;
+        const uint32_t index_c = a.child_b;
+        Node& b                = m_nodes[index_b];
+        Node& c                = m_nodes[index_c];
+        const int32_t balance  = c.height - b.height;
+
+        // the parent of a now points to the node which replaces it
+        auto replace_in_parent = [this, index_a](Node& node, const uint32_t index_node)
+        {
+            if (node.parent == node_invalid)
+            {
+                m_root = index_node;
+            }
+            else if (m_nodes[node.parent].child_a == index_a)
+            {
+                m_nodes[node.parent].child_a = index_node;
+            }
+            else
+            {
+                m_nodes[node.parent].child_b = index_node;
+            }
+        };
+
+        // rotate c up
+        if (balance > 1)
+        {
+            const uint32_t index_f = c.child_a;
+            const uint32_t index_g = c.child_b;
+            Node& f                = m_nodes[index_f];
+            Node& g                = m_nodes[index_g];
+
+            c.child_a = index_a;
+            c.parent  = a.parent;
+            a.parent  = index_c;
+            replace_in_parent(c, index_c);
+
+            if (f.height > g.height)
+            {
+                c.child_b = index_f;
+                a.child_b = index_g;
+                g.parent  = index_a;
+                a.box     = merge(b.box, g.box);
+                c.box     = merge(a.box, f.box);
+                a.height  = 1 + max(b.height, g.height);
+                c.height  = 1 + max(a.height, f.height);
+            }
+            else
+            {
+                c.child_b = index_g;
+                a.child_b = index_f;
+                f.parent  = index_a;
+                a.box     = merge(b.box, f.box);
+                c.box     = merge(a.box, g.box);
+                a.height  = 1 + max(b.height, f.height);
+                c.height  = 1 + max(a.height, g.height);
+            }
+
+            return index_c;
+        }
+
+        // rotate b up
+        if (balance < -1)
+        {
+            const uint32_t index_d = b.child_a;
+            const uint32_t index_e = b.child_b;
+            Node& d                = m_nodes[index_d];
+            Node& e                = m_nodes[index_e];
+
+            b.child_a = index_a;
+            b.parent  = a.parent;
+            a.parent  = index_b;
+            replace_in_parent(b, index_b);
+
+            if (d.height > e.height)
+            {
+                b.child_b = index_d;
+                a.child_a = index_e;
+                e.parent  = index_a;
+                a.box     = merge(c.box, e.box);
+                b.box     = merge(a.box, d.box);
+                a.height  = 1 + max(c.height, e.height);
+                b.height  = 1 + max(a.height, d.height);
+            }
+            else
+            {
+                b.child_b = index_e;
+                a.child_a = index_d;
+                d.parent  = index_a;
+                a.box     = merge(c.box, d.box);
+                b.box     = merge(a.box, e.box);
+                a.height  = 1 + max(c.height, d.height);
+                b.height  = 1 + max(a.height, e.height);
+            }
+
+            return index_b;
+        }
+
+        return index_a;
+    }
+
+    void BoundingVolumeHierarchy::ReportLeaves(const uint32_t index, const function<void(uint32_t leaf)>& callback) const
+    {
+        // called from within a query, so it can't use the shared stack
+        const Node& node = m_nodes[index];
+        if (node.IsLeaf())
+        {
+            callback(index);
+            return;
+        }
+
+        ReportLeaves(node.child_a, callback);
+        ReportLeaves(node.child_b, callback);
+    }
+}
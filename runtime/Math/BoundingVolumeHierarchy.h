@@ -0,0 +1,85 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==========
+#include <vector>
+#include <functional>
+#include "BoundingBox.h"
+//=====================
+
+namespace Spartan::Math
+{
+    class Frustum;
+    class Ray;
+
+    // a dynamic aabb tree, leaves are inserted, moved and removed incrementally, so the tree never has to be rebuilt
+    // leaves are stored fattened by a margin, small movements don't touch the tree, and rotations keep it balanced
+    class SP_CLASS BoundingVolumeHierarchy
+    {
+    public:
+        static constexpr uint32_t node_invalid = std::numeric_limits<uint32_t>::max();
+
+        BoundingVolumeHierarchy() = default;
+        ~BoundingVolumeHierarchy() = default;
+
+        // returns the leaf, which identifies the box until it's removed, owners can map their data to it
+        uint32_t Insert(const BoundingBox& box);
+        void Remove(const uint32_t leaf);
+        void Update(const uint32_t leaf, const BoundingBox& box);
+        void Clear();
+
+        // the callbacks receive the leaves whose box passes the test
+        void QueryFrustum(const Frustum& frustum, const bool ignore_depth, const std::function<void(uint32_t leaf)>& callback) const;
+        void QueryRay(const Ray& ray, const std::function<void(uint32_t leaf, float distance)>& callback) const;
+        void QueryBox(const BoundingBox& box, const std::function<void(uint32_t leaf)>& callback) const;
+
+        uint32_t GetLeafCount() const { return m_leaf_count; }
+        uint32_t GetHeight() const    { return m_root == node_invalid ? 0 : static_cast<uint32_t>(m_nodes[m_root].height); }
+
+    private:
+        struct Node
+        {
+            BoundingBox box;       // fattened, for leaves
+            BoundingBox box_tight; // leaves only, what the queries test against
+            uint32_t parent  = node_invalid; // or the next free node
+            uint32_t child_a = node_invalid;
+            uint32_t child_b = node_invalid;
+            int32_t height   = -1;           // 0 for leaves, -1 for free nodes
+
+            bool IsLeaf() const { return child_a == node_invalid; }
+        };
+
+        uint32_t AllocateNode();
+        void FreeNode(const uint32_t index);
+        void InsertLeaf(const uint32_t leaf);
+        void RemoveLeaf(const uint32_t leaf);
+        void Refit(uint32_t index);
+        uint32_t Balance(const uint32_t index);
+        void ReportLeaves(const uint32_t index, const std::function<void(uint32_t leaf)>& callback) const;
+
+        std::vector<Node> m_nodes;
+        uint32_t m_root       = node_invalid;
+        uint32_t m_free       = node_invalid;
+        uint32_t m_leaf_count = 0;
+    };
+}
@@ -19,7 +19,7 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES =========================
+//= INCLUDES =============================
 #include "pch.h"
 #include "Profiler.h"
 #include "../RHI/RHI_Device.h"
@@ -28,8 +28,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_SwapChain.h"
 #include "../Core/ThreadPool.h"
 #include "../Rendering/Renderer.h"
+#include "../Rendering/TextureStreaming.h"
 #include "../Resource/ResourceCache.h"
-//====================================
+//========================================
 
 //= NAMESPACES =====
 using namespace std;
@@ -40,22 +41,22 @@ namespace Spartan
     ProfilerGranularity granularity = ProfilerGranularity::Light;
 
     // metrics - rhi
-    uint32_t Profiler::m_rhi_draw                       = 0;
-    uint32_t Profiler::m_rhi_bindings_buffer_index      = 0;
-    uint32_t Profiler::m_rhi_bindings_buffer_vertex     = 0;
-    uint32_t Profiler::m_rhi_bindings_buffer_constant   = 0;
-    uint32_t Profiler::m_rhi_bindings_buffer_structured = 0;
-    uint32_t Profiler::m_rhi_bindings_sampler           = 0;
-    uint32_t Profiler::m_rhi_bindings_texture_sampled   = 0;
-    uint32_t Profiler::m_rhi_bindings_shader_vertex     = 0;
-    uint32_t Profiler::m_rhi_bindings_shader_pixel      = 0;
-    uint32_t Profiler::m_rhi_bindings_shader_compute    = 0;
-    uint32_t Profiler::m_rhi_bindings_render_target     = 0;
-    uint32_t Profiler::m_rhi_bindings_texture_storage   = 0;
-    uint32_t Profiler::m_rhi_bindings_descriptor_set    = 0;
-    uint32_t Profiler::m_rhi_bindings_pipeline          = 0;
-    uint32_t Profiler::m_rhi_pipeline_barriers          = 0;
-    uint32_t Profiler::m_rhi_timeblock_count            = 0;
+    atomic<uint32_t> Profiler::m_rhi_draw                    = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_buffer_index   = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_buffer_vertex  = 0;
+    uint32_t Profiler::m_rhi_bindings_buffer_constant        = 0;
+    uint32_t Profiler::m_rhi_bindings_buffer_structured      = 0;
+    uint32_t Profiler::m_rhi_bindings_sampler                = 0;
+    uint32_t Profiler::m_rhi_bindings_texture_sampled        = 0;
+    uint32_t Profiler::m_rhi_bindings_shader_vertex          = 0;
+    uint32_t Profiler::m_rhi_bindings_shader_pixel           = 0;
+    uint32_t Profiler::m_rhi_bindings_shader_compute         = 0;
+    uint32_t Profiler::m_rhi_bindings_render_target          = 0;
+    uint32_t Profiler::m_rhi_bindings_texture_storage        = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_descriptor_set = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_pipeline       = 0;
+    uint32_t Profiler::m_rhi_pipeline_barriers               = 0;
+    uint32_t Profiler::m_rhi_timeblock_count                 = 0;
 
     // metrics - time
     float Profiler::m_time_frame_avg  = 0.0f;
@@ -481,6 +482,7 @@ namespace Spartan
         oss_metrics << endl << "GPU" << endl
             << "Name:\t\t\t"   << gpu_name << endl
             << "Memory:\t"     << gpu_memory_used << "/" << gpu_memory_available << " MB" << endl
+            << "Streamed:\t"   << TextureStreaming::GetMemoryUsage() / (1024 * 1024) << "/" << TextureStreaming::GetBudget() / (1024 * 1024) << " MB" << endl
             << "API:\t\t\t\t"  << RHI_Context::api_type_str << "\t" << gpu_api << endl
             << "Driver:\t\t"   << RHI_Device::GetPrimaryPhysicalDevice()->GetVendorName() << "\t\t" << gpu_driver << endl;
 
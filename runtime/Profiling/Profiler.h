@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ===================
 #include <string>
+#include <atomic>
 #include <vector>
 #include "TimeBlock.h"
 #include "../Core/Definitions.h"
@@ -66,10 +67,10 @@ namespace Spartan
         static bool IsCpuStuttering();
         static bool IsGpuStuttering();
         
-        // metrics - rhi
-        static uint32_t m_rhi_draw;
-        static uint32_t m_rhi_bindings_buffer_index;
-        static uint32_t m_rhi_bindings_buffer_vertex;
+        // metrics - rhi (the atomic ones are also incremented by threads recording secondary command lists)
+        static std::atomic<uint32_t> m_rhi_draw;
+        static std::atomic<uint32_t> m_rhi_bindings_buffer_index;
+        static std::atomic<uint32_t> m_rhi_bindings_buffer_vertex;
         static uint32_t m_rhi_bindings_buffer_constant;
         static uint32_t m_rhi_bindings_buffer_structured;
         static uint32_t m_rhi_bindings_sampler;
@@ -79,8 +80,8 @@ namespace Spartan
         static uint32_t m_rhi_bindings_shader_compute;
         static uint32_t m_rhi_bindings_render_target;
         static uint32_t m_rhi_bindings_texture_storage;
-        static uint32_t m_rhi_bindings_descriptor_set;
-        static uint32_t m_rhi_bindings_pipeline;
+        static std::atomic<uint32_t> m_rhi_bindings_descriptor_set;
+        static std::atomic<uint32_t> m_rhi_bindings_pipeline;
         static uint32_t m_rhi_pipeline_barriers;
         static uint32_t m_rhi_timeblock_count;
 
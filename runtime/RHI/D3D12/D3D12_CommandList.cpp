@@ -48,10 +48,11 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
-    RHI_CommandList::RHI_CommandList(const RHI_Queue_Type queue_type, const uint64_t swapchain_index, void* cmd_pool, const char* name)
+    RHI_CommandList::RHI_CommandList(const RHI_Queue_Type queue_type, const uint64_t swapchain_index, void* cmd_pool, const char* name, const bool is_secondary)
     {
         SP_ASSERT(cmd_pool != nullptr);
 
+        m_is_secondary          = is_secondary;
         m_queue_type            = queue_type;
         m_object_name           = name;
         m_rhi_cmd_pool_resource = cmd_pool;
@@ -124,7 +125,28 @@ namespace Spartan
         SP_ASSERT_MSG(false, "Function is not implemented");
     }
 
-    void RHI_CommandList::BeginRenderPass()
+    void RHI_CommandList::BeginSecondary(RHI_CommandList* cmd_list_primary)
+    {
+        SP_ASSERT_MSG(false, "Function is not implemented");
+    }
+
+    void RHI_CommandList::ExecuteSecondary(const vector<RHI_CommandList*>& cmd_lists_secondary)
+    {
+        SP_ASSERT_MSG(false, "Function is not implemented");
+    }
+
+    RHI_DynamicOffsets RHI_CommandList::GetDynamicOffsets()
+    {
+        SP_ASSERT_MSG(false, "Function is not implemented");
+        return RHI_DynamicOffsets();
+    }
+
+    void RHI_CommandList::SetDynamicOffsets(const RHI_DynamicOffsets& dynamic_offsets)
+    {
+        SP_ASSERT_MSG(false, "Function is not implemented");
+    }
+
+    void RHI_CommandList::BeginRenderPass(const bool contents_secondary /*= false*/)
     {
         SP_ASSERT_MSG(false, "Function is not implemented");
     }
@@ -181,6 +203,16 @@ namespace Spartan
         Profiler::m_rhi_draw++;
     }
   
+    void RHI_CommandList::DrawIndexedIndirect(RHI_StructuredBuffer* args, const uint32_t args_offset, const uint32_t draw_count)
+    {
+        SP_ASSERT_MSG(false, "Function is not implemented");
+    }
+
+    void RHI_CommandList::DrawIndexedIndirectCount(RHI_StructuredBuffer* args, const uint32_t args_offset, RHI_StructuredBuffer* count, const uint32_t count_offset, const uint32_t draw_count_max)
+    {
+        SP_ASSERT_MSG(false, "Function is not implemented");
+    }
+
     void RHI_CommandList::Dispatch(uint32_t x, uint32_t y, uint32_t z, bool async /*= false*/)
     {
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
@@ -248,6 +280,11 @@ namespace Spartan
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
     }
 
+    void RHI_CommandList::SetBufferVertex(const RHI_StructuredBuffer* buffer, const uint32_t binding /*= 0*/)
+    {
+        SP_ASSERT_MSG(false, "Function is not implemented");
+    }
+
     void RHI_CommandList::SetBufferVertex(const RHI_VertexBuffer* buffer, const uint32_t binding /*= 0*/)
     {
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
@@ -361,6 +398,11 @@ namespace Spartan
         SP_ASSERT_MSG(false, "Function is not implemented");
     }
 
+    void RHI_CommandList::FlushBarriers()
+    {
+
+    }
+
     void RHI_CommandList::InsertMemoryBarrierImage(void* image, const uint32_t aspect_mask,
         const uint32_t mip_index, const uint32_t mip_range, const uint32_t array_length,
         const RHI_Image_Layout layout_old, const RHI_Image_Layout layout_new
@@ -383,4 +425,14 @@ namespace Spartan
     {
 
     }
+
+    void RHI_CommandList::InsertMemoryBarrierWaitForCompute()
+    {
+
+    }
+
+    void RHI_CommandList::InsertMemoryBarrierAliasing()
+    {
+
+    }
 }
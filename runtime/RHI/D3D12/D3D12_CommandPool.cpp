@@ -53,4 +53,10 @@ namespace Spartan
     {
         return false;
     }
+
+    RHI_CommandList* RHI_CommandPool::AcquireSecondaryCommandList()
+    {
+        SP_ASSERT_MSG(false, "Function is not implemented");
+        return nullptr;
+    }
 }
@@ -306,7 +306,17 @@ namespace Spartan
         }
     }
 
-    void RHI_Device::UpdateBindlessResources(const array<shared_ptr<RHI_Sampler>, static_cast<uint32_t>(Renderer_Sampler::Max)>* samplers, array<RHI_Texture*, rhi_max_array_size>* textures)
+    void RHI_Device::UpdateBindlessResources(const array<shared_ptr<RHI_Sampler>, static_cast<uint32_t>(Renderer_Sampler::Max)>* samplers, array<RHI_Texture*, rhi_max_array_size>* textures, const uint32_t texture_index, const uint32_t texture_count)
+    {
+
+    }
+
+    void* RHI_Device::MemoryAliasCreate(const vector<RHI_Texture*>& textures, const char* name)
+    {
+        return nullptr;
+    }
+
+    void RHI_Device::MemoryAliasDestroy(void*& memory)
     {
 
     }
@@ -31,7 +31,7 @@ using namespace std;
 
 namespace Spartan
 {
-    RHI_StructuredBuffer::RHI_StructuredBuffer(const uint32_t stride, const uint32_t element_count, const char* name)
+    RHI_StructuredBuffer::RHI_StructuredBuffer(const uint32_t stride, const uint32_t element_count, const char* name, const bool is_mappable, const void* data_initial)
     {
 
     }
@@ -41,7 +41,12 @@ namespace Spartan
 
     }
 
-    void RHI_StructuredBuffer::Update(void* data_cpu)
+    void RHI_StructuredBuffer::Update(void* data_cpu, const uint32_t size)
+    {
+        SP_ASSERT_MSG(false, "Not implemented");
+    }
+
+    void RHI_StructuredBuffer::UpdateRange(void* data_cpu, const uint32_t offset, const uint32_t size)
     {
         SP_ASSERT_MSG(false, "Not implemented");
     }
@@ -44,6 +44,13 @@ namespace Spartan
     {
         SP_ASSERT_MSG(m_state == RHI_CommandListState::Submitted, "The command list hasn't been submitted, can't wait for it.");
 
+        // secondary command lists are executed by a primary, which has already been waited for
+        if (m_is_secondary)
+        {
+            m_state = RHI_CommandListState::Idle;
+            return;
+        }
+
         // Wait for execution to finish
         if (IsExecuting())
         {
@@ -62,6 +69,7 @@ namespace Spartan
     bool RHI_CommandList::IsExecuting()
     {
         return
+            !m_is_secondary &&                            // it's executed by a primary
             m_state == RHI_CommandListState::Submitted && // it has been submitted
             !m_proccessed_fence->IsSignaled();            // and the fence is not signaled yet
     }
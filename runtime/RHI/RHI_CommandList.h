@@ -44,10 +44,34 @@ namespace Spartan
         Submitted
     };
 
+    // the dynamic offsets of a descriptor set, captured so that a draw can be recorded later (and by any thread)
+    struct RHI_DynamicOffsets
+    {
+        std::array<uint32_t, 10> offsets = {};
+        uint32_t count                   = 0;
+
+        bool operator==(const RHI_DynamicOffsets& rhs) const
+        {
+            return count == rhs.count && std::equal(offsets.begin(), offsets.begin() + count, rhs.offsets.begin());
+        }
+    };
+
+    // an image layout transition which waits to be recorded together with the rest of the transitions of a pass
+    struct RHI_ImageBarrier
+    {
+        void* image                 = nullptr;
+        uint32_t aspect_mask        = 0;
+        uint32_t mip_index          = 0;
+        uint32_t mip_range          = 0;
+        uint32_t array_length       = 0;
+        RHI_Image_Layout layout_old = RHI_Image_Layout::Max;
+        RHI_Image_Layout layout_new = RHI_Image_Layout::Max;
+    };
+
     class SP_CLASS RHI_CommandList : public SpObject
     {
     public:
-        RHI_CommandList(const RHI_Queue_Type queue_type, const uint64_t swapchain_id, void* cmd_pool_resource, const char* name);
+        RHI_CommandList(const RHI_Queue_Type queue_type, const uint64_t swapchain_id, void* cmd_pool_resource, const char* name, const bool is_secondary = false);
         ~RHI_CommandList();
 
         void Begin();
@@ -56,6 +80,15 @@ namespace Spartan
         void WaitForExecution();
         void SetPipelineState(RHI_PipelineState& pso);
 
+        // secondary command lists
+        // begin inherits the pipeline state and the render targets of the primary, it has to be called from the main thread
+        // recording can then happen from any thread, and execution is done by the primary, from the main thread again
+        void BeginSecondary(RHI_CommandList* cmd_list_primary);
+        void ExecuteSecondary(const std::vector<RHI_CommandList*>& cmd_lists_secondary);
+        RHI_DynamicOffsets GetDynamicOffsets();
+        void SetDynamicOffsets(const RHI_DynamicOffsets& dynamic_offsets);
+        bool IsSecondary() const { return m_is_secondary; }
+
         // clear
         void ClearPipelineStateRenderTargets(RHI_PipelineState& pipeline_state);
         void ClearRenderTarget(
@@ -72,6 +105,10 @@ namespace Spartan
         void Draw(const uint32_t vertex_count, const uint32_t vertex_start_index = 0);
         void DrawIndexed(const uint32_t index_count, const uint32_t index_offset = 0, const uint32_t vertex_offset = 0, const uint32_t instance_start_index = 0, const uint32_t instance_count = 1);
 
+        // indirect draw, the arguments are RHI_IndirectDrawArgsIndexed structs (and the count is a uint32_t) written by the gpu
+        void DrawIndexedIndirect(RHI_StructuredBuffer* args, const uint32_t args_offset, const uint32_t draw_count = 1);
+        void DrawIndexedIndirectCount(RHI_StructuredBuffer* args, const uint32_t args_offset, RHI_StructuredBuffer* count, const uint32_t count_offset, const uint32_t draw_count_max);
+
         // dispatch
         void Dispatch(uint32_t x, uint32_t y, uint32_t z = 1, bool async = false);
 
@@ -94,6 +131,7 @@ namespace Spartan
         
         // vertex buffer
         void SetBufferVertex(const RHI_VertexBuffer* buffer, const uint32_t binding = 0);
+        void SetBufferVertex(const RHI_StructuredBuffer* buffer, const uint32_t binding = 0);
         
         // index buffer
         void SetBufferIndex(const RHI_IndexBuffer* buffer);
@@ -118,6 +156,7 @@ namespace Spartan
 
         // structured buffer
         void SetStructuredBuffer(const uint32_t slot, RHI_StructuredBuffer* structured_buffer) const;
+        void SetStructuredBuffer(const Renderer_BindingsUav slot,                       RHI_StructuredBuffer*  structured_buffer) const { SetStructuredBuffer(static_cast<uint32_t>(slot), structured_buffer); }
         void SetStructuredBuffer(const Renderer_BindingsUav slot, const std::shared_ptr<RHI_StructuredBuffer>& structured_buffer) const { SetStructuredBuffer(static_cast<uint32_t>(slot), structured_buffer.get()); }
 
         // markers
@@ -138,12 +177,17 @@ namespace Spartan
         bool IsExecuting();
 
         // memory Barriers
+        // image barriers are deferred and recorded in a single call before the next command which needs them,
+        // anything which records commands to the rhi resource directly has to flush them first
+        void FlushBarriers();
         void InsertMemoryBarrierImage(void* image, const uint32_t aspect_mask, const uint32_t mip_index, const uint32_t mip_range, const uint32_t array_length, const RHI_Image_Layout layout_old, const RHI_Image_Layout layout_new);
         void InsertMemoryBarrierImage(RHI_Texture* texture, const uint32_t mip_start, const uint32_t mip_range, const uint32_t array_length, const RHI_Image_Layout layout_old, const RHI_Image_Layout layout_new);
         void InsertMemoryBarrierImageWaitForWrite(RHI_Texture* texture);
         void InsertMemoryBarrierBufferWaitForWrite(void* buffer);
         void InsertMemoryBarrierBufferWaitForWrite(RHI_VertexBuffer* buffer);
         void InsertMemoryBarrierBufferWaitForWrite(RHI_IndexBuffer* buffer);
+        void InsertMemoryBarrierWaitForCompute(); // compute shader buffer writes vs. compute, vertex and indirect argument reads (both ways)
+        void InsertMemoryBarrierAliasing();       // everything before vs. everything after, for textures which take over memory that other textures used
 
         // misc
         RHI_Semaphore* GetSemaphoreProccessed() { return m_proccessed_semaphore.get(); }
@@ -151,7 +195,7 @@ namespace Spartan
 
     private:
         void OnPreDrawDispatch();
-        void BeginRenderPass();
+        void BeginRenderPass(const bool contents_secondary = false);
         void EndRenderPass();
 
         // sync
@@ -180,6 +224,12 @@ namespace Spartan
         static bool m_memory_query_support;
         std::mutex m_mutex_reset;
         RHI_PipelineState m_pso;
+        std::vector<RHI_ImageBarrier> m_barriers_pending;
+
+        // secondary
+        bool m_is_secondary                  = false;
+        void* m_descriptor_set_secondary     = nullptr;
+        RHI_DynamicOffsets m_dynamic_offsets;
 
         // rhi resources
         void* m_rhi_resource          = nullptr;
@@ -26,6 +26,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "RHI_Definitions.h"
 #include "RHI_CommandList.h"
 #include <array>
+#include <vector>
 //============================
 
 namespace Spartan
@@ -41,11 +42,20 @@ namespace Spartan
         RHI_CommandList* GetCurrentCommandList()       { return m_using_pool_a ? m_cmd_lists_0[m_index].get() : m_cmd_lists_1[m_index].get(); }
         uint64_t GetSwapchainId()                const { return m_swap_chain_id; }
 
+        // returns a secondary command list which can be recorded from any thread (the acquisition itself is main thread only)
+        // they live for as long as the primary command lists of the current pool, each one comes with its own rhi pool
+        RHI_CommandList* AcquireSecondaryCommandList();
+
     private:
         std::array<std::shared_ptr<RHI_CommandList>, 2> m_cmd_lists_0;
         std::array<std::shared_ptr<RHI_CommandList>, 2> m_cmd_lists_1;
         std::array<void*, 2> m_rhi_resources;
 
+        // secondary command lists, per pool
+        std::array<std::vector<std::shared_ptr<RHI_CommandList>>, 2> m_cmd_lists_secondary;
+        std::array<std::vector<void*>, 2> m_rhi_resources_secondary;
+        std::array<uint32_t, 2> m_index_secondary = { 0, 0 };
+
         uint32_t m_index            = 0;
         bool m_using_pool_a         = true;
         bool m_first_tick           = true;
@@ -192,6 +192,9 @@ namespace Spartan
         D32_Float,
         D32_Float_S8X24_Uint,
         // Compressed
+        BC1,
+        BC4,
+        BC5,
         BC7,
         ASTC,
         // Surface
@@ -286,6 +289,7 @@ namespace Spartan
         Transfer_Source,
         Transfer_Destination,
         Present_Source,
+        Undefined, // the content can be discarded, e.g. memory which another texture used in the meantime
         Max
     };
 
@@ -311,6 +315,16 @@ namespace Spartan
         textures_material
     };
 
+    // the layout matches VkDrawIndexedIndirectCommand and D3D12_DRAW_INDEXED_ARGUMENTS, it's also written by shaders (see instance_culling.hlsl)
+    struct RHI_IndirectDrawArgsIndexed
+    {
+        uint32_t index_count     = 0;
+        uint32_t instance_count  = 0;
+        uint32_t index_offset    = 0;
+        int32_t vertex_offset    = 0;
+        uint32_t instance_offset = 0;
+    };
+
     static uint64_t rhi_hash_combine(uint64_t seed, uint64_t x)
     {
         // xxHash is probably the best hashing lib out there.
@@ -399,6 +413,9 @@ namespace Spartan
             case RHI_Format::R32G32B32A32_Float:   return "RHI_Format_R32G32B32A32_Float";
             case RHI_Format::D32_Float:            return "RHI_Format_D32_Float";
             case RHI_Format::D32_Float_S8X24_Uint: return "RHI_Format_D32_Float_S8X24_Uint";
+            case RHI_Format::BC1:                  return "RHI_Format_BC1";
+            case RHI_Format::BC4:                  return "RHI_Format_BC4";
+            case RHI_Format::BC5:                  return "RHI_Format_BC5";
             case RHI_Format::BC7:                  return "RHI_Format_BC7";
             case RHI_Format::Max:            return "RHI_Format_Undefined";
         }
@@ -412,6 +429,27 @@ namespace Spartan
         return static_cast<uint32_t>(format);
     }
 
+    static bool rhi_format_is_compressed(const RHI_Format format)
+    {
+        return format == RHI_Format::BC1 || format == RHI_Format::BC4 || format == RHI_Format::BC5 || format == RHI_Format::BC7 || format == RHI_Format::ASTC;
+    }
+
+    // the bytes of a 4x4 block, for block compressed formats
+    static uint32_t rhi_format_to_block_size(const RHI_Format format)
+    {
+        switch (format)
+        {
+            case RHI_Format::BC1:  return 8;
+            case RHI_Format::BC4:  return 8;
+            case RHI_Format::BC5:  return 16;
+            case RHI_Format::BC7:  return 16;
+            case RHI_Format::ASTC: return 16;
+        }
+
+        assert(false && "Unsupported format");
+        return 0;
+    }
+
     // shader register slot shifts (required to produce spirv from hlsl)
     // 000-099 is push constant buffer range
     const uint32_t rhi_shader_shift_register_u   = 100;
@@ -53,7 +53,7 @@ namespace Spartan
         static std::unordered_map<uint64_t, RHI_DescriptorSet>& GetDescriptorSets();
         static void* GetDescriptorSet(const RHI_Device_Resource resource_type);
         static void* GetDescriptorSetLayout(const RHI_Device_Resource resource_type);
-        static void UpdateBindlessResources(const std::array<std::shared_ptr<RHI_Sampler>, static_cast<uint32_t>(Renderer_Sampler::Max)>* samplers, std::array<RHI_Texture*, rhi_max_array_size>* textures);
+        static void UpdateBindlessResources(const std::array<std::shared_ptr<RHI_Sampler>, static_cast<uint32_t>(Renderer_Sampler::Max)>* samplers, std::array<RHI_Texture*, rhi_max_array_size>* textures, const uint32_t texture_index = 0, const uint32_t texture_count = rhi_max_array_size);
 
         // Pipelines
         static void GetOrCreatePipeline(RHI_PipelineState& pso, RHI_Pipeline*& pipeline, RHI_DescriptorSetLayout*& descriptor_set_layout);
@@ -75,6 +75,8 @@ namespace Spartan
         static void MemoryBufferDestroy(void*& resource);
         static void MemoryTextureCreate(RHI_Texture* texture);
         static void MemoryTextureDestroy(void*& resource);
+        static void* MemoryAliasCreate(const std::vector<RHI_Texture*>& textures, const char* name); // null if the textures can't share memory
+        static void MemoryAliasDestroy(void*& memory);
         static void MemoryMap(void* resource, void*& mapped_data);
         static void MemoryUnmap(void* resource);
         static uint32_t MemoryGetUsageMb();
@@ -264,14 +264,7 @@ namespace Spartan
     public:
         static IDxcResult* Compile(const std::string& source, std::vector<std::string>& arguments)
         {
-            // Initialise (only happens once)
-            static IDxcUtils* m_utils        = nullptr;
-            static IDxcCompiler3* m_compiler = nullptr;
-            if (!m_compiler)
-            {
-                DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&m_compiler));
-                DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&m_utils));
-            }
+            Initialize();
 
             // Get shader source
             DxcBuffer dxc_buffer = {};
@@ -335,5 +328,37 @@ namespace Spartan
 
             return dxc_result;
         }
+
+        // part of the key of the compiled shader cache, so that a compiler update invalidates it
+        static std::string GetVersion()
+        {
+            Initialize();
+
+            uint32_t major = 0;
+            uint32_t minor = 0;
+            IDxcVersionInfo* version_info = nullptr;
+            if (m_compiler && SUCCEEDED(m_compiler->QueryInterface(IID_PPV_ARGS(&version_info))))
+            {
+                version_info->GetVersion(&major, &minor);
+                version_info->Release();
+            }
+
+            return std::to_string(major) + "." + std::to_string(minor);
+        }
+
+    private:
+        // only happens once
+        static void Initialize()
+        {
+            static std::once_flag flag;
+            std::call_once(flag, []()
+            {
+                DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&m_compiler));
+                DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&m_utils));
+            });
+        }
+
+        static inline IDxcUtils* m_utils        = nullptr;
+        static inline IDxcCompiler3* m_compiler = nullptr;
     };
 }
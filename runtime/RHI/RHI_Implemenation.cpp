@@ -41,6 +41,7 @@ namespace Spartan
     VkInstance       RHI_Context::instance        = nullptr;
     VkPhysicalDevice RHI_Context::device_physical = nullptr;
     VkDevice         RHI_Context::device          = nullptr;
+    VkPipelineCache  RHI_Context::pipeline_cache  = nullptr;
 
     vector<VkValidationFeatureEnableEXT> RHI_Context::validation_extensions;
     vector<const char*> RHI_Context::extensions_instance = { "VK_KHR_surface", "VK_KHR_win32_surface", "VK_EXT_swapchain_colorspace" };
@@ -82,6 +82,9 @@ static const DXGI_FORMAT d3d12_format[] =
     DXGI_FORMAT_D32_FLOAT,
     DXGI_FORMAT_D32_FLOAT_S8X24_UINT,
     // Compressed
+    DXGI_FORMAT_BC1_UNORM,
+    DXGI_FORMAT_BC4_UNORM,
+    DXGI_FORMAT_BC5_UNORM,
     DXGI_FORMAT_BC7_UNORM,
     DXGI_FORMAT_UNKNOWN,
     // Surface
@@ -216,6 +219,9 @@ static const VkFormat vulkan_format[] =
     VK_FORMAT_D32_SFLOAT,
     VK_FORMAT_D32_SFLOAT_S8_UINT,
     // Compressed
+    VK_FORMAT_BC1_RGB_UNORM_BLOCK,
+    VK_FORMAT_BC4_UNORM_BLOCK,
+    VK_FORMAT_BC5_UNORM_BLOCK,
     VK_FORMAT_BC7_UNORM_BLOCK,
     VK_FORMAT_UNDEFINED,
     // Surface
@@ -332,6 +338,7 @@ static const VkImageLayout vulkan_image_layout[] =
     VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
     VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+    VK_IMAGE_LAYOUT_UNDEFINED,
     VK_IMAGE_LAYOUT_UNDEFINED
 };
 
@@ -401,6 +408,7 @@ namespace Spartan
             static VkInstance instance;
             static VkDevice device;
             static VkPhysicalDevice device_physical;
+            static VkPipelineCache pipeline_cache;
             static std::vector<VkValidationFeatureEnableEXT> validation_extensions;
             static std::vector<const char*> extensions_instance;
             static std::vector<const char*> validation_layers;
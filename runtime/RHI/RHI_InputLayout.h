@@ -110,13 +110,13 @@ namespace Spartan
             {
                 m_vertex_attributes =
                 {
-                    { "POSITION", 0, binding, RHI_Format::R32G32B32_Float, offsetof(RHI_Vertex_PosTexNorTan, pos) },
-                    { "TEXCOORD", 1, binding, RHI_Format::R32G32_Float,    offsetof(RHI_Vertex_PosTexNorTan, tex) },
-                    { "NORMAL",   2, binding, RHI_Format::R32G32B32_Float, offsetof(RHI_Vertex_PosTexNorTan, nor) },
-                    { "TANGENT",  3, binding, RHI_Format::R32G32B32_Float, offsetof(RHI_Vertex_PosTexNorTan, tan) }
+                    // the packed layout which meshes upload, the fetch expands it to what the shaders declare
+                    { "POSITION", 0, binding, RHI_Format::R32G32B32_Float,    offsetof(RHI_Vertex_PosTexNorTanPacked, pos) },
+                    { "TEXCOORD", 1, binding, RHI_Format::R16G16_Float,       offsetof(RHI_Vertex_PosTexNorTanPacked, tex) },
+                    { "NORMAL",   2, binding, RHI_Format::R16G16B16A16_Snorm, offsetof(RHI_Vertex_PosTexNorTanPacked, nor_tan) }
                 };
 
-                m_vertex_size = sizeof(RHI_Vertex_PosTexNorTan);
+                m_vertex_size = sizeof(RHI_Vertex_PosTexNorTanPacked);
             }
         }
 
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "RHI_Shader.h"
 #include "RHI_InputLayout.h"
 #include "../Core/ThreadPool.h"
+#include "../IO/FileStream.h"
 //=============================
 
 //= NAMESPACES =====
@@ -34,6 +35,9 @@ namespace Spartan
 {
     namespace
     {
+        const char* cache_directory  = "shader_cache/";
+        const uint32_t cache_version = 1; // bump when the layout of the cache files changes
+
         static void log_compilation_result(
             const RHI_Shader_Stage shader_stage,
             const unordered_map<string, string>& defines,
@@ -265,4 +269,95 @@ namespace Spartan
 
         return nullptr;
     }
+
+    uint64_t RHI_Shader::GetCacheKey(const vector<string>& arguments, const string& compiler_version) const
+    {
+        // the preprocessed source contains the includes, so changing any of them changes the key
+        // the arguments contain the stage, the entry point, the defines and the optimization level
+        hash<string> hasher;
+        uint64_t key = rhi_hash_combine(static_cast<uint64_t>(cache_version), static_cast<uint64_t>(hasher(m_preprocessed_source)));
+        key          = rhi_hash_combine(key, static_cast<uint64_t>(hasher(compiler_version)));
+        for (const string& argument : arguments)
+        {
+            key = rhi_hash_combine(key, static_cast<uint64_t>(hasher(argument)));
+        }
+
+        return key;
+    }
+
+    string RHI_Shader::GetCacheFilePath() const
+    {
+        // one file per variant, so that a recompilation overwrites the stale one instead of adding another
+        vector<pair<string, string>> defines(m_defines.begin(), m_defines.end());
+        sort(defines.begin(), defines.end());
+
+        hash<string> hasher;
+        uint64_t variant = static_cast<uint64_t>(m_shader_type);
+        for (const auto& define : defines)
+        {
+            variant = rhi_hash_combine(variant, static_cast<uint64_t>(hasher(define.first)));
+            variant = rhi_hash_combine(variant, static_cast<uint64_t>(hasher(define.second)));
+        }
+
+        char variant_str[17];
+        snprintf(variant_str, sizeof(variant_str), "%016llx", static_cast<unsigned long long>(variant));
+
+        return string(cache_directory) + m_object_name + "_" + variant_str + ".bin";
+    }
+
+    bool RHI_Shader::LoadFromCache(const uint64_t key, vector<byte>& bytecode)
+    {
+        const string file_path = GetCacheFilePath();
+        if (!FileSystem::IsFile(file_path))
+            return false;
+
+        FileStream file(file_path, FileStream_Read);
+        if (!file.IsOpen() || file.ReadAs<uint64_t>() != key)
+            return false;
+
+        file.Read(&bytecode);
+
+        m_descriptors.resize(file.ReadAs<uint32_t>());
+        for (RHI_Descriptor& descriptor : m_descriptors)
+        {
+            file.Read(&descriptor.name);
+            descriptor.type   = static_cast<RHI_Descriptor_Type>(file.ReadAs<uint32_t>());
+            descriptor.layout = static_cast<RHI_Image_Layout>(file.ReadAs<uint32_t>());
+            file.Read(&descriptor.slot);
+            file.Read(&descriptor.stage);
+            file.Read(&descriptor.struct_size);
+            file.Read(&descriptor.as_array);
+            file.Read(&descriptor.array_length);
+        }
+
+        return !bytecode.empty();
+    }
+
+    void RHI_Shader::SaveToCache(const uint64_t key, const vector<byte>& bytecode) const
+    {
+        if (!FileSystem::Exists(cache_directory))
+        {
+            FileSystem::CreateDirectory(cache_directory);
+        }
+
+        FileStream file(GetCacheFilePath(), FileStream_Write);
+        if (!file.IsOpen())
+            return;
+
+        file.Write(key);
+        file.Write(bytecode);
+
+        file.Write(static_cast<uint32_t>(m_descriptors.size()));
+        for (const RHI_Descriptor& descriptor : m_descriptors)
+        {
+            file.Write(descriptor.name);
+            file.Write(static_cast<uint32_t>(descriptor.type));
+            file.Write(static_cast<uint32_t>(descriptor.layout));
+            file.Write(descriptor.slot);
+            file.Write(descriptor.stage);
+            file.Write(descriptor.struct_size);
+            file.Write(descriptor.as_array);
+            file.Write(descriptor.array_length);
+        }
+    }
 }
@@ -79,6 +79,12 @@ namespace Spartan
         void* RHI_Compile();
         void Reflect(const RHI_Shader_Stage shader_type, const uint32_t* ptr, uint32_t size);
 
+        // compiled shader cache, the bytecode and the reflected descriptors are kept on the drive, one file per shader variant
+        uint64_t GetCacheKey(const std::vector<std::string>& arguments, const std::string& compiler_version) const;
+        std::string GetCacheFilePath() const;
+        bool LoadFromCache(const uint64_t key, std::vector<std::byte>& bytecode);
+        void SaveToCache(const uint64_t key, const std::vector<std::byte>& bytecode) const;
+
         std::string m_file_path;
         std::string m_preprocessed_source;
         std::vector<std::string> m_names;               // The names of the files from the include directives in the shader
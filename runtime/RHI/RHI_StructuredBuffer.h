@@ -30,13 +30,17 @@ namespace Spartan
     class RHI_StructuredBuffer : public SpObject
     {
     public:
-        RHI_StructuredBuffer(const uint32_t stride, const uint32_t element_count, const char* name);
+        // mappable buffers are updated by the cpu (using dynamic offsets), the rest live in gpu memory, are written by shaders and can
+        // also be used as vertex buffers or as indirect argument buffers, initial data (if any) is uploaded through a staging buffer
+        RHI_StructuredBuffer(const uint32_t stride, const uint32_t element_count, const char* name, const bool is_mappable = true, const void* data_initial = nullptr);
         ~RHI_StructuredBuffer();
 
-        void Update(void* data);
+        void Update(void* data, const uint32_t size = 0); // the size of the data, if less than the stride (0 for the full stride)
+        void UpdateRange(void* data, const uint32_t offset, const uint32_t size); // writes part of the current element, without advancing to the next one
         void ResetOffset()           { m_offset = 0; first_update = true; }
         uint32_t GetStride()   const { return m_stride; }
         uint32_t GetOffset()   const { return m_offset; }
+        bool IsMappable()      const { return m_mapped_data != nullptr; }
         void* GetRhiResource() const { return m_rhi_resource; }
 
     private:
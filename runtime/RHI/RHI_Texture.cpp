@@ -23,8 +23,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "pch.h"
 #include "RHI_Texture.h"
 #include "RHI_Device.h"
+#include "../Core/ThreadPool.h"
 #include "../IO/FileStream.h"
+#include "../IO/AssetArchive.h"
 #include "../Rendering/Renderer.h"
+#include "../Rendering/MipGenerator.h"
 #include "../Resource/Import/ImageImporterExporter.h"
 SP_WARNINGS_OFF
 #include "compressonator.h"
@@ -80,6 +83,15 @@ namespace Spartan
             if (format == RHI_Format::ASTC)
                 return CMP_FORMAT::CMP_FORMAT_ASTC;
 
+            if (format == RHI_Format::BC1)
+                return CMP_FORMAT::CMP_FORMAT_BC1;
+
+            if (format == RHI_Format::BC4)
+                return CMP_FORMAT::CMP_FORMAT_BC4;
+
+            if (format == RHI_Format::BC5)
+                return CMP_FORMAT::CMP_FORMAT_BC5;
+
             if (format == RHI_Format::BC7)
                 return CMP_FORMAT::CMP_FORMAT_BC7;
 
@@ -87,102 +99,105 @@ namespace Spartan
             return CMP_FORMAT::CMP_FORMAT_Unknown;
         }
 
-        void generate_mips(RHI_Texture* texture)
+        // greyscale textures keep a single channel (the views read it as rgb), normal maps keep x and y (the shaders reconstruct z)
+        // transparent textures need the alpha of bc7, and the rest is opaque colour (or packed masks), for which bc1 is enough
+        RHI_Format get_compressed_format(const RHI_Texture* texture)
         {
-            /*
-            for (uint32_t index_array = 0; index_array < texture->GetArrayLength(); index_array++)
-            {
-                for (uint32_t index_mip = 0; index_mip < texture->GetMipCount() - 1; index_mip++)
-                {
-                    CMP_MipSet source   = {};
-                    source.m_nMipLevels = 1;
-                    source.m_nWidth     = texture->GetWidth() >> index_mip;
-                    source.m_nHeight    = texture->GetHeight() >> index_mip;
-                    source.m_format     = rhi_format_to_compressonator_format(texture->GetFormat());
-
-                    CMP_MipLevel* sourceMip   = new CMP_MipLevel;
-                    sourceMip->m_nWidth       = source.m_nWidth;
-                    sourceMip->m_nHeight      = source.m_nHeight;
-                    sourceMip->m_dwLinearSize = source.m_nWidth * source.m_nHeight * texture->GetChannelCount();
-                    sourceMip->m_pbData       = reinterpret_cast<CMP_BYTE*>(texture->GetData()[index_array].mips[index_mip].bytes.data());
-                    source.m_pMipLevelTable   = reinterpret_cast<CMP_MipLevelTable*>(sourceMip);
-
-                    CMP_MipSet destination = {};
-                    destination.m_nWidth   = source.m_nWidth >> 1;
-                    destination.m_nHeight  = source.m_nHeight >> 1;
-                    destination.m_format   = source.m_format;
-
-                    CMP_MipLevel* destMip   = new CMP_MipLevel;
-                    destMip->m_nWidth       = destination.m_nWidth;
-                    destMip->m_nHeight      = destination.m_nHeight;
-                    destMip->m_dwLinearSize = destination.m_nWidth * destination.m_nHeight * texture->GetChannelCount();
-
-                    // allocate data for the destination mipmap
-                    texture->GetData()[index_array].mips[index_mip + 1].bytes.resize(destMip->m_dwLinearSize);
-                    destMip->m_pbData = reinterpret_cast<CMP_BYTE*>(texture->GetData()[index_array].mips[index_mip + 1].bytes.data());
-                    destination.m_pMipLevelTable = reinterpret_cast<CMP_MipLevelTable*>(destMip);
-
-                    // use the source to generate the destination mip level
-                    CMP_GenerateMIPLevels(&destination, destination.m_nWidth);
-
-                    // clean up for this iteration
-                    delete source.m_pMipLevelTable;
-                    delete destination.m_pMipLevelTable;
-                }
-            }
-            */
+            if (texture->IsGrayscale() && !texture->IsTransparent())
+                return RHI_Format::BC4;
+
+            if (texture->GetFlags() & RHI_Texture_NormalMap)
+                return RHI_Format::BC5;
+
+            if (texture->IsTransparent())
+                return RHI_Format::BC7;
+
+            return RHI_Format::BC1;
+        }
+
+        bool can_compress(const RHI_Texture* texture)
+        {
+            // the blocks are 4x4, and some apis require the top mip to be made of whole blocks
+            return texture->GetFormat() == RHI_Format::R8G8B8A8_Unorm && texture->GetWidth() % 4 == 0 && texture->GetHeight() % 4 == 0;
         }
 
-        void compress(RHI_Texture* texture)
+        bool compress(RHI_Texture* texture, const RHI_Format format)
         {
-            /*
-            KernelOptions options;
-            options.height        = texture->GetHeight();
-            options.width         = texture->GetWidth();
-            options.fquality      = 1.0f;
-            options.format        = rhi_format_to_compressonator_format(texture->GetFormat());
-            options.srcformat     = CMP_FORMAT_BC7;
-            options.encodeWith    = CMP_Compute_type::CMP_GPU_HW;
-            options.threads       = 0;
-            options.genGPUMipMaps = true;
-            options.miplevels     = texture->GetMipCount();
-
-            for (uint32_t index_array = 0; index_array < texture->GetArrayLength(); index_array++)
+            // every mip of every slice is compressed on its own, so they are spread across the thread pool
+            vector<pair<uint32_t, uint32_t>> mips; // array index, mip index
+            for (uint32_t array_index = 0; array_index < texture->GetArrayLength(); array_index++)
             {
-                CMP_MipSet source                         = {};
-                source.m_nMipLevels                       = 1;
-                source.m_nWidth                           = texture->GetWidth();
-                source.m_nHeight                          = texture->GetHeight();
-                source.m_format                           = rhi_format_to_compressonator_format(texture->GetFormat());
-                source.m_pMipLevelTable                   = new CMP_MipLevel[1];
-                source.m_pMipLevelTable[0].m_nWidth       = source.m_nWidth;
-                source.m_pMipLevelTable[0].m_nHeight      = source.m_nHeight;
-                source.m_pMipLevelTable[0].m_dwLinearSize = source.m_nWidth * source.m_nHeight * texture->GetChannelCount();
-                source.m_pMipLevelTable[0].m_pbData       = reinterpret_cast<CMP_BYTE*>(texture->GetData()[index_array].mips[0].bytes.data());
-
-                CMP_MipSet destination       = {};
-                destination.m_nWidth         = source.m_nWidth;
-                destination.m_nHeight        = source.m_nHeight;
-                destination.m_format         = source.m_format;
-                destination.m_pMipLevelTable = new CMP_MipLevel[texture->GetMipCount()];
-
-                for (uint32_t mip_index = 0; mip_index < texture->GetMipCount(); mip_index++)
+                for (uint32_t mip_index = 0; mip_index < texture->GetSlice(array_index).GetMipCount(); mip_index++)
                 {
-                    destination.m_pMipLevelTable[mip_index].m_pbData = reinterpret_cast<CMP_BYTE*>(texture->GetData()[index_array].mips[mip_index].bytes.data());
+                    mips.emplace_back(array_index, mip_index);
                 }
+            }
 
-                if (CMP_CompressTexture(&options, source, destination, nullptr) != CMP_OK)
+            vector<vector<std::byte>> mips_compressed(mips.size());
+            atomic<bool> failed = false;
+            ThreadPool::ParallelFor([&](uint32_t work_index_start, uint32_t work_index_end)
+            {
+                for (uint32_t i = work_index_start; i < work_index_end; i++)
                 {
-                    SP_LOG_ERROR("Failed to compress texture");
+                    RHI_Texture_Mip& mip  = texture->GetMip(mips[i].first, mips[i].second);
+                    const uint32_t width  = max(texture->GetWidth()  >> mips[i].second, 1u);
+                    const uint32_t height = max(texture->GetHeight() >> mips[i].second, 1u);
+
+                    CMP_Texture source = {};
+                    source.dwSize      = sizeof(source);
+                    source.dwWidth     = width;
+                    source.dwHeight    = height;
+                    source.dwPitch     = width * texture->GetBytesPerPixel();
+                    source.format      = rhi_format_to_compressonator_format(texture->GetFormat());
+                    source.dwDataSize  = static_cast<CMP_DWORD>(mip.bytes.size());
+                    source.pData       = reinterpret_cast<CMP_BYTE*>(mip.bytes.data());
+
+                    mips_compressed[i].resize(RHI_Texture::CalculateMipSize(width, height, format, 0, 0));
+                    CMP_Texture destination = {};
+                    destination.dwSize      = sizeof(destination);
+                    destination.dwWidth     = width;
+                    destination.dwHeight    = height;
+                    destination.format      = rhi_format_to_compressonator_format(format);
+                    destination.dwDataSize  = static_cast<CMP_DWORD>(mips_compressed[i].size());
+                    destination.pData       = reinterpret_cast<CMP_BYTE*>(mips_compressed[i].data());
+
+                    // the thread pool is what runs the work in parallel
+                    CMP_CompressOptions options    = {};
+                    options.dwSize                 = sizeof(options);
+                    options.fquality               = 0.05f;
+                    options.dwnumThreads           = 1;
+                    options.bDisableMultiThreading = true;
+
+                    if (CMP_ConvertTexture(&source, &destination, &options, nullptr) != CMP_OK)
+                    {
+                        failed = true;
+                    }
                 }
+            }, static_cast<uint32_t>(mips.size()));
 
-                delete[] source.m_pMipLevelTable;
-                delete[] destination.m_pMipLevelTable;
+            if (failed)
+            {
+                SP_LOG_ERROR("Failed to compress \"%s\"", texture->GetResourceFilePath().c_str());
+                return false;
             }
-            */
+
+            for (uint32_t i = 0; i < static_cast<uint32_t>(mips.size()); i++)
+            {
+                texture->GetMip(mips[i].first, mips[i].second).bytes = move(mips_compressed[i]);
+            }
+            texture->SetFormat(format);
+
+            return true;
         }
     }
 
+    namespace
+    {
+        // the largest resident mip of a streamed texture when it's loaded, the rest is streamed in when needed
+        const uint32_t stream_size_initial    = 128;
+        const uint32_t stream_mip_top_initial = numeric_limits<uint32_t>::max(); // what RHI_Texture::LoadFromFileEngine() loads when the texture is loaded
+    }
+
     RHI_Texture::RHI_Texture() : IResource(ResourceType::Texture)
     {
         m_layout.fill(RHI_Image_Layout::Max);
@@ -208,59 +223,45 @@ namespace Spartan
 
     bool RHI_Texture::SaveToFile(const string& file_path)
     {
-        // if a file already exists, get the byte count
-        m_object_size_cpu = 0;
-        {
-            if (FileSystem::Exists(file_path))
-            {
-                auto file = make_unique<FileStream>(file_path, FileStream_Read);
-                if (file->IsOpen())
-                {
-                    file->Read(&m_object_size_cpu);
-                }
-            }
-        }
+        // a texture without data (or with its data mapped) was loaded from this file, so the file is already up to date
+        const bool is_mapped = !m_slices.empty() && m_slices[0].mapping;
+        if ((!HasData() || is_mapped) && AssetArchive::Exists(file_path))
+            return true;
 
-        bool append = true;
-        auto file = make_unique<FileStream>(file_path, FileStream_Write | FileStream_Append);
+        auto file = make_unique<FileStream>(file_path, FileStream_Write);
         if (!file->IsOpen())
             return false;
 
-        // if the existing file has texture data but we don't, don't overwrite them
-        bool dont_overwrite_data = m_object_size_cpu != 0 && !HasData();
-        if (dont_overwrite_data)
+        // the file keeps the whole mip chain, so that it can be streamed when loaded
+        MipGenerator::Generate(this);
+
+        // write mip info, the byte count allows the mips to be skipped
+        uint64_t byte_count = 0;
+        for (RHI_Texture_Slice& slice : m_slices)
         {
-            file->Skip
-            (
-                sizeof(m_object_size_cpu) + // byte count
-                sizeof(m_array_length)    + // array length
-                sizeof(m_mip_count)       + // mip count
-                m_object_size_cpu           // bytes
-            );
+            for (RHI_Texture_Mip& mip : slice.mips)
+            {
+                byte_count += sizeof(uint32_t) + mip.GetBytes().size();
+            }
         }
-        else
-        {
-            ComputeMemoryUsage();
+        file->Write(byte_count);
+        file->Write(m_array_length);
+        file->Write(m_slices.empty() ? 0 : m_slices[0].GetMipCount());
 
-            // write mip info
-            file->Write(m_object_size_cpu);
-            file->Write(m_array_length);
-            file->Write(m_mip_count);
-
-            // write mip data
-            for (RHI_Texture_Slice& slice : m_slices)
+        // write mip data
+        for (RHI_Texture_Slice& slice : m_slices)
+        {
+            for (RHI_Texture_Mip& mip : slice.mips)
             {
-                for (RHI_Texture_Mip& mip : slice.mips)
-                {
-                    file->Write(mip.bytes);
-                }
+                file->Write(mip.GetBytes());
             }
-
-            // the bytes have been saved, so we can now free some memory
-            m_slices.clear();
-            m_slices.shrink_to_fit();
         }
 
+        // the bytes have been saved, so we can now free some memory
+        m_slices.clear();
+        m_slices.shrink_to_fit();
+        ComputeMemoryUsage();
+
         // write properties
         file->Write(m_width);
         file->Write(m_height);
@@ -276,7 +277,7 @@ namespace Spartan
 
     bool RHI_Texture::LoadFromFile(const string& file_path)
     {
-        if (!FileSystem::IsFile(file_path))
+        if (!AssetArchive::Exists(file_path))
         {
             SP_LOG_ERROR("Invalid file path \"%s\".", file_path.c_str());
             return false;
@@ -289,38 +290,11 @@ namespace Spartan
         {
             if (FileSystem::IsEngineTextureFile(file_path))
             {
-                auto file = make_unique<FileStream>(file_path, FileStream_Read);
-                if (!file->IsOpen())
+                if (!LoadFromFileEngine(file_path, stream_mip_top_initial))
                 {
                     SP_LOG_ERROR("Failed to load \"%s\".", file_path.c_str());
                     return false;
                 }
-
-                // read mip info
-                file->Read(&m_object_size_cpu);
-                file->Read(&m_array_length);
-                file->Read(&m_mip_count);
-
-                // read mip data
-                m_slices.resize(m_array_length);
-                for (RHI_Texture_Slice& slice : m_slices)
-                {
-                    slice.mips.resize(m_mip_count);
-                    for (RHI_Texture_Mip& mip : slice.mips)
-                    {
-                        file->Read(&mip.bytes);
-                    }
-                }
-
-                // read properties
-                file->Read(&m_width);
-                file->Read(&m_height);
-                file->Read(&m_channel_count);
-                file->Read(&m_bits_per_channel);
-                file->Read(reinterpret_cast<uint32_t*>(&m_format));
-                file->Read(&m_flags);
-                SetObjectId(file->ReadAs<uint64_t>());
-                SetResourceFilePath(file->ReadAs<string>());
             }
             else if (FileSystem::IsSupportedImageFile(file_path))
             {
@@ -355,31 +329,50 @@ namespace Spartan
                 // set resource file path so it can be used by the resource cache.
                 SetResourceFilePath(file_path);
 
-                // compress texture
-                if (m_flags & RHI_Texture_Compressed)
-                {
-                    //Compress(RHI_Format::RHI_Format_BC7);
-                }
             }
         }
 
-        m_mip_count = (m_flags & RHI_Texture_Mips) ? static_cast<uint32_t>(log2(Math::Helper::Min<uint32_t>(m_width, m_height))) : 1;
+        // mips are generated on the cpu when possible, so that they are saved with the texture, the rest are generated on the gpu
+        bool generate_mips = !m_slices.empty() && m_slices[0].GetMipCount() == 1 && !IsStreamed() && !IsCompressedFormat();
+        if (generate_mips)
+        {
+            m_mip_count   = (m_flags & RHI_Texture_Mips) ? static_cast<uint32_t>(log2(Math::Helper::Min<uint32_t>(m_width, m_height))) : 1;
+            generate_mips = m_mip_count > 1;
+
+            if (generate_mips && MipGenerator::CanGenerate(this))
+            {
+                MipGenerator::Generate(this);
+                generate_mips = false;
+            }
+        }
+
+        // compress imported textures, after their mips, since block compressed formats can't be written by the gpu
+        // the compressed mips are what SaveToFile() writes, so engine textures load them as they are
+        if (!FileSystem::IsEngineTextureFile(file_path) && !generate_mips && (m_flags & RHI_Texture_Compressed) && amd_compressonator::can_compress(this))
+        {
+            amd_compressonator::compress(this, amd_compressonator::get_compressed_format(this));
+        }
 
         // add appropriate flags
-        if (m_mip_count > 1)
+        if (generate_mips)
         {
             // ensure the texture has the appropriate flags so that it can be used to generate mips on the GPU
             // once the mips have been generated, those flags and the resources associated with them, will be removed
             m_flags |= RHI_Texture_PerMipViews;
             m_flags |= RHI_Texture_Uav;
         }
+        else
+        {
+            m_flags &= ~RHI_Texture_PerMipViews;
+            m_flags &= ~RHI_Texture_Uav;
+        }
 
         // create gpu resource
         SP_ASSERT_MSG(RHI_CreateResource(), "Failed to create GPU resource");
         m_is_ready_for_use = true;
 
         // gpu based mip generation
-        if (m_mip_count > 1)
+        if (generate_mips)
         {
             Renderer::AddTextureForMipGeneration(this);
         }
@@ -397,6 +390,146 @@ namespace Spartan
         return true;
     }
 
+    bool RHI_Texture::LoadFromFileEngine(const string& file_path, const uint32_t mip_top)
+    {
+        // the properties come after the mips, they are read first since they determine which mips to read
+        uint64_t byte_count     = 0;
+        uint32_t mip_count_file = 0;
+        {
+            auto file = make_unique<FileStream>(file_path, FileStream_Read);
+            if (!file->IsOpen())
+                return false;
+
+            file->Read(&byte_count);
+            file->Read(&m_array_length);
+            file->Read(&mip_count_file);
+            file->Skip(byte_count);
+
+            file->Read(&m_width);
+            file->Read(&m_height);
+            file->Read(&m_channel_count);
+            file->Read(&m_bits_per_channel);
+            file->Read(reinterpret_cast<uint32_t*>(&m_format));
+            file->Read(&m_flags);
+
+            // streaming only needs the mips
+            const uint64_t object_id        = file->ReadAs<uint64_t>();
+            const string resource_file_path = file->ReadAs<string>();
+            if (mip_top == stream_mip_top_initial)
+            {
+                SetObjectId(object_id);
+                SetResourceFilePath(resource_file_path);
+            }
+        }
+
+        // 2d textures with a mip chain are streamed, they skip the mips which are more detailed than needed
+        m_mip_count       = max(mip_count_file, 1u);
+        uint32_t mip_skip = 0;
+        if (mip_count_file > 1 && m_array_length == 1 && m_resource_type == ResourceType::Texture2d)
+        {
+            uint32_t mip_top_max = 0;
+            while (mip_top_max + 1 < mip_count_file && max(m_width >> mip_top_max, m_height >> mip_top_max) > stream_size_initial)
+            {
+                mip_top_max++;
+            }
+
+            mip_skip             = min(mip_top, mip_top_max);
+            m_stream_width       = m_width;
+            m_stream_height      = m_height;
+            m_stream_mip_count   = mip_count_file;
+            m_stream_mip_top     = mip_skip;
+            m_stream_mip_top_max = mip_top_max;
+            m_width            >>= mip_skip;
+            m_height           >>= mip_skip;
+            m_mip_count          = mip_count_file - mip_skip;
+        }
+
+        // the mips point into the file's mapping, so they are copied once, straight into the staging buffer
+        auto file = make_unique<FileStream>(file_path, FileStream_Read);
+        if (!file->IsOpen())
+            return false;
+
+        file->Skip(sizeof(byte_count) + sizeof(m_array_length) + sizeof(mip_count_file));
+        m_slices.resize(m_array_length);
+        for (RHI_Texture_Slice& slice : m_slices)
+        {
+            slice.mapping = file->GetMapping();
+            slice.mips.resize(mip_count_file - mip_skip);
+            for (uint32_t mip_index = 0; mip_index < mip_count_file; mip_index++)
+            {
+                if (mip_index < mip_skip)
+                {
+                    file->Skip(file->ReadAs<uint32_t>());
+                }
+                else
+                {
+                    slice.mips[mip_index - mip_skip].bytes_mapped = file->ReadSpan();
+                }
+            }
+        }
+
+        return true;
+    }
+
+    uint64_t RHI_Texture::GetStreamSizeGpu(const uint32_t mip_top) const
+    {
+        uint64_t size = 0;
+        for (uint32_t mip_index = mip_top; mip_index < m_stream_mip_count; mip_index++)
+        {
+            size += CalculateMipSize(m_stream_width >> mip_index, m_stream_height >> mip_index, m_format, m_bits_per_channel, m_channel_count);
+        }
+
+        return size;
+    }
+
+    void RHI_Texture::Stream(const uint32_t mip_top)
+    {
+        SP_ASSERT(IsStreamed() && IsStreaming());
+
+        // a texture with the requested mips, whose resource StreamApply() takes
+        shared_ptr<RHI_Texture> texture = make_shared<RHI_Texture>();
+        texture->m_resource_type        = m_resource_type;
+        texture->SetObjectName(GetObjectName());
+        bool loaded = texture->LoadFromFileEngine(GetResourceFilePathNative(), mip_top);
+        texture->SetFlags(GetFlags()); // without the ones which mip generation needed, as loaded
+        if (!loaded || !texture->RHI_CreateResource())
+        {
+            SP_LOG_ERROR("Failed to stream \"%s\"", GetResourceFilePathNative().c_str());
+            m_stream_in_flight = false;
+            return;
+        }
+        texture->m_slices.clear();
+        texture->m_slices.shrink_to_fit();
+
+        lock_guard lock(m_stream_mutex);
+        m_stream_pending = texture;
+    }
+
+    bool RHI_Texture::StreamApply()
+    {
+        shared_ptr<RHI_Texture> texture;
+        {
+            lock_guard lock(m_stream_mutex);
+            texture.swap(m_stream_pending);
+        }
+
+        if (!texture)
+            return false;
+
+        // take the new resource, the texture takes the current one and releases it when it goes out of scope
+        m_stream_mip_top = texture->m_stream_mip_top;
+        swap(m_rhi_resource, texture->m_rhi_resource);
+        swap(m_rhi_srv,      texture->m_rhi_srv);
+        swap(m_layout,       texture->m_layout);
+        swap(m_width,        texture->m_width);
+        swap(m_height,       texture->m_height);
+        swap(m_mip_count,    texture->m_mip_count);
+        ComputeMemoryUsage();
+
+        m_stream_in_flight = false;
+        return true;
+    }
+
     RHI_Texture_Mip& RHI_Texture::CreateMip(const uint32_t array_index)
     {
         // grow data if needed
@@ -451,6 +584,15 @@ namespace Spartan
         return m_slices[array_index];
     }
 
+    uint64_t RHI_Texture::CalculateMipSize(const uint32_t width, const uint32_t height, const RHI_Format format, const uint32_t bits_per_channel, const uint32_t channel_count)
+    {
+        // block compressed formats are stored as 4x4 blocks, partial blocks are padded
+        if (rhi_format_is_compressed(format))
+            return static_cast<uint64_t>((width + 3) / 4) * static_cast<uint64_t>((height + 3) / 4) * rhi_format_to_block_size(format);
+
+        return static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * static_cast<uint64_t>(channel_count) * static_cast<uint64_t>(bits_per_channel / 8);
+    }
+
     void RHI_Texture::ComputeMemoryUsage()
     {
         m_object_size_cpu = 0;
@@ -460,9 +602,6 @@ namespace Spartan
         {
             for (uint32_t mip_index = 0; mip_index < m_mip_count; mip_index++)
             {
-                const uint32_t mip_width  = m_width >> mip_index;
-                const uint32_t mip_height = m_height >> mip_index;
-
                 if (array_index < m_slices.size())
                 {
                     if (mip_index < m_slices[array_index].mips.size())
@@ -470,7 +609,7 @@ namespace Spartan
                         m_object_size_cpu += m_slices[array_index].mips[mip_index].bytes.size();
                     }
                 }
-                m_object_size_gpu += mip_width * mip_height * m_channel_count * (m_bits_per_channel / 8);
+                m_object_size_gpu += GetMipSize(mip_index);
             }
         }
     }
@@ -527,6 +666,23 @@ namespace Spartan
         }
     }
 
+    void RHI_Texture::SetAliasMemory(void* memory)
+    {
+        if (memory == m_rhi_memory_alias && m_rhi_resource != nullptr)
+            return;
+
+        // the image is bound to its memory on creation, so it has to be created anew
+        if (m_rhi_resource != nullptr)
+        {
+            RHI_DestroyResource(true, true);
+        }
+
+        m_rhi_memory_alias = memory;
+        m_layout.fill(RHI_Image_Layout::Max);
+
+        SP_ASSERT_MSG(RHI_CreateResource(), "Failed to create GPU resource");
+    }
+
     void RHI_Texture::SaveAsImage(const string& file_path)
     {
         SP_ASSERT_MSG(m_mapped_data != nullptr, "The texture needs to be mappable");
@@ -24,6 +24,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =====================
 #include <memory>
 #include <array>
+#include <atomic>
+#include <mutex>
+#include <span>
 #include "RHI_Viewport.h"
 #include "RHI_Definitions.h"
 #include "../Resource/IResource.h"
@@ -43,7 +46,9 @@ namespace Spartan
         RHI_Texture_Srgb         = 1U << 7,
         RHI_Texture_Mips         = 1U << 8,
         RHI_Texture_Compressed   = 1U << 9,
-        RHI_Texture_Mappable     = 1U << 10
+        RHI_Texture_Mappable     = 1U << 10,
+        RHI_Texture_NormalMap    = 1U << 11,
+        RHI_Texture_Transient    = 1U << 12  // the content doesn't outlive the frame, so the memory can be shared (see RenderGraph)
     };
 
     enum RHI_Shader_View_Type : uint8_t
@@ -53,14 +58,20 @@ namespace Spartan
         RHI_Shader_View_Unordered_Access
     };
 
+    class FileMapping;
+
     struct RHI_Texture_Mip
     {
         std::vector<std::byte> bytes;
+        std::span<const std::byte> bytes_mapped; // engine textures point into their file instead, see RHI_Texture_Slice::mapping
+
+        std::span<const std::byte> GetBytes() const { return bytes.empty() ? bytes_mapped : std::span<const std::byte>(bytes); }
     };
 
     struct RHI_Texture_Slice
     {
         std::vector<RHI_Texture_Mip> mips;
+        std::shared_ptr<FileMapping> mapping; // keeps the mapped mips valid, released along with them
         uint32_t GetMipCount() { return static_cast<uint32_t>(mips.size()); }
     };
 
@@ -99,11 +110,27 @@ namespace Spartan
         // data
         uint32_t GetArrayLength()                          const { return m_array_length; }
         uint32_t GetMipCount()                             const { return m_mip_count; }
-        bool HasData()                                     const { return !m_slices.empty() && !m_slices[0].mips.empty() && !m_slices[0].mips[0].bytes.empty(); };
+        bool HasData()                                     const { return !m_slices.empty() && !m_slices[0].mips.empty() && !m_slices[0].mips[0].GetBytes().empty(); };
         std::vector<RHI_Texture_Slice>& GetData()                { return m_slices; }
         RHI_Texture_Mip& CreateMip(const uint32_t array_index);
         RHI_Texture_Mip& GetMip(const uint32_t array_index, const uint32_t mip_index);
         RHI_Texture_Slice& GetSlice(const uint32_t array_index);
+        uint64_t GetMipSize(const uint32_t mip_index) const { return CalculateMipSize(m_width >> mip_index, m_height >> mip_index, m_format, m_bits_per_channel, m_channel_count); }
+        static uint64_t CalculateMipSize(const uint32_t width, const uint32_t height, const RHI_Format format, const uint32_t bits_per_channel, const uint32_t channel_count);
+
+        // streaming, engine textures which were saved with their mip chain are loaded with only their smallest mips resident
+        // more detailed mips are read from the file on demand, into a new resource which replaces the current one (see TextureStreaming)
+        bool IsStreamed()                                  const { return m_stream_mip_count != 0; }
+        bool IsStreaming()                                 const { return m_stream_in_flight; }
+        uint32_t GetStreamWidth()                          const { return m_stream_width; }        // of the full mip chain
+        uint32_t GetStreamHeight()                         const { return m_stream_height; }
+        uint32_t GetStreamMipCount()                       const { return m_stream_mip_count; }    // the mips in the file
+        uint32_t GetStreamMipTop()                         const { return m_stream_mip_top; }      // the most detailed resident mip
+        uint32_t GetStreamMipTopMax()                      const { return m_stream_mip_top_max; }  // the mip the texture was loaded with, it's never evicted
+        uint64_t GetStreamSizeGpu(const uint32_t mip_top) const;
+        void StreamBegin() { m_stream_in_flight = true; } // main thread, before Stream() is queued, so that the texture isn't requested twice
+        void Stream(const uint32_t mip_top); // any thread, reads the mips and creates their resource
+        bool StreamApply();                  // main thread, swaps in the resource of the last Stream(), returns true if there was one
 
         // flags
         bool IsSrv()                      const { return m_flags & RHI_Texture_Srv; }
@@ -115,12 +142,14 @@ namespace Spartan
         bool HasMips()                    const { return m_flags & RHI_Texture_Mips; }
         bool IsGrayscale()                const { return m_flags & RHI_Texture_Greyscale; }
         bool IsTransparent()              const { return m_flags & RHI_Texture_Transparent; }
+        bool IsTransient()                const { return m_flags & RHI_Texture_Transient; }
 
         // format type
         bool IsDepthFormat()        const { return m_format == RHI_Format::D16_Unorm || m_format == RHI_Format::D32_Float || m_format == RHI_Format::D32_Float_S8X24_Uint; }
         bool IsStencilFormat()      const { return m_format == RHI_Format::D32_Float_S8X24_Uint; }
         bool IsDepthStencilFormat() const { return IsDepthFormat() || IsStencilFormat(); }
         bool IsColorFormat()        const { return !IsDepthStencilFormat(); }
+        bool IsCompressedFormat()   const { return rhi_format_is_compressed(m_format); }
 
         // layout
         void SetLayout(const RHI_Image_Layout layout, RHI_CommandList* cmd_list, uint32_t mip_index = rhi_all_mips,  uint32_t mip_range = 0);
@@ -142,6 +171,11 @@ namespace Spartan
         void RHI_DestroyResource(const bool destroy_main, const bool destroy_per_view);
         void*& GetMappedData() { return m_mapped_data; }
 
+        // memory which is shared with other textures (see RHI_Device::MemoryAliasCreate()), null if the texture has its own
+        // setting it creates the resource anew, so the gpu has to be idle, and what the texture contained is lost
+        void SetAliasMemory(void* memory);
+        void* GetAliasMemory() const { return m_rhi_memory_alias; }
+
     protected:
         bool RHI_CreateResource();
         void RHI_SetLayout(const RHI_Image_Layout new_layout, RHI_CommandList* cmd_list, const uint32_t mip_index, const uint32_t mip_range);
@@ -157,6 +191,16 @@ namespace Spartan
         std::vector<RHI_Texture_Slice> m_slices;
         std::array<RHI_Image_Layout, rhi_max_mip_count> m_layout;
 
+        // streaming
+        uint32_t m_stream_width              = 0;
+        uint32_t m_stream_height             = 0;
+        uint32_t m_stream_mip_count          = 0;
+        uint32_t m_stream_mip_top            = 0;
+        uint32_t m_stream_mip_top_max        = 0;
+        std::atomic<bool> m_stream_in_flight = false;
+        std::shared_ptr<RHI_Texture> m_stream_pending;
+        std::mutex m_stream_mutex;
+
         // api resources
         void* m_rhi_resource = nullptr;
         void* m_rhi_srv      = nullptr;
@@ -166,9 +210,11 @@ namespace Spartan
         std::array<void*, rhi_max_render_target_count> m_rhi_rtv;
         std::array<void*, rhi_max_render_target_count> m_rhi_dsv;
         std::array<void*, rhi_max_render_target_count> m_rhi_dsv_read_only;
-        void* m_mapped_data = nullptr;
+        void* m_mapped_data      = nullptr;
+        void* m_rhi_memory_alias = nullptr;
 
     private:
+        bool LoadFromFileEngine(const std::string& file_path, const uint32_t mip_top);
         void ComputeMemoryUsage();
     };
 }
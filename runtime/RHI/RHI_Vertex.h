@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
 #include "../Math/Vector4.h"
+#include "../Math/Matrix.h"
 //==========================
 
 namespace Spartan
@@ -127,9 +128,62 @@ namespace Spartan
         float tan[3] = { 0, 0, 0 };
     };
 
+    // what the gpu sees of RHI_Vertex_PosTexNorTan (24 bytes instead of 44), packed by Mesh::CreateGpuBuffers()
+    // the uv is half precision, the normal and the tangent are octahedral encoded snorm16 pairs (see common_vertex_processing.hlsl)
+    struct RHI_Vertex_PosTexNorTanPacked
+    {
+        float pos[3]       = { 0, 0, 0 };
+        uint16_t tex[2]    = { 0, 0 };
+        int16_t nor_tan[4] = { 0, 0, 0, 0 };
+    };
+
+    // an instance transform, as a translation, a rotation and a uniform scale (24 bytes instead of the 64 of a matrix)
+    // the rotation is a quaternion stored as snorm16, the shaders rebuild the matrix (see common_vertex_processing.hlsl)
+    struct RHI_Instance
+    {
+        RHI_Instance() = default;
+        RHI_Instance(const Math::Vector3& position, const Math::Quaternion& rotation, const float scale)
+        {
+            this->position[0] = position.x;
+            this->position[1] = position.y;
+            this->position[2] = position.z;
+            this->scale       = scale;
+
+            const Math::Quaternion rotation_normalized = rotation.Normalized();
+            this->rotation[0] = to_snorm16(rotation_normalized.x);
+            this->rotation[1] = to_snorm16(rotation_normalized.y);
+            this->rotation[2] = to_snorm16(rotation_normalized.z);
+            this->rotation[3] = to_snorm16(rotation_normalized.w);
+        }
+
+        Math::Matrix GetMatrix() const
+        {
+            const Math::Quaternion rotation_unpacked = Math::Quaternion(
+                from_snorm16(rotation[0]),
+                from_snorm16(rotation[1]),
+                from_snorm16(rotation[2]),
+                from_snorm16(rotation[3])
+            ).Normalized();
+
+            return Math::Matrix(Math::Vector3(position[0], position[1], position[2]), rotation_unpacked, Math::Vector3(scale));
+        }
+
+        float position[3]   = { 0, 0, 0 };
+        float scale         = 1.0f;
+        int16_t rotation[4] = { 0, 0, 0, 32767 };
+
+    private:
+        static int16_t to_snorm16(const float value)  { return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f)); }
+        static float from_snorm16(const int16_t value) { return std::max(static_cast<float>(value) / 32767.0f, -1.0f); }
+    };
+
     SP_ASSERT_STATIC_IS_TRIVIALLY_COPYABLE(RHI_Vertex_Pos);
     SP_ASSERT_STATIC_IS_TRIVIALLY_COPYABLE(RHI_Vertex_PosTex);
     SP_ASSERT_STATIC_IS_TRIVIALLY_COPYABLE(RHI_Vertex_PosCol);
     SP_ASSERT_STATIC_IS_TRIVIALLY_COPYABLE(RHI_Vertex_Pos2dTexCol8);
     SP_ASSERT_STATIC_IS_TRIVIALLY_COPYABLE(RHI_Vertex_PosTexNorTan);
+    SP_ASSERT_STATIC_IS_TRIVIALLY_COPYABLE(RHI_Vertex_PosTexNorTanPacked);
+    SP_ASSERT_STATIC_IS_TRIVIALLY_COPYABLE(RHI_Instance);
+    static_assert(sizeof(RHI_Vertex_PosTexNorTanPacked) == 24, "The vertex layout has to match the shaders");
+    static_assert(sizeof(RHI_Instance) == 24, "The instance layout has to match the shaders");
 }
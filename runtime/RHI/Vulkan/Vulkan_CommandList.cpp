@@ -311,18 +311,19 @@ namespace Spartan
         }
     }
 
-    RHI_CommandList::RHI_CommandList(const RHI_Queue_Type queue_type, const uint64_t swapchain_id, void* cmd_pool, const char* name) : SpObject()
+    RHI_CommandList::RHI_CommandList(const RHI_Queue_Type queue_type, const uint64_t swapchain_id, void* cmd_pool, const char* name, const bool is_secondary) : SpObject()
     {
         m_timestamps.fill(0);
-        m_queue_type  = queue_type;
-        m_object_name = name;
+        m_queue_type   = queue_type;
+        m_object_name  = name;
+        m_is_secondary = is_secondary;
 
         // command buffer
         {
             VkCommandBufferAllocateInfo allocate_info = {};
             allocate_info.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
             allocate_info.commandPool                 = static_cast<VkCommandPool>(cmd_pool);
-            allocate_info.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocate_info.level                       = is_secondary ? VK_COMMAND_BUFFER_LEVEL_SECONDARY : VK_COMMAND_BUFFER_LEVEL_PRIMARY;
             allocate_info.commandBufferCount          = 1;
 
             // Allocate
@@ -333,6 +334,10 @@ namespace Spartan
             RHI_Device::SetResourceName(static_cast<void*>(m_rhi_resource), RHI_Resource_Type::CommandList, name);
         }
 
+        // secondary command lists are executed by a primary one, which is what gets timed and synchronized
+        if (is_secondary)
+            return;
+
         // query pool
         if (Profiler::IsGpuTimingEnabled())
         {
@@ -420,10 +425,14 @@ namespace Spartan
     {
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
 
-        if (m_render_pass_active && m_pso.IsGraphics())
+        // the render pass of a secondary command list belongs to the primary
+        if (m_render_pass_active && m_pso.IsGraphics() && !m_is_secondary)
         {
             EndRenderPass();
         }
+        m_render_pass_active = false;
+
+        FlushBarriers();
 
         SP_ASSERT_MSG(
             vkEndCommandBuffer(static_cast<VkCommandBuffer>(m_rhi_resource)) == VK_SUCCESS,
@@ -436,6 +445,7 @@ namespace Spartan
     void RHI_CommandList::Submit()
     {
         SP_ASSERT(m_state == RHI_CommandListState::Ended);
+        SP_ASSERT_MSG(!m_is_secondary, "Secondary command lists can only be executed by a primary command list");
 
         // we can reach this code path and have a submitted semaphore when exiting full screen
         // it's okay to reset it manually here but ideally, we should find out why this happens
@@ -516,7 +526,7 @@ namespace Spartan
         descriptor_sets::dynamic_descriptor_needs_to_bind = true;
     }
 
-    void RHI_CommandList::BeginRenderPass()
+    void RHI_CommandList::BeginRenderPass(const bool contents_secondary /*= false*/)
     {
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
         SP_ASSERT_MSG(m_pso.IsGraphics(), "You can't use a render pass with a compute pipeline");
@@ -537,6 +547,7 @@ namespace Spartan
         rendering_info.pColorAttachments    = nullptr;
         rendering_info.pDepthAttachment     = nullptr;
         rendering_info.pStencilAttachment   = nullptr;
+        rendering_info.flags                = contents_secondary ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
 
         // color attachments
         vector<VkRenderingAttachmentInfo> attachments_color;
@@ -631,16 +642,22 @@ namespace Spartan
             }
         }
 
+        // the attachment transitions (and whatever else is pending) go in one batch
+        FlushBarriers();
+
         // begin dynamic render pass instance
         vkCmdBeginRendering(static_cast<VkCommandBuffer>(m_rhi_resource), &rendering_info);
 
-        // set viewport
-        RHI_Viewport viewport = RHI_Viewport(
-            0.0f, 0.0f,
-            static_cast<float>(m_pso.GetWidth()),
-            static_cast<float>(m_pso.GetHeight())
-        );
-        SetViewport(viewport);
+        // set viewport (when the contents are secondary, they set it themselves)
+        if (!contents_secondary)
+        {
+            RHI_Viewport viewport = RHI_Viewport(
+                0.0f, 0.0f,
+                static_cast<float>(m_pso.GetWidth()),
+                static_cast<float>(m_pso.GetHeight())
+            );
+            SetViewport(viewport);
+        }
 
         m_render_pass_active = true;
     }
@@ -659,6 +676,169 @@ namespace Spartan
         }
     }
 
+    void RHI_CommandList::BeginSecondary(RHI_CommandList* cmd_list_primary)
+    {
+        SP_ASSERT(m_is_secondary);
+        SP_ASSERT(m_state == RHI_CommandListState::Idle);
+        SP_ASSERT(cmd_list_primary != nullptr && !cmd_list_primary->IsSecondary());
+        SP_ASSERT(cmd_list_primary->GetState() == RHI_CommandListState::Recording);
+        SP_ASSERT_MSG(cmd_list_primary->m_pso.IsGraphics(), "Secondary command lists are only supported for graphics pipelines");
+
+        // inherit the pipeline state
+        m_pso                       = cmd_list_primary->m_pso;
+        m_pipeline                  = cmd_list_primary->m_pipeline;
+        m_descriptor_layout_current = cmd_list_primary->m_descriptor_layout_current;
+
+        // resolve the descriptor set here, on the main thread, since the descriptor set cache isn't thread safe
+        Renderer::SetStandardResources(cmd_list_primary);
+        m_descriptor_set_secondary = m_descriptor_layout_current->GetDescriptorSet()->GetResource();
+        m_dynamic_offsets          = RHI_DynamicOffsets();
+
+        // describe the render targets that the primary will render into
+        vector<VkFormat> attachment_formats_color;
+        VkFormat attachment_format_depth   = VK_FORMAT_UNDEFINED;
+        VkFormat attachment_format_stencil = VK_FORMAT_UNDEFINED;
+        {
+            if (m_pso.render_target_swapchain)
+            {
+                attachment_formats_color.push_back(vulkan_format[rhi_format_to_index(m_pso.render_target_swapchain->GetFormat())]);
+            }
+            else
+            {
+                for (uint32_t i = 0; i < rhi_max_render_target_count; i++)
+                {
+                    RHI_Texture* texture = m_pso.render_target_color_textures[i];
+                    if (texture == nullptr)
+                        break;
+
+                    attachment_formats_color.push_back(vulkan_format[rhi_format_to_index(texture->GetFormat())]);
+                }
+            }
+
+            if (m_pso.render_target_depth_texture)
+            {
+                attachment_format_depth   = vulkan_format[rhi_format_to_index(m_pso.render_target_depth_texture->GetFormat())];
+                attachment_format_stencil = m_pso.render_target_depth_texture->IsStencilFormat() ? attachment_format_depth : VK_FORMAT_UNDEFINED;
+            }
+        }
+
+        VkCommandBufferInheritanceRenderingInfo inheritance_rendering_info = {};
+        inheritance_rendering_info.sType                                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+        inheritance_rendering_info.colorAttachmentCount                    = static_cast<uint32_t>(attachment_formats_color.size());
+        inheritance_rendering_info.pColorAttachmentFormats                 = attachment_formats_color.data();
+        inheritance_rendering_info.depthAttachmentFormat                   = attachment_format_depth;
+        inheritance_rendering_info.stencilAttachmentFormat                 = attachment_format_stencil;
+        inheritance_rendering_info.rasterizationSamples                    = VK_SAMPLE_COUNT_1_BIT;
+
+        VkCommandBufferInheritanceInfo inheritance_info = {};
+        inheritance_info.sType                          = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance_info.pNext                          = &inheritance_rendering_info;
+
+        // begin command buffer
+        VkCommandBufferBeginInfo begin_info = {};
+        begin_info.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        begin_info.pInheritanceInfo         = &inheritance_info;
+        SP_ASSERT_MSG(vkBeginCommandBuffer(static_cast<VkCommandBuffer>(m_rhi_resource), &begin_info) == VK_SUCCESS, "Failed to begin command buffer");
+
+        m_state              = RHI_CommandListState::Recording;
+        m_render_pass_active = true;
+        m_pipeline_dirty     = false;
+        m_vertex_buffer_id   = 0;
+        m_index_buffer_id    = 0;
+
+        // no state is inherited from the primary, so bind everything
+        vkCmdBindPipeline(static_cast<VkCommandBuffer>(m_rhi_resource), VK_PIPELINE_BIND_POINT_GRAPHICS, static_cast<VkPipeline>(m_pipeline->GetResource_Pipeline()));
+        Profiler::m_rhi_bindings_pipeline++;
+        descriptor_sets::set_bindless(m_pso, m_rhi_resource, m_pipeline->GetResource_PipelineLayout());
+
+        m_cull_mode = RHI_CullMode::Max;
+        SetCullMode(m_pso.rasterizer_state->GetCullMode());
+
+        Math::Rectangle scissor_rect;
+        scissor_rect.left   = 0.0f;
+        scissor_rect.top    = 0.0f;
+        scissor_rect.right  = static_cast<float>(m_pso.GetWidth());
+        scissor_rect.bottom = static_cast<float>(m_pso.GetHeight());
+        SetScissorRectangle(scissor_rect);
+
+        SetViewport(RHI_Viewport(0.0f, 0.0f, static_cast<float>(m_pso.GetWidth()), static_cast<float>(m_pso.GetHeight())));
+    }
+
+    void RHI_CommandList::ExecuteSecondary(const vector<RHI_CommandList*>& cmd_lists_secondary)
+    {
+        SP_ASSERT(m_state == RHI_CommandListState::Recording);
+        SP_ASSERT(!m_is_secondary);
+
+        if (cmd_lists_secondary.empty())
+            return;
+
+        vector<VkCommandBuffer> vk_cmd_buffers;
+        vk_cmd_buffers.reserve(cmd_lists_secondary.size());
+        for (RHI_CommandList* cmd_list : cmd_lists_secondary)
+        {
+            if (cmd_list->GetState() == RHI_CommandListState::Recording)
+            {
+                cmd_list->End();
+            }
+
+            SP_ASSERT(cmd_list->GetState() == RHI_CommandListState::Ended);
+            vk_cmd_buffers.push_back(static_cast<VkCommandBuffer>(cmd_list->GetRhiResource()));
+
+            // from now on, the secondary command list shares the fate of the primary
+            cmd_list->m_state = RHI_CommandListState::Submitted;
+        }
+
+        // a render pass which only consists of secondary command lists
+        BeginRenderPass(true);
+        vkCmdExecuteCommands(static_cast<VkCommandBuffer>(m_rhi_resource), static_cast<uint32_t>(vk_cmd_buffers.size()), vk_cmd_buffers.data());
+        EndRenderPass();
+
+        // the state of this command list is undefined after executing secondary command lists
+        m_pipeline_dirty   = true;
+        m_cull_mode        = RHI_CullMode::Max;
+        m_vertex_buffer_id = 0;
+        m_index_buffer_id  = 0;
+    }
+
+    RHI_DynamicOffsets RHI_CommandList::GetDynamicOffsets()
+    {
+        SP_ASSERT(m_descriptor_layout_current != nullptr);
+
+        // make sure that the standard resources are part of the offsets, like they would be on draw
+        Renderer::SetStandardResources(this);
+
+        RHI_DynamicOffsets dynamic_offsets;
+        m_descriptor_layout_current->GetDynamicOffsets(&dynamic_offsets.offsets, &dynamic_offsets.count);
+
+        return dynamic_offsets;
+    }
+
+    void RHI_CommandList::SetDynamicOffsets(const RHI_DynamicOffsets& dynamic_offsets)
+    {
+        SP_ASSERT(m_state == RHI_CommandListState::Recording);
+        SP_ASSERT_MSG(m_is_secondary, "Primary command lists bind their descriptor sets on draw");
+
+        // the descriptor set never changes during the lifetime of a secondary command list, only the offsets do
+        if (m_dynamic_offsets.count != 0 && m_dynamic_offsets == dynamic_offsets)
+            return;
+
+        vkCmdBindDescriptorSets
+        (
+            static_cast<VkCommandBuffer>(m_rhi_resource),                            // commandBuffer
+            VK_PIPELINE_BIND_POINT_GRAPHICS,                                         // pipelineBindPoint
+            static_cast<VkPipelineLayout>(m_pipeline->GetResource_PipelineLayout()), // layout
+            0,                                                                       // firstSet
+            1,                                                                       // descriptorSetCount
+            reinterpret_cast<VkDescriptorSet*>(&m_descriptor_set_secondary),         // pDescriptorSets
+            dynamic_offsets.count,                                                   // dynamicOffsetCount
+            dynamic_offsets.offsets.data()                                           // pDynamicOffsets
+        );
+
+        m_dynamic_offsets = dynamic_offsets;
+        Profiler::m_rhi_bindings_descriptor_set++;
+    }
+
     void RHI_CommandList::ClearPipelineStateRenderTargets(RHI_PipelineState& pipeline_state)
     {
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
@@ -736,6 +916,7 @@ namespace Spartan
 
         // One of the required layouts for clear functions
         texture->SetLayout(RHI_Image_Layout::Transfer_Destination, this);
+        FlushBarriers();
 
         VkImageSubresourceRange image_subresource_range = {};
         image_subresource_range.baseMipLevel            = 0;
@@ -808,6 +989,49 @@ namespace Spartan
         }
     }
 
+    void RHI_CommandList::DrawIndexedIndirect(RHI_StructuredBuffer* args, const uint32_t args_offset, const uint32_t draw_count)
+    {
+        SP_ASSERT(m_state == RHI_CommandListState::Recording);
+        SP_ASSERT(args != nullptr && !args->IsMappable());
+        OnPreDrawDispatch();
+
+        vkCmdDrawIndexedIndirect(
+            static_cast<VkCommandBuffer>(m_rhi_resource), // commandBuffer
+            static_cast<VkBuffer>(args->GetRhiResource()), // buffer
+            args_offset,                                  // offset
+            draw_count,                                   // drawCount
+            sizeof(RHI_IndirectDrawArgsIndexed)           // stride
+        );
+
+        if (Profiler::GetGranularity() == ProfilerGranularity::Full)
+        {
+            Profiler::m_rhi_draw++;
+        }
+    }
+
+    void RHI_CommandList::DrawIndexedIndirectCount(RHI_StructuredBuffer* args, const uint32_t args_offset, RHI_StructuredBuffer* count, const uint32_t count_offset, const uint32_t draw_count_max)
+    {
+        SP_ASSERT(m_state == RHI_CommandListState::Recording);
+        SP_ASSERT(args != nullptr && !args->IsMappable());
+        SP_ASSERT(count != nullptr && !count->IsMappable());
+        OnPreDrawDispatch();
+
+        vkCmdDrawIndexedIndirectCount(
+            static_cast<VkCommandBuffer>(m_rhi_resource),  // commandBuffer
+            static_cast<VkBuffer>(args->GetRhiResource()),  // buffer
+            args_offset,                                   // offset
+            static_cast<VkBuffer>(count->GetRhiResource()), // countBuffer
+            count_offset,                                  // countBufferOffset
+            draw_count_max,                                // maxDrawCount
+            sizeof(RHI_IndirectDrawArgsIndexed)            // stride
+        );
+
+        if (Profiler::GetGranularity() == ProfilerGranularity::Full)
+        {
+            Profiler::m_rhi_draw++;
+        }
+    }
+
     void RHI_CommandList::Dispatch(uint32_t x, uint32_t y, uint32_t z /*= 1*/, bool async /*= false*/)
     {
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
@@ -868,6 +1092,7 @@ namespace Spartan
         // Transition to blit appropriate layouts
         source->SetLayout(RHI_Image_Layout::Transfer_Source, this);
         destination->SetLayout(RHI_Image_Layout::Transfer_Destination, this);
+        FlushBarriers();
 
         // blit
         vkCmdBlitImage(
@@ -884,13 +1109,22 @@ namespace Spartan
             for (uint32_t i = 0; i < source->GetMipCount(); i++)
             {
                 source->SetLayout(layouts_initial_source[i], this, i, 1);
-                destination->SetLayout(layouts_initial_destination[i], this, i, 1);
+
+                // a discarded texture can't go back to being undefined, so it keeps the transfer layout
+                if (layouts_initial_destination[i] != RHI_Image_Layout::Undefined)
+                {
+                    destination->SetLayout(layouts_initial_destination[i], this, i, 1);
+                }
             }
         }
         else
         {
             source->SetLayout(layouts_initial_source[0], this);
-            destination->SetLayout(layouts_initial_destination[0], this);
+
+            if (layouts_initial_destination[0] != RHI_Image_Layout::Undefined)
+            {
+                destination->SetLayout(layouts_initial_destination[0], this);
+            }
         }
     }
 
@@ -930,6 +1164,7 @@ namespace Spartan
         // transition to blit appropriate layouts
         source->SetLayout(RHI_Image_Layout::Transfer_Source,      this);
         destination->SetLayout(RHI_Image_Layout::Transfer_Destination, this);
+        FlushBarriers();
 
         // deduce filter
         bool width_equal  = source->GetWidth() == destination->GetWidth();
@@ -986,6 +1221,7 @@ namespace Spartan
         // transition to blit appropriate layouts
         source->SetLayout(RHI_Image_Layout::Transfer_Source, this);
         destination->SetLayout(RHI_Image_Layout::Transfer_Destination, this);
+        FlushBarriers();
 
         vkCmdCopyImage(
             static_cast<VkCommandBuffer>(m_rhi_resource),
@@ -1000,13 +1236,22 @@ namespace Spartan
             for (uint32_t i = 0; i < source->GetMipCount(); i++)
             {
                 source->SetLayout(layouts_initial_source[i], this, i, 1);
-                destination->SetLayout(layouts_initial_destination[i], this, i, 1);
+
+                // a discarded texture can't go back to being undefined, so it keeps the transfer layout
+                if (layouts_initial_destination[i] != RHI_Image_Layout::Undefined)
+                {
+                    destination->SetLayout(layouts_initial_destination[i], this, i, 1);
+                }
             }
         }
         else
         {
             source->SetLayout(layouts_initial_source[0], this);
-            destination->SetLayout(layouts_initial_destination[0], this);
+
+            if (layouts_initial_destination[0] != RHI_Image_Layout::Undefined)
+            {
+                destination->SetLayout(layouts_initial_destination[0], this);
+            }
         }
     }
 
@@ -1032,6 +1277,7 @@ namespace Spartan
         RHI_Image_Layout layout_initial_source = source->GetLayout(0);
         source->SetLayout(RHI_Image_Layout::Transfer_Source, this);
         destination->SetLayout(RHI_Image_Layout::Transfer_Destination, this);
+        FlushBarriers();
 
         // Blit
         vkCmdCopyImage(
@@ -1124,6 +1370,30 @@ namespace Spartan
         Profiler::m_rhi_bindings_buffer_vertex++;
     }
 
+    void RHI_CommandList::SetBufferVertex(const RHI_StructuredBuffer* buffer, const uint32_t binding /*= 0*/)
+    {
+        SP_ASSERT(m_state == RHI_CommandListState::Recording);
+        SP_ASSERT(buffer != nullptr);
+        SP_ASSERT_MSG(!buffer->IsMappable(), "Only gpu structured buffers can be used as vertex buffers");
+
+        if (m_vertex_buffer_id == buffer->GetObjectId())
+            return;
+
+        VkBuffer vertex_buffers[] = { static_cast<VkBuffer>(buffer->GetRhiResource()) };
+        VkDeviceSize offsets[]    = { 0 };
+
+        vkCmdBindVertexBuffers(
+            static_cast<VkCommandBuffer>(m_rhi_resource), // commandBuffer
+            binding,                                      // firstBinding
+            1,                                            // bindingCount
+            vertex_buffers,                               // pBuffers
+            offsets                                       // pOffsets
+        );
+
+        m_vertex_buffer_id = buffer->GetObjectId();
+        Profiler::m_rhi_bindings_buffer_vertex++;
+    }
+
     void RHI_CommandList::SetBufferIndex(const RHI_IndexBuffer* buffer)
     {
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
@@ -1414,12 +1684,20 @@ namespace Spartan
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
         SP_ASSERT(m_pipeline != nullptr);
 
+        // secondary command lists inherit the render pass and get their resources via SetDynamicOffsets()
+        if (m_is_secondary)
+            return;
+
+        // the standard resources go first, as they can transition textures
+        Renderer::SetStandardResources(this);
+
         if (!m_render_pass_active && m_pso.IsGraphics())
         {
             BeginRenderPass();
         }
 
-        Renderer::SetStandardResources(this);
+        // compute work has no render pass to flush the pending barriers
+        FlushBarriers();
 
         // set dynamic resources
         if (descriptor_sets::dynamic_descriptor_needs_to_bind)
@@ -1429,62 +1707,60 @@ namespace Spartan
         }
     }
 
-    void RHI_CommandList::InsertMemoryBarrierImage(void* image, const uint32_t aspect_mask,
-        const uint32_t mip_index, const uint32_t mip_range, const uint32_t array_length,
-        const RHI_Image_Layout layout_old, const RHI_Image_Layout layout_new
-    )
+    void RHI_CommandList::FlushBarriers()
     {
-        SP_ASSERT(image != nullptr);
+        if (m_barriers_pending.empty())
+            return;
 
-        VkImageMemoryBarrier image_barrier            = {};
-        image_barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        image_barrier.pNext                           = nullptr;
-        image_barrier.oldLayout                       = vulkan_image_layout[static_cast<VkImageLayout>(layout_old)];
-        image_barrier.newLayout                       = vulkan_image_layout[static_cast<VkImageLayout>(layout_new)];
-        image_barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
-        image_barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
-        image_barrier.image                           = static_cast<VkImage>(image);
-        image_barrier.subresourceRange.aspectMask     = aspect_mask;
-        image_barrier.subresourceRange.baseMipLevel   = mip_index;
-        image_barrier.subresourceRange.levelCount     = mip_range;
-        image_barrier.subresourceRange.baseArrayLayer = 0;
-        image_barrier.subresourceRange.layerCount     = array_length;
-        image_barrier.srcAccessMask                   = layout_to_access_mask(image_barrier.oldLayout, false);
-        image_barrier.dstAccessMask                   = layout_to_access_mask(image_barrier.newLayout, true);
+        SP_ASSERT_MSG(!m_render_pass_active, "Layout transitions can't happen within a render pass");
 
-        VkPipelineStageFlags source_stage_mask = 0;
+        static thread_local vector<VkImageMemoryBarrier> image_barriers;
+        image_barriers.clear();
+
+        VkPipelineStageFlags source_stage_mask      = 0;
+        VkPipelineStageFlags destination_stage_mask = 0;
+        for (const RHI_ImageBarrier& barrier : m_barriers_pending)
         {
+            VkImageMemoryBarrier& image_barrier           = image_barriers.emplace_back();
+            image_barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            image_barrier.pNext                           = nullptr;
+            image_barrier.oldLayout                       = vulkan_image_layout[static_cast<VkImageLayout>(barrier.layout_old)];
+            image_barrier.newLayout                       = vulkan_image_layout[static_cast<VkImageLayout>(barrier.layout_new)];
+            image_barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+            image_barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+            image_barrier.image                           = static_cast<VkImage>(barrier.image);
+            image_barrier.subresourceRange.aspectMask     = barrier.aspect_mask;
+            image_barrier.subresourceRange.baseMipLevel   = barrier.mip_index;
+            image_barrier.subresourceRange.levelCount     = barrier.mip_range;
+            image_barrier.subresourceRange.baseArrayLayer = 0;
+            image_barrier.subresourceRange.layerCount     = barrier.array_length;
+            image_barrier.srcAccessMask                   = layout_to_access_mask(image_barrier.oldLayout, false);
+            image_barrier.dstAccessMask                   = layout_to_access_mask(image_barrier.newLayout, true);
+
+            // the stages of the batch are the union of the stages of its barriers
             if (image_barrier.oldLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
             {
-                source_stage_mask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+                source_stage_mask |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
             }
             else if (image_barrier.oldLayout == VK_IMAGE_LAYOUT_UNDEFINED)
             {
-                source_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+                source_stage_mask |= VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
             }
             else
             {
-                source_stage_mask = access_flags_to_pipeline_stage(image_barrier.srcAccessMask);
+                source_stage_mask |= access_flags_to_pipeline_stage(image_barrier.srcAccessMask);
             }
-        }
 
-        VkPipelineStageFlags destination_stage_mask = 0;
-        {
             if (image_barrier.newLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
             {
-                destination_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+                destination_stage_mask |= VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
             }
             else
             {
-                destination_stage_mask = access_flags_to_pipeline_stage(image_barrier.dstAccessMask);
+                destination_stage_mask |= access_flags_to_pipeline_stage(image_barrier.dstAccessMask);
             }
         }
-
-        // as per vulkan, you can't transition within a render pass
-        if (m_render_pass_active)
-        {
-            EndRenderPass();
-        }
+        m_barriers_pending.clear();
 
         vkCmdPipelineBarrier
         (
@@ -1496,13 +1772,47 @@ namespace Spartan
             nullptr,                                      // pMemoryBarriers
             0,                                            // bufferMemoryBarrierCount
             nullptr,                                      // pBufferMemoryBarriers
-            1,                                            // imageMemoryBarrierCount
-            &image_barrier                                // pImageMemoryBarriers
+            static_cast<uint32_t>(image_barriers.size()), // imageMemoryBarrierCount
+            image_barriers.data()                         // pImageMemoryBarriers
         );
 
         Profiler::m_rhi_pipeline_barriers++;
     }
 
+    void RHI_CommandList::InsertMemoryBarrierImage(void* image, const uint32_t aspect_mask,
+        const uint32_t mip_index, const uint32_t mip_range, const uint32_t array_length,
+        const RHI_Image_Layout layout_old, const RHI_Image_Layout layout_new
+    )
+    {
+        SP_ASSERT(image != nullptr);
+
+        // as per vulkan, you can't transition within a render pass
+        if (m_render_pass_active)
+        {
+            EndRenderPass();
+        }
+
+        // a second transition of the same subresources has to wait for the first one, so record what's pending
+        for (const RHI_ImageBarrier& barrier : m_barriers_pending)
+        {
+            bool mips_overlap = mip_index < barrier.mip_index + barrier.mip_range && barrier.mip_index < mip_index + mip_range;
+            if (barrier.image == image && mips_overlap)
+            {
+                FlushBarriers();
+                break;
+            }
+        }
+
+        RHI_ImageBarrier& barrier = m_barriers_pending.emplace_back();
+        barrier.image             = image;
+        barrier.aspect_mask       = aspect_mask;
+        barrier.mip_index         = mip_index;
+        barrier.mip_range         = mip_range;
+        barrier.array_length      = array_length;
+        barrier.layout_old        = layout_old;
+        barrier.layout_new        = layout_new;
+    }
+
     void RHI_CommandList::InsertMemoryBarrierImage(RHI_Texture* texture, const uint32_t mip_start, const uint32_t mip_range, const uint32_t array_length, const RHI_Image_Layout layout_old, const RHI_Image_Layout layout_new)
     {
         SP_ASSERT(texture != nullptr);
@@ -1512,6 +1822,7 @@ namespace Spartan
     void RHI_CommandList::InsertMemoryBarrierImageWaitForWrite(RHI_Texture* texture)
     {
         SP_ASSERT(texture != nullptr);
+        FlushBarriers();
 
         VkImageMemoryBarrier image_barrier            = {};
         image_barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -1553,6 +1864,7 @@ namespace Spartan
     void RHI_CommandList::InsertMemoryBarrierBufferWaitForWrite(void* buffer)
     {
         SP_ASSERT(buffer != nullptr);
+        FlushBarriers();
 
         VkBufferMemoryBarrier buffer_barrier = {};
         buffer_barrier.sType                 = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
@@ -1583,4 +1895,67 @@ namespace Spartan
 
         Profiler::m_rhi_pipeline_barriers++;
     }
+
+    void RHI_CommandList::InsertMemoryBarrierWaitForCompute()
+    {
+        SP_ASSERT(m_state == RHI_CommandListState::Recording);
+        FlushBarriers();
+
+        // a global memory barrier, so that it can cover many buffers at once
+        VkMemoryBarrier memory_barrier = {};
+        memory_barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memory_barrier.srcAccessMask   = VK_ACCESS_SHADER_WRITE_BIT;
+        memory_barrier.dstAccessMask   = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+
+        // the source stages also include the readers, so that a write which follows a read (e.g. from the previous frame) waits for it
+        VkPipelineStageFlags stages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+
+        vkCmdPipelineBarrier(
+            static_cast<VkCommandBuffer>(m_rhi_resource),
+            stages,
+            stages,
+            0,
+            1,
+            &memory_barrier,
+            0,
+            nullptr,
+            0,
+            nullptr
+        );
+
+        Profiler::m_rhi_pipeline_barriers++;
+    }
+
+    void RHI_CommandList::InsertMemoryBarrierAliasing()
+    {
+        SP_ASSERT(m_state == RHI_CommandListState::Recording);
+
+        // as per vulkan, you can't have a barrier within a render pass (without a self-dependency)
+        if (m_render_pass_active)
+        {
+            EndRenderPass();
+        }
+        FlushBarriers();
+
+        // transitions out of an undefined layout don't wait for anything, so this is what makes them wait for the previous user of the memory
+        VkMemoryBarrier memory_barrier = {};
+        memory_barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memory_barrier.srcAccessMask   = VK_ACCESS_MEMORY_WRITE_BIT;
+        memory_barrier.dstAccessMask   = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+        vkCmdPipelineBarrier(
+            static_cast<VkCommandBuffer>(m_rhi_resource),
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            1,
+            &memory_barrier,
+            0,
+            nullptr,
+            0,
+            nullptr
+        );
+
+        Profiler::m_rhi_pipeline_barriers++;
+    }
 }
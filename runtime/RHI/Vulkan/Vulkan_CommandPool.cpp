@@ -106,6 +106,19 @@ namespace Spartan
             }
         }
 
+        // free secondary command lists and their pools
+        for (uint32_t pool_index = 0; pool_index < 2; pool_index++)
+        {
+            for (uint32_t i = 0; i < static_cast<uint32_t>(m_cmd_lists_secondary[pool_index].size()); i++)
+            {
+                VkCommandBuffer vk_cmd_buffer = reinterpret_cast<VkCommandBuffer>(m_cmd_lists_secondary[pool_index][i]->GetRhiResource());
+                VkCommandPool vk_cmd_pool     = static_cast<VkCommandPool>(m_rhi_resources_secondary[pool_index][i]);
+
+                vkFreeCommandBuffers(RHI_Context::device, vk_cmd_pool, 1, &vk_cmd_buffer);
+                vkDestroyCommandPool(RHI_Context::device, vk_cmd_pool, nullptr);
+            }
+        }
+
         // destroy commend pools
         vkDestroyCommandPool(RHI_Context::device, static_cast<VkCommandPool>(m_rhi_resources[0]), nullptr);
         vkDestroyCommandPool(RHI_Context::device, static_cast<VkCommandPool>(m_rhi_resources[1]), nullptr);
@@ -146,8 +159,53 @@ namespace Spartan
             // reset
             SP_VK_ASSERT_MSG(vkResetCommandPool(RHI_Context::device, pool, 0), "Failed to reset command pool");
             has_been_reset = true;
+
+            // reset secondaries, they were executed by the primaries that we just waited for
+            uint32_t pool_index = m_using_pool_a ? 0 : 1;
+            for (uint32_t i = 0; i < m_index_secondary[pool_index]; i++)
+            {
+                shared_ptr<RHI_CommandList>& cmd_list = m_cmd_lists_secondary[pool_index][i];
+                SP_ASSERT(cmd_list->GetState() != RHI_CommandListState::Recording);
+
+                if (cmd_list->GetState() == RHI_CommandListState::Submitted)
+                {
+                    cmd_list->WaitForExecution();
+                }
+
+                SP_VK_ASSERT_MSG(vkResetCommandPool(RHI_Context::device, static_cast<VkCommandPool>(m_rhi_resources_secondary[pool_index][i]), 0), "Failed to reset command pool");
+            }
+            m_index_secondary[pool_index] = 0;
         }
 
         return has_been_reset;
     }
+
+    RHI_CommandList* RHI_CommandPool::AcquireSecondaryCommandList()
+    {
+        uint32_t pool_index = m_using_pool_a ? 0 : 1;
+        uint32_t index      = m_index_secondary[pool_index]++;
+
+        // create a new one (with its own pool) if needed, recording can happen on any thread and pools are externally synchronized
+        if (index == m_cmd_lists_secondary[pool_index].size())
+        {
+            VkCommandPoolCreateInfo cmd_pool_info = {};
+            cmd_pool_info.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            cmd_pool_info.queueFamilyIndex        = RHI_Device::QueueGetIndex(m_queue_type);
+            cmd_pool_info.flags                   = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+            string name = m_object_name + "_secondary_" + to_string(pool_index) + "_" + to_string(index);
+
+            VkCommandPool cmd_pool = nullptr;
+            SP_VK_ASSERT_MSG(vkCreateCommandPool(RHI_Context::device, &cmd_pool_info, nullptr, &cmd_pool), "Failed to create command pool");
+            RHI_Device::SetResourceName(cmd_pool, RHI_Resource_Type::CommandPool, name);
+            m_rhi_resources_secondary[pool_index].push_back(static_cast<void*>(cmd_pool));
+
+            m_cmd_lists_secondary[pool_index].push_back(make_shared<RHI_CommandList>(m_queue_type, 0, cmd_pool, name.c_str(), true));
+        }
+
+        RHI_CommandList* cmd_list = m_cmd_lists_secondary[pool_index][index].get();
+        SP_ASSERT(cmd_list->GetState() == RHI_CommandListState::Idle);
+
+        return cmd_list;
+    }
 }
@@ -34,6 +34,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_DescriptorSetLayout.h"
 #include "../RHI_Pipeline.h"
 #include "../RHI_Texture.h"
+#include "../../IO/FileStream.h"
 SP_WARNINGS_OFF
 #define VMA_IMPLEMENTATION
 #include "vk_mem_alloc.h"
@@ -161,6 +162,27 @@ namespace Spartan
 
             return flags;
         }
+
+        VkImageCreateInfo get_image_create_info(RHI_Texture* texture)
+        {
+            VkImageCreateInfo create_info = {};
+            create_info.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            create_info.imageType         = VK_IMAGE_TYPE_2D;
+            create_info.flags             = texture->GetResourceType() == ResourceType::TextureCube ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+            create_info.usage             = get_image_usage_flags(texture);
+            create_info.extent.width      = texture->GetWidth();
+            create_info.extent.height     = texture->GetHeight();
+            create_info.extent.depth      = 1;
+            create_info.mipLevels         = texture->GetMipCount();
+            create_info.arrayLayers       = texture->GetArrayLength();
+            create_info.format            = vulkan_format[rhi_format_to_index(texture->GetFormat())];
+            create_info.tiling            = VK_IMAGE_TILING_OPTIMAL;
+            create_info.initialLayout     = vulkan_image_layout[static_cast<uint8_t>(texture->GetLayout(0))];
+            create_info.samples           = VK_SAMPLE_COUNT_1_BIT;
+            create_info.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+
+            return create_info;
+        }
     }
 
     namespace command_pools
@@ -350,6 +372,7 @@ namespace Spartan
         mutex mutex_allocator;
         VmaAllocator allocator;
         unordered_map<uint64_t, VmaAllocation> allocations;
+        unordered_set<uint64_t> images_aliasing; // images which are bound to memory they don't own
 
         void initialize(const uint32_t api_version)
         {
@@ -631,10 +654,11 @@ namespace Spartan
                 }
             }
 
-            void update_textures(const array<RHI_Texture*, rhi_max_array_size>* textures, const uint32_t binding_slot)
+            void update_textures(const array<RHI_Texture*, rhi_max_array_size>* textures, const uint32_t binding_slot, const uint32_t index_start = 0, const uint32_t index_count = rhi_max_array_size)
             {
                 uint32_t texture_count = static_cast<uint32_t>(textures->size());
                 uint32_t binding       = rhi_shader_shift_register_t + binding_slot;
+                SP_ASSERT(index_start + index_count <= texture_count);
 
                 // create layout and set (if needed)
                 if (layouts[static_cast<uint32_t>(RHI_Device_Resource::textures_material)] == nullptr)
@@ -645,12 +669,12 @@ namespace Spartan
                     create_set(RHI_Device_Resource::textures_material, texture_count, debug_name);
                 }
 
-                // update
+                // update, only the requested range of the array is written
                 {
-                    vector<VkDescriptorImageInfo> image_infos(texture_count);
-                    for (uint32_t i = 0; i < texture_count; ++i)
+                    vector<VkDescriptorImageInfo> image_infos(index_count);
+                    for (uint32_t i = 0; i < index_count; ++i)
                     {
-                        RHI_Texture* texture = (*textures)[i];
+                        RHI_Texture* texture = (*textures)[index_start + i];
                         if (!texture)
                             continue;
 
@@ -667,9 +691,9 @@ namespace Spartan
                     descriptor_write.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
                     descriptor_write.dstSet               = sets[static_cast<uint32_t>(RHI_Device_Resource::textures_material)];
                     descriptor_write.dstBinding           = binding;
-                    descriptor_write.dstArrayElement      = 0; // starting element in the array
+                    descriptor_write.dstArrayElement      = index_start; // starting element in the array
                     descriptor_write.descriptorType       = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-                    descriptor_write.descriptorCount      = texture_count;
+                    descriptor_write.descriptorCount      = index_count;
                     descriptor_write.pImageInfo           = image_infos.data();
 
                     vkUpdateDescriptorSets(RHI_Context::device, 1, &descriptor_write, 0, nullptr);
@@ -691,6 +715,115 @@ namespace Spartan
         }
     }
 
+    namespace pipeline_cache
+    {
+        // the driver compiled pipelines are saved on shutdown and loaded on startup, so that pipelines
+        // which were created in a previous session don't have to be compiled again
+        const char* file_path   = "pipeline_cache.bin";
+        const uint32_t magic    = 0x53504350; // "SPCP"
+        const uint32_t version  = 1;
+
+        // the data is only valid for the device and driver which produced it, and a mismatch can crash some drivers, so it's checked here
+        struct identity
+        {
+            uint32_t vendor_id      = 0;
+            uint32_t device_id      = 0;
+            uint32_t driver_version = 0;
+            vector<unsigned char> uuid;
+
+            bool operator==(const identity& rhs) const
+            {
+                return vendor_id == rhs.vendor_id && device_id == rhs.device_id && driver_version == rhs.driver_version && uuid == rhs.uuid;
+            }
+        };
+
+        identity get_identity()
+        {
+            VkPhysicalDeviceProperties properties = {};
+            vkGetPhysicalDeviceProperties(RHI_Context::device_physical, &properties);
+
+            identity id;
+            id.vendor_id      = properties.vendorID;
+            id.device_id      = properties.deviceID;
+            id.driver_version = properties.driverVersion;
+            id.uuid.assign(properties.pipelineCacheUUID, properties.pipelineCacheUUID + VK_UUID_SIZE);
+
+            return id;
+        }
+
+        void initialize()
+        {
+            // load
+            vector<byte> data;
+            if (FileSystem::IsFile(file_path))
+            {
+                FileStream file(file_path, FileStream_Read);
+                if (file.IsOpen() && file.ReadAs<uint32_t>() == magic && file.ReadAs<uint32_t>() == version)
+                {
+                    identity id;
+                    file.Read(&id.vendor_id);
+                    file.Read(&id.device_id);
+                    file.Read(&id.driver_version);
+                    file.Read(&id.uuid);
+
+                    if (id == get_identity())
+                    {
+                        file.Read(&data);
+                    }
+                    else
+                    {
+                        SP_LOG_INFO("The pipeline cache was created by a different device or driver, it will be rebuilt");
+                    }
+                }
+            }
+
+            // create
+            VkPipelineCacheCreateInfo create_info = {};
+            create_info.sType                     = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+            create_info.initialDataSize           = data.size();
+            create_info.pInitialData              = data.empty() ? nullptr : data.data();
+            SP_VK_ASSERT_MSG(vkCreatePipelineCache(RHI_Context::device, &create_info, nullptr, &RHI_Context::pipeline_cache), "Failed to create pipeline cache");
+
+            if (!data.empty())
+            {
+                SP_LOG_INFO("Loaded pipeline cache (%.1f KB)", static_cast<float>(data.size()) / 1024.0f);
+            }
+        }
+
+        void shutdown()
+        {
+            if (!RHI_Context::pipeline_cache)
+                return;
+
+            // save
+            size_t size = 0;
+            if (vkGetPipelineCacheData(RHI_Context::device, RHI_Context::pipeline_cache, &size, nullptr) == VK_SUCCESS && size != 0)
+            {
+                vector<byte> data(size);
+                if (vkGetPipelineCacheData(RHI_Context::device, RHI_Context::pipeline_cache, &size, data.data()) == VK_SUCCESS)
+                {
+                    data.resize(size);
+
+                    identity id = get_identity();
+                    FileStream file(file_path, FileStream_Write);
+                    if (file.IsOpen())
+                    {
+                        file.Write(magic);
+                        file.Write(version);
+                        file.Write(id.vendor_id);
+                        file.Write(id.device_id);
+                        file.Write(id.driver_version);
+                        file.Write(id.uuid);
+                        file.Write(data);
+                    }
+                }
+            }
+
+            vkDestroyPipelineCache(RHI_Context::device, RHI_Context::pipeline_cache, nullptr);
+            RHI_Context::pipeline_cache = nullptr;
+        }
+    }
+
     namespace device_features
     {
         VkPhysicalDeviceFeatures2 pNext                              = {};
@@ -742,10 +875,27 @@ namespace Spartan
                 SP_ASSERT(features_support.features.imageCubeArray == VK_TRUE);
                 pNext.features.imageCubeArray = VK_TRUE;
 
+                // block compressed textures
+                SP_ASSERT(features_support.features.textureCompressionBC == VK_TRUE);
+                pNext.features.textureCompressionBC = VK_TRUE;
+
                 // timeline semaphores
                 SP_ASSERT(features_1_2_support.timelineSemaphore == VK_TRUE);
                 device_features_1_2.timelineSemaphore = VK_TRUE;
 
+                // indirect draws, with the draw count coming from a buffer as well (gpu driven instancing)
+                {
+                    SP_ASSERT(features_support.features.multiDrawIndirect == VK_TRUE);
+                    pNext.features.multiDrawIndirect = VK_TRUE;
+
+                    // the lods of gpu driven instancing, read their visible instances from their own region
+                    SP_ASSERT(features_support.features.drawIndirectFirstInstance == VK_TRUE);
+                    pNext.features.drawIndirectFirstInstance = VK_TRUE;
+
+                    SP_ASSERT(features_1_2_support.drawIndirectCount == VK_TRUE);
+                    device_features_1_2.drawIndirectCount = VK_TRUE;
+                }
+
                 // descriptors
                 {
                     SP_ASSERT(features_1_2_support.descriptorBindingVariableDescriptorCount == VK_TRUE);
@@ -1043,6 +1193,8 @@ namespace Spartan
 
         CreateDescriptorPool();
 
+        pipeline_cache::initialize();
+
         // detect and log version
         {
             string version_major = to_string(VK_VERSION_MAJOR(app_info.apiVersion));
@@ -1087,6 +1239,9 @@ namespace Spartan
         // descriptors
         descriptors::release();
 
+        // save the pipeline cache to disk
+        pipeline_cache::shutdown();
+
         // the destructor of all the resources enqueues it's vk buffer memory for de-allocation
         // this is where we actually go through them and de-allocate them
         RHI_Device::DeletionQueueParse();
@@ -1570,7 +1725,7 @@ namespace Spartan
         return VkDescriptorType::VK_DESCRIPTOR_TYPE_MAX_ENUM;
     }
 
-    void RHI_Device::UpdateBindlessResources(const array<shared_ptr<RHI_Sampler>, static_cast<uint32_t>(Renderer_Sampler::Max)>* samplers, array<RHI_Texture*, rhi_max_array_size>* textures)
+    void RHI_Device::UpdateBindlessResources(const array<shared_ptr<RHI_Sampler>, static_cast<uint32_t>(Renderer_Sampler::Max)>* samplers, array<RHI_Texture*, rhi_max_array_size>* textures, const uint32_t texture_index, const uint32_t texture_count)
     {
         if (samplers)
         {
@@ -1621,7 +1776,7 @@ namespace Spartan
 
             if (textures)
             {
-                descriptors::bindless::update_textures(textures, binding_slot);
+                descriptors::bindless::update_textures(textures, binding_slot, texture_index, texture_count);
             }
         }
     }
@@ -1755,21 +1910,24 @@ namespace Spartan
     void RHI_Device::MemoryTextureCreate(RHI_Texture* texture)
     {
         // describe image
-        VkImageCreateInfo create_info_image = {};
-        create_info_image.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-        create_info_image.imageType         = VK_IMAGE_TYPE_2D;
-        create_info_image.flags             = texture->GetResourceType() == ResourceType::TextureCube ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
-        create_info_image.usage             = get_image_usage_flags(texture);
-        create_info_image.extent.width      = texture->GetWidth();
-        create_info_image.extent.height     = texture->GetHeight();
-        create_info_image.extent.depth      = 1;
-        create_info_image.mipLevels         = texture->GetMipCount();
-        create_info_image.arrayLayers       = texture->GetArrayLength();
-        create_info_image.format            = vulkan_format[rhi_format_to_index(texture->GetFormat())];
-        create_info_image.tiling            = VK_IMAGE_TILING_OPTIMAL;
-        create_info_image.initialLayout     = vulkan_image_layout[static_cast<uint8_t>(texture->GetLayout(0))];
-        create_info_image.samples           = VK_SAMPLE_COUNT_1_BIT;
-        create_info_image.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+        VkImageCreateInfo create_info_image = get_image_create_info(texture);
+        void*& resource                     = texture->GetRhiResource();
+
+        // bind to memory which is shared with other textures
+        if (void* memory = texture->GetAliasMemory())
+        {
+            SP_VK_ASSERT_MSG(vmaCreateAliasingImage(
+                vulkan_memory_allocator::allocator,
+                static_cast<VmaAllocation>(memory),
+                &create_info_image,
+                reinterpret_cast<VkImage*>(&resource)),
+                "Failed to create aliasing texture");
+
+            lock_guard<mutex> lock(mutex_allocation);
+            vulkan_memory_allocator::images_aliasing.insert(vulkan_memory_allocator::resource_to_id(resource));
+
+            return;
+        }
 
         // describe allocation
         VmaAllocationCreateInfo create_info_allocation = {};
@@ -1782,7 +1940,6 @@ namespace Spartan
         // allocate
         VmaAllocationInfo allocation_info;
         VmaAllocation allocation;
-        void*& resource = texture->GetRhiResource();
         SP_VK_ASSERT_MSG(vmaCreateImage(
             vulkan_memory_allocator::allocator,
             &create_info_image,
@@ -1812,9 +1969,68 @@ namespace Spartan
         {
             vmaDestroyImage(vulkan_memory_allocator::allocator, static_cast<VkImage>(resource), allocation);
             vulkan_memory_allocator::destroy_allocation(resource);
+            return;
+        }
+
+        // the memory outlives the image, it's freed by MemoryAliasDestroy()
+        lock_guard<mutex> lock_allocation(mutex_allocation);
+        if (vulkan_memory_allocator::images_aliasing.erase(vulkan_memory_allocator::resource_to_id(resource)) != 0)
+        {
+            vkDestroyImage(RHI_Context::device, static_cast<VkImage>(resource), nullptr);
+            resource = nullptr;
         }
     }
 
+    void* RHI_Device::MemoryAliasCreate(const vector<RHI_Texture*>& textures, const char* name)
+    {
+        SP_ASSERT(!textures.empty());
+
+        // memory which satisfies all of the textures
+        VkMemoryRequirements requirements = {};
+        requirements.memoryTypeBits       = numeric_limits<uint32_t>::max();
+        for (RHI_Texture* texture : textures)
+        {
+            VkImageCreateInfo create_info_image = get_image_create_info(texture);
+            create_info_image.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            VkDeviceImageMemoryRequirements info = {};
+            info.sType                           = VK_STRUCTURE_TYPE_DEVICE_IMAGE_MEMORY_REQUIREMENTS;
+            info.pCreateInfo                     = &create_info_image;
+
+            VkMemoryRequirements2 requirements_texture = {};
+            requirements_texture.sType                 = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+            vkGetDeviceImageMemoryRequirements(RHI_Context::device, &info, &requirements_texture);
+
+            requirements.size            = max(requirements.size, requirements_texture.memoryRequirements.size);
+            requirements.alignment       = max(requirements.alignment, requirements_texture.memoryRequirements.alignment);
+            requirements.memoryTypeBits &= requirements_texture.memoryRequirements.memoryTypeBits;
+        }
+
+        // the textures can't share memory
+        if (requirements.memoryTypeBits == 0)
+            return nullptr;
+
+        VmaAllocationCreateInfo create_info_allocation = {};
+        create_info_allocation.preferredFlags          = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+        VmaAllocation allocation = nullptr;
+        lock_guard<mutex> lock(vulkan_memory_allocator::mutex_allocator);
+        SP_VK_ASSERT_MSG(vmaAllocateMemory(vulkan_memory_allocator::allocator, &requirements, &create_info_allocation, &allocation, nullptr), "Failed to allocate memory");
+        vmaSetAllocationName(vulkan_memory_allocator::allocator, allocation, name);
+
+        return static_cast<void*>(allocation);
+    }
+
+    void RHI_Device::MemoryAliasDestroy(void*& memory)
+    {
+        if (!memory)
+            return;
+
+        lock_guard<mutex> lock(vulkan_memory_allocator::mutex_allocator);
+        vmaFreeMemory(vulkan_memory_allocator::allocator, static_cast<VmaAllocation>(memory));
+        memory = nullptr;
+    }
+
     void RHI_Device::MemoryMap(void* resource, void*& mapped_data)
     {
         if (VmaAllocation allocation = static_cast<VmaAllocation>(vulkan_memory_allocator::get_allocation_from_resource(resource)))
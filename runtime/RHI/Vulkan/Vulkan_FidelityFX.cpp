@@ -322,6 +322,7 @@ namespace Spartan
         }                                                                                   
 
         // dispatch
+        cmd_list->FlushBarriers(); // fsr records its own commands
         SP_ASSERT(ffxFsr2ContextDispatch(&fsr2_context, &fsr2_dispatch_description) == FFX_OK);
         fsr2_dispatch_description.reset = false;
     }
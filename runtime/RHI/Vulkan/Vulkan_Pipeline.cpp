@@ -211,7 +211,7 @@ namespace Spartan
                 vertex_input_binding_descs.push_back
                 ({
                     1,                            // binding
-                    sizeof(Math::Matrix),         // stride
+                    sizeof(RHI_Instance),         // stride
                     VK_VERTEX_INPUT_RATE_INSTANCE // inputRate
                 });
             }
@@ -233,18 +233,22 @@ namespace Spartan
 
             if (m_state.instancing)
             {
-                // update the attribute descriptions to pass the entire matrix
-                // each row of the matrix is treated as a separate attribute
-                for (uint32_t i = 0; i < 4; i++)
-                {
-                    vertex_attribute_descs.push_back
-                    ({
-                        static_cast<uint32_t>(vertex_attribute_descs.size()), // location, assuming the next available location
-                        1,                                                    // binding
-                        VK_FORMAT_R32G32B32A32_SFLOAT,                        // format, assuming 32-bit float components
-                        i * sizeof(Math::Vector4)                             // offset, assuming Math::Vector4 is the type of each row
-                    });
-                }
+                // the compact instance (RHI_Instance), position and scale as one attribute, then the rotation
+                vertex_attribute_descs.push_back
+                ({
+                    static_cast<uint32_t>(vertex_attribute_descs.size()), // location, assuming the next available location
+                    1,                                                    // binding
+                    VK_FORMAT_R32G32B32A32_SFLOAT,                        // format, position (xyz) and uniform scale (w)
+                    offsetof(RHI_Instance, position)                      // offset
+                });
+
+                vertex_attribute_descs.push_back
+                ({
+                    static_cast<uint32_t>(vertex_attribute_descs.size()), // location
+                    1,                                                    // binding
+                    VK_FORMAT_R16G16B16A16_SNORM,                         // format, the rotation quaternion
+                    offsetof(RHI_Instance, rotation)                      // offset
+                });
             }
         }
 
@@ -425,7 +429,7 @@ namespace Spartan
                 pipeline_info.renderPass                   = nullptr;
         
                 // Create
-                SP_VK_ASSERT_MSG(vkCreateGraphicsPipelines(RHI_Context::device, nullptr, 1, &pipeline_info, nullptr, pipeline),
+                SP_VK_ASSERT_MSG(vkCreateGraphicsPipelines(RHI_Context::device, RHI_Context::pipeline_cache, 1, &pipeline_info, nullptr, pipeline),
                     "Failed to create graphics pipeline");
 
                 // disable naming until I can come up with a more meaningful name
@@ -440,7 +444,7 @@ namespace Spartan
                 pipeline_info.stage                       = shader_stages[0];
 
                 // create
-                SP_VK_ASSERT_MSG(vkCreateComputePipelines(RHI_Context::device, nullptr, 1, &pipeline_info, nullptr, pipeline),
+                SP_VK_ASSERT_MSG(vkCreateComputePipelines(RHI_Context::device, RHI_Context::pipeline_cache, 1, &pipeline_info, nullptr, pipeline),
                     "Failed to create compute pipeline");
 
                 // name
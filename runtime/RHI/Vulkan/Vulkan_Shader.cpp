@@ -151,46 +151,55 @@ namespace Spartan
             arguments.emplace_back("-D"); arguments.emplace_back(define.first + "=" + define.second);
         }
 
-        // compile
-        if (IDxcResult* dxc_result = DirecXShaderCompiler::Compile(m_preprocessed_source, arguments))
+        // load the spir-v and the reflection from the cache, or compile and reflect, and then cache them
+        vector<byte> bytecode;
+        uint64_t cache_key = GetCacheKey(arguments, DirecXShaderCompiler::GetVersion());
+        if (!LoadFromCache(cache_key, bytecode))
         {
+            IDxcResult* dxc_result = DirecXShaderCompiler::Compile(m_preprocessed_source, arguments);
+            if (!dxc_result)
+                return nullptr;
+
             // get compiled shader buffer
             IDxcBlob* shader_buffer = nullptr;
             dxc_result->GetResult(&shader_buffer);
+            const byte* buffer = static_cast<const byte*>(shader_buffer->GetBufferPointer());
+            bytecode.assign(buffer, buffer + shader_buffer->GetBufferSize());
 
-            // create shader module
-            VkShaderModule shader_module         = nullptr;
-            VkShaderModuleCreateInfo create_info = {};
-            create_info.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-            create_info.codeSize                 = static_cast<size_t>(shader_buffer->GetBufferSize());
-            create_info.pCode                    = reinterpret_cast<const uint32_t*>(shader_buffer->GetBufferPointer());
-
-            SP_VK_ASSERT_MSG(vkCreateShaderModule(RHI_Context::device, &create_info, nullptr, &shader_module), "Failed to create shader module");
-
-            // name the shader module (useful for gpu-based validation)
-            RHI_Device::SetResourceName(static_cast<void*>(shader_module), RHI_Resource_Type::Shader, m_object_name.c_str());
+            // release
+            dxc_result->Release();
 
             // reflect shader resources (so that descriptor sets can be created later)
+            m_descriptors.clear();
             Reflect
             (
                 m_shader_type,
-                reinterpret_cast<uint32_t*>(shader_buffer->GetBufferPointer()),
-                static_cast<uint32_t>(shader_buffer->GetBufferSize() / 4)
+                reinterpret_cast<uint32_t*>(bytecode.data()),
+                static_cast<uint32_t>(bytecode.size() / 4)
             );
-            
-            // create input layout
-            if (m_input_layout)
-            {
-                m_input_layout->Create(m_vertex_type, nullptr);
-            }
 
-            // release
-            dxc_result->Release();
+            SaveToCache(cache_key, bytecode);
+        }
+
+        // create shader module
+        VkShaderModule shader_module         = nullptr;
+        VkShaderModuleCreateInfo create_info = {};
+        create_info.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        create_info.codeSize                 = bytecode.size();
+        create_info.pCode                    = reinterpret_cast<const uint32_t*>(bytecode.data());
 
-            return static_cast<void*>(shader_module);
+        SP_VK_ASSERT_MSG(vkCreateShaderModule(RHI_Context::device, &create_info, nullptr, &shader_module), "Failed to create shader module");
+
+        // name the shader module (useful for gpu-based validation)
+        RHI_Device::SetResourceName(static_cast<void*>(shader_module), RHI_Resource_Type::Shader, m_object_name.c_str());
+
+        // create input layout
+        if (m_input_layout)
+        {
+            m_input_layout->Create(m_vertex_type, nullptr);
         }
 
-        return nullptr;
+        return static_cast<void*>(shader_module);
     }
 
     void RHI_Shader::Reflect(const RHI_Shader_Stage shader_stage, const uint32_t* ptr, const uint32_t size)
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_Device.h"
 #include "../RHI_Implementation.h"
 #include "../RHI_StructuredBuffer.h"
+#include "../RHI_CommandList.h"
 //==================================
 
 //= NAMESPACES =====
@@ -32,7 +33,7 @@ using namespace std;
 
 namespace Spartan
 {
-    RHI_StructuredBuffer::RHI_StructuredBuffer(const uint32_t stride, const uint32_t element_count, const char* name)
+    RHI_StructuredBuffer::RHI_StructuredBuffer(const uint32_t stride, const uint32_t element_count, const char* name, const bool is_mappable, const void* data_initial)
     {
         m_object_name     = name;
         m_stride          = stride;
@@ -47,13 +48,41 @@ namespace Spartan
         }
         m_object_size_gpu = m_stride * m_element_count;
 
-        // create buffer
-        VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT; // mappable
-        RHI_Device::MemoryBufferCreate(m_rhi_resource, m_object_size_gpu, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, flags, nullptr, name);
-        RHI_Device::SetResourceName(m_rhi_resource, RHI_Resource_Type::Buffer, name); // name the resource
+        if (is_mappable)
+        {
+            SP_ASSERT_MSG(data_initial == nullptr, "Mappable buffers are initialized with Update()");
+
+            // create buffer
+            VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT; // mappable
+            RHI_Device::MemoryBufferCreate(m_rhi_resource, m_object_size_gpu, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, flags, nullptr, name);
+
+            // get mapped data pointer
+            m_mapped_data = RHI_Device::MemoryGetMappedDataFromBuffer(m_rhi_resource);
+        }
+        else
+        {
+            // create buffer
+            uint32_t usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            RHI_Device::MemoryBufferCreate(m_rhi_resource, m_object_size_gpu, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, nullptr, name);
+
+            // copy the initial data over, through a staging buffer
+            if (data_initial)
+            {
+                void* staging_buffer = nullptr;
+                RHI_Device::MemoryBufferCreate(staging_buffer, stride * element_count, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, data_initial, name);
+
+                RHI_CommandList* cmd_list = RHI_Device::CmdImmediateBegin(RHI_Queue_Type::Copy);
 
-        // get mapped data pointer
-        m_mapped_data = RHI_Device::MemoryGetMappedDataFromBuffer(m_rhi_resource); 
+                VkBufferCopy copy_region = {};
+                copy_region.size         = stride * element_count;
+                vkCmdCopyBuffer(static_cast<VkCommandBuffer>(cmd_list->GetRhiResource()), static_cast<VkBuffer>(staging_buffer), static_cast<VkBuffer>(m_rhi_resource), 1, &copy_region);
+
+                RHI_Device::CmdImmediateSubmit(cmd_list);
+                RHI_Device::MemoryBufferDestroy(staging_buffer);
+            }
+        }
+
+        RHI_Device::SetResourceName(m_rhi_resource, RHI_Resource_Type::Buffer, name); // name the resource
     }
 
     RHI_StructuredBuffer::~RHI_StructuredBuffer()
@@ -62,9 +91,10 @@ namespace Spartan
         m_rhi_resource = nullptr;
     }
 
-    void RHI_StructuredBuffer::Update(void* data_cpu)
+    void RHI_StructuredBuffer::Update(void* data_cpu, const uint32_t size)
     {
         SP_ASSERT_MSG(data_cpu != nullptr,                      "Invalid update data");
+        SP_ASSERT_MSG(size <= m_stride,                         "Size exceeds the stride");
         SP_ASSERT_MSG(m_mapped_data != nullptr,                 "Invalid mapped data");
         SP_ASSERT_MSG(m_offset + m_stride <= m_object_size_gpu, "Out of memory");
 
@@ -79,6 +109,15 @@ namespace Spartan
         }
 
         // we are using persistent mapping, so we only copy (no need for map/unmap)
-        memcpy(reinterpret_cast<std::byte*>(m_mapped_data) + m_offset, reinterpret_cast<std::byte*>(data_cpu), m_stride);
+        memcpy(reinterpret_cast<std::byte*>(m_mapped_data) + m_offset, reinterpret_cast<std::byte*>(data_cpu), size != 0 ? size : m_stride);
+    }
+
+    void RHI_StructuredBuffer::UpdateRange(void* data_cpu, const uint32_t offset, const uint32_t size)
+    {
+        SP_ASSERT_MSG(data_cpu != nullptr,       "Invalid update data");
+        SP_ASSERT_MSG(offset + size <= m_stride, "Range exceeds the stride");
+        SP_ASSERT_MSG(m_mapped_data != nullptr,  "Invalid mapped data");
+
+        memcpy(reinterpret_cast<std::byte*>(m_mapped_data) + m_offset + offset, reinterpret_cast<std::byte*>(data_cpu), size);
     }
 }
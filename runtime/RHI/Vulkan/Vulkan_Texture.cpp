@@ -141,6 +141,14 @@ namespace Spartan
             create_info.components.b                    = VK_COMPONENT_SWIZZLE_IDENTITY;
             create_info.components.a                    = VK_COMPONENT_SWIZZLE_IDENTITY;
 
+            // single channel compressed textures were greyscale, so they read as such
+            if (texture->GetFormat() == RHI_Format::BC4)
+            {
+                create_info.components.g = VK_COMPONENT_SWIZZLE_R;
+                create_info.components.b = VK_COMPONENT_SWIZZLE_R;
+                create_info.components.a = VK_COMPONENT_SWIZZLE_ONE;
+            }
+
             SP_ASSERT_MSG(vkCreateImageView(RHI_Context::device, &create_info, nullptr, reinterpret_cast<VkImageView*>(&image_view)) == VK_SUCCESS, "Failed to create image view");
         }
 
@@ -195,7 +203,6 @@ namespace Spartan
             const uint32_t height          = texture->GetHeight();
             const uint32_t array_length    = texture->GetArrayLength();
             const uint32_t mip_count       = texture->GetMipCount();
-            const uint32_t bytes_per_pixel = texture->GetBytesPerPixel();
 
             const uint32_t region_count = array_length * mip_count;
             regions.resize(region_count);
@@ -224,7 +231,7 @@ namespace Spartan
                     regions[region_index].imageExtent                     = { mip_width, mip_height, 1 };
 
                     // update staging buffer memory requirement (in bytes)
-                    buffer_offset += static_cast<uint64_t>(mip_width) * static_cast<uint64_t>(mip_height) * static_cast<uint64_t>(bytes_per_pixel);
+                    buffer_offset += texture->GetMipSize(mip_index);
                 }
             }
 
@@ -240,11 +247,13 @@ namespace Spartan
                 {
                     for (uint32_t mip_index = 0; mip_index < mip_count; mip_index++)
                     {
-                        uint64_t buffer_size = static_cast<uint64_t>(width >> mip_index) * static_cast<uint64_t>(height >> mip_index) * static_cast<uint64_t>(bytes_per_pixel);
+                        uint64_t buffer_size = texture->GetMipSize(mip_index);
 
-                        if (texture->GetMip(array_index, mip_index).bytes.size() != 0)
+                        // engine textures are copied straight from their file's mapping
+                        span<const std::byte> bytes = texture->GetMip(array_index, mip_index).GetBytes();
+                        if (bytes.size() != 0)
                         {
-                            memcpy(static_cast<std::byte*>(mapped_data) + buffer_offset, texture->GetMip(array_index, mip_index).bytes.data(), buffer_size);
+                            memcpy(static_cast<std::byte*>(mapped_data) + buffer_offset, bytes.data(), min(buffer_size, static_cast<uint64_t>(bytes.size())));
                         }
 
                         buffer_offset += buffer_size;
@@ -273,6 +282,7 @@ namespace Spartan
 
                 // insert memory barrier
                 cmd_list->InsertMemoryBarrierImage(texture, 0, texture->GetMipCount(), texture->GetArrayLength(), texture->GetLayout(0), layout);
+                cmd_list->FlushBarriers();
 
                 // copy the staging buffer to the image
                 vkCmdCopyBufferToImage(
@@ -21,79 +21,183 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
 
-//= INCLUDES ===============
-#include <unordered_map>
+//= INCLUDES ==================
+#include <bit>
 #include "../Math/Vector3.h"
 #include "../Math/Matrix.h"
-//==========================
+#include "../Core/ThreadPool.h"
+//=============================
 
 namespace grid_partitioning
 {
     // this namespace organizes 3D objects into a grid layout, grouping instances into grid cells
     // it enables optimized rendering by allowing culling of non-visible chunks efficiently
+    // the instances are sorted by the morton code of their cell, so neighbouring cells (and therefore groups) are also neighbours in memory
 
-    const uint32_t physical_cell_size = 125;
+    const float cell_size_default           = 125.0f;
+    const uint32_t group_instance_count_max = 4096;  // a cell with more instances than this is split into its octants
+    const uint32_t subdivision_levels       = 2;     // how many times a cell can be split
+    const uint32_t bits_per_axis            = 21;    // 63 bits of morton code
+    const uint32_t parallel_instance_count  = 16384; // below this, going wide costs more than it saves
 
-    struct GridKey
+    // spreads the lower 21 bits of a value, so that there are two zero bits between each of them
+    inline uint64_t expand_bits(uint64_t value)
     {
-        uint32_t x, y, z;
+        value &= 0x1fffff;
+        value  = (value | value << 32) & 0x001f00000000ffff;
+        value  = (value | value << 16) & 0x001f0000ff0000ff;
+        value  = (value | value << 8)  & 0x100f00f00f00f00f;
+        value  = (value | value << 4)  & 0x10c30c30c30c30c3;
+        value  = (value | value << 2)  & 0x1249249249249249;
+        return value;
+    }
 
-        bool operator==(const GridKey& other) const
+    inline uint64_t get_morton_code(const uint32_t x, const uint32_t y, const uint32_t z)
+    {
+        return expand_bits(x) | (expand_bits(y) << 1) | (expand_bits(z) << 2);
+    }
+
+    // stable, least significant byte first, only for as many bytes as the largest key has
+    inline void radix_sort(std::vector<uint64_t>& keys, std::vector<uint32_t>& indices)
+    {
+        uint64_t key_max = 0;
+        for (uint64_t key : keys)
         {
-            return x == other.x && y == other.y && z == other.z;
+            key_max = std::max(key_max, key);
         }
-    };
 
-    struct GridKeyHash
-    {
-        size_t operator()(const GridKey& k) const
+        std::vector<uint64_t> keys_sorted(keys.size());
+        std::vector<uint32_t> indices_sorted(indices.size());
+        for (uint32_t shift = 0; shift < static_cast<uint32_t>(std::bit_width(key_max)); shift += 8)
         {
-            // interleave the bits of the x, y, and z coordinates
-            // this approach tends to maintain spatial locality better, as nearby
-            // coordinates will result in hash values that are also close to each other
+            uint32_t offsets[257] = {};
+            for (uint64_t key : keys)
+            {
+                offsets[((key >> shift) & 0xff) + 1]++;
+            }
 
-            size_t result = 0;
+            for (uint32_t i = 1; i < 257; i++)
+            {
+                offsets[i] += offsets[i - 1];
+            }
 
-            for (uint32_t i = 0; i < (sizeof(uint32_t) * 8); i++) // for each bit in the integers
+            for (uint32_t i = 0; i < static_cast<uint32_t>(keys.size()); i++)
             {
-                result |= ((k.x & (1 << i)) << (2 * i)) | ((k.y & (1 << i)) << ((2 * i) + 1)) | ((k.z & (1 << i)) << ((2 * i) + 2));
+                uint32_t destination        = offsets[(keys[i] >> shift) & 0xff]++;
+                keys_sorted[destination]    = keys[i];
+                indices_sorted[destination] = indices[i];
             }
 
-            return result;
+            keys.swap(keys_sorted);
+            indices.swap(indices_sorted);
         }
+    }
 
-        static GridKey get_key(const Spartan::Math::Vector3& position)
+    // moves every element to its sorted position by following the cycles of the permutation, each matrix is moved once
+    inline void permute_in_place(std::vector<Spartan::Math::Matrix>& instance_transforms, const std::vector<uint32_t>& order)
+    {
+        std::vector<bool> done(order.size(), false);
+        for (uint32_t start = 0; start < static_cast<uint32_t>(order.size()); start++)
         {
-            return
+            if (done[start] || order[start] == start)
+                continue;
+
+            Spartan::Math::Matrix first = instance_transforms[start];
+            uint32_t current            = start;
+            while (true)
             {
-                static_cast<uint32_t>(std::floor(position.x / static_cast<float>(physical_cell_size))),
-                static_cast<uint32_t>(std::floor(position.y / static_cast<float>(physical_cell_size))),
-                static_cast<uint32_t>(std::floor(position.z / static_cast<float>(physical_cell_size)))
-            };
+                done[current]   = true;
+                uint32_t source = order[current];
+                if (source == start)
+                {
+                    instance_transforms[current] = first;
+                    break;
+                }
+
+                instance_transforms[current] = instance_transforms[source];
+                current                      = source;
+            }
         }
-    };
+    }
 
-    void reorder_instances_into_cell_chunks(std::vector<Spartan::Math::Matrix>& instance_transforms, std::vector<uint32_t>& cell_end_indices)
+    // the instances are sorted, so a cell is a run of equal codes at its level, a coarser level is the code shifted by 3 bits per level
+    inline void emit_groups(const std::vector<uint64_t>& codes, const uint32_t start, const uint32_t end, const uint32_t level, std::vector<uint32_t>& cell_end_indices)
     {
-        // populate the grid map
-        std::unordered_map<GridKey, std::vector<Spartan::Math::Matrix>, GridKeyHash> grid_map;
-        for (const auto& instance : instance_transforms)
+        const uint32_t shift = level * 3;
+
+        uint32_t run_start = start;
+        while (run_start < end)
         {
-            Spartan::Math::Vector3 position = instance.GetTranslation();
+            const uint64_t cell = codes[run_start] >> shift;
+            uint32_t run_end    = run_start + 1;
+            while (run_end < end && (codes[run_end] >> shift) == cell)
+            {
+                run_end++;
+            }
+
+            if (run_end - run_start > group_instance_count_max && level > 0)
+            {
+                emit_groups(codes, run_start, run_end, level - 1, cell_end_indices);
+            }
+            else
+            {
+                cell_end_indices.push_back(run_end);
+            }
 
-            GridKey key = GridKeyHash::get_key(position);
-            grid_map[key].push_back(instance);
+            run_start = run_end;
         }
+    }
 
-        // reorder instances based on grid map
-        instance_transforms.clear();
+    inline void reorder_instances_into_cell_chunks(std::vector<Spartan::Math::Matrix>& instance_transforms, std::vector<uint32_t>& cell_end_indices, float cell_size = cell_size_default)
+    {
         cell_end_indices.clear();
-        uint32_t index = 0;
-        for (const auto& [key, transforms] : grid_map)
+
+        const uint32_t instance_count = static_cast<uint32_t>(instance_transforms.size());
+        if (instance_count == 0)
+            return;
+
+        // the codes are computed for the finest subdivision, a cell of the requested size is a few bits away
+        cell_size                 = cell_size > 0.0f ? cell_size : cell_size_default;
+        const float cell_size_inv = static_cast<float>(1 << subdivision_levels) / cell_size;
+
+        // relative to the minimum, so that negative coordinates don't wrap
+        Spartan::Math::Vector3 position_min = Spartan::Math::Vector3::Infinity;
+        for (const Spartan::Math::Matrix& transform : instance_transforms)
         {
-            instance_transforms.insert(instance_transforms.end(), transforms.begin(), transforms.end());
-            index += static_cast<uint32_t>(transforms.size());
-            cell_end_indices.push_back(index);
+            const Spartan::Math::Vector3 position = transform.GetTranslation();
+            position_min.x                        = std::min(position_min.x, position.x);
+            position_min.y                        = std::min(position_min.y, position.y);
+            position_min.z                        = std::min(position_min.z, position.z);
         }
+
+        std::vector<uint64_t> codes(instance_count);
+        std::vector<uint32_t> order(instance_count);
+        auto compute_codes = [&](uint32_t start, uint32_t end)
+        {
+            const float coordinate_max = static_cast<float>((1 << bits_per_axis) - 1);
+            for (uint32_t i = start; i < end; i++)
+            {
+                const Spartan::Math::Vector3 cell = (instance_transforms[i].GetTranslation() - position_min) * cell_size_inv;
+                codes[i]                          = get_morton_code(
+                    static_cast<uint32_t>(std::min(cell.x, coordinate_max)),
+                    static_cast<uint32_t>(std::min(cell.y, coordinate_max)),
+                    static_cast<uint32_t>(std::min(cell.z, coordinate_max))
+                );
+                order[i]                          = i;
+            }
+        };
+
+        if (instance_count >= parallel_instance_count)
+        {
+            Spartan::ThreadPool::ParallelFor(compute_codes, instance_count);
+        }
+        else
+        {
+            compute_codes(0, instance_count);
+        }
+
+        radix_sort(codes, order);
+        permute_in_place(instance_transforms, order);
+        emit_groups(codes, 0, instance_count, subdivision_levels, cell_end_indices);
     }
 }
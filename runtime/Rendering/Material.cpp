@@ -27,6 +27,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_Texture2D.h"
 #include "../RHI/RHI_TextureCube.h"
 #include "../World/World.h"
+#include "../IO/AssetArchive.h"
 SP_WARNINGS_OFF
 #include "../IO/pugixml.hpp"
 SP_WARNINGS_ON
@@ -104,8 +105,10 @@ namespace Spartan
 
     bool Material::LoadFromFile(const std::string& file_path)
     {
+        // parsed from the mapping, which can be of the copy in the archive
         pugi::xml_document doc;
-        if (!doc.load_file(file_path.c_str()))
+        shared_ptr<FileMapping> mapping = AssetArchive::Map(file_path);
+        if (!mapping || !doc.load_buffer(mapping->GetData(), static_cast<size_t>(mapping->GetSize())))
         {
             SP_LOG_ERROR("Failed to load XML file");
             return false;
@@ -134,14 +137,17 @@ namespace Spartan
             string tex_path         = node_texture.attribute("texture_path").as_string();
 
             // If the texture happens to be loaded, get a reference to it
-            auto texture = ResourceCache::GetByName<RHI_Texture2D>(tex_name);
-            // If there is not texture (it's not loaded yet), load it
-            if (!texture)
+            if (auto texture = ResourceCache::GetByName<RHI_Texture2D>(tex_name))
             {
-                texture = ResourceCache::Load<RHI_Texture2D>(tex_path);
+                SetTexture(tex_type, texture);
+            }
+            // If there is not texture (it's not loaded yet), load it in the background
+            else if (!tex_path.empty())
+            {
+                ResourceHandle<RHI_Texture2D> handle = ResourceCache::LoadAsync<RHI_Texture2D>(tex_path);
+                m_textures_loading[static_cast<uint32_t>(tex_type)] = handle;
+                SetTextureSlot(tex_type, handle.Get());
             }
-
-            SetTexture(tex_type, texture);
         }
 
         m_object_size_cpu = sizeof(*this);
@@ -177,22 +183,20 @@ namespace Spartan
             textureNode.append_attribute("texture_path").set_value(m_textures[i] ? m_textures[i]->GetResourceFilePathNative().c_str() : "");
         }
 
+        AssetArchive::Invalidate(file_path);
         return doc.save_file(file_path.c_str());
     }
 
     void Material::SetTexture(const MaterialTexture texture_type, RHI_Texture* texture)
     {
-        uint32_t type_int = static_cast<uint32_t>(texture_type);
+        // cache the texture to ensure scene serialization/deserialization
+        m_textures_loading[static_cast<uint32_t>(texture_type)] = ResourceHandle<RHI_Texture2D>();
+        SetTextureSlot(texture_type, texture ? ResourceCache::Cache(texture->GetSharedPtr()) : nullptr);
+    }
 
-        if (texture)
-        {
-            // cache the texture to ensure scene serialization/deserialization
-            m_textures[type_int] = ResourceCache::Cache(texture->GetSharedPtr());
-        }
-        else
-        {
-            m_textures[type_int] = nullptr;
-        }
+    void Material::SetTextureSlot(const MaterialTexture texture_type, shared_ptr<RHI_Texture> texture)
+    {
+        m_textures[static_cast<uint32_t>(texture_type)] = texture;
 
         // set the correct multiplier
         float multiplier = texture != nullptr;
@@ -213,7 +217,7 @@ namespace Spartan
             SetProperty(MaterialProperty::Height, multiplier);
         }
 
-        SP_FIRE_EVENT(EventType::MaterialOnChanged);
+        SP_FIRE_EVENT_DATA(EventType::MaterialOnChanged, static_cast<void*>(this));
     }
 
     void Material::SetTexture(const MaterialTexture texture_type, shared_ptr<RHI_Texture> texture)
@@ -233,7 +237,17 @@ namespace Spartan
 
     void Material::SetTexture(const MaterialTexture texture_type, const string& file_path)
     {
-        SetTexture(texture_type, ResourceCache::Load<RHI_Texture2D>(file_path, RHI_Texture_Srv | RHI_Texture_Mips | RHI_Texture_Compressed));
+        // the slot determines the compressed format of normal maps, the rest is deduced from the image
+        // colour is srgb (the shaders degamma it), so its mips are filtered in linear space
+        const uint32_t type      = static_cast<uint32_t>(texture_type);
+        const bool is_normal_map = type >= static_cast<uint32_t>(MaterialTexture::Normal) && type <= static_cast<uint32_t>(MaterialTexture::Normal4);
+        const bool is_color      = type >= static_cast<uint32_t>(MaterialTexture::Color)  && type <= static_cast<uint32_t>(MaterialTexture::Color4);
+        const uint32_t flags     = RHI_Texture_Srv | RHI_Texture_Mips | RHI_Texture_Compressed | (is_normal_map ? static_cast<uint32_t>(RHI_Texture_NormalMap) : 0u) | (is_color ? static_cast<uint32_t>(RHI_Texture_Srgb) : 0u);
+
+        // the texture is assigned while it loads, the renderer only binds it once it's ready (and the loader caches it)
+        ResourceHandle<RHI_Texture2D> handle = ResourceCache::LoadAsync<RHI_Texture2D>(file_path, flags);
+        m_textures_loading[type]             = handle;
+        SetTextureSlot(texture_type, handle.Get());
     }
  
     bool Material::HasTexture(const string& path) const
@@ -255,6 +269,23 @@ namespace Spartan
         return m_textures[static_cast<uint32_t>(texture_type)] != nullptr;
     }
 
+    bool Material::IsTextureReady(const MaterialTexture texture_type) const
+    {
+        const shared_ptr<RHI_Texture>& texture = m_textures[static_cast<uint32_t>(texture_type)];
+        return texture && texture->IsReadyForUse();
+    }
+
+    bool Material::IsLoading() const
+    {
+        for (const ResourceHandle<RHI_Texture2D>& handle : m_textures_loading)
+        {
+            if (handle.IsLoading())
+                return true;
+        }
+
+        return false;
+    }
+
     string Material::GetTexturePathByType(const MaterialTexture texture_type)
     {
         if (!HasTexture(texture_type))
@@ -337,7 +368,7 @@ namespace Spartan
 
         m_properties[static_cast<uint32_t>(property_type)] = value;
 
-        SP_FIRE_EVENT(EventType::MaterialOnChanged);
+        SP_FIRE_EVENT_DATA(EventType::MaterialOnChanged, static_cast<void*>(this));
     }
 
     void Material::SetColor(const Color& color)
@@ -21,12 +21,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
 
-//= INCLUDES ======================
+//= INCLUDES ========================
 #include <memory>
 #include <array>
 #include "../RHI/RHI_Definitions.h"
 #include "../Resource/IResource.h"
-//=================================
+#include "../Resource/ResourceLoader.h"
+//===================================
 
 namespace Spartan
 {
@@ -100,6 +101,8 @@ namespace Spartan
         void SetTexture(const MaterialTexture texture_type, const std::string& file_path);
         bool HasTexture(const std::string& path) const;
         bool HasTexture(const MaterialTexture texture_type) const;
+        bool IsTextureReady(const MaterialTexture texture_type) const; // loaded and created on the gpu
+        bool IsLoading() const;                                        // any of the textures
         std::string GetTexturePathByType(const MaterialTexture texture_type);
         std::vector<std::string> GetTexturePaths();
         RHI_Texture* GetTexture(const MaterialTexture texture_type);
@@ -116,7 +119,10 @@ namespace Spartan
         uint32_t GetIndex() const           { return m_index; }
 
     private:
+        void SetTextureSlot(const MaterialTexture texture_type, std::shared_ptr<RHI_Texture> texture);
+
         std::array<std::shared_ptr<RHI_Texture>, material_texture_count_support> m_textures;
+        std::array<ResourceHandle<RHI_Texture2D>, material_texture_count_support> m_textures_loading;
         std::array<float, material_property_count> m_properties;
         uint32_t m_index = 0;
     };
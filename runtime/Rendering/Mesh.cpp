@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Renderer.h"
 #include "../RHI/RHI_VertexBuffer.h"
 #include "../RHI/RHI_IndexBuffer.h"
+#include "../RHI/RHI_StructuredBuffer.h"
 #include "../RHI/RHI_Texture2D.h"
 #include "../World/Components/Renderable.h"
 #include "../World/Entity.h"
@@ -43,6 +44,45 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    namespace
+    {
+        // the engine format starts with these, bump the version whenever what follows changes
+        const uint32_t mesh_format_magic   = 0x48534D53; // "SMSH"
+        const uint32_t mesh_format_version = 1;
+
+        void pack_octahedral(const float* direction, int16_t* packed)
+        {
+            // project onto the octahedron, and fold the lower hemisphere over the diagonals
+            const float length = abs(direction[0]) + abs(direction[1]) + abs(direction[2]);
+            float x            = length > 0.0f ? direction[0] / length : 0.0f;
+            float y            = length > 0.0f ? direction[1] / length : 0.0f;
+            if (length > 0.0f && direction[2] < 0.0f)
+            {
+                const float x_folded = (1.0f - abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+                y                    = (1.0f - abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+                x                    = x_folded;
+            }
+
+            packed[0] = static_cast<int16_t>(meshopt_quantizeSnorm(x, 16));
+            packed[1] = static_cast<int16_t>(meshopt_quantizeSnorm(y, 16));
+        }
+
+        RHI_Vertex_PosTexNorTanPacked pack_vertex(const RHI_Vertex_PosTexNorTan& vertex)
+        {
+            RHI_Vertex_PosTexNorTanPacked packed;
+
+            packed.pos[0] = vertex.pos[0];
+            packed.pos[1] = vertex.pos[1];
+            packed.pos[2] = vertex.pos[2];
+            packed.tex[0] = meshopt_quantizeHalf(vertex.tex[0]);
+            packed.tex[1] = meshopt_quantizeHalf(vertex.tex[1]);
+            pack_octahedral(vertex.nor, &packed.nor_tan[0]);
+            pack_octahedral(vertex.tan, &packed.nor_tan[2]);
+
+            return packed;
+        }
+    }
+
     Mesh::Mesh() : IResource(ResourceType::Mesh)
     {
         m_flags = GetDefaultFlags();
@@ -61,6 +101,12 @@ namespace Spartan
 
         m_vertices.clear();
         m_vertices.shrink_to_fit();
+
+        m_clusters.clear();
+        m_clusters.shrink_to_fit();
+
+        m_lods.clear();
+        m_lods.shrink_to_fit();
     }
 
     bool Mesh::LoadFromFile(const string& file_path)
@@ -74,28 +120,83 @@ namespace Spartan
         }
 
         // load engine format
-        if (FileSystem::GetExtensionFromFilePath(file_path) == EXTENSION_MODEL)
+        string file_path_import = FileSystem::GetExtensionFromFilePath(file_path) != EXTENSION_MODEL ? file_path : "";
+        if (file_path_import.empty())
         {
             // deserialize
             auto file = make_unique<FileStream>(file_path, FileStream_Read);
             if (!file->IsOpen())
                 return false;
 
-            SetResourceFilePath(file->ReadAs<string>());
-            file->Read(&m_indices);
-            file->Read(&m_vertices);
+            // files saved without the header start with the path, which is what every version saves first
+            const uint32_t magic   = file->ReadAs<uint32_t>();
+            const uint32_t version = magic == mesh_format_magic ? file->ReadAs<uint32_t>() : 0;
+            if (magic != mesh_format_magic)
+            {
+                file = make_unique<FileStream>(file_path, FileStream_Read);
+            }
+            const string file_path_source = file->ReadAs<string>();
 
-            //Optimize();
-            ComputeAabb();
-            ComputeNormalizedScale();
-            CreateGpuBuffers();
+            // what an incompatible version saved can't be read, so it's imported again from the file that it was imported from
+            if (version != mesh_format_version)
+            {
+                if (file_path_source.empty() || !FileSystem::IsFile(file_path_source))
+                {
+                    SP_LOG_ERROR("\"%s\" was saved by an incompatible version and the file that it was imported from is missing", file_path.c_str());
+                    return false;
+                }
+
+                SP_LOG_WARNING("\"%s\" was saved by an incompatible version, re-importing \"%s\"", file_path.c_str(), file_path_source.c_str());
+                file_path_import = file_path_source;
+            }
+            else
+            {
+                SetResourceFilePath(file_path_source);
+                file->Read(&m_flags);
+                if (m_flags & static_cast<uint32_t>(MeshFlags::CompressEngineFormat))
+                {
+                    // decoded straight from the file's mapping
+                    const uint32_t index_count             = file->ReadAs<uint32_t>();
+                    const uint32_t vertex_count            = file->ReadAs<uint32_t>();
+                    span<const std::byte> indices_encoded  = file->ReadSpan();
+                    span<const std::byte> vertices_encoded = file->ReadSpan();
+
+                    m_indices.resize(index_count);
+                    m_vertices.resize(vertex_count);
+                    if (meshopt_decodeIndexBuffer(m_indices.data(), index_count, sizeof(uint32_t), reinterpret_cast<const unsigned char*>(indices_encoded.data()), indices_encoded.size()) != 0 ||
+                        meshopt_decodeVertexBuffer(m_vertices.data(), vertex_count, sizeof(RHI_Vertex_PosTexNorTan), reinterpret_cast<const unsigned char*>(vertices_encoded.data()), vertices_encoded.size()) != 0)
+                    {
+                        SP_LOG_ERROR("Failed to decode \"%s\"", file_path.c_str());
+                        return false;
+                    }
+                }
+                else
+                {
+                    file->Read(&m_indices);
+                    file->Read(&m_vertices);
+                }
+
+                span<const std::byte> clusters = file->ReadSpan();
+                m_clusters.resize(clusters.size() / sizeof(MeshCluster));
+                memcpy(m_clusters.data(), clusters.data(), m_clusters.size() * sizeof(MeshCluster));
+
+                span<const std::byte> lods = file->ReadSpan();
+                m_lods.resize(lods.size() / sizeof(MeshLod));
+                memcpy(m_lods.data(), lods.data(), m_lods.size() * sizeof(MeshLod));
+
+                // the geometry was optimized when it was imported
+                ComputeAabb();
+                ComputeNormalizedScale();
+                CreateGpuBuffers();
+            }
         }
+
         // load foreign format
-        else
+        if (!file_path_import.empty())
         {
-            SetResourceFilePath(file_path);
+            SetResourceFilePath(file_path_import);
 
-            if (!ModelImporter::Load(this, file_path))
+            if (!ModelImporter::Load(this, file_path_import))
                 return false;
         }
 
@@ -123,9 +224,35 @@ namespace Spartan
         if (!file->IsOpen())
             return false;
 
+        file->Write(mesh_format_magic);
+        file->Write(mesh_format_version);
         file->Write(GetResourceFilePath());
-        file->Write(m_indices);
-        file->Write(m_vertices);
+        file->Write(m_flags);
+        if (m_flags & static_cast<uint32_t>(MeshFlags::CompressEngineFormat))
+        {
+            const size_t index_count  = m_indices.size();
+            const size_t vertex_count = m_vertices.size();
+
+            // the codecs favour optimized geometry, vertices which are referenced close to each other compress better
+            vector<unsigned char> indices_encoded(meshopt_encodeIndexBufferBound(index_count, vertex_count));
+            indices_encoded.resize(meshopt_encodeIndexBuffer(indices_encoded.data(), indices_encoded.size(), m_indices.data(), index_count));
+
+            vector<unsigned char> vertices_encoded(meshopt_encodeVertexBufferBound(vertex_count, sizeof(RHI_Vertex_PosTexNorTan)));
+            vertices_encoded.resize(meshopt_encodeVertexBuffer(vertices_encoded.data(), vertices_encoded.size(), m_vertices.data(), vertex_count, sizeof(RHI_Vertex_PosTexNorTan)));
+
+            file->Write(static_cast<uint32_t>(index_count));
+            file->Write(static_cast<uint32_t>(vertex_count));
+            file->Write(indices_encoded);
+            file->Write(vertices_encoded);
+        }
+        else
+        {
+            file->Write(m_indices);
+            file->Write(m_vertices);
+        }
+
+        file->Write(as_bytes(span<const MeshCluster>(m_clusters)));
+        file->Write(as_bytes(span<const MeshLod>(m_lods)));
 
         file->Close();
 
@@ -137,6 +264,8 @@ namespace Spartan
         uint32_t size = 0;
         size += uint32_t(m_indices.size()  * sizeof(uint32_t));
         size += uint32_t(m_vertices.size() * sizeof(RHI_Vertex_PosTexNorTan));
+        size += uint32_t(m_clusters.size() * sizeof(MeshCluster));
+        size += uint32_t(m_lods.size() * sizeof(MeshLod));
 
         return size;
     }
@@ -209,10 +338,13 @@ namespace Spartan
     {
         return
             static_cast<uint32_t>(MeshFlags::ImportRemoveRedundantData) |
-            static_cast<uint32_t>(MeshFlags::ImportNormalizeScale);
-            //static_cast<uint32_t>(MeshFlags::OptimizeVertexCache) |
-            //static_cast<uint32_t>(MeshFlags::OptimizeOverdraw) |
-            //static_cast<uint32_t>(MeshFlags::OptimizeVertexFetch);
+            static_cast<uint32_t>(MeshFlags::ImportNormalizeScale)      |
+            static_cast<uint32_t>(MeshFlags::OptimizeVertexCache)       |
+            static_cast<uint32_t>(MeshFlags::OptimizeOverdraw)          |
+            static_cast<uint32_t>(MeshFlags::OptimizeVertexFetch)       |
+            static_cast<uint32_t>(MeshFlags::CompressEngineFormat)      |
+            static_cast<uint32_t>(MeshFlags::ImportClusters)            |
+            static_cast<uint32_t>(MeshFlags::ImportLods);
     }
 
     float Mesh::ComputeNormalizedScale()
@@ -223,40 +355,190 @@ namespace Spartan
         return normalized_scale;
     }
     
-    void Mesh::Optimize()
+    void Mesh::Optimize(vector<uint32_t>& indices, vector<RHI_Vertex_PosTexNorTan>& vertices) const
     {
-        SP_ASSERT(!m_indices.empty());
-        SP_ASSERT(!m_vertices.empty());
+        SP_ASSERT(!indices.empty());
+        SP_ASSERT(!vertices.empty());
 
-        uint32_t index_count                     = static_cast<uint32_t>(m_indices.size());
-        uint32_t vertex_count                    = static_cast<uint32_t>(m_vertices.size());
-        size_t vertex_size                       = sizeof(RHI_Vertex_PosTexNorTan);
-        vector<uint32_t> indices                 = m_indices;
-        vector<RHI_Vertex_PosTexNorTan> vertices = m_vertices;
+        // the indices are local to the sub-mesh, so this is done before the sub-mesh is appended to the mesh
+        const size_t index_count  = indices.size();
+        const size_t vertex_count = vertices.size();
+        const size_t vertex_size  = sizeof(RHI_Vertex_PosTexNorTan);
 
         // vertex cache optimization
         // improves the GPU's post-transform cache hit rate, reducing the required vertex shader invocations
         if (m_flags & static_cast<uint32_t>(MeshFlags::OptimizeVertexCache))
         {
-            meshopt_optimizeVertexCache(&indices[0], &m_indices[0], index_count, vertex_count);
+            meshopt_optimizeVertexCache(indices.data(), indices.data(), index_count, vertex_count);
         }
 
         // overdraw optimization
         // minimizes overdraw by reordering triangles, aiming to reduce pixel shader invocations
         if (m_flags & static_cast<uint32_t>(MeshFlags::OptimizeOverdraw))
         {
-            meshopt_optimizeOverdraw(&indices[0], &indices[0], index_count, &m_vertices[0].pos[0], vertex_count, vertex_size, 1.05f);
+            meshopt_optimizeOverdraw(indices.data(), indices.data(), index_count, &vertices[0].pos[0], vertex_count, vertex_size, 1.05f);
         }
 
         // vertex fetch optimization
         // reorders vertices and changes indices to improve vertex fetch cache performance, reducing the bandwidth needed to fetch vertices
         if (m_flags & static_cast<uint32_t>(MeshFlags::OptimizeVertexFetch))
         {
-            meshopt_optimizeVertexFetch(&m_vertices[0], &indices[0], index_count, &vertices[0], vertex_count, vertex_size);
+            vector<RHI_Vertex_PosTexNorTan> vertices_optimized(vertex_count);
+            const size_t vertex_count_referenced = meshopt_optimizeVertexFetch(vertices_optimized.data(), indices.data(), index_count, vertices.data(), vertex_count, vertex_size);
+            vertices_optimized.resize(vertex_count_referenced);
+            vertices = move(vertices_optimized);
+        }
+    }
+
+    void Mesh::BuildClusters(vector<uint32_t>& indices, const vector<RHI_Vertex_PosTexNorTan>& vertices, vector<MeshCluster>* clusters) const
+    {
+        SP_ASSERT(!indices.empty());
+        SP_ASSERT(!vertices.empty());
+        SP_ASSERT(clusters != nullptr);
+
+        // sizes which suit mesh shaders too, the cone weight trades a bit of cluster compactness for back face culling
+        const size_t vertex_count_max   = 64;
+        const size_t triangle_count_max = 124;
+        const float cone_weight         = 0.25f;
+        const size_t vertex_size        = sizeof(RHI_Vertex_PosTexNorTan);
+
+        const size_t meshlet_count_max = meshopt_buildMeshletsBound(indices.size(), vertex_count_max, triangle_count_max);
+        vector<meshopt_Meshlet> meshlets(meshlet_count_max);
+        vector<unsigned int> meshlet_vertices(meshlet_count_max * vertex_count_max);
+        vector<unsigned char> meshlet_triangles(meshlet_count_max * triangle_count_max * 3);
+        const size_t meshlet_count = meshopt_buildMeshlets(
+            meshlets.data(), meshlet_vertices.data(), meshlet_triangles.data(),
+            indices.data(), indices.size(),
+            &vertices[0].pos[0], vertices.size(), vertex_size,
+            vertex_count_max, triangle_count_max, cone_weight
+        );
+
+        // rewrite the indices so that every meshlet is a contiguous range, the triangles are the same so the sub-mesh can still be drawn whole
+        vector<uint32_t> indices_clustered;
+        indices_clustered.reserve(indices.size());
+        clusters->clear();
+        clusters->reserve(meshlet_count);
+        for (size_t i = 0; i < meshlet_count; i++)
+        {
+            const meshopt_Meshlet& meshlet = meshlets[i];
+            const meshopt_Bounds bounds    = meshopt_computeMeshletBounds(
+                &meshlet_vertices[meshlet.vertex_offset], &meshlet_triangles[meshlet.triangle_offset], meshlet.triangle_count,
+                &vertices[0].pos[0], vertices.size(), vertex_size
+            );
+
+            MeshCluster& cluster = clusters->emplace_back();
+            cluster.center[0]    = bounds.center[0];
+            cluster.center[1]    = bounds.center[1];
+            cluster.center[2]    = bounds.center[2];
+            cluster.radius       = bounds.radius;
+            cluster.cone_axis[0] = bounds.cone_axis[0];
+            cluster.cone_axis[1] = bounds.cone_axis[1];
+            cluster.cone_axis[2] = bounds.cone_axis[2];
+            cluster.cone_cutoff  = bounds.cone_cutoff;
+            cluster.index_offset = static_cast<uint32_t>(indices_clustered.size());
+            cluster.index_count  = meshlet.triangle_count * 3;
+
+            for (uint32_t j = 0; j < meshlet.triangle_count * 3; j++)
+            {
+                indices_clustered.push_back(meshlet_vertices[meshlet.vertex_offset + meshlet_triangles[meshlet.triangle_offset + j]]);
+            }
+        }
+
+        SP_ASSERT(indices_clustered.size() == indices.size());
+        indices = move(indices_clustered);
+    }
+
+    void Mesh::AddClusters(const vector<MeshCluster>& clusters, const uint32_t index_offset)
+    {
+        lock_guard lock(m_mutex_vertices);
+
+        for (MeshCluster cluster : clusters)
+        {
+            cluster.index_offset += index_offset;
+            m_clusters.push_back(cluster);
+        }
+    }
+
+    void Mesh::GetClusters(const uint32_t index_offset, const uint32_t index_count, uint32_t* cluster_offset, uint32_t* cluster_count) const
+    {
+        // the clusters which lie within the index range
+        auto first = lower_bound(m_clusters.begin(), m_clusters.end(), index_offset, [](const MeshCluster& cluster, uint32_t offset)
+        {
+            return cluster.index_offset < offset;
+        });
+
+        auto last = lower_bound(first, m_clusters.end(), index_offset + index_count, [](const MeshCluster& cluster, uint32_t offset)
+        {
+            return cluster.index_offset < offset;
+        });
+
+        *cluster_offset = static_cast<uint32_t>(first - m_clusters.begin());
+        *cluster_count  = static_cast<uint32_t>(last - first);
+    }
+
+    void Mesh::BuildLods(const vector<uint32_t>& indices, const vector<RHI_Vertex_PosTexNorTan>& vertices, vector<vector<uint32_t>>* lods) const
+    {
+        SP_ASSERT(!indices.empty());
+        SP_ASSERT(!vertices.empty());
+        SP_ASSERT(lods != nullptr);
+
+        // every level aims for half the triangles of the previous one, with an error (relative to the extents) which doubles as well
+        const float error_lod_1          = 0.01f;
+        const float reduction_min        = 0.8f; // a level which doesn't remove at least this much of the previous one isn't worth it
+        const uint32_t index_count_min   = 3 * 32;
+        const vector<uint32_t>* previous = &indices;
+        float error                      = error_lod_1;
+
+        lods->clear();
+        for (uint32_t lod = 1; lod < mesh_lod_count_max; lod++)
+        {
+            const size_t index_count_target = (previous->size() / 6) * 3;
+            if (index_count_target < index_count_min)
+                break;
+
+            // simplified from the full detail indices, so that the errors don't accumulate
+            vector<uint32_t> indices_lod(indices.size());
+            const size_t index_count = meshopt_simplify(
+                indices_lod.data(),
+                indices.data(),
+                indices.size(),
+                &vertices[0].pos[0],
+                vertices.size(),
+                sizeof(RHI_Vertex_PosTexNorTan),
+                index_count_target,
+                error,
+                0,
+                nullptr
+            );
+
+            if (index_count == 0 || static_cast<float>(index_count) > static_cast<float>(previous->size()) * reduction_min)
+                break;
+
+            // the simplified triangles can still use the vertex cache well
+            indices_lod.resize(index_count);
+            meshopt_optimizeVertexCache(indices_lod.data(), indices_lod.data(), index_count, vertices.size());
+
+            lods->emplace_back(move(indices_lod));
+            previous  = &lods->back();
+            error    *= 2.0f;
         }
+    }
+
+    void Mesh::AddLods(const vector<MeshLod>& lods)
+    {
+        lock_guard lock(m_mutex_vertices);
+
+        m_lods.insert(m_lods.end(), lods.begin(), lods.end());
+    }
 
-        // store the updated indices back to m_indices
-        m_indices = indices;
+    void Mesh::GetLods(const uint32_t index_offset, vector<MeshLod>* lods) const
+    {
+        auto range = equal_range(m_lods.begin(), m_lods.end(), MeshLod{ index_offset, 0, 0 }, [](const MeshLod& a, const MeshLod& b)
+        {
+            return a.index_offset_base < b.index_offset_base;
+        });
+
+        lods->assign(range.first, range.second);
     }
 
     void Mesh::CreateGpuBuffers()
@@ -266,8 +548,28 @@ namespace Spartan
         m_index_buffer->Create(m_indices);
 
         SP_ASSERT_MSG(!m_vertices.empty(), "There are no vertices");
+        vector<RHI_Vertex_PosTexNorTanPacked> vertices_packed(m_vertices.size());
+        for (size_t i = 0; i < m_vertices.size(); i++)
+        {
+            vertices_packed[i] = pack_vertex(m_vertices[i]);
+        }
+
         m_vertex_buffer = make_shared<RHI_VertexBuffer>(false, (string("mesh_vertex_buffer_") + m_object_name).c_str());
-        m_vertex_buffer->Create(m_vertices);
+        m_vertex_buffer->Create(vertices_packed);
+
+        // sub-meshes are added by multiple threads when importing, so the lods and the clusters are sorted here, once the mesh is complete
+        sort(m_lods.begin(), m_lods.end(), [](const MeshLod& a, const MeshLod& b)
+        {
+            return a.index_offset_base != b.index_offset_base ? a.index_offset_base < b.index_offset_base : a.index_offset < b.index_offset;
+        });
+
+        if (!m_clusters.empty())
+        {
+            sort(m_clusters.begin(), m_clusters.end(), [](const MeshCluster& a, const MeshCluster& b) { return a.index_offset < b.index_offset; });
+
+            const uint32_t size = static_cast<uint32_t>(m_clusters.size() * sizeof(MeshCluster));
+            m_cluster_buffer    = make_shared<RHI_StructuredBuffer>(size, 1, (string("mesh_cluster_buffer_") + m_object_name).c_str(), false, m_clusters.data());
+        }
     }
 
     void Mesh::SetMaterial(shared_ptr<Material>& material, Entity* entity) const
@@ -298,11 +600,8 @@ namespace Spartan
         }
         else // if we didn't get a texture, it's not cached, hence we have to load it and cache it now
         {
-            // load texture
-            texture = ResourceCache::Load<RHI_Texture2D>(file_path, RHI_Texture_Srv | RHI_Texture_Mips | RHI_Texture_Compressed);
-
-            // set the texture to the provided material
-            material->SetTexture(texture_type, texture);
+            // load the texture (with the flags of its slot) and set it to the provided material
+            material->SetTexture(texture_type, file_path);
         }
     }
 }
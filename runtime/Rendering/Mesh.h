@@ -31,6 +31,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace Spartan
 {
+    // vertices are always packed for the gpu (see RHI_Vertex_PosTexNorTanPacked), there is no flag for it
+    // since the geometry shaders are compiled against that one input layout, the engine format keeps them at full precision either way
     enum class MeshFlags : uint32_t
     {
         ImportRemoveRedundantData = 1 << 0,
@@ -40,6 +42,31 @@ namespace Spartan
         OptimizeVertexCache       = 1 << 4,
         OptimizeVertexFetch       = 1 << 5,
         OptimizeOverdraw          = 1 << 6,
+        CompressEngineFormat      = 1 << 7, // the engine format (.mesh) is saved with meshoptimizer's vertex and index codecs
+        ImportClusters            = 1 << 8, // split the sub-meshes into clusters (meshlets), which the renderer culls on the gpu
+        ImportLods                = 1 << 9, // generate simplified levels of detail for the sub-meshes
+    };
+
+    // levels of detail per sub-mesh, including the full detail one
+    const uint32_t mesh_lod_count_max = 4;
+
+    // a simplified version of a sub-mesh, which uses the same vertices and comes after it in the index buffer
+    struct MeshLod
+    {
+        uint32_t index_offset_base = 0; // the index offset of the full detail sub-mesh
+        uint32_t index_offset      = 0;
+        uint32_t index_count       = 0;
+    };
+
+    // a range of the index buffer with its bounds in mesh space, as read by cluster_culling.hlsl
+    struct MeshCluster
+    {
+        float center[3]       = { 0, 0, 0 }; // bounding sphere
+        float radius          = 0.0f;
+        float cone_axis[3]    = { 0, 0, 0 }; // normal cone, the cluster is back facing when seen from within it
+        float cone_cutoff     = 1.0f;
+        uint32_t index_offset = 0;
+        uint32_t index_count  = 0;
     };
 
     class Mesh : public IResource
@@ -80,10 +107,21 @@ namespace Spartan
         const Math::BoundingBox& GetAabb() const { return m_aabb; }
         void ComputeAabb();
 
+        // clusters, sorted by index offset
+        void BuildClusters(std::vector<uint32_t>& indices, const std::vector<RHI_Vertex_PosTexNorTan>& vertices, std::vector<MeshCluster>* clusters) const; // groups the indices of a sub-mesh, cluster after cluster
+        void AddClusters(const std::vector<MeshCluster>& clusters, const uint32_t index_offset);
+        void GetClusters(const uint32_t index_offset, const uint32_t index_count, uint32_t* cluster_offset, uint32_t* cluster_count) const;
+
+        // lods, sorted by the sub-mesh they belong to
+        void BuildLods(const std::vector<uint32_t>& indices, const std::vector<RHI_Vertex_PosTexNorTan>& vertices, std::vector<std::vector<uint32_t>>* lods) const; // the simplified indices, full detail excluded
+        void AddLods(const std::vector<MeshLod>& lods);
+        void GetLods(const uint32_t index_offset, std::vector<MeshLod>* lods) const;
+
         // gpu buffers
         void CreateGpuBuffers();
-        RHI_IndexBuffer* GetIndexBuffer()   { return m_index_buffer.get();  }
-        RHI_VertexBuffer* GetVertexBuffer() { return m_vertex_buffer.get(); }
+        RHI_IndexBuffer* GetIndexBuffer()        { return m_index_buffer.get();   }
+        RHI_VertexBuffer* GetVertexBuffer()      { return m_vertex_buffer.get();  }
+        RHI_StructuredBuffer* GetClusterBuffer() { return m_cluster_buffer.get(); }
 
         // root entity
         std::weak_ptr<Entity> GetRootEntity() { return m_root_entity; }
@@ -93,7 +131,7 @@ namespace Spartan
         uint32_t GetFlags() const { return m_flags; }
         static uint32_t GetDefaultFlags();
         float ComputeNormalizedScale();
-        void Optimize();
+        void Optimize(std::vector<uint32_t>& indices, std::vector<RHI_Vertex_PosTexNorTan>& vertices) const; // a single sub-mesh, before it's added
         void SetMaterial(std::shared_ptr<Material>& material, Entity* entity) const;
         void AddTexture(std::shared_ptr<Material>& material, MaterialTexture texture_type, const std::string& file_path, bool is_gltf);
 
@@ -101,10 +139,13 @@ namespace Spartan
         // Geometry
         std::vector<RHI_Vertex_PosTexNorTan> m_vertices;
         std::vector<uint32_t> m_indices;
+        std::vector<MeshCluster> m_clusters;
+        std::vector<MeshLod> m_lods;
 
         // GPU buffers
         std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer;
         std::shared_ptr<RHI_IndexBuffer> m_index_buffer;
+        std::shared_ptr<RHI_StructuredBuffer> m_cluster_buffer;
 
         // AABB
         Math::BoundingBox m_aabb;
@@ -0,0 +1,320 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===================
+#include "pch.h"
+#include "MipGenerator.h"
+#include "../Core/ThreadPool.h"
+#include "../RHI/RHI_Texture.h"
+#include <emmintrin.h>
+//==============================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    namespace
+    {
+        const float alpha_threshold = 0.6f; // matches ALPHA_THRESHOLD_DEFAULT in common.hlsl
+        const float kaiser_alpha    = 4.0f;
+        const int32_t kaiser_radius = 3;    // in source texels, on each side
+
+        struct Tap
+        {
+            int32_t offset = 0; // from the first of the two source texels which the destination texel covers
+            float weight   = 0.0f;
+        };
+
+        float bessel_i0(const float x)
+        {
+            float sum  = 1.0f;
+            float term = 1.0f;
+            for (uint32_t k = 1; k < 16; k++)
+            {
+                term *= (x * 0.5f) / static_cast<float>(k);
+                sum  += term * term;
+            }
+
+            return sum;
+        }
+
+        float sinc(const float x)
+        {
+            if (abs(x) < 1e-5f)
+                return 1.0f;
+
+            const float pi_x = x * 3.14159265f;
+            return sin(pi_x) / pi_x;
+        }
+
+        // the same for every destination texel, since the downsampling is always by two
+        vector<Tap> get_taps(const MipFilter filter)
+        {
+            vector<Tap> taps;
+
+            if (filter == MipFilter::Box)
+            {
+                taps.push_back({ 0, 0.5f });
+                taps.push_back({ 1, 0.5f });
+                return taps;
+            }
+
+            float weight_sum = 0.0f;
+            for (int32_t offset = 1 - kaiser_radius; offset <= kaiser_radius; offset++)
+            {
+                // the distance of the source texel center from the destination texel center, in source texels
+                const float distance = static_cast<float>(offset) - 0.5f;
+                const float t        = distance / static_cast<float>(kaiser_radius);
+                const float window   = bessel_i0(kaiser_alpha * sqrt(max(1.0f - t * t, 0.0f))) / bessel_i0(kaiser_alpha);
+                const float weight   = sinc(distance * 0.5f) * window;
+
+                taps.push_back({ offset, weight });
+                weight_sum += weight;
+            }
+
+            for (Tap& tap : taps)
+            {
+                tap.weight /= weight_sum;
+            }
+
+            return taps;
+        }
+
+        const float* get_srgb_to_linear()
+        {
+            static const array<float, 256> table = []()
+            {
+                array<float, 256> values;
+                for (uint32_t i = 0; i < 256; i++)
+                {
+                    const float c = static_cast<float>(i) / 255.0f;
+                    values[i]     = c <= 0.04045f ? c / 12.92f : pow((c + 0.055f) / 1.055f, 2.4f);
+                }
+                return values;
+            }();
+
+            return table.data();
+        }
+
+        // indexed by the linear value in 16 bits, which is precise enough for the darks, where srgb is the steepest
+        const uint8_t* get_linear_to_srgb()
+        {
+            static const vector<uint8_t> table = []()
+            {
+                vector<uint8_t> values(65536);
+                for (uint32_t i = 0; i < 65536; i++)
+                {
+                    const float c = static_cast<float>(i) / 65535.0f;
+                    const float s = c <= 0.0031308f ? c * 12.92f : 1.055f * pow(c, 1.0f / 2.4f) - 0.055f;
+                    values[i]     = static_cast<uint8_t>(clamp(s, 0.0f, 1.0f) * 255.0f + 0.5f);
+                }
+                return values;
+            }();
+
+            return table.data();
+        }
+
+        // the intermediate result of the vertical pass, over-aligned types are allocated aligned (c++17), so the sse loads and stores can be aligned
+        struct alignas(16) Texel
+        {
+            float values[4];
+        };
+
+        struct Level
+        {
+            const std::byte* src = nullptr;
+            std::byte* dst       = nullptr;
+            uint32_t width_src   = 0;
+            uint32_t height_src  = 0;
+            uint32_t width       = 0;
+            uint32_t height      = 0;
+            uint32_t channels    = 0;
+            bool srgb            = false;
+        };
+
+        // rgb is converted to linear for srgb textures, alpha is always linear
+        __m128 load(const Level& level, const uint32_t x, const uint32_t y)
+        {
+            const uint8_t* texel = reinterpret_cast<const uint8_t*>(level.src) + (static_cast<size_t>(y) * level.width_src + x) * level.channels;
+            float values[4]      = { 0.0f, 0.0f, 0.0f, 1.0f };
+            const float* decode  = get_srgb_to_linear();
+
+            for (uint32_t c = 0; c < level.channels; c++)
+            {
+                const bool is_alpha = c == 3;
+                values[c]           = (level.srgb && !is_alpha) ? decode[texel[c]] : static_cast<float>(texel[c]) / 255.0f;
+            }
+
+            return _mm_loadu_ps(values);
+        }
+
+        void store(const Level& level, const uint32_t x, const uint32_t y, __m128 value)
+        {
+            // the kaiser filter has negative lobes
+            value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+
+            float values[4];
+            _mm_storeu_ps(values, value);
+
+            uint8_t* texel         = reinterpret_cast<uint8_t*>(level.dst) + (static_cast<size_t>(y) * level.width + x) * level.channels;
+            const uint8_t* encode  = get_linear_to_srgb();
+            for (uint32_t c = 0; c < level.channels; c++)
+            {
+                const bool is_alpha = c == 3;
+                texel[c]            = (level.srgb && !is_alpha) ? encode[static_cast<uint32_t>(values[c] * 65535.0f + 0.5f)] : static_cast<uint8_t>(values[c] * 255.0f + 0.5f);
+            }
+        }
+
+        // separable, every destination row filters its source rows vertically, and then the result horizontally
+        void filter_rows(const Level& level, const vector<Tap>& taps, const uint32_t row_start, const uint32_t row_end)
+        {
+            vector<Texel> column(level.width_src);
+
+            for (uint32_t y = row_start; y < row_end; y++)
+            {
+                for (uint32_t x = 0; x < level.width_src; x++)
+                {
+                    __m128 sum = _mm_setzero_ps();
+                    for (const Tap& tap : taps)
+                    {
+                        const uint32_t y_src = static_cast<uint32_t>(clamp(static_cast<int32_t>(y * 2) + tap.offset, 0, static_cast<int32_t>(level.height_src) - 1));
+                        sum                  = _mm_add_ps(sum, _mm_mul_ps(load(level, x, y_src), _mm_set1_ps(tap.weight)));
+                    }
+                    _mm_store_ps(column[x].values, sum);
+                }
+
+                for (uint32_t x = 0; x < level.width; x++)
+                {
+                    __m128 sum = _mm_setzero_ps();
+                    for (const Tap& tap : taps)
+                    {
+                        const uint32_t x_src = static_cast<uint32_t>(clamp(static_cast<int32_t>(x * 2) + tap.offset, 0, static_cast<int32_t>(level.width_src) - 1));
+                        sum                  = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(column[x_src].values), _mm_set1_ps(tap.weight)));
+                    }
+                    store(level, x, y, sum);
+                }
+            }
+        }
+
+        void get_alpha_histogram(span<const std::byte> bytes, const uint32_t channels, array<uint32_t, 256>& histogram)
+        {
+            histogram.fill(0);
+            for (size_t i = 3; i < bytes.size(); i += channels)
+            {
+                histogram[static_cast<uint8_t>(bytes[i])]++;
+            }
+        }
+
+        float get_coverage(const array<uint32_t, 256>& histogram, const float scale)
+        {
+            uint64_t covered = 0;
+            uint64_t total   = 0;
+            for (uint32_t alpha = 0; alpha < 256; alpha++)
+            {
+                covered += (static_cast<float>(alpha) / 255.0f) * scale > alpha_threshold ? histogram[alpha] : 0;
+                total   += histogram[alpha];
+            }
+
+            return total != 0 ? static_cast<float>(covered) / static_cast<float>(total) : 0.0f;
+        }
+
+        // scales the alpha of a mip so that as many texels pass the alpha test as they do in the top mip
+        void preserve_alpha_coverage(vector<std::byte>& bytes, const uint32_t channels, const float coverage)
+        {
+            array<uint32_t, 256> histogram;
+            get_alpha_histogram(bytes, channels, histogram);
+
+            float scale_min = 0.0f;
+            float scale_max = 8.0f;
+            for (uint32_t i = 0; i < 12; i++)
+            {
+                const float scale = (scale_min + scale_max) * 0.5f;
+                (get_coverage(histogram, scale) < coverage ? scale_min : scale_max) = scale;
+            }
+
+            const float scale = (scale_min + scale_max) * 0.5f;
+            for (size_t i = 3; i < bytes.size(); i += channels)
+            {
+                const float alpha = static_cast<float>(static_cast<uint8_t>(bytes[i])) * scale;
+                bytes[i]          = static_cast<std::byte>(static_cast<uint8_t>(min(alpha, 255.0f) + 0.5f));
+            }
+        }
+    }
+
+    bool MipGenerator::CanGenerate(RHI_Texture* texture)
+    {
+        return texture->HasData() && texture->GetBitsPerChannel() == 8 && texture->GetChannelCount() <= 4 && !texture->IsCompressedFormat();
+    }
+
+    void MipGenerator::Generate(RHI_Texture* texture, const MipFilter filter)
+    {
+        if (!CanGenerate(texture))
+            return;
+
+        const vector<Tap> taps        = get_taps(filter);
+        const uint32_t channels       = texture->GetChannelCount();
+        const bool srgb               = (texture->GetFlags() & RHI_Texture_Srgb) != 0;
+        const bool preserve_coverage  = texture->IsTransparent() && channels == 4;
+
+        for (RHI_Texture_Slice& slice : texture->GetData())
+        {
+            if (slice.mips.empty() || slice.GetMipCount() >= texture->GetMipCount())
+                continue;
+
+            float coverage = 0.0f;
+            if (preserve_coverage)
+            {
+                array<uint32_t, 256> histogram;
+                get_alpha_histogram(slice.mips[0].GetBytes(), channels, histogram);
+                coverage = get_coverage(histogram, 1.0f);
+            }
+
+            // each mip is filtered from the one above it, its rows in parallel
+            for (uint32_t mip_index = slice.GetMipCount(); mip_index < texture->GetMipCount(); mip_index++)
+            {
+                slice.mips.emplace_back();
+
+                Level level;
+                level.width_src  = max(texture->GetWidth()  >> (mip_index - 1), 1u);
+                level.height_src = max(texture->GetHeight() >> (mip_index - 1), 1u);
+                level.width      = max(texture->GetWidth()  >> mip_index, 1u);
+                level.height     = max(texture->GetHeight() >> mip_index, 1u);
+                level.channels   = channels;
+                level.srgb       = srgb;
+                slice.mips[mip_index].bytes.resize(static_cast<size_t>(level.width) * level.height * channels);
+                level.src        = slice.mips[mip_index - 1].GetBytes().data();
+                level.dst        = slice.mips[mip_index].bytes.data();
+
+                ThreadPool::ParallelFor([&level, &taps](uint32_t work_index_start, uint32_t work_index_end)
+                {
+                    filter_rows(level, taps, work_index_start, work_index_end);
+                }, level.height);
+
+                if (preserve_coverage)
+                {
+                    preserve_alpha_coverage(slice.mips[mip_index].bytes, channels, coverage);
+                }
+            }
+        }
+    }
+}
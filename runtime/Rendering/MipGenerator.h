@@ -0,0 +1,50 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ===
+#include <cstdint>
+//==============
+
+namespace Spartan
+{
+    class RHI_Texture;
+
+    enum class MipFilter : uint8_t
+    {
+        Box,   // 2x2 average
+        Kaiser // 6x6 kaiser windowed sinc, sharper
+    };
+
+    // builds the mip chain of textures which have their data on the cpu, so that it's saved with them (the engine format keeps every mip)
+    // srgb textures are filtered in linear space, and transparent ones keep the alpha test coverage of their top mip, so foliage doesn't thin out
+    // the rows of every mip are filtered in parallel (sse), anything which can't be filtered here is downsampled on the gpu (see Renderer::Pass_GenerateMips())
+    class MipGenerator
+    {
+    public:
+        // 8 bit, uncompressed, with data
+        static bool CanGenerate(RHI_Texture* texture);
+
+        // any thread, fills in the mips that every slice is missing, up to the texture's mip count
+        static void Generate(RHI_Texture* texture, const MipFilter filter = MipFilter::Kaiser);
+    };
+}
@@ -0,0 +1,458 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===================
+#include "pch.h"
+#include "OcclusionBuffer.h"
+#include "../Core/ThreadPool.h"
+#include <emmintrin.h>
+//==============================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    namespace
+    {
+        const uint32_t width       = 256;
+        const uint32_t height      = 128;
+        const uint32_t band_height = 8;     // rows rasterized by a single task
+        const float near_w         = 0.01f; // anything closer is clipped (occluders) or considered visible (occludees)
+        const float depth_bias     = 0.01f; // relative, prevents geometry from being occluded by its own (simplified) occluder
+
+        struct Occluder
+        {
+            const vector<Vector3>* triangles = nullptr;
+            Matrix transform;
+        };
+
+        // screen space, z is 1/w
+        struct Triangle
+        {
+            float x[3];
+            float y[3];
+            float z[3];
+            int32_t y_min;
+            int32_t y_max;
+        };
+
+        Matrix view_projection;
+        vector<Occluder> occluders;
+        vector<vector<Triangle>> triangles; // per occluder, so that they can be set up in parallel
+        vector<float> hi_z;                 // mip 0 is the depth buffer, every other mip holds the farthest depth of the 2x2 texels below it
+        vector<uint32_t> hi_z_offsets;      // the mips are packed one after the other
+        uint32_t triangle_count = 0;
+
+        uint32_t clip_against_near_plane(const Vector4* vertices_in, Vector4* vertices_out)
+        {
+            uint32_t count = 0;
+
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                const Vector4& a = vertices_in[i];
+                const Vector4& b = vertices_in[(i + 1) % 3];
+                bool a_inside    = a.w >= near_w;
+                bool b_inside    = b.w >= near_w;
+
+                if (a_inside)
+                {
+                    vertices_out[count++] = a;
+                }
+
+                if (a_inside != b_inside)
+                {
+                    float t = (near_w - a.w) / (b.w - a.w);
+                    vertices_out[count++] = Vector4(
+                        a.x + (b.x - a.x) * t,
+                        a.y + (b.y - a.y) * t,
+                        a.z + (b.z - a.z) * t,
+                        near_w
+                    );
+                }
+            }
+
+            return count;
+        }
+
+        void emit_triangle(const float* x, const float* y, const float* z, const uint32_t i0, const uint32_t i1, const uint32_t i2, vector<Triangle>& triangles_out)
+        {
+            Triangle triangle;
+            triangle.x[0] = x[i0]; triangle.y[0] = y[i0]; triangle.z[0] = z[i0];
+            triangle.x[1] = x[i1]; triangle.y[1] = y[i1]; triangle.z[1] = z[i1];
+            triangle.x[2] = x[i2]; triangle.y[2] = y[i2]; triangle.z[2] = z[i2];
+
+            // make the winding consistent, both faces are rasterized since occluders can be open meshes
+            float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) - (triangle.y[1] - triangle.y[0]) * (triangle.x[2] - triangle.x[0]);
+            if (abs(area) < 1e-6f)
+                return;
+
+            if (area < 0.0f)
+            {
+                swap(triangle.x[1], triangle.x[2]);
+                swap(triangle.y[1], triangle.y[2]);
+                swap(triangle.z[1], triangle.z[2]);
+            }
+
+            // reject if off screen
+            float x_min = min(min(triangle.x[0], triangle.x[1]), triangle.x[2]);
+            float x_max = max(max(triangle.x[0], triangle.x[1]), triangle.x[2]);
+            float y_min = min(min(triangle.y[0], triangle.y[1]), triangle.y[2]);
+            float y_max = max(max(triangle.y[0], triangle.y[1]), triangle.y[2]);
+            if (x_max < 0.0f || y_max < 0.0f || x_min >= static_cast<float>(width) || y_min >= static_cast<float>(height))
+                return;
+
+            triangle.y_min = max(static_cast<int32_t>(y_min), 0);
+            triangle.y_max = min(static_cast<int32_t>(y_max), static_cast<int32_t>(height) - 1);
+
+            triangles_out.push_back(triangle);
+        }
+
+        void setup_triangles(const Occluder& occluder, vector<Triangle>& triangles_out)
+        {
+            triangles_out.clear();
+
+            const Matrix transform           = occluder.transform * view_projection;
+            const vector<Vector3>& positions   = *occluder.triangles;
+
+            for (size_t i = 0; i + 2 < positions.size(); i += 3)
+            {
+                Vector4 clip[3];
+                for (uint32_t v = 0; v < 3; v++)
+                {
+                    clip[v] = Vector4(positions[i + v].x, positions[i + v].y, positions[i + v].z, 1.0f) * transform;
+                }
+
+                // trivially reject triangles which are outside of any frustum plane (far is not needed since there is no depth range)
+                if ((clip[0].x >  clip[0].w && clip[1].x >  clip[1].w && clip[2].x >  clip[2].w) ||
+                    (clip[0].x < -clip[0].w && clip[1].x < -clip[1].w && clip[2].x < -clip[2].w) ||
+                    (clip[0].y >  clip[0].w && clip[1].y >  clip[1].w && clip[2].y >  clip[2].w) ||
+                    (clip[0].y < -clip[0].w && clip[1].y < -clip[1].w && clip[2].y < -clip[2].w) ||
+                    (clip[0].w < near_w && clip[1].w < near_w && clip[2].w < near_w))
+                    continue;
+
+                // clip and project
+                Vector4 polygon[4];
+                uint32_t vertex_count = clip_against_near_plane(clip, polygon);
+                if (vertex_count < 3)
+                    continue;
+
+                float x[4], y[4], z[4];
+                for (uint32_t v = 0; v < vertex_count; v++)
+                {
+                    float w_inv = 1.0f / polygon[v].w;
+                    x[v]        = (polygon[v].x * w_inv * 0.5f + 0.5f) * static_cast<float>(width);
+                    y[v]        = (0.5f - polygon[v].y * w_inv * 0.5f) * static_cast<float>(height);
+                    z[v]        = w_inv;
+                }
+
+                emit_triangle(x, y, z, 0, 1, 2, triangles_out);
+                if (vertex_count == 4)
+                {
+                    emit_triangle(x, y, z, 0, 2, 3, triangles_out);
+                }
+            }
+        }
+
+        void rasterize_triangle(const Triangle& triangle, const int32_t row_start, const int32_t row_end, float* depth)
+        {
+            // bounds
+            int32_t y_start = max(triangle.y_min, row_start);
+            int32_t y_end   = min(triangle.y_max, row_end - 1);
+            if (y_start > y_end)
+                return;
+
+            float x_min     = min(min(triangle.x[0], triangle.x[1]), triangle.x[2]);
+            float x_max     = max(max(triangle.x[0], triangle.x[1]), triangle.x[2]);
+            int32_t x_start = max(static_cast<int32_t>(x_min), 0) & ~3; // sse processes 4 pixels at a time
+            int32_t x_end   = min(static_cast<int32_t>(x_max), static_cast<int32_t>(width) - 1);
+
+            // edge functions, e(x, y) = a * x + b * y + c, positive inside
+            float a[3], b[3], c[3];
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                uint32_t j = (i + 1) % 3;
+                a[i]       = triangle.y[i] - triangle.y[j];
+                b[i]       = triangle.x[j] - triangle.x[i];
+                c[i]       = -(a[i] * triangle.x[i] + b[i] * triangle.y[i]);
+            }
+
+            // depth plane, from the barycentric weights (edge i is opposite to vertex (i + 2) % 3)
+            float area_inv = 1.0f / (a[0] * triangle.x[2] + b[0] * triangle.y[2] + c[0]);
+            float z_a      = (a[1] * triangle.z[0] + a[2] * triangle.z[1] + a[0] * triangle.z[2]) * area_inv;
+            float z_b      = (b[1] * triangle.z[0] + b[2] * triangle.z[1] + b[0] * triangle.z[2]) * area_inv;
+            float z_c      = (c[1] * triangle.z[0] + c[2] * triangle.z[1] + c[0] * triangle.z[2]) * area_inv;
+
+            const __m128 zero       = _mm_setzero_ps();
+            const __m128 offsets    = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f); // pixel centers
+            const __m128 e0_step    = _mm_set1_ps(a[0] * 4.0f);
+            const __m128 e1_step    = _mm_set1_ps(a[1] * 4.0f);
+            const __m128 e2_step    = _mm_set1_ps(a[2] * 4.0f);
+            const __m128 z_step     = _mm_set1_ps(z_a  * 4.0f);
+            const __m128 x_centers  = _mm_add_ps(_mm_set1_ps(static_cast<float>(x_start)), offsets);
+
+            for (int32_t y = y_start; y <= y_end; y++)
+            {
+                float y_center = static_cast<float>(y) + 0.5f;
+
+                __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), x_centers), _mm_set1_ps(b[0] * y_center + c[0]));
+                __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[1]), x_centers), _mm_set1_ps(b[1] * y_center + c[1]));
+                __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[2]), x_centers), _mm_set1_ps(b[2] * y_center + c[2]));
+                __m128 z  = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(z_a),  x_centers), _mm_set1_ps(z_b  * y_center + z_c));
+
+                float* row = depth + y * width;
+                for (int32_t x = x_start; x <= x_end; x += 4)
+                {
+                    __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                    if (_mm_movemask_ps(inside) != 0)
+                    {
+                        // keep the nearest, which is the largest 1/w
+                        __m128 depth_old = _mm_loadu_ps(row + x);
+                        __m128 depth_new = _mm_max_ps(depth_old, z);
+                        _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, depth_new), _mm_andnot_ps(inside, depth_old)));
+                    }
+
+                    e0 = _mm_add_ps(e0, e0_step);
+                    e1 = _mm_add_ps(e1, e1_step);
+                    e2 = _mm_add_ps(e2, e2_step);
+                    z  = _mm_add_ps(z,  z_step);
+                }
+            }
+        }
+
+        void allocate()
+        {
+            if (!hi_z.empty())
+                return;
+
+            uint32_t mip_count = 1;
+            while ((width >> mip_count) > 0 && (height >> mip_count) > 0)
+            {
+                mip_count++;
+            }
+
+            uint32_t size = 0;
+            for (uint32_t mip = 0; mip < mip_count; mip++)
+            {
+                hi_z_offsets.push_back(size);
+                size += (width >> mip) * (height >> mip);
+            }
+            hi_z.resize(size);
+        }
+
+        void build_hi_z()
+        {
+            for (uint32_t mip = 1; mip < static_cast<uint32_t>(hi_z_offsets.size()); mip++)
+            {
+                const float* source         = hi_z.data() + hi_z_offsets[mip - 1];
+                float* destination          = hi_z.data() + hi_z_offsets[mip];
+                uint32_t source_width       = max(width  >> (mip - 1), 1u);
+                uint32_t source_height      = max(height >> (mip - 1), 1u);
+                uint32_t mip_width          = max(width  >> mip, 1u);
+                uint32_t mip_height         = max(height >> mip, 1u);
+
+                for (uint32_t y = 0; y < mip_height; y++)
+                {
+                    uint32_t y0 = min(y * 2,     source_height - 1);
+                    uint32_t y1 = min(y * 2 + 1, source_height - 1);
+
+                    for (uint32_t x = 0; x < mip_width; x++)
+                    {
+                        uint32_t x0 = min(x * 2,     source_width - 1);
+                        uint32_t x1 = min(x * 2 + 1, source_width - 1);
+
+                        destination[y * mip_width + x] = min(
+                            min(source[y0 * source_width + x0], source[y0 * source_width + x1]),
+                            min(source[y1 * source_width + x0], source[y1 * source_width + x1])
+                        );
+                    }
+                }
+            }
+        }
+    }
+
+    void OcclusionBuffer::Begin(const Matrix& _view_projection)
+    {
+        view_projection = _view_projection;
+        occluders.clear();
+        triangle_count = 0;
+
+        allocate();
+
+        // clear to infinitely far
+        fill(hi_z.begin(), hi_z.begin() + width * height, 0.0f);
+    }
+
+    void OcclusionBuffer::AddOccluder(const vector<Vector3>* triangles, const Matrix& transform)
+    {
+        SP_ASSERT(triangles != nullptr);
+
+        if (triangles->empty())
+            return;
+
+        occluders.push_back({ triangles, transform });
+    }
+
+    void OcclusionBuffer::Rasterize()
+    {
+        // transform, clip and project
+        triangles.resize(max(triangles.size(), occluders.size()));
+        ThreadPool::ParallelFor([](uint32_t start, uint32_t end)
+        {
+            for (uint32_t i = start; i < end; i++)
+            {
+                setup_triangles(occluders[i], triangles[i]);
+            }
+        }, static_cast<uint32_t>(occluders.size()));
+
+        for (uint32_t i = 0; i < static_cast<uint32_t>(occluders.size()); i++)
+        {
+            triangle_count += static_cast<uint32_t>(triangles[i].size());
+        }
+
+        // rasterize, each task owns a band of rows so there is no contention on the depth buffer
+        if (triangle_count != 0)
+        {
+            ThreadPool::ParallelFor([](uint32_t start, uint32_t end)
+            {
+                for (uint32_t band = start; band < end; band++)
+                {
+                    int32_t row_start = static_cast<int32_t>(band * band_height);
+                    int32_t row_end   = static_cast<int32_t>(min((band + 1) * band_height, height));
+
+                    for (uint32_t i = 0; i < static_cast<uint32_t>(occluders.size()); i++)
+                    {
+                        for (const Triangle& triangle : triangles[i])
+                        {
+                            if (triangle.y_max < row_start || triangle.y_min >= row_end)
+                                continue;
+
+                            rasterize_triangle(triangle, row_start, row_end, hi_z.data());
+                        }
+                    }
+                }
+            }, (height + band_height - 1) / band_height);
+        }
+
+        build_hi_z();
+    }
+
+    bool OcclusionBuffer::IsVisible(const BoundingBox& bounding_box)
+    {
+        if (triangle_count == 0 || bounding_box == BoundingBox::Undefined)
+            return true;
+
+        // project the corners and find the screen space rectangle and the nearest depth
+        const Vector3& min_corner = bounding_box.GetMin();
+        const Vector3& max_corner = bounding_box.GetMax();
+        float x_min = numeric_limits<float>::max(), x_max = numeric_limits<float>::lowest();
+        float y_min = numeric_limits<float>::max(), y_max = numeric_limits<float>::lowest();
+        float z_max = 0.0f;
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            Vector4 corner = Vector4(
+                (i & 1) ? max_corner.x : min_corner.x,
+                (i & 2) ? max_corner.y : min_corner.y,
+                (i & 4) ? max_corner.z : min_corner.z,
+                1.0f
+            ) * view_projection;
+
+            // intersects the near plane, can't be occluded
+            if (corner.w < near_w)
+                return true;
+
+            float w_inv = 1.0f / corner.w;
+            float x     = (corner.x * w_inv * 0.5f + 0.5f) * static_cast<float>(width);
+            float y     = (0.5f - corner.y * w_inv * 0.5f) * static_cast<float>(height);
+            x_min       = min(x_min, x);
+            x_max       = max(x_max, x);
+            y_min       = min(y_min, y);
+            y_max       = max(y_max, y);
+            z_max       = max(z_max, w_inv);
+        }
+
+        // off screen, that's for frustum culling to decide
+        if (x_max < 0.0f || y_max < 0.0f || x_min >= static_cast<float>(width) || y_min >= static_cast<float>(height))
+            return true;
+
+        int32_t x_start = max(static_cast<int32_t>(x_min), 0);
+        int32_t y_start = max(static_cast<int32_t>(y_min), 0);
+        int32_t x_end   = min(static_cast<int32_t>(x_max), static_cast<int32_t>(width)  - 1);
+        int32_t y_end   = min(static_cast<int32_t>(y_max), static_cast<int32_t>(height) - 1);
+
+        // pick the mip at which the rectangle covers about 2x2 texels
+        uint32_t size = static_cast<uint32_t>(max(x_end - x_start, y_end - y_start) + 1);
+        uint32_t mip  = 0;
+        while ((size >> mip) > 2 && mip + 1 < static_cast<uint32_t>(hi_z_offsets.size()))
+        {
+            mip++;
+        }
+
+        // find the farthest occluder depth within the rectangle
+        const float* depth         = hi_z.data() + hi_z_offsets[mip];
+        uint32_t mip_width         = width >> mip;
+        float z_occluder           = numeric_limits<float>::max();
+        for (int32_t y = y_start >> mip; y <= (y_end >> mip); y++)
+        {
+            for (int32_t x = x_start >> mip; x <= (x_end >> mip); x++)
+            {
+                z_occluder = min(z_occluder, depth[y * mip_width + x]);
+            }
+        }
+
+        // visible if the nearest point of the box is in front of the farthest occluder
+        return z_max * (1.0f + depth_bias) >= z_occluder;
+    }
+
+    uint32_t OcclusionBuffer::GetOccluderCount()
+    {
+        return static_cast<uint32_t>(occluders.size());
+    }
+
+    uint32_t OcclusionBuffer::GetTriangleCount()
+    {
+        return triangle_count;
+    }
+
+    const vector<float>& OcclusionBuffer::GetHiZ()
+    {
+        allocate();
+        return hi_z;
+    }
+
+    uint32_t OcclusionBuffer::GetWidth()
+    {
+        return width;
+    }
+
+    uint32_t OcclusionBuffer::GetHeight()
+    {
+        return height;
+    }
+
+    uint32_t OcclusionBuffer::GetMipCount()
+    {
+        allocate();
+        return static_cast<uint32_t>(hi_z_offsets.size());
+    }
+}
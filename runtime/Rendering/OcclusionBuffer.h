@@ -0,0 +1,55 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ======================
+#include <vector>
+#include "../Math/Matrix.h"
+#include "../Math/BoundingBox.h"
+//=================================
+
+namespace Spartan
+{
+    // a low resolution depth buffer which is rasterized on the cpu (sse, in parallel bands)
+    // occluders are rasterized as triangles, occludees are tested as screen space rectangles against a hi-z pyramid
+    // depth is stored as 1/w, which is linear in screen space and independent of the projection (reverse-z or not)
+    class OcclusionBuffer
+    {
+    public:
+        // main thread
+        static void Begin(const Math::Matrix& view_projection);
+        static void AddOccluder(const std::vector<Math::Vector3>* triangles, const Math::Matrix& transform);
+        static void Rasterize();
+
+        // any thread, after Rasterize()
+        static bool IsVisible(const Math::BoundingBox& bounding_box);
+
+        static uint32_t GetOccluderCount();
+        static uint32_t GetTriangleCount();
+
+        // the hi-z pyramid, packed mip after mip (depth is 1/w, the farthest one within each texel)
+        static const std::vector<float>& GetHiZ();
+        static uint32_t GetWidth();
+        static uint32_t GetHeight();
+        static uint32_t GetMipCount();
+    };
+}
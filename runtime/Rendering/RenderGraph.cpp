@@ -0,0 +1,416 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ===================
+#include "pch.h"
+#include "RenderGraph.h"
+#include "Renderer.h"
+#include "../RHI/RHI_Device.h"
+#include "../RHI/RHI_Texture.h"
+#include "../RHI/RHI_CommandList.h"
+//==============================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    namespace
+    {
+        const uint32_t render_target_count = static_cast<uint32_t>(Renderer_RenderTexture::max);
+        const uint8_t access_read          = 1 << 0;
+        const uint8_t access_write         = 1 << 1;
+
+        // the passes (indices) from a write which discards the render target, to the last pass which accesses it
+        struct Lifetime
+        {
+            uint32_t pass_first = 0;
+            uint32_t pass_last  = 0;
+        };
+
+        // render targets which share memory
+        struct AliasGroup
+        {
+            vector<uint32_t> render_targets;
+            void* memory                = nullptr;             // null if the render target is alone, or if the render targets can't share memory
+            uint32_t render_target_last = render_target_count; // the one whose content the memory holds
+        };
+
+        deque<RenderGraphPass> passes; // a deque, so that the passes which were returned stay where they are
+        vector<AliasGroup> groups;
+        array<bool, render_target_count> grouped        = {}; // what the groups were made from, so that changes can be detected
+        array<uint64_t, render_target_count> object_ids = {};
+
+        RHI_Texture* get_render_target(const uint32_t index)
+        {
+            return Renderer::GetRenderTarget(static_cast<Renderer_RenderTexture>(index)).get();
+        }
+
+        bool overlap(const vector<Lifetime>& a, const vector<Lifetime>& b)
+        {
+            for (const Lifetime& lifetime_a : a)
+            {
+                for (const Lifetime& lifetime_b : b)
+                {
+                    if (lifetime_a.pass_first <= lifetime_b.pass_last && lifetime_b.pass_first <= lifetime_a.pass_last)
+                        return true;
+                }
+            }
+
+            return false;
+        }
+
+        bool overlap(const AliasGroup& group, const uint32_t render_target, const array<vector<Lifetime>, render_target_count>& lifetimes)
+        {
+            for (uint32_t member : group.render_targets)
+            {
+                if (member != render_target && overlap(lifetimes[member], lifetimes[render_target]))
+                    return true;
+            }
+
+            return false;
+        }
+
+        bool is_assignment_valid(const array<bool, render_target_count>& aliasable, const array<vector<Lifetime>, render_target_count>& lifetimes)
+        {
+            for (uint32_t i = 0; i < render_target_count; i++)
+            {
+                RHI_Texture* texture = get_render_target(i);
+                if (!texture || !texture->IsTransient())
+                    continue;
+
+                // the render target was re-created (e.g. the resolution changed), or started or stopped carrying content over
+                if (texture->GetObjectId() != object_ids[i] || aliasable[i] != grouped[i])
+                    return false;
+            }
+
+            for (const AliasGroup& group : groups)
+            {
+                for (uint32_t render_target : group.render_targets)
+                {
+                    if (overlap(group, render_target, lifetimes))
+                        return false;
+                }
+            }
+
+            return true;
+        }
+
+        // largest first, each render target goes to the first group whose members it doesn't overlap with
+        vector<AliasGroup> pack(const array<bool, render_target_count>& aliasable, const array<vector<Lifetime>, render_target_count>& lifetimes)
+        {
+            vector<uint32_t> render_targets;
+            for (uint32_t i = 0; i < render_target_count; i++)
+            {
+                if (aliasable[i])
+                {
+                    render_targets.push_back(i);
+                }
+            }
+
+            sort(render_targets.begin(), render_targets.end(), [](const uint32_t a, const uint32_t b)
+            {
+                return get_render_target(a)->GetObjectSizeGpu() > get_render_target(b)->GetObjectSizeGpu();
+            });
+
+            vector<AliasGroup> groups_packed;
+            for (uint32_t render_target : render_targets)
+            {
+                AliasGroup* group_fit = nullptr;
+                for (AliasGroup& group : groups_packed)
+                {
+                    if (!overlap(group, render_target, lifetimes))
+                    {
+                        group_fit = &group;
+                        break;
+                    }
+                }
+
+                if (!group_fit)
+                {
+                    group_fit = &groups_packed.emplace_back();
+                }
+
+                group_fit->render_targets.push_back(render_target);
+            }
+
+            return groups_packed;
+        }
+
+        // the textures are created anew, so the gpu has to be idle
+        void assign(vector<AliasGroup>& groups_packed, const array<bool, render_target_count>& aliasable)
+        {
+            RHI_Device::QueueWaitAll();
+
+            uint32_t aliased_count = 0;
+            for (AliasGroup& group : groups_packed)
+            {
+                if (group.render_targets.size() < 2)
+                    continue;
+
+                vector<RHI_Texture*> textures;
+                for (uint32_t render_target : group.render_targets)
+                {
+                    textures.push_back(get_render_target(render_target));
+                }
+
+                group.memory = RHI_Device::MemoryAliasCreate(textures, "render_graph_alias");
+                if (group.memory)
+                {
+                    aliased_count += static_cast<uint32_t>(group.render_targets.size());
+                }
+                else
+                {
+                    SP_LOG_WARNING("Render targets \"%s\" and \"%s\" can't share memory", textures[0]->GetObjectName().c_str(), textures[1]->GetObjectName().c_str());
+                }
+            }
+
+            // every transient render target, so that the ones which no longer share memory get their own
+            for (uint32_t i = 0; i < render_target_count; i++)
+            {
+                RHI_Texture* texture = get_render_target(i);
+                if (!texture || !texture->IsTransient())
+                    continue;
+
+                void* memory = nullptr;
+                for (const AliasGroup& group : groups_packed)
+                {
+                    if (find(group.render_targets.begin(), group.render_targets.end(), i) != group.render_targets.end())
+                    {
+                        memory = group.memory;
+                        break;
+                    }
+                }
+
+                texture->SetAliasMemory(memory);
+                object_ids[i] = texture->GetObjectId();
+            }
+
+            // the images which were bound to the previous memory go first, along with the descriptor sets which reference them
+            RHI_Device::DeletionQueueParse();
+            for (AliasGroup& group : groups)
+            {
+                RHI_Device::MemoryAliasDestroy(group.memory);
+            }
+
+            groups  = move(groups_packed);
+            grouped = aliasable;
+
+            SP_LOG_INFO("%u render targets share memory, in %u allocations", aliased_count, static_cast<uint32_t>(count_if(groups.begin(), groups.end(), [](const AliasGroup& group) { return group.memory != nullptr; })));
+        }
+    }
+
+    RenderGraphPass& RenderGraphPass::Read(initializer_list<Renderer_RenderTexture> render_targets)
+    {
+        for (Renderer_RenderTexture render_target : render_targets)
+        {
+            access[static_cast<uint32_t>(render_target)] |= access_read;
+        }
+
+        return *this;
+    }
+
+    RenderGraphPass& RenderGraphPass::Write(initializer_list<Renderer_RenderTexture> render_targets)
+    {
+        for (Renderer_RenderTexture render_target : render_targets)
+        {
+            access[static_cast<uint32_t>(render_target)] |= access_write;
+        }
+
+        return *this;
+    }
+
+    RenderGraphPass& RenderGraph::AddPass(const char* name, function<void(RHI_CommandList*)> execute)
+    {
+        RenderGraphPass& pass = passes.emplace_back();
+        pass.name             = name;
+        pass.execute          = move(execute);
+
+        return pass;
+    }
+
+    void RenderGraph::Execute(RHI_CommandList* cmd_list)
+    {
+        const uint32_t pass_count = static_cast<uint32_t>(passes.size());
+
+        // a render target keeps its content across frames if it isn't transient, or if it's read before it's written
+        array<bool, render_target_count> persistent = {};
+        {
+            array<bool, render_target_count> written = {};
+            for (const RenderGraphPass& pass : passes)
+            {
+                for (uint32_t i = 0; i < render_target_count; i++)
+                {
+                    persistent[i] = persistent[i] || ((pass.access[i] & access_read) && !written[i]);
+                    written[i]    = written[i]    || (pass.access[i] & access_write);
+                }
+            }
+
+            for (uint32_t i = 0; i < render_target_count; i++)
+            {
+                RHI_Texture* texture = get_render_target(i);
+                persistent[i]        = persistent[i] || !texture || !texture->IsTransient();
+            }
+        }
+
+        // cull, from the last pass to the first, the passes which only write what nothing needs
+        vector<bool> culled(pass_count, false);
+        {
+            array<bool, render_target_count> needed = persistent;
+            for (uint32_t index = pass_count; index-- > 0;)
+            {
+                const RenderGraphPass& pass = passes[index];
+
+                bool writes        = false;
+                bool writes_needed = false;
+                for (uint32_t i = 0; i < render_target_count; i++)
+                {
+                    if (pass.access[i] & access_write)
+                    {
+                        writes        = true;
+                        writes_needed = writes_needed || needed[i];
+                    }
+                }
+
+                // a pass which writes no render target does something else (e.g. shadow maps, culling)
+                if (writes && !writes_needed)
+                {
+                    culled[index] = true;
+                    continue;
+                }
+
+                // what's discarded isn't needed before, what's read is
+                for (uint32_t i = 0; i < render_target_count; i++)
+                {
+                    if (pass.access[i] == access_write && !persistent[i])
+                    {
+                        needed[i] = false;
+                    }
+
+                    if (pass.access[i] & access_read)
+                    {
+                        needed[i] = true;
+                    }
+                }
+            }
+        }
+
+        // the lifetimes of the render targets which can share memory
+        array<bool, render_target_count> aliasable = {};
+        array<vector<Lifetime>, render_target_count> lifetimes;
+        for (uint32_t i = 0; i < render_target_count; i++)
+        {
+            aliasable[i] = !persistent[i];
+        }
+        for (uint32_t index = 0; index < pass_count; index++)
+        {
+            if (culled[index])
+                continue;
+
+            for (uint32_t i = 0; i < render_target_count; i++)
+            {
+                const uint8_t access = passes[index].access[i];
+                if (!aliasable[i] || access == 0)
+                    continue;
+
+                if (access == access_write || lifetimes[i].empty())
+                {
+                    lifetimes[i].push_back({ index, index });
+                }
+                else
+                {
+                    lifetimes[i].back().pass_last = index;
+                }
+            }
+        }
+
+        // re-assign the memory only when the lifetimes no longer allow it, since it stalls the gpu
+        if (!is_assignment_valid(aliasable, lifetimes))
+        {
+            vector<AliasGroup> groups_packed = pack(aliasable, lifetimes);
+            assign(groups_packed, aliasable);
+        }
+
+        array<AliasGroup*, render_target_count> group_of = {};
+        for (AliasGroup& group : groups)
+        {
+            for (uint32_t render_target : group.render_targets)
+            {
+                group_of[render_target] = group.memory ? &group : nullptr;
+            }
+        }
+
+        for (uint32_t index = 0; index < pass_count; index++)
+        {
+            if (culled[index])
+                continue;
+
+            // render targets whose lifetime starts here take over the memory, unless they were the last to use it
+            bool discarded = false;
+            for (uint32_t i = 0; i < render_target_count; i++)
+            {
+                AliasGroup* group = group_of[i];
+                if (!group || group->render_target_last == i)
+                    continue;
+
+                for (const Lifetime& lifetime : lifetimes[i])
+                {
+                    if (lifetime.pass_first == index)
+                    {
+                        get_render_target(i)->SetLayout(RHI_Image_Layout::Undefined, nullptr);
+                        group->render_target_last = i;
+                        discarded                 = true;
+                    }
+                }
+            }
+
+            if (discarded)
+            {
+                cmd_list->InsertMemoryBarrierAliasing();
+            }
+
+            cmd_list->BeginMarker(passes[index].name);
+            passes[index].execute(cmd_list);
+            cmd_list->EndMarker();
+        }
+
+        passes.clear();
+    }
+
+    void RenderGraph::Shutdown()
+    {
+        passes.clear();
+
+        // the images which are bound to the memory go first
+        RHI_Device::QueueWaitAll();
+        RHI_Device::DeletionQueueParse();
+        for (AliasGroup& group : groups)
+        {
+            RHI_Device::MemoryAliasDestroy(group.memory);
+        }
+
+        groups.clear();
+        grouped.fill(false);
+        object_ids.fill(0);
+    }
+}
@@ -0,0 +1,60 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES =====================
+#include <array>
+#include <functional>
+#include <initializer_list>
+#include "Renderer_Definitions.h"
+//================================
+
+namespace Spartan
+{
+    class RHI_CommandList;
+
+    // a pass of the frame, along with the render targets it accesses
+    struct RenderGraphPass
+    {
+        // the pass needs what the render target contained before it
+        RenderGraphPass& Read(std::initializer_list<Renderer_RenderTexture> render_targets);
+
+        // the pass changes the render target, if it doesn't also read it, whatever it contained before is discarded
+        RenderGraphPass& Write(std::initializer_list<Renderer_RenderTexture> render_targets);
+
+        const char* name = nullptr;
+        std::function<void(RHI_CommandList*)> execute;
+        std::array<uint8_t, static_cast<uint32_t>(Renderer_RenderTexture::max)> access = {};
+    };
+
+    // the passes of a frame are added in the order they execute, then executed together
+    // passes whose writes nothing needs are culled, where needed means read by a later pass, or a render target which isn't transient (see RHI_Texture_Transient)
+    // transient render targets whose lifetimes don't overlap share memory, the assignment is only redone (which stalls the gpu) when the lifetimes change
+    class RenderGraph
+    {
+    public:
+        static RenderGraphPass& AddPass(const char* name, std::function<void(RHI_CommandList*)> execute);
+        static void Execute(RHI_CommandList* cmd_list);
+        static void Shutdown();
+    };
+}
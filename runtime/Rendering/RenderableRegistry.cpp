@@ -0,0 +1,384 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===============================
+#include "pch.h"
+#include "RenderableRegistry.h"
+#include "Material.h"
+#include "../World/Entity.h"
+#include "../RHI/RHI_VertexBuffer.h"
+#include "../Math/BoundingVolumeHierarchy.h"
+//==========================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    namespace
+    {
+        const uint32_t list_count = static_cast<uint32_t>(Renderer_Entity::GeometryTransparentInstanced) + 1;
+        array<RenderableList, list_count> lists;
+        bool dirty = false;
+
+        // the owners of the bvh leaves, indexed by leaf
+        struct BvhLeaf
+        {
+            Renderable* renderable = nullptr;
+            uint32_t group_index   = RenderableRegistry::group_none;
+        };
+        BoundingVolumeHierarchy bvh;
+        vector<BvhLeaf> bvh_leaves;
+
+        void bvh_remove(Renderable* renderable)
+        {
+            for (uint32_t leaf : renderable->GetRegistryLeaves())
+            {
+                bvh.Remove(leaf);
+                bvh_leaves[leaf] = BvhLeaf();
+            }
+
+            renderable->GetRegistryLeaves().clear();
+        }
+
+        void bvh_update(RenderableList& list, const uint32_t index)
+        {
+            Renderable* renderable = list.renderables[index];
+            if (list.bounding_boxes[index] == BoundingBox::Undefined)
+            {
+                bvh_remove(renderable);
+                return;
+            }
+
+            // one leaf per instance group, so that the groups can be culled individually, otherwise one for the whole renderable
+            const uint32_t group_count = list.IsInstanced() ? renderable->GetInstancePartitionCount() : 0;
+            const uint32_t leaf_count  = max(group_count, 1u);
+            vector<uint32_t>& leaves   = renderable->GetRegistryLeaves();
+            if (leaves.size() != leaf_count)
+            {
+                bvh_remove(renderable);
+            }
+
+            for (uint32_t i = 0; i < leaf_count; i++)
+            {
+                const BoundingBox& box = group_count > 0 ? renderable->GetBoundingBox(BoundingBoxType::TransformedInstanceGroup, i) : list.bounding_boxes[index];
+
+                // moves within the margin of the leaf are free
+                if (i < leaves.size())
+                {
+                    bvh.Update(leaves[i], box);
+                    continue;
+                }
+
+                uint32_t leaf = bvh.Insert(box);
+                if (leaf >= bvh_leaves.size())
+                {
+                    bvh_leaves.resize(leaf + 1);
+                }
+                bvh_leaves[leaf].renderable  = renderable;
+                bvh_leaves[leaf].group_index = group_count > 0 ? i : RenderableRegistry::group_none;
+                leaves.emplace_back(leaf);
+            }
+        }
+
+        template<typename T>
+        void permute(vector<T>& values, const vector<uint32_t>& order)
+        {
+            static vector<T> values_ordered;
+            values_ordered.clear();
+            values_ordered.reserve(values.size());
+            for (uint32_t index : order)
+            {
+                values_ordered.push_back(values[index]);
+            }
+            values.swap(values_ordered);
+        }
+
+        void refresh(RenderableList& list, const uint32_t index)
+        {
+            Renderable* renderable = list.renderables[index];
+            Entity* entity         = renderable->GetEntity();
+            Material* material     = renderable->GetMaterial();
+            bool ready             = renderable->ReadyToRender();
+
+            // keep the visibility, which is written by the renderer
+            const uint32_t flags_visibility = RenderableFlags::IsInViewFrustum | RenderableFlags::IsOccluded | RenderableFlags::IsOccluding;
+
+            list.transforms[index] = entity->GetMatrix();
+            list.flags[index]      = (list.flags[index] & flags_visibility) | (renderable->GetFlags() & ~flags_visibility);
+
+            RenderableGeometry& geometry = list.geometry[index];
+            geometry.vertex_buffer       = ready ? renderable->GetVertexBuffer() : nullptr;
+            geometry.index_buffer        = ready ? renderable->GetIndexBuffer()  : nullptr;
+            geometry.index_offset        = renderable->GetIndexOffset();
+            geometry.index_count         = renderable->GetIndexCount();
+            geometry.vertex_offset       = renderable->GetVertexOffset();
+
+            if (ready)
+            {
+                list.bounding_boxes[index] = renderable->GetBoundingBox(list.IsInstanced() ? BoundingBoxType::TransformedInstances : BoundingBoxType::Transformed);
+
+                list.material_indices[index] = material->GetIndex();
+                list.cull_modes[index]       = static_cast<RHI_CullMode>(material->GetProperty(MaterialProperty::CullMode));
+                list.material_alpha[index]   = Vector3(
+                    material->HasTexture(MaterialTexture::AlphaMask) ? 1.0f : 0.0f,
+                    material->HasTexture(MaterialTexture::Color)     ? 1.0f : 0.0f,
+                    material->GetProperty(MaterialProperty::ColorA)
+                );
+
+                // the lods and the clusters are only known once the mesh is complete (the sub-meshes are imported in parallel)
+                renderable->UpdateLods();
+                if (!list.IsInstanced())
+                {
+                    renderable->UpdateClusters();
+                }
+
+                bvh_update(list, index);
+            }
+
+            // when async loading, the buffers might not be there yet, so keep checking
+            list.dirty[index] = ready ? 0 : 1;
+            dirty            |= !ready;
+        }
+    }
+
+    void RenderableRegistry::Clear()
+    {
+        for (RenderableList& list : lists)
+        {
+            for (uint32_t i = 0; i < list.GetCount(); i++)
+            {
+                // carry the previous transform over, so that velocity survives the registry being rebuilt
+                list.renderables[i]->GetEntity()->SetMatrixPrevious(list.transforms_previous[i]);
+                list.renderables[i]->SetRegistrySlot(list.type, numeric_limits<uint32_t>::max());
+                list.renderables[i]->GetRegistryLeaves().clear();
+            }
+
+            list.transforms.clear();
+            list.transforms_previous.clear();
+            list.bounding_boxes.clear();
+            list.geometry.clear();
+            list.material_indices.clear();
+            list.material_alpha.clear();
+            list.cull_modes.clear();
+            list.flags.clear();
+            list.renderables.clear();
+            list.dirty.clear();
+        }
+
+        bvh.Clear();
+        bvh_leaves.clear();
+        dirty = false;
+    }
+
+    void RenderableRegistry::Add(Renderable* renderable, const Renderer_Entity type)
+    {
+        SP_ASSERT(renderable != nullptr);
+        SP_ASSERT(static_cast<uint32_t>(type) < list_count);
+
+        RenderableList& list = lists[static_cast<uint32_t>(type)];
+        list.type            = type;
+
+        renderable->SetRegistrySlot(type, list.GetCount());
+        list.transforms.emplace_back(renderable->GetEntity()->GetMatrix());
+        list.transforms_previous.emplace_back(renderable->GetEntity()->GetMatrixPrevious());
+        list.bounding_boxes.emplace_back(BoundingBox::Undefined);
+        list.geometry.emplace_back();
+        list.material_indices.emplace_back(0);
+        list.material_alpha.emplace_back(Vector3::Zero);
+        list.cull_modes.emplace_back(RHI_CullMode::Back);
+        list.flags.emplace_back(renderable->GetFlags());
+        list.renderables.emplace_back(renderable);
+        list.dirty.emplace_back(1);
+
+        dirty = true;
+    }
+
+    void RenderableRegistry::Remove(Renderable* renderable)
+    {
+        uint32_t type  = static_cast<uint32_t>(renderable->GetRegistryType());
+        uint32_t index = renderable->GetRegistryIndex();
+        if (type >= list_count || index >= lists[type].GetCount())
+            return;
+
+        bvh_remove(renderable);
+
+        // move the last element into the slot, so that the arrays stay packed
+        RenderableList& list = lists[type];
+        uint32_t index_last  = list.GetCount() - 1;
+        if (index != index_last)
+        {
+            list.transforms[index]          = list.transforms[index_last];
+            list.transforms_previous[index] = list.transforms_previous[index_last];
+            list.bounding_boxes[index]      = list.bounding_boxes[index_last];
+            list.geometry[index]            = list.geometry[index_last];
+            list.material_indices[index]    = list.material_indices[index_last];
+            list.material_alpha[index]      = list.material_alpha[index_last];
+            list.cull_modes[index]          = list.cull_modes[index_last];
+            list.flags[index]               = list.flags[index_last];
+            list.renderables[index]         = list.renderables[index_last];
+            list.dirty[index]               = list.dirty[index_last];
+
+            list.renderables[index]->SetRegistrySlot(list.type, index);
+        }
+
+        list.transforms.pop_back();
+        list.transforms_previous.pop_back();
+        list.bounding_boxes.pop_back();
+        list.geometry.pop_back();
+        list.material_indices.pop_back();
+        list.material_alpha.pop_back();
+        list.cull_modes.pop_back();
+        list.flags.pop_back();
+        list.renderables.pop_back();
+        list.dirty.pop_back();
+
+        renderable->SetRegistrySlot(list.type, numeric_limits<uint32_t>::max());
+    }
+
+    void RenderableRegistry::Update()
+    {
+        if (!dirty)
+            return;
+
+        dirty = false;
+        for (RenderableList& list : lists)
+        {
+            for (uint32_t i = 0; i < list.GetCount(); i++)
+            {
+                if (list.dirty[i])
+                {
+                    refresh(list, i);
+                }
+            }
+        }
+    }
+
+    void RenderableRegistry::Sort(const Renderer_Entity type, const Vector3& position, const bool back_to_front)
+    {
+        RenderableList& list = GetList(type);
+        if (list.GetCount() <= 2)
+            return;
+
+        static vector<float> distances;
+        distances.resize(list.GetCount());
+        for (uint32_t i = 0; i < list.GetCount(); i++)
+        {
+            distances[i] = (list.bounding_boxes[i].GetCenter() - position).LengthSquared();
+        }
+
+        static vector<uint32_t> order;
+        order.resize(list.GetCount());
+        for (uint32_t i = 0; i < list.GetCount(); i++)
+        {
+            order[i] = i;
+        }
+
+        sort(order.begin(), order.end(), [back_to_front](const uint32_t a, const uint32_t b)
+        {
+            return back_to_front ? distances[a] > distances[b] : distances[a] < distances[b];
+        });
+
+        permute(list.transforms,          order);
+        permute(list.transforms_previous, order);
+        permute(list.bounding_boxes,      order);
+        permute(list.geometry,            order);
+        permute(list.material_indices,    order);
+        permute(list.material_alpha,      order);
+        permute(list.cull_modes,          order);
+        permute(list.flags,               order);
+        permute(list.renderables,         order);
+        permute(list.dirty,               order);
+
+        for (uint32_t i = 0; i < list.GetCount(); i++)
+        {
+            list.renderables[i]->SetRegistrySlot(type, i);
+        }
+    }
+
+    void RenderableRegistry::SetDirty(const Renderable* renderable)
+    {
+        uint32_t type  = static_cast<uint32_t>(renderable->GetRegistryType());
+        uint32_t index = renderable->GetRegistryIndex();
+        if (type >= list_count || index >= lists[type].GetCount())
+            return;
+
+        lists[type].dirty[index] = 1;
+        dirty                    = true;
+    }
+
+    void RenderableRegistry::SetDirty(const unordered_set<Material*>& materials)
+    {
+        for (RenderableList& list : lists)
+        {
+            for (uint32_t i = 0; i < list.GetCount(); i++)
+            {
+                if (materials.find(list.renderables[i]->GetMaterial()) != materials.end())
+                {
+                    list.dirty[i] = 1;
+                    dirty         = true;
+                }
+            }
+        }
+    }
+
+    void RenderableRegistry::SetDirtyAll()
+    {
+        for (RenderableList& list : lists)
+        {
+            fill(list.dirty.begin(), list.dirty.end(), static_cast<uint8_t>(1));
+        }
+
+        dirty = true;
+    }
+
+    RenderableList& RenderableRegistry::GetList(const Renderer_Entity type)
+    {
+        SP_ASSERT(static_cast<uint32_t>(type) < list_count);
+        return lists[static_cast<uint32_t>(type)];
+    }
+
+    void RenderableRegistry::QueryFrustum(const Frustum& frustum, const bool ignore_depth, const function<void(Renderable* renderable, uint32_t group_index)>& callback)
+    {
+        bvh.QueryFrustum(frustum, ignore_depth, [&callback](uint32_t leaf)
+        {
+            callback(bvh_leaves[leaf].renderable, bvh_leaves[leaf].group_index);
+        });
+    }
+
+    void RenderableRegistry::QueryRay(const Ray& ray, const function<void(Renderable* renderable, uint32_t group_index, float distance)>& callback)
+    {
+        bvh.QueryRay(ray, [&callback](uint32_t leaf, float distance)
+        {
+            callback(bvh_leaves[leaf].renderable, bvh_leaves[leaf].group_index, distance);
+        });
+    }
+
+    void RenderableRegistry::QueryBox(const BoundingBox& box, const function<void(Renderable* renderable, uint32_t group_index)>& callback)
+    {
+        bvh.QueryBox(box, [&callback](uint32_t leaf)
+        {
+            callback(bvh_leaves[leaf].renderable, bvh_leaves[leaf].group_index);
+        });
+    }
+}
@@ -0,0 +1,101 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =============================
+#include <vector>
+#include "../RHI/RHI_Definitions.h"
+#include "../World/Components/Renderable.h"
+//========================================
+
+namespace Spartan
+{
+    class RHI_VertexBuffer;
+    class RHI_IndexBuffer;
+    class Material;
+
+    namespace Math
+    {
+        class Frustum;
+        class Ray;
+    }
+
+    struct RenderableGeometry
+    {
+        RHI_VertexBuffer* vertex_buffer = nullptr; // null until the renderable is ready to render
+        RHI_IndexBuffer* index_buffer   = nullptr;
+        uint32_t index_offset           = 0;
+        uint32_t index_count            = 0;
+        uint32_t vertex_offset          = 0;
+    };
+
+    // the renderables of one geometry type (Renderer_Entity::Geometry to GeometryTransparentInstanced), as a structure of arrays
+    struct RenderableList
+    {
+        std::vector<Math::Matrix> transforms;
+        std::vector<Math::Matrix> transforms_previous; // written by Renderer::UpdateDrawData(), for velocity
+        std::vector<Math::BoundingBox> bounding_boxes; // world space, spans all the instances (if any)
+        std::vector<RenderableGeometry> geometry;
+        std::vector<uint32_t> material_indices;
+        std::vector<Math::Vector3> material_alpha;     // has alpha mask, has color texture, alpha - what the depth passes alpha test with
+        std::vector<RHI_CullMode> cull_modes;
+        std::vector<uint32_t> flags;                   // RenderableFlags
+        std::vector<Renderable*> renderables;          // for the less frequent accesses (instancing, occluder geometry)
+        std::vector<uint8_t> dirty;
+
+        uint32_t GetCount() const                    { return static_cast<uint32_t>(renderables.size()); }
+        bool IsReady(const uint32_t index) const     { return geometry[index].vertex_buffer != nullptr; }
+        bool IsVisible(const uint32_t index) const   { return (flags[index] & RenderableFlags::IsInViewFrustum) && !(flags[index] & RenderableFlags::IsOccluded); }
+        bool IsInstanced() const                     { return type == Renderer_Entity::GeometryInstanced || type == Renderer_Entity::GeometryTransparentInstanced; }
+
+        Renderer_Entity type = Renderer_Entity::Geometry;
+        uint32_t draw_offset = 0; // where the elements start in the draw buffer
+    };
+
+    // a packed view of everything that's drawn, which the passes iterate instead of the entities
+    // renderables keep their slot and flag it when their transform, geometry or material changes, only those elements are refreshed
+    // the bounding boxes are also kept in a bounding volume hierarchy, one leaf per renderable or instance group, for the spatial queries
+    class RenderableRegistry
+    {
+    public:
+        static constexpr uint32_t group_none = std::numeric_limits<uint32_t>::max();
+
+        // main thread
+        static void Clear();
+        static void Add(Renderable* renderable, const Renderer_Entity type);
+        static void Remove(Renderable* renderable);
+        static void Update();
+        static void Sort(const Renderer_Entity type, const Math::Vector3& position, const bool back_to_front);
+
+        // dirty elements are refreshed by the next Update()
+        static void SetDirty(const Renderable* renderable);
+        static void SetDirty(const std::unordered_set<Material*>& materials); // the elements which use any of the materials
+        static void SetDirtyAll();
+
+        static RenderableList& GetList(const Renderer_Entity type);
+
+        // spatial queries, main thread, the group index is that of the instance group which was hit (or group_none)
+        static void QueryFrustum(const Math::Frustum& frustum, const bool ignore_depth, const std::function<void(Renderable* renderable, uint32_t group_index)>& callback);
+        static void QueryRay(const Math::Ray& ray, const std::function<void(Renderable* renderable, uint32_t group_index, float distance)>& callback);
+        static void QueryBox(const Math::BoundingBox& box, const std::function<void(Renderable* renderable, uint32_t group_index)>& callback);
+    };
+}
@@ -23,6 +23,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "pch.h"
 #include "Renderer.h"
 #include "ThreadPool.h"
+#include "RenderableRegistry.h"
+#include "TextureStreaming.h"
+#include "RenderGraph.h"
+#include "../Resource/ResourceCache.h"
 #include "../Profiling/Profiler.h"
 #include "../Profiling/RenderDoc.h"
 #include "../Core/Window.h"
@@ -86,7 +90,10 @@ namespace Spartan
 
         // renderable/entity management
         mutex mutex_entity_addition;
-        vector<shared_ptr<Entity>> m_entities_to_add;
+        vector<shared_ptr<Entity>> m_entities_to_add;  // a full resolve
+        vector<shared_ptr<Entity>> m_entities_changed; // individual changes, applied on top
+        vector<shared_ptr<Entity>> m_entities_removed;
+        unordered_set<Entity*> entities_registered;
 
         // misc
         unordered_map<Renderer_Option, float> m_options;
@@ -97,30 +104,131 @@ namespace Spartan
         float far_plane                      = 1.0f;
         bool dirty_orthographic_projection   = true;
 
+        // stable slots in a bindless table, an element keeps its slot for as long as it's in use, so that editing it only rewrites that slot
+        template<typename T>
+        struct bindless_slots
+        {
+            bindless_slots(const uint32_t stride) : stride(stride) { }
+
+            unordered_map<T*, uint32_t> slots;
+            vector<uint32_t> slots_free;
+            vector<uint32_t> slots_dirty; // the slots to upload
+            const uint32_t stride = 1;    // how many array elements an element occupies
+            uint32_t slot_end     = 0;
+            bool dirty_users      = true; // the entities changed, so slots have to be acquired or released
+
+            // edits can come from any thread
+            mutex mutex_dirty;
+            unordered_set<T*> dirty;
+            bool dirty_all = true;
+
+            void clear()
+            {
+                slots.clear();
+                slots_free.clear();
+                slots_dirty.clear();
+                slot_end    = 0;
+                dirty_users = true;
+
+                lock_guard lock(mutex_dirty);
+                dirty.clear();
+                dirty_all = true;
+            }
+
+            // the event data is the element that changed, if there is none, everything is rewritten
+            void on_changed(const sp_variant& data)
+            {
+                lock_guard lock(mutex_dirty);
+
+                if (holds_alternative<void*>(data) && get<void*>(data) != nullptr)
+                {
+                    dirty.insert(static_cast<T*>(get<void*>(data)));
+                }
+                else
+                {
+                    dirty_all = true;
+                }
+            }
+
+            // moves the edits into the given set, returns true if everything has to be rewritten
+            bool take_dirty(unordered_set<T*>& edited)
+            {
+                lock_guard lock(mutex_dirty);
+
+                edited.clear();
+                edited.swap(dirty);
+
+                bool all  = dirty_all;
+                dirty_all = false;
+                return all;
+            }
+
+            // returns true if the element didn't have a slot
+            bool acquire(T* element, uint32_t& slot)
+            {
+                auto it = slots.find(element);
+                if (it != slots.end())
+                {
+                    slot = it->second;
+                    return false;
+                }
+
+                if (!slots_free.empty())
+                {
+                    slot = slots_free.back();
+                    slots_free.pop_back();
+                }
+                else
+                {
+                    SP_ASSERT_MSG(slot_end + stride <= rhi_max_array_size, "Bindless table is full");
+                    slot      = slot_end;
+                    slot_end += stride;
+                }
+
+                slots[element] = slot;
+                return true;
+            }
+
+            // releases the slots of the elements which are no longer in use, the callback resets their data
+            void release_unused(const unordered_set<T*>& used, const function<void(const uint32_t slot)>& on_release)
+            {
+                for (auto it = slots.begin(); it != slots.end();)
+                {
+                    if (used.find(it->first) == used.end())
+                    {
+                        on_release(it->second);
+                        slots_free.push_back(it->second);
+                        slots_dirty.push_back(it->second);
+                        it = slots.erase(it);
+                    }
+                    else
+                    {
+                        it++;
+                    }
+                }
+            }
+        };
+
         namespace materials
         {
             array<RHI_Texture*, rhi_max_array_size> textures;  // mapped to the GPU as a bindless texture array
             array<Sb_Material, rhi_max_array_size> properties; // mapped to the GPU as a structured properties buffer
-            unordered_set<uint64_t> unique_material_ids;
-            uint32_t index = 0;
-            bool dirty     = true;
+            bindless_slots<Material> slots(material_texture_count_support); // material loading happens in other threads, the dirty tracking is thread safe
+            unordered_set<Material*> loading;                               // materials with textures that are still loading, updated again once they are done
 
             void clear()
             {
                 properties.fill(Sb_Material{});
                 textures.fill(nullptr);
-                unique_material_ids.clear();
-                index = 0;
+                slots.clear();
+                loading.clear();
             }
 
-            void update(Material* material)
+            void update(Material* material, const uint32_t index)
             {
-                // check if the material's ID is already processed
-                if (unique_material_ids.find(material->GetObjectId()) != unique_material_ids.end())
-                    return;
-
                 // properties
                 {
+                    properties[index]                        = Sb_Material{};
                     properties[index].world_space_height     = material->GetProperty(MaterialProperty::WorldSpaceHeight);
                     properties[index].color.x                = material->GetProperty(MaterialProperty::ColorR);
                     properties[index].color.y                = material->GetProperty(MaterialProperty::ColorG);
@@ -143,14 +251,14 @@ namespace Spartan
                     properties[index].subsurface_scattering  = material->GetProperty(MaterialProperty::SubsurfaceScattering);
                     properties[index].ior                    = material->GetProperty(MaterialProperty::Ior);
                     properties[index].flags                 |= material->GetProperty(MaterialProperty::SingleTextureRoughnessMetalness) ? (1U << 0)  : 0;
-                    properties[index].flags                 |= material->HasTexture(MaterialTexture::Height)                            ? (1U << 1)  : 0;
-                    properties[index].flags                 |= material->HasTexture(MaterialTexture::Normal)                            ? (1U << 2)  : 0;
-                    properties[index].flags                 |= material->HasTexture(MaterialTexture::Color)                             ? (1U << 3)  : 0;
-                    properties[index].flags                 |= material->HasTexture(MaterialTexture::Roughness)                         ? (1U << 4)  : 0;
-                    properties[index].flags                 |= material->HasTexture(MaterialTexture::Metalness)                         ? (1U << 5)  : 0;
-                    properties[index].flags                 |= material->HasTexture(MaterialTexture::AlphaMask)                         ? (1U << 6)  : 0;
-                    properties[index].flags                 |= material->HasTexture(MaterialTexture::Emission)                          ? (1U << 7)  : 0;
-                    properties[index].flags                 |= material->HasTexture(MaterialTexture::Occlusion)                         ? (1U << 8)  : 0;
+                    properties[index].flags                 |= material->IsTextureReady(MaterialTexture::Height)                        ? (1U << 1)  : 0;
+                    properties[index].flags                 |= material->IsTextureReady(MaterialTexture::Normal)                        ? (1U << 2)  : 0;
+                    properties[index].flags                 |= material->IsTextureReady(MaterialTexture::Color)                         ? (1U << 3)  : 0;
+                    properties[index].flags                 |= material->IsTextureReady(MaterialTexture::Roughness)                     ? (1U << 4)  : 0;
+                    properties[index].flags                 |= material->IsTextureReady(MaterialTexture::Metalness)                     ? (1U << 5)  : 0;
+                    properties[index].flags                 |= material->IsTextureReady(MaterialTexture::AlphaMask)                     ? (1U << 6)  : 0;
+                    properties[index].flags                 |= material->IsTextureReady(MaterialTexture::Emission)                      ? (1U << 7)  : 0;
+                    properties[index].flags                 |= material->IsTextureReady(MaterialTexture::Occlusion)                     ? (1U << 8)  : 0;
                     properties[index].flags                 |= material->GetProperty(MaterialProperty::TextureSlopeBased)               ? (1U << 9)  : 0;
                     properties[index].flags                 |= material->GetProperty(MaterialProperty::VertexAnimateWind)               ? (1U << 10) : 0;
                     properties[index].flags                 |= material->GetProperty(MaterialProperty::VertexAnimateWater)              ? (1U << 11) : 0;
@@ -166,88 +274,224 @@ namespace Spartan
                         {
                             uint32_t texture_index          = type * material_texture_count_per_type + variation;
                             MaterialTexture textureType     = static_cast<MaterialTexture>(texture_index);
-                            textures[index + texture_index] = material->GetTexture(static_cast<MaterialTexture>(texture_index));
+                            // textures which are still loading are bound once they are done
+                            textures[index + texture_index] = material->IsTextureReady(textureType) ? material->GetTexture(textureType) : nullptr;
                         }
                     }
 
                 }
 
+                if (material->IsLoading())
+                {
+                    loading.insert(material);
+                }
+
                 material->SetIndex(index);
-                index += material_texture_count_support;
+                slots.slots_dirty.push_back(index);
             }
 
-            void update(vector<shared_ptr<Entity>>& entities)
+            // releases the slots of the materials which are no longer used, and acquires slots for the new ones
+            void update_slots(unordered_map<Renderer_Entity, vector<shared_ptr<Entity>>>& renderables, unordered_set<Material*>& edited)
             {
-                for (shared_ptr<Entity> entity : entities)
+                static vector<pair<Renderable*, Material*>> users;
+                static unordered_set<Material*> used;
+                users.clear();
+                used.clear();
+
+                for (Renderer_Entity type : { Renderer_Entity::Geometry, Renderer_Entity::GeometryInstanced, Renderer_Entity::GeometryTransparent, Renderer_Entity::GeometryTransparentInstanced })
                 {
-                    if (shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>())
+                    for (const shared_ptr<Entity>& entity : renderables[type])
                     {
-                        if (Material* material = renderable->GetMaterial())
+                        if (shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>())
                         {
-                            update(material);
+                            if (Material* material = renderable->GetMaterial())
+                            {
+                                users.emplace_back(renderable.get(), material);
+                                used.insert(material);
+                            }
                         }
                     }
                 }
+
+                // release first, so that the freed slots can be reused right away
+                slots.release_unused(used, [](const uint32_t index)
+                {
+                    properties[index] = Sb_Material{};
+                    fill(textures.begin() + index, textures.begin() + index + material_texture_count_support, nullptr);
+                });
+
+                for (const auto& [renderable, material] : users)
+                {
+                    uint32_t index = 0;
+                    bool acquired  = slots.acquire(material, index);
+
+                    // the registry caches the material index
+                    if (acquired || material->GetIndex() != index)
+                    {
+                        edited.insert(material);
+                    }
+
+                    if (material->GetIndex() != index)
+                    {
+                        RenderableRegistry::SetDirty(renderable);
+                    }
+                }
             }
 
-            void update(unordered_map<Renderer_Entity, vector<shared_ptr<Entity>>>& renderables)
+            // returns true if the whole table has to be uploaded
+            bool update(unordered_map<Renderer_Entity, vector<shared_ptr<Entity>>>& renderables)
             {
-                clear();
+                static unordered_set<Material*> edited;
+                bool rewrite_all = slots.take_dirty(edited);
+
+                // a renderable switched to a material which doesn't have a slot yet
+                for (Material* material : edited)
+                {
+                    if (slots.slots.find(material) == slots.slots.end())
+                    {
+                        slots.dirty_users = true;
+                        break;
+                    }
+                }
+
+                if (slots.dirty_users)
+                {
+                    update_slots(renderables, edited);
+                    slots.dirty_users = false;
+                }
+
+                // materials whose textures finished loading are rewritten, so that the textures get bound
+                for (auto it = loading.begin(); it != loading.end();)
+                {
+                    if (slots.slots.find(*it) == slots.slots.end())
+                    {
+                        it = loading.erase(it);
+                    }
+                    else if (!(*it)->IsLoading())
+                    {
+                        edited.insert(*it);
+                        it = loading.erase(it);
+                    }
+                    else
+                    {
+                        it++;
+                    }
+                }
+
+                if (rewrite_all)
+                {
+                    for (const auto& [material, index] : slots.slots)
+                    {
+                        update(material, index);
+                    }
+
+                    RenderableRegistry::SetDirtyAll();
+                }
+                else if (!edited.empty())
+                {
+                    // edits to materials which are no longer used are dropped, they don't have a slot
+                    for (Material* material : edited)
+                    {
+                        auto it = slots.slots.find(material);
+                        if (it != slots.slots.end())
+                        {
+                            update(material, it->second);
+                        }
+                    }
+
+                    // the registry caches the alpha and the cull mode
+                    RenderableRegistry::SetDirty(edited);
+                }
 
-                update(renderables[Renderer_Entity::Geometry]);
-                update(renderables[Renderer_Entity::GeometryInstanced]);
-                update(renderables[Renderer_Entity::GeometryTransparent]);
-                update(renderables[Renderer_Entity::GeometryTransparentInstanced]);
+                return rewrite_all;
             }
         }
 
         namespace lights
         {
             array<Sb_Light, rhi_max_array_size> properties;
-            bool dirty = true;
+            bindless_slots<Light> slots(1); // lights can tick in parallel, the dirty tracking is thread safe
 
-            void update(vector<shared_ptr<Entity>>& entities, Camera* camera)
+            void clear()
             {
-                // clear
                 properties.fill(Sb_Light{});
+                slots.clear();
+            }
+
+            void update(Light* light, const uint32_t index, Camera* camera)
+            {
+                light->SetIndex(index);
 
-                // go through each light
-                uint32_t index = 0;
-                for (shared_ptr<Entity>& entity : entities)
+                // set light properties
+                properties[index] = Sb_Light{};
+                if (RHI_Texture* texture = light->GetDepthTexture())
                 {
-                    Light* light = entity->GetComponent<Light>().get();
+                    for (uint32_t i = 0; i < texture->GetArrayLength(); i++)
+                    {
+                        properties[index].view_projection[i] = light->GetViewMatrix(i) * light->GetProjectionMatrix(i);
+                    }
+                }
+                properties[index].intensity    = light->GetIntensityWatt(camera);
+                properties[index].range        = light->GetRange();
+                properties[index].angle        = light->GetAngle();
+                properties[index].bias         = light->GetBias();
+                properties[index].color        = light->GetColor();
+                properties[index].normal_bias  = light->GetNormalBias();
+                properties[index].position     = light->GetEntity()->GetPosition();
+                properties[index].direction    = light->GetEntity()->GetForward();
+                properties[index].flags        = 0;
+                properties[index].flags       |= light->GetLightType() == LightType::Directional                                                                      ? (1 << 0) : 0;
+                properties[index].flags       |= light->GetLightType() == LightType::Point                                                                            ? (1 << 1) : 0;
+                properties[index].flags       |= light->GetLightType() == LightType::Spot                                                                             ? (1 << 2) : 0;
+                properties[index].flags       |= light->IsFlagSet(LightFlags::Shadows)                                                                                ? (1 << 3) : 0;
+                properties[index].flags       |= light->IsFlagSet(LightFlags::ShadowsTransparent)                                                                     ? (1 << 4) : 0;
+                properties[index].flags       |= (light->IsFlagSet(LightFlags::ShadowsScreenSpace) && Renderer::GetOption<bool>(Renderer_Option::ScreenSpaceShadows)) ? (1 << 5) : 0;
+                properties[index].flags       |= (light->IsFlagSet(LightFlags::Volumetric)         && Renderer::GetOption<bool>(Renderer_Option::FogVolumetric))      ? (1 << 6) : 0;
+                // when changing the bit flags, ensure that you also update the Light struct in common_structs.hlsl, so that it reads those flags as expected
+
+                slots.slots_dirty.push_back(index);
+            }
 
-                    // set light index
-                    light->SetIndex(index);
+            // returns true if the whole table has to be uploaded
+            bool update(vector<shared_ptr<Entity>>& entities, Camera* camera)
+            {
+                static unordered_set<Light*> edited;
+                bool rewrite_all = slots.take_dirty(edited);
 
-                    // set light properties
-                    if (RHI_Texture* texture = light->GetDepthTexture())
+                // release the slots of the removed lights and acquire slots for the added ones
+                if (slots.dirty_users)
+                {
+                    static unordered_set<Light*> used;
+                    used.clear();
+                    for (const shared_ptr<Entity>& entity : entities)
                     {
-                        for (uint32_t i = 0; i < texture->GetArrayLength(); i++)
+                        used.insert(entity->GetComponent<Light>().get());
+                    }
+
+                    slots.release_unused(used, [](const uint32_t index) { properties[index] = Sb_Light{}; });
+
+                    for (Light* light : used)
+                    {
+                        uint32_t index = 0;
+                        if (slots.acquire(light, index) || light->GetIndex() != index)
                         {
-                            properties[index].view_projection[i] = light->GetViewMatrix(i) * light->GetProjectionMatrix(i);
+                            edited.insert(light);
                         }
                     }
-                    properties[index].intensity    = light->GetIntensityWatt(camera);
-                    properties[index].range        = light->GetRange();
-                    properties[index].angle        = light->GetAngle();
-                    properties[index].bias         = light->GetBias();
-                    properties[index].color        = light->GetColor();
-                    properties[index].normal_bias  = light->GetNormalBias();
-                    properties[index].position     = light->GetEntity()->GetPosition();
-                    properties[index].direction    = light->GetEntity()->GetForward();
-                    properties[index].flags        = 0;
-                    properties[index].flags       |= light->GetLightType() == LightType::Directional                                                                      ? (1 << 0) : 0;
-                    properties[index].flags       |= light->GetLightType() == LightType::Point                                                                            ? (1 << 1) : 0;
-                    properties[index].flags       |= light->GetLightType() == LightType::Spot                                                                             ? (1 << 2) : 0;
-                    properties[index].flags       |= light->IsFlagSet(LightFlags::Shadows)                                                                                ? (1 << 3) : 0;
-                    properties[index].flags       |= light->IsFlagSet(LightFlags::ShadowsTransparent)                                                                     ? (1 << 4) : 0;
-                    properties[index].flags       |= (light->IsFlagSet(LightFlags::ShadowsScreenSpace) && Renderer::GetOption<bool>(Renderer_Option::ScreenSpaceShadows)) ? (1 << 5) : 0;
-                    properties[index].flags       |= (light->IsFlagSet(LightFlags::Volumetric)         && Renderer::GetOption<bool>(Renderer_Option::FogVolumetric))      ? (1 << 6) : 0;
-                    // when changing the bit flags, ensure that you also update the Light struct in common_structs.hlsl, so that it reads those flags as expected
-
-                    index++;
+
+                    slots.dirty_users = false;
+                }
+
+                // edits to lights which were removed are dropped, they don't have a slot
+                for (const auto& [light, index] : slots.slots)
+                {
+                    if (rewrite_all || edited.find(light) != edited.end())
+                    {
+                        update(light, index, camera);
+                    }
                 }
+
+                return rewrite_all;
             }
         }
     }
@@ -321,6 +565,10 @@ namespace Spartan
         SetOption(Renderer_Option::Antialiasing,                  static_cast<float>(Renderer_Antialiasing::Taa));       // this is using fsr 2 for taa
         SetOption(Renderer_Option::Upsampling,                    static_cast<float>(Renderer_Upsampling::FSR2));
         SetOption(Renderer_Option::Vsync,                         0.0f);
+        SetOption(Renderer_Option::OcclusionCulling,              1.0f);
+        SetOption(Renderer_Option::TextureStreamingBudget,        0.5f);                                                 // fraction of the gpu memory budget which streamed textures can use
+        SetOption(Renderer_Option::ResourceCacheBudgetCpu,        4096.0f);                                              // mb of cached resources before unused ones are evicted, 0 is unlimited
+        SetOption(Renderer_Option::ResourceCacheBudgetGpu,        0.8f);                                                 // fraction of the gpu memory budget, 0 is unlimited
         SetOption(Renderer_Option::Debanding,                     0.0f);
         SetOption(Renderer_Option::Debug_TransformHandle,         1.0f);
         SetOption(Renderer_Option::Debug_SelectionOutline,        1.0f);
@@ -356,10 +604,12 @@ namespace Spartan
         {
             // subscribe
             SP_SUBSCRIBE_TO_EVENT(EventType::WorldResolved,           SP_EVENT_HANDLER_VARIANT_STATIC(OnWorldResolved));
+            SP_SUBSCRIBE_TO_EVENT(EventType::WorldEntitiesChanged,    SP_EVENT_HANDLER_VARIANT_STATIC(OnWorldEntitiesChanged));
+            SP_SUBSCRIBE_TO_EVENT(EventType::WorldEntitiesRemoved,    SP_EVENT_HANDLER_VARIANT_STATIC(OnWorldEntitiesRemoved));
             SP_SUBSCRIBE_TO_EVENT(EventType::WorldClear,              SP_EVENT_HANDLER_STATIC(OnClear));
             SP_SUBSCRIBE_TO_EVENT(EventType::WindowFullScreenToggled, SP_EVENT_HANDLER_STATIC(OnFullScreenToggled));
-            SP_SUBSCRIBE_TO_EVENT(EventType::MaterialOnChanged,       SP_EVENT_HANDLER_EXPRESSION_STATIC( materials::dirty = true; ));
-            SP_SUBSCRIBE_TO_EVENT(EventType::LightOnChanged,          SP_EVENT_HANDLER_EXPRESSION_STATIC( lights::dirty    = true; ));
+            SP_SUBSCRIBE_TO_EVENT(EventType::MaterialOnChanged,       SP_EVENT_HANDLER_EXPRESSION_STATIC( materials::slots.on_changed(var); ));
+            SP_SUBSCRIBE_TO_EVENT(EventType::LightOnChanged,          SP_EVENT_HANDLER_EXPRESSION_STATIC( lights::slots.on_changed(var);    ));
 
             // fire
             SP_FIRE_EVENT(EventType::RendererOnInitialized);
@@ -374,10 +624,16 @@ namespace Spartan
         // releases their rhi resources before device destruction
         {
             DestroyResources();
+            RenderGraph::Shutdown();
             materials::clear();
+            TextureStreaming::Shutdown();
 
             m_entities_to_add.clear();
+            m_entities_changed.clear();
+            m_entities_removed.clear();
+            RenderableRegistry::Clear();
             m_renderables.clear();
+            entities_registered.clear();
             swap_chain            = nullptr;
             m_vertex_buffer_lines = nullptr;
         }
@@ -531,9 +787,7 @@ namespace Spartan
 
     void Renderer::UpdateConstantBufferFrame(RHI_CommandList* cmd_list, const bool set /*= true*/)
     {
-        // we are temporarily using the frame buffer to update the material index
-        // multiple times per frame, so do the update in this function only every
-        // frame, but do set the constant buffer
+        // only update once per frame, but do set the constant buffer
         bool is_new_frame = m_cb_frame_cpu.frame != frame_num;
 
         // update
@@ -613,23 +867,84 @@ namespace Spartan
         }
     }
 
+    void Renderer::UpdateDrawData()
+    {
+        // sort renderables by depth - front-to-back helps with the depth prep-pass, back-to-front with blending
+        // this happens first since the draw buffer follows the order of the lists
+        if (!m_sorted && m_camera)
+        {
+            Vector3 camera_position = m_camera->GetEntity()->GetPosition();
+            RenderableRegistry::Sort(Renderer_Entity::Geometry,            camera_position, false);
+            RenderableRegistry::Sort(Renderer_Entity::GeometryTransparent, camera_position, true);
+            m_sorted = true;
+        }
+
+        // give each list a range of the draw buffer
+        static array<RenderableList*, 4> lists;
+        uint32_t draw_count = 0;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(lists.size()); i++)
+        {
+            lists[i]              = &RenderableRegistry::GetList(static_cast<Renderer_Entity>(static_cast<uint32_t>(Renderer_Entity::Geometry) + i));
+            lists[i]->draw_offset = draw_count;
+            draw_count           += lists[i]->GetCount();
+        }
+        SP_ASSERT_MSG(draw_count <= draw_count_max, "Increase draw_count_max");
+
+        // write the draws of all the lists in one go
+        static vector<Sb_Draw> draws;
+        draws.resize(draw_count);
+        ThreadPool::ParallelFor([](uint32_t draw_start, uint32_t draw_end)
+        {
+            for (uint32_t draw_index = draw_start; draw_index < draw_end; draw_index++)
+            {
+                // the last list which starts at or before the draw, empty lists share the offset of the next one
+                uint32_t list_index = static_cast<uint32_t>(lists.size()) - 1;
+                while (lists[list_index]->draw_offset > draw_index)
+                {
+                    list_index--;
+                }
+
+                RenderableList& renderables = *lists[list_index];
+                uint32_t index              = draw_index - renderables.draw_offset;
+                Sb_Draw& draw               = draws[draw_index];
+                draw.transform              = renderables.transforms[index];
+                draw.transform_previous     = renderables.transforms_previous[index];
+                draw.material_index         = renderables.material_indices[index];
+                draw.flags                  = renderables.flags[index];
+
+                // for the velocity of the next frame
+                renderables.transforms_previous[index] = renderables.transforms[index];
+            }
+        }, draw_count);
+
+        // upload only the part which is used, the buffer is bound with the standard resources
+        if (draw_count != 0)
+        {
+            GetStructuredBuffer(Renderer_StructuredBuffer::Draws)->Update(draws.data(), draw_count * static_cast<uint32_t>(sizeof(Sb_Draw)));
+        }
+    }
+
     void Renderer::PushPassConstants(RHI_CommandList* cmd_list)
     {
         cmd_list->PushConstants(0, sizeof(Pcb_Pass), &m_pcb_pass_cpu);
     }
 
-    void Renderer::OnWorldResolved(sp_variant data)
+    void Renderer::OnWorldResolved(const sp_variant& data)
     {
         // note: m_renderables is a vector of shared pointers.
         // this ensures that if any entities are deallocated by the world.
         // we'll still have some valid pointers until the are overridden by m_renderables_world.
 
-        vector<shared_ptr<Entity>> entities = get<vector<shared_ptr<Entity>>>(data);
+        const vector<shared_ptr<Entity>>& entities = *get<const vector<shared_ptr<Entity>>*>(data);
 
         lock_guard lock(mutex_entity_addition);
         m_entities_to_add.clear();
 
-        for (shared_ptr<Entity> entity : entities)
+        // a full resolve supersedes any individual changes
+        m_entities_changed.clear();
+        m_entities_removed.clear();
+
+        for (const shared_ptr<Entity>& entity : entities)
         {
             SP_ASSERT_MSG(entity != nullptr, "Entity is null");
 
@@ -639,10 +954,106 @@ namespace Spartan
             }
         }
     }
+
+    void Renderer::OnWorldEntitiesChanged(const sp_variant& data)
+    {
+        const vector<shared_ptr<Entity>>& entities = *get<const vector<shared_ptr<Entity>>*>(data);
+
+        lock_guard lock(mutex_entity_addition);
+        m_entities_changed.insert(m_entities_changed.end(), entities.begin(), entities.end());
+    }
+
+    void Renderer::OnWorldEntitiesRemoved(const sp_variant& data)
+    {
+        const vector<shared_ptr<Entity>>& entities = *get<const vector<shared_ptr<Entity>>*>(data);
+
+        lock_guard lock(mutex_entity_addition);
+        m_entities_removed.insert(m_entities_removed.end(), entities.begin(), entities.end());
+    }
+
+    void Renderer::AddEntity(const shared_ptr<Entity>& entity)
+    {
+        if (shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>())
+        {
+            bool is_transparent = false;
+            bool is_visible     = true;
+
+            if (const Material* material = renderable->GetMaterial())
+            {
+                is_transparent = material->GetProperty(MaterialProperty::ColorA) < 1.0f;
+                is_visible     = material->GetProperty(MaterialProperty::ColorA) != 0.0f;
+            }
+
+            if (is_visible)
+            {
+                Renderer_Entity type = Renderer_Entity::Geometry;
+                if (is_transparent)
+                {
+                    type = renderable->HasInstancing() ? Renderer_Entity::GeometryTransparentInstanced : Renderer_Entity::GeometryTransparent;
+                }
+                else
+                {
+                    type = renderable->HasInstancing() ? Renderer_Entity::GeometryInstanced : Renderer_Entity::Geometry;
+                }
+
+                m_renderables[type].emplace_back(entity);
+                RenderableRegistry::Add(renderable.get(), type);
+            }
+        }
+
+        if (shared_ptr<Light> light = entity->GetComponent<Light>())
+        {
+            m_renderables[Renderer_Entity::Light].emplace_back(entity);
+        }
+
+        if (shared_ptr<Camera> camera = entity->GetComponent<Camera>())
+        {
+            m_renderables[Renderer_Entity::Camera].emplace_back(entity);
+            m_camera = camera;
+        }
+
+        if (shared_ptr<AudioSource> audio_source = entity->GetComponent<AudioSource>())
+        {
+            m_renderables[Renderer_Entity::AudioSource].emplace_back(entity);
+        }
+
+        entities_registered.insert(entity.get());
+    }
+
+    void Renderer::RemoveEntity(Entity* entity)
+    {
+        if (entities_registered.erase(entity) == 0)
+            return;
+
+        // if the renderable component was removed, it has already left the registry
+        if (shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>())
+        {
+            RenderableRegistry::Remove(renderable.get());
+        }
+
+        for (auto& [type, entities] : m_renderables)
+        {
+            auto it = find_if(entities.begin(), entities.end(), [entity](const shared_ptr<Entity>& entity_registered) { return entity_registered.get() == entity; });
+            if (it != entities.end())
+            {
+                swap(*it, entities.back());
+                entities.pop_back();
+            }
+        }
+
+        if (m_camera && m_camera->GetEntity() == entity)
+        {
+            m_camera = nullptr;
+        }
+    }
     
     void Renderer::OnClear()
     {
+        RenderableRegistry::Clear();
         m_renderables.clear();
+        entities_registered.clear();
+        materials::clear();
+        lights::clear();
     }
 
     void Renderer::OnFullScreenToggled()
@@ -677,60 +1088,59 @@ namespace Spartan
     void Renderer::OnSyncPoint(RHI_CommandList* cmd_list)
     {
         // acquire renderables - if any
-        if (!m_entities_to_add.empty())
         {
-            // clear previous state
-            m_renderables.clear();
-            m_camera = nullptr;
+            lock_guard lock(mutex_entity_addition);
+            bool changed = false;
 
-            for (shared_ptr<Entity> entity : m_entities_to_add)
+            // a full resolve, rebuild everything
+            if (!m_entities_to_add.empty())
             {
-                if (shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>())
+                // clear previous state
+                RenderableRegistry::Clear();
+                m_renderables.clear();
+                entities_registered.clear();
+                materials::clear();
+                lights::clear();
+                m_camera = nullptr;
+
+                for (const shared_ptr<Entity>& entity : m_entities_to_add)
                 {
-                    bool is_transparent = false;
-                    bool is_visible     = true;
-
-                    if (const Material* material = renderable->GetMaterial())
-                    {
-                        is_transparent = material->GetProperty(MaterialProperty::ColorA) < 1.0f;
-                        is_visible     = material->GetProperty(MaterialProperty::ColorA) != 0.0f;
-                    }
-
-                    if (is_visible)
-                    {
-                        if (is_transparent)
-                        {
-                            m_renderables[renderable->HasInstancing() ? Renderer_Entity::GeometryTransparentInstanced : Renderer_Entity::GeometryTransparent].emplace_back(entity);
-                        }
-                        else
-                        {
-                            m_renderables[renderable->HasInstancing() ? Renderer_Entity::GeometryInstanced : Renderer_Entity::Geometry].emplace_back(entity);
-                        }
-
-                    }
+                    AddEntity(entity);
                 }
 
-                if (shared_ptr<Light> light = entity->GetComponent<Light>())
-                {
-                    m_renderables[Renderer_Entity::Light].emplace_back(entity);
-                }
+                m_entities_to_add.clear();
+                changed = true;
+            }
 
-                if (shared_ptr<Camera> camera = entity->GetComponent<Camera>())
+            // individual changes, only the affected entities are touched
+            if (!m_entities_removed.empty() || !m_entities_changed.empty())
+            {
+                for (const shared_ptr<Entity>& entity : m_entities_removed)
                 {
-                    m_renderables[Renderer_Entity::Camera].emplace_back(entity);
-                    m_camera = camera;
+                    RemoveEntity(entity.get());
                 }
 
-                if (shared_ptr<AudioSource> audio_source = entity->GetComponent<AudioSource>())
+                for (const shared_ptr<Entity>& entity : m_entities_changed)
                 {
-                    m_renderables[Renderer_Entity::AudioSource].emplace_back(entity);
+                    RemoveEntity(entity.get());
+
+                    if (entity->IsActiveRecursively())
+                    {
+                        AddEntity(entity);
+                    }
                 }
+
+                m_entities_removed.clear();
+                m_entities_changed.clear();
+                changed = true;
             }
 
-            m_entities_to_add.clear();
-            m_sorted = false;
-            materials::dirty = true;
-            lights::dirty = true;
+            if (changed)
+            {
+                m_sorted                     = false;
+                materials::slots.dirty_users = true;
+                lights::slots.dirty_users    = true;
+            }
         }
 
         // generate mips - if any
@@ -772,28 +1182,65 @@ namespace Spartan
             }
         }
 
+        // texture streaming, before the bindless work, which picks up the textures that were streamed in
+        if (shared_ptr<Camera> camera = GetCamera())
+        {
+            TextureStreaming::Tick(camera.get(), GetResolutionRender(), GetOption<float>(Renderer_Option::TextureStreamingBudget));
+        }
+
+        // resource cache budgets, the gpu one follows the device budget, which changes with what other processes use
+        {
+            const uint64_t mb         = 1024 * 1024;
+            const uint64_t budget_cpu = static_cast<uint64_t>(GetOption<float>(Renderer_Option::ResourceCacheBudgetCpu)) * mb;
+            const uint64_t budget_gpu = static_cast<uint64_t>(static_cast<double>(RHI_Device::MemoryGetBudgetMb()) * GetOption<float>(Renderer_Option::ResourceCacheBudgetGpu)) * mb;
+            ResourceCache::SetMemoryBudget(budget_cpu, budget_gpu);
+        }
+
         // bindless work
         {
             // these two map to two arrays on the gpu
             // it should be ok to update them without syncing with the gpu
             
-            // materials
-            if (materials::dirty)
+            // materials, only the slots which changed are written
             {
-                materials::update(m_renderables);
-                GetStructuredBuffer(Renderer_StructuredBuffer::Materials)->ResetOffset();
-                GetStructuredBuffer(Renderer_StructuredBuffer::Materials)->Update(&materials::properties[0]);
-                RHI_Device::UpdateBindlessResources(nullptr, &materials::textures);
-                materials::dirty = false;
+                bool upload_all = materials::update(m_renderables);
+
+                RHI_StructuredBuffer* buffer = GetStructuredBuffer(Renderer_StructuredBuffer::Materials).get();
+                if (upload_all)
+                {
+                    buffer->ResetOffset();
+                    buffer->Update(&materials::properties[0]);
+                    RHI_Device::UpdateBindlessResources(nullptr, &materials::textures);
+                }
+                else
+                {
+                    for (uint32_t index : materials::slots.slots_dirty)
+                    {
+                        buffer->UpdateRange(&materials::properties[index], index * sizeof(Sb_Material), sizeof(Sb_Material));
+                        RHI_Device::UpdateBindlessResources(nullptr, &materials::textures, index, material_texture_count_support);
+                    }
+                }
+                materials::slots.slots_dirty.clear();
             }
 
             // lights
-            if (lights::dirty)
             {
-                lights::update(m_renderables[Renderer_Entity::Light], GetCamera().get());
-                GetStructuredBuffer(Renderer_StructuredBuffer::Lights)->ResetOffset();
-                GetStructuredBuffer(Renderer_StructuredBuffer::Lights)->Update(&lights::properties[0]);
-                lights::dirty = false;
+                bool upload_all = lights::update(m_renderables[Renderer_Entity::Light], GetCamera().get());
+
+                RHI_StructuredBuffer* buffer = GetStructuredBuffer(Renderer_StructuredBuffer::Lights).get();
+                if (upload_all)
+                {
+                    buffer->ResetOffset();
+                    buffer->Update(&lights::properties[0]);
+                }
+                else
+                {
+                    for (uint32_t index : lights::slots.slots_dirty)
+                    {
+                        buffer->UpdateRange(&lights::properties[index], index * sizeof(Sb_Light), sizeof(Sb_Light));
+                    }
+                }
+                lights::slots.slots_dirty.clear();
             }
         }
 
@@ -824,6 +1271,9 @@ namespace Spartan
                 }
             }
         }
+
+        // refresh the renderables which changed (transform, geometry, material)
+        RenderableRegistry::Update();
     }
 
     void Renderer::DrawString(const string& text, const Vector2& position_screen_percentage)
@@ -114,7 +114,7 @@ namespace Spartan
         // get all
         static std::array<std::shared_ptr<RHI_Texture>, static_cast<uint32_t>(Renderer_RenderTexture::max)>& GetRenderTargets();
         static std::array<std::shared_ptr<RHI_Shader>, static_cast<uint32_t>(Renderer_Shader::max)>& GetShaders();
-        static std::array<std::shared_ptr<RHI_StructuredBuffer>, 3>& GetStructuredBuffers();
+        static std::array<std::shared_ptr<RHI_StructuredBuffer>, 4>& GetStructuredBuffers();
 
         // get individual
         static std::shared_ptr<RHI_RasterizerState> GetRasterizerState(const Renderer_RasterizerState type);
@@ -134,6 +134,7 @@ namespace Spartan
     private:
         // constant and push constant buffers
         static void UpdateConstantBufferFrame(RHI_CommandList* cmd_list, const bool set = true);
+        static void UpdateDrawData();
         static void PushPassConstants(RHI_CommandList* cmd_list);
 
         // resource creation
@@ -154,6 +155,8 @@ namespace Spartan
         static void Pass_Frame(RHI_CommandList* cmd_list);
         static void Pass_ShadowMaps(RHI_CommandList* cmd_list, const bool is_transparent_pass = false);
         static void Pass_Visibility(RHI_CommandList* cmd_list);
+        static void Pass_Cull_Instances(RHI_CommandList* cmd_list);
+        static void Pass_Cull_Clusters(RHI_CommandList* cmd_list);
         static void Pass_Depth_Prepass(RHI_CommandList* cmd_list, const bool is_transparent_pass = false);
         static void Pass_GBuffer(RHI_CommandList* cmd_list, const bool is_transparent_pass = false);
         static void Pass_Ssgi(RHI_CommandList* cmd_list);
@@ -191,11 +194,17 @@ namespace Spartan
         static void Pass_Ffx_Fsr2(RHI_CommandList* cmd_list, RHI_Texture* tex_in, RHI_Texture* tex_out);
 
         // event handlers
-        static void OnWorldResolved(sp_variant data);
+        static void OnWorldResolved(const sp_variant& data);
+        static void OnWorldEntitiesChanged(const sp_variant& data);
+        static void OnWorldEntitiesRemoved(const sp_variant& data);
         static void OnClear();
         static void OnFullScreenToggled();
         static void OnSyncPoint(RHI_CommandList* cmd_list);
 
+        // entities
+        static void AddEntity(const std::shared_ptr<Entity>& entity);
+        static void RemoveEntity(Entity* entity);
+
         // misc
         static void AddLinesToBeRendered();
         static void SetGbufferTextures(RHI_CommandList* cmd_list);
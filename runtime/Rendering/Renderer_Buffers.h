@@ -26,6 +26,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Math/Vector3.h"
 #include "../Math/Matrix.h"
 #include "Color.h"
+#include <bit>
 //==========================
 
 namespace Spartan
@@ -63,7 +64,7 @@ namespace Spartan
         Math::Vector2 padding;
 
         Math::Vector3 camera_position_previous;
-        uint32_t material_index;
+        float padding2;
 
         void set_bit(const bool set, const uint32_t bit)
         {
@@ -94,7 +95,6 @@ namespace Spartan
                 resolution_render          == rhs.resolution_render          &&
                 taa_jitter_current         == rhs.taa_jitter_current         &&
                 taa_jitter_previous        == rhs.taa_jitter_previous        &&
-                material_index             == rhs.material_index             &&
                 options                    == rhs.options;
         }
 
@@ -107,11 +107,6 @@ namespace Spartan
         Math::Matrix transform = Math::Matrix::Identity;
         Math::Matrix m_value   = Math::Matrix::Identity;
 
-        void set_transform_previous(const Math::Matrix& transform_previous)
-        {
-            m_value = transform_previous;
-        }
-
         void set_resolution_in(const RHI_Texture* texture)
         {
             m_value.m03 = static_cast<float>(texture->GetWidth());
@@ -180,9 +175,10 @@ namespace Spartan
             m_value.m13 = w;
         };
 
-        void set_material_index(const uint32_t index)
+        // the element of the draw buffer which holds the transforms and the material of the renderable (read with asuint() in the shader)
+        void set_draw_index(const uint32_t index)
         {
-            m_value.m32 = static_cast<float>(index);
+            m_value.m32 = std::bit_cast<float>(index);
         }
 
         void set_is_transparent(const bool is_transparent)
@@ -190,6 +186,39 @@ namespace Spartan
             m_value.m33 = is_transparent ? 1.0f : 0.0f;
         }
 
+        // compute passes which don't need a transform can use it to pass integers (read with asuint() in the shader)
+        void set_u4_value(const uint32_t x, const uint32_t y, const uint32_t z, const uint32_t w)
+        {
+            transform.m00 = std::bit_cast<float>(x);
+            transform.m01 = std::bit_cast<float>(y);
+            transform.m02 = std::bit_cast<float>(z);
+            transform.m03 = std::bit_cast<float>(w);
+        }
+
+        void set_u4_value2(const uint32_t x, const uint32_t y, const uint32_t z, const uint32_t w)
+        {
+            transform.m10 = std::bit_cast<float>(x);
+            transform.m11 = std::bit_cast<float>(y);
+            transform.m12 = std::bit_cast<float>(z);
+            transform.m13 = std::bit_cast<float>(w);
+        }
+
+        void set_u4_value3(const uint32_t x, const uint32_t y, const uint32_t z, const uint32_t w)
+        {
+            transform.m20 = std::bit_cast<float>(x);
+            transform.m21 = std::bit_cast<float>(y);
+            transform.m22 = std::bit_cast<float>(z);
+            transform.m23 = std::bit_cast<float>(w);
+        }
+
+        void set_u4_value4(const uint32_t x, const uint32_t y, const uint32_t z, const uint32_t w)
+        {
+            transform.m30 = std::bit_cast<float>(x);
+            transform.m31 = std::bit_cast<float>(y);
+            transform.m32 = std::bit_cast<float>(z);
+            transform.m33 = std::bit_cast<float>(w);
+        }
+
         bool operator==(const Pcb_Pass& rhs) const
         {
             return transform == rhs.transform && m_value == rhs.m_value;
@@ -224,6 +253,17 @@ namespace Spartan
         float clearcoat_roughness;
     };
 
+    // per draw data, written once per frame for all the renderables, see Renderer::UpdateDrawData()
+    struct Sb_Draw
+    {
+        Math::Matrix transform;
+        Math::Matrix transform_previous;
+
+        uint32_t material_index;
+        uint32_t flags;
+        uint32_t padding[2];
+    };
+
     struct Sb_Light
     {
         Math::Matrix view_projection[6];
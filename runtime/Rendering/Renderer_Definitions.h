@@ -30,6 +30,7 @@ namespace Spartan
     #define debug_color Math::Vector4(0.41f, 0.86f, 1.0f, 1.0f)
     constexpr uint8_t resources_frame_lifetime = 5;
     constexpr uint8_t shader_count             = 54;
+    constexpr uint32_t draw_count_max          = 8192; // renderables, the draw buffer holds one element per renderable
 
     enum class Renderer_Option : uint32_t
     {
@@ -65,6 +66,10 @@ namespace Spartan
         Sharpness,
         Hdr,
         Vsync,
+        OcclusionCulling,
+        TextureStreamingBudget,
+        ResourceCacheBudgetCpu,
+        ResourceCacheBudgetGpu,
         Max
     };
 
@@ -152,14 +157,21 @@ namespace Spartan
 
     enum class Renderer_BindingsUav
     {
-        sb_materials      = 0,
-        sb_lights         = 1,
-        tex               = 2,
-        tex2              = 3,
-        tex3              = 4,
-        tex_sss           = 5,
-        sb_spd            = 6,
-        tex_spd           = 7,
+        sb_materials         = 0,
+        sb_lights            = 1,
+        tex                  = 2,
+        tex2                 = 3,
+        tex3                 = 4,
+        tex_sss              = 5,
+        sb_spd               = 6,
+        tex_spd              = 7, // an array of 12, so up to 18
+        sb_instances         = 19,
+        sb_instances_visible = 20,
+        sb_indirect_args     = 21,
+        sb_hi_z              = 22,
+        sb_draws             = 23,
+        sb_clusters          = 24,
+        sb_draw_count        = 25
     };
 
     enum class Renderer_Shader : uint8_t
@@ -219,6 +231,8 @@ namespace Spartan
         ffx_spd_average_c,
         ffx_spd_highest_c,
         ffx_spd_antiflicker_c,
+        instance_culling_c,
+        cluster_culling_c,
         max
     };
     
@@ -285,7 +299,9 @@ namespace Spartan
     {
         Spd,
         Materials,
-        Lights
+        Lights,
+        HiZ,
+        Draws
     };
 
     enum class Renderer_StandardTexture
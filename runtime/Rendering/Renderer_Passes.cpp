@@ -23,12 +23,18 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "pch.h"
 #include "Renderer.h"
 #include "bend_sss_cpu.h"
+#include "OcclusionBuffer.h"
+#include "RenderableRegistry.h"
+#include "RenderGraph.h"
 #include "../Display/Display.h"
 #include "../Profiling/Profiler.h"
+#include "../Core/ThreadPool.h"
 #include "../World/Entity.h"
 #include "../World/Components/Camera.h"
 #include "../World/Components/Light.h"
 #include "../RHI/RHI_CommandList.h"
+#include "../RHI/RHI_CommandPool.h"
+#include "../RHI/RHI_RasterizerState.h"
 #include "../RHI/RHI_VertexBuffer.h"
 #include "../RHI/RHI_Shader.h"
 #include "../RHI/RHI_FidelityFX.h"
@@ -47,26 +53,50 @@ namespace Spartan
         bool light_integration_brdf_speculat_lut_completed = false;
         mutex mutex_generate_mips;
         const float thread_group_count = 8.0f;
+        const uint32_t occluder_count_max = 64;
+        bool instance_culling_gpu = false; // set by Pass_Cull_Instances(), instanced renderables are then drawn indirectly (except for shadows)
+        bool cluster_culling_gpu  = false; // set by Pass_Cull_Clusters(), renderables with clusters are then drawn indirectly (except for shadows)
+        uint32_t hi_z_mip_count   = 0;     // set by Pass_Cull_Instances(), which uploads the hi-z buffer for both culling passes
+        // lods are picked by how large the bounding box is on the screen of the main camera, for every pass, so that the shadows match what's seen
+        const float lod_screen_size = 0.5f; // the fraction of the screen height below which the first simplified lod is used, each next one at half of that
+
+        uint32_t get_lod(Camera* camera, const BoundingBox& bounding_box, const uint32_t lod_count)
+        {
+            if (lod_count <= 1 || !camera)
+                return 0;
+
+            const float radius      = bounding_box.GetExtents().Length();
+            const float distance    = max(Vector3::Distance(camera->GetEntity()->GetPosition(), bounding_box.GetCenter()), 0.001f);
+            const float screen_size = radius * camera->GetProjectionMatrix().m11 / distance;
+            const float lod         = floor(log2(lod_screen_size / screen_size)) + 1.0f;
+
+            return static_cast<uint32_t>(clamp(lod, 0.0f, static_cast<float>(lod_count - 1)));
+        }
+
         #define thread_group_count_x(tex) static_cast<uint32_t>(Math::Helper::Ceil(static_cast<float>(tex->GetWidth())  / thread_group_count))
         #define thread_group_count_y(tex) static_cast<uint32_t>(Math::Helper::Ceil(static_cast<float>(tex->GetHeight()) / thread_group_count))
 
         // called by: Pass_ShadowMaps(), Pass_Depth_Prepass(), Pass_GBuffer()
-        void draw_renderable(RHI_CommandList* cmd_list, RHI_PipelineState& pso, Camera* camera, Renderable* renderable, Light* light = nullptr, uint32_t array_index = 0)
+        void draw_renderable(RHI_CommandList* cmd_list, RHI_PipelineState& pso, Camera* camera, const RenderableGeometry& geometry, Renderable* renderable, const uint32_t lod, Light* light = nullptr, uint32_t array_index = 0)
         {
             uint32_t instance_start_index = 0;
             bool draw_instanced           = pso.instancing && renderable->HasInstancing();
 
-            if (draw_instanced)
+            if (draw_instanced && instance_culling_gpu && !light)
+            {
+                // one draw per lod, the instance culling pass picked the lod of every instance
+                uint32_t args_offset = renderable->GetIndirectArgsIndex() * mesh_lod_count_max * static_cast<uint32_t>(sizeof(RHI_IndirectDrawArgsIndexed));
+                cmd_list->DrawIndexedIndirect(renderable->GetIndirectArgsBuffer(), args_offset, renderable->GetLodCount());
+            }
+            else if (draw_instanced)
             {
                 for (uint32_t group_index = 0; group_index < renderable->GetInstancePartitionCount(); group_index++)
                 {
                     uint32_t group_end_index = renderable->GetBoundingBoxGroupEndIndices()[group_index];
                     uint32_t instance_count  = group_end_index - instance_start_index;
 
-                    // skip instance groups outside of the view frustum
+                    // skip instance groups outside of the view frustum or occluded (as determined by Pass_Visibility())
                     {
-                        const BoundingBox& bounding_box_group = renderable->GetBoundingBox(BoundingBoxType::TransformedInstanceGroup, group_index);
-
                         if (light)
                         {
                             if (!light->IsInViewFrustum(renderable, array_index))
@@ -75,7 +105,7 @@ namespace Spartan
                                 continue;
                             }
                         }
-                        else if (!camera->IsInViewFrustum(bounding_box_group))
+                        else if (!renderable->IsInstanceGroupVisible(group_index))
                         {
                             instance_start_index = group_end_index;
                             continue;
@@ -88,10 +118,12 @@ namespace Spartan
 
                     if (instance_count > 0)
                     {
+                        uint32_t group_lod = get_lod(camera, renderable->GetBoundingBox(BoundingBoxType::TransformedInstanceGroup, group_index), renderable->GetLodCount());
+
                         cmd_list->DrawIndexed(
-                            renderable->GetIndexCount(),
-                            renderable->GetIndexOffset(),
-                            renderable->GetVertexOffset(),
+                            renderable->GetLodIndexCount(group_lod),
+                            renderable->GetLodIndexOffset(group_lod),
+                            geometry.vertex_offset,
                             instance_start_index,
                             instance_count
                         );
@@ -100,15 +132,106 @@ namespace Spartan
                     instance_start_index = group_end_index;
                 }
             }
+            else if (cluster_culling_gpu && !light && lod == 0 && renderable->GetClusterCount() != 0)
+            {
+                uint32_t cluster_count = renderable->GetClusterCount();
+                uint32_t args_offset   = renderable->GetClusterArgsIndex() * cluster_count * static_cast<uint32_t>(sizeof(RHI_IndirectDrawArgsIndexed));
+                uint32_t count_offset  = renderable->GetClusterArgsIndex() * static_cast<uint32_t>(sizeof(uint32_t));
+                cmd_list->DrawIndexedIndirectCount(renderable->GetClusterArgsBuffer(), args_offset, renderable->GetClusterDrawCountBuffer(), count_offset, cluster_count);
+            }
             else 
             {
                 cmd_list->DrawIndexed(
-                    renderable->GetIndexCount(),
-                    renderable->GetIndexOffset(),
-                    renderable->GetVertexOffset()
+                    geometry.index_count,
+                    geometry.index_offset,
+                    geometry.vertex_offset
                 );
             }
         }
+
+        // a draw which is prepared on the main thread and can be recorded by any thread
+        struct DrawCall
+        {
+            RenderableGeometry geometry;
+            Renderable* renderable = nullptr; // only dereferenced for instancing, lods and clusters
+            uint32_t lod           = 0;       // what the geometry is, instanced renderables pick theirs per instance group (or instance)
+            RHI_CullMode cull_mode = RHI_CullMode::Back;
+            Pcb_Pass pass_constants;
+            RHI_DynamicOffsets dynamic_offsets;
+        };
+
+        // called by: Pass_ShadowMaps(), Pass_Depth_Prepass(), Pass_GBuffer()
+        void set_lod(DrawCall& draw_call, Camera* camera, const BoundingBox& bounding_box)
+        {
+            Renderable* renderable = draw_call.renderable;
+            if (renderable->HasInstancing() || renderable->GetLodCount() <= 1)
+                return;
+
+            draw_call.lod                   = get_lod(camera, bounding_box, renderable->GetLodCount());
+            draw_call.geometry.index_offset = renderable->GetLodIndexOffset(draw_call.lod);
+            draw_call.geometry.index_count  = renderable->GetLodIndexCount(draw_call.lod);
+        }
+
+        // below this many draws per command list, the cost of recording is less than the cost of going wide
+        const uint32_t draw_calls_per_cmd_list_min = 64;
+
+        // called by: Pass_ShadowMaps(), Pass_Depth_Prepass(), Pass_GBuffer()
+        void draw_renderables(RHI_CommandPool* cmd_pool, RHI_CommandList* cmd_list, RHI_PipelineState& pso, const vector<DrawCall>& draw_calls, Camera* camera, Light* light = nullptr, uint32_t array_index = 0)
+        {
+            if (draw_calls.empty())
+                return;
+
+            // split the draw calls into contiguous batches, one secondary command list per batch
+            const uint32_t draw_call_count = static_cast<uint32_t>(draw_calls.size());
+            const uint32_t cmd_list_count  = Math::Helper::Clamp<uint32_t>(draw_call_count / draw_calls_per_cmd_list_min, 1, ThreadPool::GetThreadCount() + 1);
+
+            // acquire and begin on the main thread, they inherit the pipeline state of the primary
+            vector<RHI_CommandList*> cmd_lists_secondary(cmd_list_count);
+            for (uint32_t i = 0; i < cmd_list_count; i++)
+            {
+                cmd_lists_secondary[i] = cmd_pool->AcquireSecondaryCommandList();
+                cmd_lists_secondary[i]->BeginSecondary(cmd_list);
+            }
+
+            // record in parallel
+            ThreadPool::ParallelFor([&](uint32_t cmd_list_start, uint32_t cmd_list_end)
+            {
+                for (uint32_t cmd_list_index = cmd_list_start; cmd_list_index < cmd_list_end; cmd_list_index++)
+                {
+                    RHI_CommandList* cmd_list_secondary = cmd_lists_secondary[cmd_list_index];
+                    const uint32_t draw_call_start      = (cmd_list_index * draw_call_count) / cmd_list_count;
+                    const uint32_t draw_call_end        = ((cmd_list_index + 1) * draw_call_count) / cmd_list_count;
+
+                    for (uint32_t draw_call_index = draw_call_start; draw_call_index < draw_call_end; draw_call_index++)
+                    {
+                        const DrawCall& draw_call = draw_calls[draw_call_index];
+                        Renderable* renderable    = draw_call.renderable;
+
+                        cmd_list_secondary->SetCullMode(draw_call.cull_mode);
+
+                        // set vertex, index and instance buffers
+                        cmd_list_secondary->SetBufferVertex(draw_call.geometry.vertex_buffer);
+                        if (pso.instancing)
+                        {
+                            bool culled_on_gpu = instance_culling_gpu && !light;
+                            cmd_list_secondary->SetBufferVertex(culled_on_gpu ? renderable->GetInstanceBufferVisible() : renderable->GetInstanceBuffer(), 1);
+                        }
+                        cmd_list_secondary->SetBufferIndex(draw_call.geometry.index_buffer);
+
+                        // set resources
+                        cmd_list_secondary->SetDynamicOffsets(draw_call.dynamic_offsets);
+                        cmd_list_secondary->PushConstants(0, sizeof(Pcb_Pass), &draw_call.pass_constants);
+
+                        draw_renderable(cmd_list_secondary, pso, camera, draw_call.geometry, renderable, draw_call.lod, light, array_index);
+                    }
+
+                    cmd_list_secondary->End();
+                }
+            }, cmd_list_count);
+
+            // execute on the main thread
+            cmd_list->ExecuteSecondary(cmd_lists_secondary);
+        }
     }
 
     void Renderer::SetStandardResources(RHI_CommandList* cmd_list)
@@ -122,6 +245,7 @@ namespace Spartan
         cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_materials, GetStructuredBuffer(Renderer_StructuredBuffer::Materials));
         cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_lights,    GetStructuredBuffer(Renderer_StructuredBuffer::Lights));
         cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_spd,       GetStructuredBuffer(Renderer_StructuredBuffer::Spd));
+        cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_draws,     GetStructuredBuffer(Renderer_StructuredBuffer::Draws));
 
         // textures - todo: could at these two in the bindless array
         cmd_list->SetTexture(Renderer_BindingsSrv::noise_normal, GetStandardTexture(Renderer_StandardTexture::Noise_normal));
@@ -138,87 +262,236 @@ namespace Spartan
         RHI_Texture* rt_output   = GetRenderTarget(Renderer_RenderTexture::frame_output).get();
 
         UpdateConstantBufferFrame(cmd_list, false);
+        UpdateDrawData();
 
-        Pass_Skysphere(cmd_list);
+        // the passes declare the render targets they access, so that the render graph can cull them and have render targets share memory
+        // note: a pass which declares a write, but no read, of a render target has to write all of it that later passes read
+        // note: that includes the scratch render targets of the helpers a pass calls (Pass_Blur_Gaussian() and Pass_Antiflicker())
+        const initializer_list<Renderer_RenderTexture> gbuffer =
+        {
+            Renderer_RenderTexture::gbuffer_color,
+            Renderer_RenderTexture::gbuffer_normal,
+            Renderer_RenderTexture::gbuffer_material,
+            Renderer_RenderTexture::gbuffer_velocity,
+            Renderer_RenderTexture::gbuffer_depth,
+            Renderer_RenderTexture::gbuffer_depth_opaque
+        };
+
+        RenderGraph::AddPass("skysphere", [](RHI_CommandList* cmd_list) { Pass_Skysphere(cmd_list); })
+            .Write({ Renderer_RenderTexture::skysphere });
 
         // light integration
         {
             if (!light_integration_brdf_speculat_lut_completed)
             {
-                Pass_Light_Integration_BrdfSpecularLut(cmd_list);
+                RenderGraph::AddPass("light_integration_brdf_specular_lut", [](RHI_CommandList* cmd_list) { Pass_Light_Integration_BrdfSpecularLut(cmd_list); })
+                    .Write({ Renderer_RenderTexture::brdf_specular_lut });
             }
 
             if (m_environment_mips_to_filter_count > 0)
             {
-                Pass_Light_Integration_EnvironmentPrefilter(cmd_list);
+                RenderGraph::AddPass("light_integration_environment_filter", [](RHI_CommandList* cmd_list) { Pass_Light_Integration_EnvironmentPrefilter(cmd_list); })
+                    .Read(gbuffer) // bound by the blur of the last mips
+                    .Read({ Renderer_RenderTexture::skysphere })
+                    .Write({ Renderer_RenderTexture::skysphere, Renderer_RenderTexture::scratch_blur });
             }
         }
 
         if (shared_ptr<Camera> camera = GetCamera())
         { 
-            // determine if a transparent pass is required
-            const bool do_transparent_pass = !GetEntities()[Renderer_Entity::GeometryTransparent].empty();
-            
+            // determine which passes are required
+            const bool do_transparent_pass = RenderableRegistry::GetList(Renderer_Entity::GeometryTransparent).GetCount() != 0;
+            const bool do_ssgi             = GetOption<bool>(Renderer_Option::ScreenSpaceGlobalIllumination);
+            const bool do_ssr              = GetOption<bool>(Renderer_Option::ScreenSpaceReflections);
+            const bool do_light            = !m_renderables[Renderer_Entity::Light].empty();
+
             // shadow maps
+            RenderGraph::AddPass("shadow_maps", [do_transparent_pass](RHI_CommandList* cmd_list)
             {
                 Pass_ShadowMaps(cmd_list, false);
                 if (do_transparent_pass)
                 {
                     Pass_ShadowMaps(cmd_list, true);
                 }
-            }
- 
+            });
+
             // opaque
             {
-                Pass_Visibility(cmd_list);
-                Pass_Depth_Prepass(cmd_list);
-                Pass_GBuffer(cmd_list);
-                Pass_Ssgi(cmd_list);
-                Pass_Ssr(cmd_list, rt_render);
-                Pass_Sss_Bend(cmd_list);
-                Pass_Light(cmd_list);                        // compute diffuse and specular buffers
-                Pass_Light_Composition(cmd_list, rt_render); // compose diffuse, specular, ssgi, volumetric etc.
-                Pass_Light_ImageBased(cmd_list, rt_render);  // apply IBL and SSR
-            
-                cmd_list->Blit(rt_render, GetRenderTarget(Renderer_RenderTexture::frame_render_opaque).get(), false);
+                RenderGraph::AddPass("culling", [](RHI_CommandList* cmd_list)
+                {
+                    Pass_Visibility(cmd_list);
+                    Pass_Cull_Instances(cmd_list);
+                    Pass_Cull_Clusters(cmd_list);
+                });
+
+                RenderGraph::AddPass("depth_prepass", [](RHI_CommandList* cmd_list) { Pass_Depth_Prepass(cmd_list); })
+                    .Write({ Renderer_RenderTexture::gbuffer_depth, Renderer_RenderTexture::gbuffer_depth_opaque });
+
+                RenderGraph::AddPass("gbuffer", [](RHI_CommandList* cmd_list) { Pass_GBuffer(cmd_list); })
+                    .Read({ Renderer_RenderTexture::gbuffer_depth })
+                    .Write(gbuffer);
+
+                if (do_ssgi)
+                {
+                    RenderGraph::AddPass("ssgi", [](RHI_CommandList* cmd_list) { Pass_Ssgi(cmd_list); })
+                        .Read(gbuffer)
+                        .Read({ Renderer_RenderTexture::light_diffuse }) // the previous frame's
+                        .Write({ Renderer_RenderTexture::ssgi, Renderer_RenderTexture::scratch_antiflicker, Renderer_RenderTexture::scratch_blur });
+                }
+
+                if (do_ssr)
+                {
+                    RenderGraph::AddPass("ssr", [rt_render](RHI_CommandList* cmd_list) { Pass_Ssr(cmd_list, rt_render); })
+                        .Read(gbuffer)
+                        .Read({ Renderer_RenderTexture::frame_render })
+                        .Write({ Renderer_RenderTexture::ssr, Renderer_RenderTexture::ssr_roughness, Renderer_RenderTexture::scratch_antiflicker, Renderer_RenderTexture::scratch_blur });
+                }
+
+                RenderGraph::AddPass("sss_bend", [](RHI_CommandList* cmd_list) { Pass_Sss_Bend(cmd_list); })
+                    .Read({ Renderer_RenderTexture::gbuffer_depth })
+                    .Write({ Renderer_RenderTexture::sss });
+
+                // compute diffuse and specular buffers
+                if (do_light)
+                {
+                    RenderGraph::AddPass("light", [](RHI_CommandList* cmd_list) { Pass_Light(cmd_list); })
+                        .Read(gbuffer)
+                        .Read({ Renderer_RenderTexture::sss, Renderer_RenderTexture::ssgi })
+                        .Write({ Renderer_RenderTexture::light_diffuse, Renderer_RenderTexture::light_specular, Renderer_RenderTexture::light_volumetric });
+                }
+
+                // compose diffuse, specular, ssgi, volumetric etc.
+                RenderGraph::AddPass("light_composition", [rt_render](RHI_CommandList* cmd_list) { Pass_Light_Composition(cmd_list, rt_render); })
+                    .Read(gbuffer)
+                    .Read({ Renderer_RenderTexture::light_diffuse, Renderer_RenderTexture::light_specular, Renderer_RenderTexture::light_volumetric, Renderer_RenderTexture::ssgi, Renderer_RenderTexture::skysphere })
+                    .Read({ Renderer_RenderTexture::frame_render }) // transparent pixels are left as they are
+                    .Write({ Renderer_RenderTexture::frame_render });
+
+                // apply IBL and SSR
+                RenderGraph::AddPass("light_image_based", [rt_render](RHI_CommandList* cmd_list) { Pass_Light_ImageBased(cmd_list, rt_render); })
+                    .Read(gbuffer)
+                    .Read({ Renderer_RenderTexture::ssgi, Renderer_RenderTexture::ssr, Renderer_RenderTexture::sss, Renderer_RenderTexture::brdf_specular_lut, Renderer_RenderTexture::skysphere })
+                    .Read({ Renderer_RenderTexture::frame_render })
+                    .Write({ Renderer_RenderTexture::frame_render });
+
+                // only fsr 2 reads it, so the graph culls this without it
+                RenderGraph::AddPass("frame_render_opaque", [rt_render](RHI_CommandList* cmd_list)
+                {
+                    cmd_list->Blit(rt_render, GetRenderTarget(Renderer_RenderTexture::frame_render_opaque).get(), false);
+                })
+                    .Read({ Renderer_RenderTexture::frame_render })
+                    .Write({ Renderer_RenderTexture::frame_render_opaque });
             }
-            
+
             // transparent
             if (do_transparent_pass) // actual geometry processing
             {
-                // blit the frame so that refraction can sample from it
-                cmd_list->Copy(rt_render, rt_render_2, true);
-            
-                // generate frame mips so that the reflections can simulate roughness
-                Pass_Ffx_Spd(cmd_list, rt_render_2, Renderer_DownsampleFilter::Average);
-            
-                // blur the smaller mips to reduce blockiness/flickering
-                for (uint32_t i = 1; i < rt_render_2->GetMipCount(); i++)
+                RenderGraph::AddPass("refraction", [rt_render, rt_render_2](RHI_CommandList* cmd_list)
+                {
+                    // blit the frame so that refraction can sample from it
+                    cmd_list->Copy(rt_render, rt_render_2, true);
+
+                    // generate frame mips so that the reflections can simulate roughness
+                    Pass_Ffx_Spd(cmd_list, rt_render_2, Renderer_DownsampleFilter::Average);
+
+                    // blur the smaller mips to reduce blockiness/flickering
+                    for (uint32_t i = 1; i < rt_render_2->GetMipCount(); i++)
+                    {
+                        const float radius = 1.0f;
+                        Pass_Blur_Gaussian(cmd_list, rt_render_2, nullptr, Renderer_Shader::blur_gaussian_c, radius, i);
+                    }
+                })
+                    .Read(gbuffer)
+                    .Read({ Renderer_RenderTexture::frame_render })
+                    .Write({ Renderer_RenderTexture::frame_render_2, Renderer_RenderTexture::scratch_blur });
+
+                RenderGraph::AddPass("depth_prepass_transparent", [](RHI_CommandList* cmd_list) { Pass_Depth_Prepass(cmd_list, true); })
+                    .Write({ Renderer_RenderTexture::gbuffer_depth, Renderer_RenderTexture::gbuffer_depth_opaque });
+
+                RenderGraph::AddPass("gbuffer_transparent", [](RHI_CommandList* cmd_list) { Pass_GBuffer(cmd_list, true); })
+                    .Read({ Renderer_RenderTexture::gbuffer_depth })
+                    .Write(gbuffer);
+
+                if (do_ssr)
                 {
-                    const float radius = 1.0f;
-                    Pass_Blur_Gaussian(cmd_list, rt_render_2, nullptr, Renderer_Shader::blur_gaussian_c, radius, i);
+                    RenderGraph::AddPass("ssr_transparent", [rt_render](RHI_CommandList* cmd_list) { Pass_Ssr(cmd_list, rt_render, true); })
+                        .Read(gbuffer)
+                        .Read({ Renderer_RenderTexture::frame_render })
+                        .Write({ Renderer_RenderTexture::ssr, Renderer_RenderTexture::ssr_roughness, Renderer_RenderTexture::scratch_antiflicker, Renderer_RenderTexture::scratch_blur });
                 }
-            
-                Pass_Depth_Prepass(cmd_list, do_transparent_pass);
-                Pass_GBuffer(cmd_list, do_transparent_pass);
-                Pass_Ssr(cmd_list, rt_render, do_transparent_pass);
-                Pass_Light(cmd_list, do_transparent_pass);
-                Pass_Light_Composition(cmd_list, rt_render, do_transparent_pass);
-                Pass_Light_ImageBased(cmd_list, rt_render, do_transparent_pass);
+
+                if (do_light)
+                {
+                    RenderGraph::AddPass("light_transparent", [](RHI_CommandList* cmd_list) { Pass_Light(cmd_list, true); })
+                        .Read(gbuffer)
+                        .Read({ Renderer_RenderTexture::sss, Renderer_RenderTexture::ssgi })
+                        .Write({ Renderer_RenderTexture::light_diffuse_transparent, Renderer_RenderTexture::light_specular_transparent, Renderer_RenderTexture::light_volumetric });
+                }
+
+                RenderGraph::AddPass("light_composition_transparent", [rt_render](RHI_CommandList* cmd_list) { Pass_Light_Composition(cmd_list, rt_render, true); })
+                    .Read(gbuffer)
+                    .Read({ Renderer_RenderTexture::light_diffuse_transparent, Renderer_RenderTexture::light_specular_transparent, Renderer_RenderTexture::light_volumetric, Renderer_RenderTexture::ssgi, Renderer_RenderTexture::skysphere })
+                    .Read({ Renderer_RenderTexture::frame_render, Renderer_RenderTexture::frame_render_2 })
+                    .Write({ Renderer_RenderTexture::frame_render });
+
+                RenderGraph::AddPass("light_image_based_transparent", [rt_render](RHI_CommandList* cmd_list) { Pass_Light_ImageBased(cmd_list, rt_render, true); })
+                    .Read(gbuffer)
+                    .Read({ Renderer_RenderTexture::ssgi, Renderer_RenderTexture::ssr, Renderer_RenderTexture::sss, Renderer_RenderTexture::brdf_specular_lut, Renderer_RenderTexture::skysphere })
+                    .Read({ Renderer_RenderTexture::frame_render })
+                    .Write({ Renderer_RenderTexture::frame_render });
             }
 
-            Pass_PostProcess(cmd_list);
-            Pass_Grid(cmd_list, rt_output);
-            Pass_Lines(cmd_list, rt_output);
-            Pass_Outline(cmd_list, rt_output);
-            Pass_Icons(cmd_list, rt_output);
+            // post process, frame_render_2 and frame_output_2 are its ping-pong textures
+            {
+                RenderGraphPass& pass = RenderGraph::AddPass("post_process", [](RHI_CommandList* cmd_list) { Pass_PostProcess(cmd_list); })
+                    .Read(gbuffer)
+                    .Read({ Renderer_RenderTexture::frame_render })
+                    .Write({ Renderer_RenderTexture::frame_output, Renderer_RenderTexture::frame_output_2 });
+
+                if (GetOption<bool>(Renderer_Option::DepthOfField))
+                {
+                    pass.Write({ Renderer_RenderTexture::frame_render_2, Renderer_RenderTexture::dof_half, Renderer_RenderTexture::dof_half_2 });
+                }
+
+                if (GetOption<Renderer_Upsampling>(Renderer_Option::Upsampling) == Renderer_Upsampling::FSR2)
+                {
+                    pass.Read({ Renderer_RenderTexture::frame_render_opaque });
+                }
+
+                if (GetOption<bool>(Renderer_Option::Bloom))
+                {
+                    pass.Write({ Renderer_RenderTexture::bloom });
+                }
+            }
+
+            RenderGraph::AddPass("grid", [rt_output](RHI_CommandList* cmd_list) { Pass_Grid(cmd_list, rt_output); })
+                .Read({ Renderer_RenderTexture::gbuffer_depth, Renderer_RenderTexture::frame_output })
+                .Write({ Renderer_RenderTexture::frame_output });
+
+            RenderGraph::AddPass("lines", [rt_output](RHI_CommandList* cmd_list) { Pass_Lines(cmd_list, rt_output); })
+                .Read({ Renderer_RenderTexture::gbuffer_depth, Renderer_RenderTexture::frame_output })
+                .Write({ Renderer_RenderTexture::frame_output });
+
+            RenderGraph::AddPass("outline", [rt_output](RHI_CommandList* cmd_list) { Pass_Outline(cmd_list, rt_output); })
+                .Read(gbuffer) // bound by the blur
+                .Read({ Renderer_RenderTexture::frame_output })
+                .Write({ Renderer_RenderTexture::outline, Renderer_RenderTexture::scratch_blur, Renderer_RenderTexture::frame_output });
+
+            RenderGraph::AddPass("icons", [rt_output](RHI_CommandList* cmd_list) { Pass_Icons(cmd_list, rt_output); })
+                .Read({ Renderer_RenderTexture::frame_output })
+                .Write({ Renderer_RenderTexture::frame_output });
         }
         else
         {
-            GetCmdList()->ClearRenderTarget(rt_output, 0, 0, false, Color::standard_black);
+            RenderGraph::AddPass("clear", [rt_output](RHI_CommandList* cmd_list) { cmd_list->ClearRenderTarget(rt_output, 0, 0, false, Color::standard_black); })
+                .Write({ Renderer_RenderTexture::frame_output });
         }
 
-        Pass_Text(cmd_list, rt_output);
+        RenderGraph::AddPass("text", [rt_output](RHI_CommandList* cmd_list) { Pass_Text(cmd_list, rt_output); })
+            .Read({ Renderer_RenderTexture::frame_output })
+            .Write({ Renderer_RenderTexture::frame_output });
+
+        RenderGraph::Execute(cmd_list);
 
         // transition the render target to a readable state so it can be rendered
         // within the viewport or copied to the swap chain back buffer
@@ -244,9 +517,9 @@ namespace Spartan
         uint32_t end_index   = !is_transparent_pass ? 2 : 4;
         for (uint32_t i = start_index; i < end_index; i++)
         {
-            // acquire entities
-            auto& entities = m_renderables[static_cast<Renderer_Entity>(i)];
-            if (entities.empty())
+            // acquire renderables
+            const RenderableList& renderables = RenderableRegistry::GetList(static_cast<Renderer_Entity>(i));
+            if (renderables.GetCount() == 0)
                 continue;
 
             // go through all of the lights
@@ -303,51 +576,43 @@ namespace Spartan
                     // start pso
                     cmd_list->SetPipelineState(pso);
 
-                    // go through all of the entities
-                    for (shared_ptr<Entity>& entity : entities)
+                    // go through the renderables in the light's frustum, in the order of the list
+                    static vector<uint32_t> indices;
+                    indices.clear();
+                    light->QueryRenderables(array_index, [&renderables](Renderable* renderable, uint32_t /*group_index*/)
                     {
-                        // acquire renderable component
-                        shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
-                        if (!renderable || !renderable->ReadyToRender() || !renderable->IsFlagSet(RenderableFlags::CastsShadows))
-                            continue;
-
-                        // skip objects outside of the view frustum
-                        if (!light->IsInViewFrustum(renderable.get(), array_index))
-                            continue;
-
-                        // set vertex, index and instance buffers
+                        if (renderable->GetRegistryType() == renderables.type)
                         {
-                            cmd_list->SetBufferVertex(renderable->GetVertexBuffer());
-                            if (pso.instancing)
-                            {
-                                cmd_list->SetBufferVertex(renderable->GetInstanceBuffer(), 1);
-                            }
-
-                            cmd_list->SetBufferIndex(renderable->GetIndexBuffer());
+                            indices.emplace_back(renderable->GetRegistryIndex());
                         }
+                    });
+                    sort(indices.begin(), indices.end());
+                    indices.erase(unique(indices.begin(), indices.end()), indices.end()); // instance groups share an index
+
+                    static vector<DrawCall> draw_calls;
+                    draw_calls.clear();
+                    for (uint32_t index : indices)
+                    {
+                        if (!renderables.IsReady(index) || !(renderables.flags[index] & RenderableFlags::CastsShadows))
+                            continue;
 
                         // set pass constants
                         {
                             m_pcb_pass_cpu.set_f3_value2(static_cast<float>(array_index), static_cast<float>(light->GetIndex()), 0.0f);
-                            m_pcb_pass_cpu.transform = entity->GetMatrix();
-
-                            if (Material* material = renderable->GetMaterial())
-                            {
-                                m_pcb_pass_cpu.set_f3_value(
-                                    material->HasTexture(MaterialTexture::AlphaMask) ? 1.0f : 0.0f,
-                                    material->HasTexture(MaterialTexture::Color)     ? 1.0f : 0.0f,
-                                    material->GetProperty(MaterialProperty::ColorA)
-                                );
-
-                                m_cb_frame_cpu.material_index = material->GetIndex();
-                                UpdateConstantBufferFrame(cmd_list);
-                            }
-
-                            PushPassConstants(cmd_list);
+                            m_pcb_pass_cpu.set_draw_index(renderables.draw_offset + index);
+                            m_pcb_pass_cpu.set_f3_value(renderables.material_alpha[index]);
                         }
 
-                        draw_renderable(cmd_list, pso, GetCamera().get(), renderable.get(), light.get(), array_index);
+                        DrawCall& draw_call       = draw_calls.emplace_back();
+                        draw_call.geometry        = renderables.geometry[index];
+                        draw_call.renderable      = renderables.renderables[index];
+                        draw_call.cull_mode       = pso.rasterizer_state->GetCullMode();
+                        draw_call.pass_constants  = m_pcb_pass_cpu;
+                        draw_call.dynamic_offsets = cmd_list->GetDynamicOffsets();
+                        set_lod(draw_call, GetCamera().get(), renderables.bounding_boxes[index]);
                     }
+
+                    draw_renderables(m_cmd_pool, cmd_list, pso, draw_calls, GetCamera().get(), light.get(), array_index);
                 }
             }
         }
@@ -357,137 +622,280 @@ namespace Spartan
 
     void Renderer::Pass_Visibility(RHI_CommandList* cmd_list)
     {
-        // forest cpu time: 0.3 ms
+        bool gpu = false; // only measure cpu time
+        cmd_list->BeginTimeblock("visibility", gpu, gpu);
 
-        struct Occluder
+        Camera* camera          = GetCamera().get();
+        Vector3 camera_position = camera->GetEntity()->GetPosition();
+
+        // 1. cpu: frustum culling, the bounding volume hierarchy only visits the part of the world which is near the frustum
+        for (uint32_t i = static_cast<uint32_t>(Renderer_Entity::Geometry); i <= static_cast<uint32_t>(Renderer_Entity::GeometryTransparentInstanced); i++)
         {
-            shared_ptr<Entity> entity;
-            BoundingBox box;
-        };
+            RenderableList& renderables = RenderableRegistry::GetList(static_cast<Renderer_Entity>(i));
+            for (uint32_t index = 0; index < renderables.GetCount(); index++)
+            {
+                renderables.flags[index] &= ~(RenderableFlags::IsInViewFrustum | RenderableFlags::IsOccluded | RenderableFlags::IsOccluding);
 
-        bool gpu = false; // only measure cpu time
-        cmd_list->BeginTimeblock("visibility", gpu, gpu);
+                if (renderables.IsInstanced())
+                {
+                    Renderable* renderable = renderables.renderables[index];
+                    for (uint32_t group_index = 0; group_index < renderable->GetInstancePartitionCount(); group_index++)
+                    {
+                        renderable->SetInstanceGroupVisible(group_index, false);
+                    }
+                }
+            }
+        }
+
+        camera->QueryRenderables([](Renderable* renderable, uint32_t group_index)
+        {
+            RenderableList& renderables = RenderableRegistry::GetList(renderable->GetRegistryType());
+            const uint32_t index        = renderable->GetRegistryIndex();
+
+            // when async loading certain things can be null
+            if (!renderables.IsReady(index))
+                return;
+
+            renderables.flags[index] |= RenderableFlags::IsInViewFrustum;
+            if (group_index != RenderableRegistry::group_none)
+            {
+                renderable->SetInstanceGroupVisible(group_index, true);
+            }
+        });
 
-        // 1. cpu: sort entities by depth - helps with the depth prep-pass
-        if (!m_sorted)
+        // 2. cpu: pick the occluders, large opaque objects which are close to the camera, and rasterize them
+        bool occlusion_culling = GetOption<bool>(Renderer_Option::OcclusionCulling);
+        if (occlusion_culling)
         {
-            auto sort_renderables = [](Renderer_Entity entity_type, const bool are_transparent)
+            RenderableList& renderables = RenderableRegistry::GetList(Renderer_Entity::Geometry);
+
+            static vector<pair<float, uint32_t>> candidates;
+            candidates.clear();
+            for (uint32_t index = 0; index < renderables.GetCount(); index++)
             {
-                vector<shared_ptr<Entity>>& renderables = m_renderables[entity_type];
+                if (!(renderables.flags[index] & RenderableFlags::IsInViewFrustum))
+                    continue;
 
-                if (renderables.size() <= 2)
-                    return;
+                // the projected size is roughly proportional to this
+                const BoundingBox& box = renderables.bounding_boxes[index];
+                float distance         = max((box.GetCenter() - camera_position).Length(), camera->GetNearPlane());
+                candidates.emplace_back(box.GetExtents().Length() / distance, index);
+            }
 
-                Vector3 camera_position = GetCamera()->GetEntity()->GetPosition();
+            uint32_t occluder_count = min(occluder_count_max, static_cast<uint32_t>(candidates.size()));
+            partial_sort(candidates.begin(), candidates.begin() + occluder_count, candidates.end(), [](const pair<float, uint32_t>& a, const pair<float, uint32_t>& b)
+            {
+                return a.first > b.first;
+            });
 
-                auto squared_distance = [&camera_position](const shared_ptr<Entity>& entity)
+            // simplified geometry is cached by the renderable, so this is only expensive the first time
+            ThreadPool::ParallelFor([&renderables](uint32_t start, uint32_t end)
+            {
+                for (uint32_t i = start; i < end; i++)
                 {
-                    shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
-                    BoundingBoxType type = renderable->HasInstancing() ? BoundingBoxType::TransformedInstances : BoundingBoxType::Transformed;
-                    Vector3 position = renderable->GetBoundingBox(type).GetCenter();
+                    renderables.renderables[candidates[i].second]->GetOccluderGeometry();
+                }
+            }, occluder_count);
+
+            OcclusionBuffer::Begin(m_cb_frame_cpu.view_projection_unjittered);
+            for (uint32_t i = 0; i < occluder_count; i++)
+            {
+                uint32_t index                   = candidates[i].second;
+                const vector<Vector3>& triangles = renderables.renderables[index]->GetOccluderGeometry();
+                if (triangles.empty())
+                    continue;
 
-                    // calculate squared distance
-                    return (position - camera_position).LengthSquared();
-                };
+                OcclusionBuffer::AddOccluder(&triangles, renderables.transforms[index]);
+                renderables.flags[index] |= RenderableFlags::IsOccluding;
+            }
+            OcclusionBuffer::Rasterize();
+        }
 
-                sort(renderables.begin(), renderables.end(), [&squared_distance, &are_transparent](const shared_ptr<Entity>& a, const shared_ptr<Entity>& b)
+        // 3. cpu: test what's in the frustum against the hi-z buffer, instance groups are tested individually
+        for (uint32_t i = static_cast<uint32_t>(Renderer_Entity::Geometry); i <= static_cast<uint32_t>(Renderer_Entity::GeometryTransparentInstanced); i++)
+        {
+            RenderableList& renderables = RenderableRegistry::GetList(static_cast<Renderer_Entity>(i));
+            ThreadPool::ParallelFor([occlusion_culling, &renderables](uint32_t start, uint32_t end)
+            {
+                for (uint32_t index = start; index < end; index++)
                 {
-                    if (are_transparent)
+                    uint32_t& flags = renderables.flags[index];
+                    if (flags & RenderableFlags::IsInViewFrustum)
                     {
-                        // back-to-front for transparent
-                        return squared_distance(a) < squared_distance(b);
+                        if (renderables.IsInstanced())
+                        {
+                            Renderable* renderable = renderables.renderables[index];
+                            bool any_group_visible = false;
+                            for (uint32_t group_index = 0; group_index < renderable->GetInstancePartitionCount(); group_index++)
+                            {
+                                // the frustum part was written by the query
+                                bool visible = renderable->IsInstanceGroupVisible(group_index);
+                                if (visible && occlusion_culling)
+                                {
+                                    visible = OcclusionBuffer::IsVisible(renderable->GetBoundingBox(BoundingBoxType::TransformedInstanceGroup, group_index));
+                                    renderable->SetInstanceGroupVisible(group_index, visible);
+                                }
+
+                                any_group_visible |= visible;
+                            }
+
+                            if (occlusion_culling && !any_group_visible)
+                            {
+                                flags |= RenderableFlags::IsOccluded;
+                            }
+                        }
+                        else if (occlusion_culling && !(flags & RenderableFlags::IsOccluding) && !OcclusionBuffer::IsVisible(renderables.bounding_boxes[index]))
+                        {
+                            flags |= RenderableFlags::IsOccluded;
+                        }
                     }
-                    else
+
+                    // mirror the result on the renderable, for the editor and the debug primitives
+                    if (Renderable* renderable = renderables.renderables[index])
                     {
-                        // front-to-back for opaque
-                        return squared_distance(a) > squared_distance(b);
+                        renderable->SetFlag(RenderableFlags::IsInViewFrustum, flags & RenderableFlags::IsInViewFrustum);
+                        renderable->SetFlag(RenderableFlags::IsOccluded,      flags & RenderableFlags::IsOccluded);
+                        renderable->SetFlag(RenderableFlags::IsOccluding,     flags & RenderableFlags::IsOccluding);
                     }
-                });
-            };
-
-            sort_renderables(Renderer_Entity::Geometry, false);
-            sort_renderables(Renderer_Entity::GeometryTransparent, true);
-            m_sorted = true;
+                }
+            }, renderables.GetCount());
         }
 
-        // 2. cpu: identify potential occluders - only deal with objects which are reasonably large
-        array<Occluder, 1024> occluders;
-        bool is_transparent_pass = false;
-        uint32_t start_index     = !is_transparent_pass ? 0 : 2;
-        uint32_t end_index       = !is_transparent_pass ? 2 : 4;
-        for (uint32_t i = start_index; i < end_index; i++)
+        cmd_list->EndTimeblock();
+    }
+
+    void Renderer::Pass_Cull_Instances(RHI_CommandList* cmd_list)
+    {
+        // upload the hi-z buffer which Pass_Visibility() rasterized, padded to the (aligned) stride of the structured buffer
+        RHI_StructuredBuffer* hi_z = GetStructuredBuffer(Renderer_StructuredBuffer::HiZ).get();
+        hi_z_mip_count             = 0;
+        if (GetOption<bool>(Renderer_Option::OcclusionCulling) && OcclusionBuffer::GetTriangleCount() != 0)
         {
-            auto& entities = m_renderables[static_cast<Renderer_Entity>(i)];
-            if (entities.empty())
-                continue;
+            static vector<float> hi_z_data;
+            const vector<float>& hi_z_cpu = OcclusionBuffer::GetHiZ();
+            hi_z_data.resize(hi_z->GetStride() / sizeof(float));
+            copy(hi_z_cpu.begin(), hi_z_cpu.end(), hi_z_data.begin());
+            hi_z->Update(hi_z_data.data());
+
+            hi_z_mip_count = OcclusionBuffer::GetMipCount();
+        }
+
+        // acquire shaders
+        RHI_Shader* shader_c = GetShader(Renderer_Shader::instance_culling_c).get();
+        instance_culling_gpu = shader_c->IsCompiled();
+        if (!instance_culling_gpu)
+            return;
+
+        cmd_list->BeginTimeblock("instance_culling");
 
-            for (uint32_t index_entity = 0; index_entity < entities.size(); index_entity++)
+        // define pipeline state
+        static RHI_PipelineState pso;
+        pso.name           = "instance_culling";
+        pso.shader_compute = shader_c;
+
+        // set pipeline state
+        cmd_list->SetPipelineState(pso);
+        cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_hi_z, hi_z);
+
+        // the buffers which are about to be written, could still be read by the draws of the previous frame
+        cmd_list->InsertMemoryBarrierWaitForCompute();
+
+        for (Renderer_Entity entity_type : { Renderer_Entity::GeometryInstanced, Renderer_Entity::GeometryTransparentInstanced })
+        {
+            const RenderableList& renderables = RenderableRegistry::GetList(entity_type);
+            for (uint32_t index = 0; index < renderables.GetCount(); index++)
             {
-                shared_ptr<Entity>& entity = entities[index_entity];
-                shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
-                if (!renderable || !renderable->ReadyToRender())
+                Renderable* renderable = renderables.renderables[index];
+                if (!renderables.IsReady(index) || !renderables.IsVisible(index) || !renderable->HasInstancing())
                     continue;
 
-                // get appropriate bounding box
-                BoundingBoxType type = renderable->HasInstancing() ? BoundingBoxType::TransformedInstances : BoundingBoxType::Transformed;
-                BoundingBox box      = renderable->GetBoundingBox(type).Transform(m_cb_frame_cpu.view);
+                // the set of draw arguments which the draws of this frame will use
+                renderable->SwapIndirectArgs();
 
-                // larger than one cubic meter
-                if (box.Volume() >= 1.0f)
-                {
-                    occluders[index_entity] = Occluder(entity, box);
-                    entity->GetComponent<Renderable>()->SetFlag(RenderableFlags::IsOccluded,  false);
-                    entity->GetComponent<Renderable>()->SetFlag(RenderableFlags::IsOccluding, false);
-                }
+                // set pass constants
+                BoundingBox bounding_box = renderable->GetBoundingBox(BoundingBoxType::Untransformed).Transform(renderables.transforms[index]);
+                m_pcb_pass_cpu.set_f3_value(bounding_box.GetCenter());
+                m_pcb_pass_cpu.set_f3_value2(bounding_box.GetExtents());
+                m_pcb_pass_cpu.set_u4_value(renderable->GetInstanceCount(), renderable->GetVertexOffset(), renderable->GetLodCount(), 0);
+                m_pcb_pass_cpu.set_u4_value2(renderable->GetIndirectArgsIndex(), hi_z_mip_count, OcclusionBuffer::GetWidth(), OcclusionBuffer::GetHeight());
+                m_pcb_pass_cpu.set_u4_value3(renderable->GetLodIndexOffset(0), renderable->GetLodIndexOffset(1), renderable->GetLodIndexOffset(2), renderable->GetLodIndexOffset(3));
+                m_pcb_pass_cpu.set_u4_value4(renderable->GetLodIndexCount(0),  renderable->GetLodIndexCount(1),  renderable->GetLodIndexCount(2),  renderable->GetLodIndexCount(3));
+                m_pcb_pass_cpu.set_f4_value(lod_screen_size, 0.0f, 0.0f, 0.0f);
+                PushPassConstants(cmd_list);
+
+                // set structured buffers
+                cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_instances,         renderable->GetInstanceBuffer());
+                cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_instances_visible, renderable->GetInstanceBufferVisible());
+                cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_indirect_args,     renderable->GetIndirectArgsBuffer());
+
+                // render, one thread per instance
+                cmd_list->Dispatch((renderable->GetInstanceCount() + 63) / 64, 1);
             }
         }
 
-        // 3. cpu: do fast approximate visibility tests
-        for (uint32_t i = start_index; i < end_index; i++)
-        {
-            auto& entities = m_renderables[static_cast<Renderer_Entity>(i)];
-            if (entities.empty())
-                continue;
+        // make the visible instances and the draw arguments available to the geometry passes
+        cmd_list->InsertMemoryBarrierWaitForCompute();
+
+        cmd_list->EndTimeblock();
+    }
+
+    void Renderer::Pass_Cull_Clusters(RHI_CommandList* cmd_list)
+    {
+        // acquire shaders
+        RHI_Shader* shader_c = GetShader(Renderer_Shader::cluster_culling_c).get();
+        cluster_culling_gpu  = shader_c->IsCompiled();
+        if (!cluster_culling_gpu)
+            return;
+
+        cmd_list->BeginTimeblock("cluster_culling");
+
+        // define pipeline state
+        static RHI_PipelineState pso;
+        pso.name           = "cluster_culling";
+        pso.shader_compute = shader_c;
 
-            for (shared_ptr<Entity>& entity : entities)
+        // set pipeline state
+        cmd_list->SetPipelineState(pso);
+        cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_hi_z, GetStructuredBuffer(Renderer_StructuredBuffer::HiZ));
+
+        // the buffers which are about to be written, could still be read by the draws of the previous frame
+        cmd_list->InsertMemoryBarrierWaitForCompute();
+
+        for (Renderer_Entity entity_type : { Renderer_Entity::Geometry, Renderer_Entity::GeometryTransparent })
+        {
+            const RenderableList& renderables = RenderableRegistry::GetList(entity_type);
+            for (uint32_t index = 0; index < renderables.GetCount(); index++)
             {
-                // when async loading certain things can be null
-                shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
-                if (!renderable || !renderable->ReadyToRender())
+                Renderable* renderable = renderables.renderables[index];
+                if (!renderables.IsReady(index) || !renderables.IsVisible(index) || renderable->GetClusterCount() == 0)
                     continue;
 
-                // frustum check
-                renderable->SetFlag(RenderableFlags::IsInViewFrustum, GetCamera()->IsInViewFrustum(renderable));
-                
-                // fast approximate occlusion check
-                if (renderable->IsFlagSet(RenderableFlags::IsInViewFrustum))
-                {
-                    BoundingBoxType type = renderable->HasInstancing() ? BoundingBoxType::TransformedInstances : BoundingBoxType::Transformed;
-                    BoundingBox box      = renderable->GetBoundingBox(type).Transform(m_cb_frame_cpu.view);
-    
-                    bool occluded = false;
-                    for (const Occluder& occluder : occluders)
-                    {
-                        if (!occluder.entity)
-                            continue;
+                // the clusters are those of the full detail geometry, simplified lods are drawn directly
+                if (get_lod(GetCamera().get(), renderables.bounding_boxes[index], renderable->GetLodCount()) != 0)
+                    continue;
 
-                        // ignore self
-                        if (occluder.entity->GetObjectId() == entity->GetObjectId())
-                            continue;
+                // the set of draw arguments which the draws of this frame will use
+                renderable->SwapClusterArgs();
 
-                        if (box.IsBehind(occluder.box))
-                        {
-                            //renderable->SetFlag(RenderableFlags::IsOccluded);
-                            //occluder.entity->GetComponent<Renderable>()->SetFlag(RenderableFlags::IsOccluding, true);
-                            break;
-                        }
-                    }
-                }
+                // set pass constants, the transform comes from the draw buffer
+                bool cull_back_faces = renderables.cull_modes[index] == RHI_CullMode::Back;
+                m_pcb_pass_cpu.set_draw_index(renderables.draw_offset + index);
+                m_pcb_pass_cpu.set_u4_value(renderable->GetClusterOffset(), renderable->GetClusterCount(), renderable->GetVertexOffset(), renderable->GetClusterArgsIndex());
+                m_pcb_pass_cpu.set_u4_value2(hi_z_mip_count, OcclusionBuffer::GetWidth(), OcclusionBuffer::GetHeight(), cull_back_faces ? 1 : 0);
+                PushPassConstants(cmd_list);
+
+                // set structured buffers
+                cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_clusters,      renderable->GetClusterBuffer());
+                cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_indirect_args, renderable->GetClusterArgsBuffer());
+                cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_draw_count,    renderable->GetClusterDrawCountBuffer());
+
+                // render, one thread per cluster
+                cmd_list->Dispatch((renderable->GetClusterCount() + 63) / 64, 1);
             }
         }
 
-        // 4. gpu: hardware occlusion queries on what's left
-        // this will yield pixel perfect results
+        // make the draw arguments and their counts available to the geometry passes
+        cmd_list->InsertMemoryBarrierWaitForCompute();
 
         cmd_list->EndTimeblock();
     }
@@ -508,9 +916,9 @@ namespace Spartan
         bool is_first_pass   = true;
         for (uint32_t i = start_index; i < end_index; i++)
         {
-            // acquire entities
-            auto& entities = m_renderables[static_cast<Renderer_Entity>(i)];
-            if (entities.empty())
+            // acquire renderables
+            RenderableList& renderables = RenderableRegistry::GetList(static_cast<Renderer_Entity>(i));
+            if (renderables.GetCount() == 0)
                 continue;
 
             // define pipeline state
@@ -526,51 +934,31 @@ namespace Spartan
             pso.clear_depth                 = (is_transparent_pass || pso.instancing) ? rhi_depth_load : 0.0f; // reverse-z
             cmd_list->SetPipelineState(pso);
 
-            for (shared_ptr<Entity>& entity : entities)
+            static vector<DrawCall> draw_calls;
+            draw_calls.clear();
+            for (uint32_t index = 0; index < renderables.GetCount(); index++)
             {
                 // when async loading certain things can be null
-                shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
-                if (!renderable || !renderable->ReadyToRender() || !renderable->IsVisible())
+                if (!renderables.IsReady(index) || !renderables.IsVisible(index))
                     continue;
 
-                // set cull mode
-                cmd_list->SetCullMode(static_cast<RHI_CullMode>(renderable->GetMaterial()->GetProperty(MaterialProperty::CullMode)));
-
-                // set vertex, index and instance buffers
-                {
-                    cmd_list->SetBufferVertex(renderable->GetVertexBuffer());
-                    if (pso.instancing)
-                    {
-                        cmd_list->SetBufferVertex(renderable->GetInstanceBuffer(), 1);
-                    }
-
-                    cmd_list->SetBufferIndex(renderable->GetIndexBuffer());
-                }
-
                 // set pass constants
                 {
-                    if (Material* material = renderable->GetMaterial())
-                    {
-                        m_pcb_pass_cpu.set_f3_value(
-                            material->HasTexture(MaterialTexture::AlphaMask) ? 1.0f : 0.0f,
-                            material->HasTexture(MaterialTexture::Color)     ? 1.0f : 0.0f,
-                            material->GetProperty(MaterialProperty::ColorA)
-                        );
-
-
-                        m_cb_frame_cpu.material_index = material->GetIndex();
-                        UpdateConstantBufferFrame(cmd_list);
-
-                        // the material is used for alpha testing and it's
-                        // okay for a renderable to not have a material
-                    }
-
-                    m_pcb_pass_cpu.transform = entity->GetMatrix();
-                    PushPassConstants(cmd_list);
+                    // the material is used for alpha testing
+                    m_pcb_pass_cpu.set_f3_value(renderables.material_alpha[index]);
+                    m_pcb_pass_cpu.set_draw_index(renderables.draw_offset + index);
                 }
 
-                draw_renderable(cmd_list, pso, GetCamera().get(), renderable.get());
+                DrawCall& draw_call       = draw_calls.emplace_back();
+                draw_call.geometry        = renderables.geometry[index];
+                draw_call.renderable      = renderables.renderables[index];
+                draw_call.cull_mode       = renderables.cull_modes[index];
+                draw_call.pass_constants  = m_pcb_pass_cpu;
+                draw_call.dynamic_offsets = cmd_list->GetDynamicOffsets();
+                set_lod(draw_call, GetCamera().get(), renderables.bounding_boxes[index]);
             }
+
+            draw_renderables(m_cmd_pool, cmd_list, pso, draw_calls, GetCamera().get());
         }
 
         if (!is_transparent_pass)
@@ -612,9 +1000,9 @@ namespace Spartan
         bool is_first_pass   = true;
         for (uint32_t i = start_index; i < end_index; i++)
         {
-            // acquire entities
-            auto& entities = m_renderables[static_cast<Renderer_Entity>(i)];
-            if (entities.empty())
+            // acquire renderables
+            RenderableList& renderables = RenderableRegistry::GetList(static_cast<Renderer_Entity>(i));
+            if (renderables.GetCount() == 0)
                 continue;
 
             // note: if is_transparent_pass is true we could simply clear the RTs, however we don't do this as fsr
@@ -641,41 +1029,33 @@ namespace Spartan
             pso.clear_depth                     = rhi_depth_load;
             cmd_list->SetPipelineState(pso);
 
-            for (shared_ptr<Entity>& entity : entities)
+            static vector<DrawCall> draw_calls;
+            draw_calls.clear();
+            for (uint32_t index = 0; index < renderables.GetCount(); index++)
             {
                 // when async loading certain things can be null (also frustum cull)
-                shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
-                if (!renderable || !renderable->ReadyToRender() || !renderable->IsVisible())
+                if (!renderables.IsReady(index) || !renderables.IsVisible(index))
                     continue;
 
-                // set cull mode
-                cmd_list->SetCullMode(static_cast<RHI_CullMode>(renderable->GetMaterial()->GetProperty(MaterialProperty::CullMode)));
-
-                // set vertex, index and instance buffers
-                {
-                    cmd_list->SetBufferVertex(renderable->GetVertexBuffer());
-                    if (pso.instancing)
-                    {
-                        cmd_list->SetBufferVertex(renderable->GetInstanceBuffer(), 1);
-                    }
-
-                    cmd_list->SetBufferIndex(renderable->GetIndexBuffer());
-                }
-
                 // set pass constants
                 {
-                    m_pcb_pass_cpu.transform = entity->GetMatrix();
-                    m_pcb_pass_cpu.set_transform_previous(entity->GetMatrixPrevious());
+                    m_pcb_pass_cpu.set_draw_index(renderables.draw_offset + index);
                     m_pcb_pass_cpu.set_is_transparent(is_transparent_pass);
-                    PushPassConstants(cmd_list);
-                    entity->SetMatrixPrevious(m_pcb_pass_cpu.transform);
-
-                    m_cb_frame_cpu.material_index = renderable->GetMaterial()->GetIndex();
-                    UpdateConstantBufferFrame(cmd_list);
                 }
 
-                draw_renderable(cmd_list, pso, GetCamera().get(), renderable.get());
+                DrawCall& draw_call       = draw_calls.emplace_back();
+                draw_call.geometry        = renderables.geometry[index];
+                draw_call.renderable      = renderables.renderables[index];
+                draw_call.cull_mode       = renderables.cull_modes[index];
+                draw_call.pass_constants  = m_pcb_pass_cpu;
+                draw_call.dynamic_offsets = cmd_list->GetDynamicOffsets();
+                set_lod(draw_call, GetCamera().get(), renderables.bounding_boxes[index]);
+            }
+
+            draw_renderables(m_cmd_pool, cmd_list, pso, draw_calls, GetCamera().get());
 
+            if (!draw_calls.empty())
+            {
                 is_first_pass = false;
             }
         }
@@ -1029,7 +1409,7 @@ namespace Spartan
         cmd_list->SetTexture(Renderer_BindingsSrv::light_diffuse,    is_transparent_pass ? GetRenderTarget(Renderer_RenderTexture::light_diffuse_transparent).get()  : GetRenderTarget(Renderer_RenderTexture::light_diffuse).get());
         cmd_list->SetTexture(Renderer_BindingsSrv::light_specular,   is_transparent_pass ? GetRenderTarget(Renderer_RenderTexture::light_specular_transparent).get() : GetRenderTarget(Renderer_RenderTexture::light_specular).get());
         cmd_list->SetTexture(Renderer_BindingsSrv::light_volumetric, GetRenderTarget(Renderer_RenderTexture::light_volumetric));
-        cmd_list->SetTexture(Renderer_BindingsSrv::frame,            GetRenderTarget(Renderer_RenderTexture::frame_render_2)); // refraction
+        cmd_list->SetTexture(Renderer_BindingsSrv::frame,            is_transparent_pass ? GetRenderTarget(Renderer_RenderTexture::frame_render_2).get() : nullptr); // refraction, only the transparent pass samples it
         cmd_list->SetTexture(Renderer_BindingsSrv::ssgi,             GetRenderTarget(Renderer_RenderTexture::ssgi));
         cmd_list->SetTexture(Renderer_BindingsSrv::environment,      GetRenderTarget(Renderer_RenderTexture::skysphere));
 
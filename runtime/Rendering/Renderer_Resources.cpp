@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Window.h"
 #include "Renderer.h"
 #include "Geometry.h"
+#include "OcclusionBuffer.h"
 #include "ThreadPool.h"
 #include "../World/Components/Light.h"
 #include "../Resource/ResourceCache.h"
@@ -61,7 +62,7 @@ namespace Spartan
         array<shared_ptr<RHI_Shader>, static_cast<uint32_t>(Renderer_Shader::max)>         shaders;
         array<shared_ptr<RHI_Sampler>, static_cast<uint32_t>(Renderer_Sampler::Max)>       samplers;
         shared_ptr<RHI_ConstantBuffer>                                                     constant_buffer_frame;
-        array<shared_ptr<RHI_StructuredBuffer>, 3>                                         structured_buffers;
+        array<shared_ptr<RHI_StructuredBuffer>, 4>                                         structured_buffers;
 
         // asset resources
         array<shared_ptr<RHI_Texture>, 10>                standard_textures;
@@ -72,9 +73,7 @@ namespace Spartan
 
     void Renderer::CreateConstantBuffers()
     {
-        // todo: the material index has to be removed from the frame buffer so that it only needs one update per frame
-
-        uint32_t times_used_in_frame = 4096;
+        uint32_t times_used_in_frame = 1; // per draw data lives in the draw buffer
         uint32_t element_count       = times_used_in_frame * resources_frame_lifetime;
 
         constant_buffer_frame = make_shared<RHI_ConstantBuffer>(string("frame"));
@@ -102,6 +101,15 @@ namespace Spartan
 
         stride = static_cast<uint32_t>(sizeof(Sb_Light)) * rhi_max_array_size;
         structured_buffer(Renderer_StructuredBuffer::Lights) = make_shared<RHI_StructuredBuffer>(stride, element_count, "lights");
+
+        // the cpu rasterized hi-z buffer, uploaded once per frame for gpu instance culling
+        stride        = static_cast<uint32_t>(sizeof(float) * OcclusionBuffer::GetHiZ().size());
+        element_count = resources_frame_lifetime;
+        structured_buffer(Renderer_StructuredBuffer::HiZ) = make_shared<RHI_StructuredBuffer>(stride, element_count, "hi_z");
+
+        // the transforms and materials of all the renderables, uploaded once per frame and indexed by the draws
+        stride = static_cast<uint32_t>(sizeof(Sb_Draw)) * draw_count_max;
+        structured_buffer(Renderer_StructuredBuffer::Draws) = make_shared<RHI_StructuredBuffer>(stride, element_count, "draws");
     }
 
     void Renderer::CreateDepthStencilStates()
@@ -198,6 +206,7 @@ namespace Spartan
 
         // notes:
         // - gbuffer_normal: any format with or below 8 bits per channel, will produce banding
+        // - RHI_Texture_Transient: the content doesn't outlive the frame, so the render graph can have it share memory with others
         #define render_target(x) render_targets[static_cast<uint8_t>(x)]
 
         // typical usage flags
@@ -212,9 +221,9 @@ namespace Spartan
                 uint32_t frame_render_flags    = flags_render_target | RHI_Texture_ClearBlit;
                 RHI_Format frame_render_format = RHI_Format::R16G16B16A16_Float;
 
-                render_target(Renderer_RenderTexture::frame_render)        = make_unique<RHI_Texture2D>(width_render, height_render, mip_count, frame_render_format, frame_render_flags | RHI_Texture_PerMipViews, "rt_frame_render");
-                render_target(Renderer_RenderTexture::frame_render_2)      = make_unique<RHI_Texture2D>(width_render, height_render, mip_count, frame_render_format, frame_render_flags | RHI_Texture_PerMipViews, "rt_frame_render_2");
-                render_target(Renderer_RenderTexture::frame_render_opaque) = make_unique<RHI_Texture2D>(width_render, height_render, 1,         frame_render_format, frame_render_flags,                           "rt_frame_render_opaque");
+                render_target(Renderer_RenderTexture::frame_render)        = make_unique<RHI_Texture2D>(width_render, height_render, mip_count, frame_render_format, frame_render_flags | RHI_Texture_PerMipViews,                         "rt_frame_render");
+                render_target(Renderer_RenderTexture::frame_render_2)      = make_unique<RHI_Texture2D>(width_render, height_render, mip_count, frame_render_format, frame_render_flags | RHI_Texture_PerMipViews | RHI_Texture_Transient, "rt_frame_render_2");
+                render_target(Renderer_RenderTexture::frame_render_opaque) = make_unique<RHI_Texture2D>(width_render, height_render, 1,         frame_render_format, frame_render_flags | RHI_Texture_Transient,                           "rt_frame_render_opaque");
                 //render_target(Renderer_RenderTexture::frame_render_history) = make_unique<RHI_Texture2D>(width_render, height_render, 1, frame_render_format, frame_render_flags, "rt_frame_render_history");
             }
 
@@ -235,32 +244,32 @@ namespace Spartan
                 uint32_t light_flags    = flags_standard | RHI_Texture_ClearBlit;
                 RHI_Format light_format = RHI_Format::R11G11B10_Float;
 
-                render_target(Renderer_RenderTexture::light_diffuse)              = make_unique<RHI_Texture2D>(width_render, height_render, 1, light_format, light_flags, "rt_light_diffuse");
-                render_target(Renderer_RenderTexture::light_diffuse_transparent)  = make_unique<RHI_Texture2D>(width_render, height_render, 1, light_format, light_flags, "rt_light_diffuse_transparent");
-                render_target(Renderer_RenderTexture::light_specular)             = make_unique<RHI_Texture2D>(width_render, height_render, 1, light_format, light_flags, "rt_light_specular");
-                render_target(Renderer_RenderTexture::light_specular_transparent) = make_unique<RHI_Texture2D>(width_render, height_render, 1, light_format, light_flags, "rt_light_specular_transparent");
-                render_target(Renderer_RenderTexture::light_volumetric)           = make_unique<RHI_Texture2D>(width_render, height_render, 1, light_format, light_flags, "rt_light_volumetric");
+                render_target(Renderer_RenderTexture::light_diffuse)              = make_unique<RHI_Texture2D>(width_render, height_render, 1, light_format, light_flags | RHI_Texture_Transient, "rt_light_diffuse");
+                render_target(Renderer_RenderTexture::light_diffuse_transparent)  = make_unique<RHI_Texture2D>(width_render, height_render, 1, light_format, light_flags | RHI_Texture_Transient, "rt_light_diffuse_transparent");
+                render_target(Renderer_RenderTexture::light_specular)             = make_unique<RHI_Texture2D>(width_render, height_render, 1, light_format, light_flags | RHI_Texture_Transient, "rt_light_specular");
+                render_target(Renderer_RenderTexture::light_specular_transparent) = make_unique<RHI_Texture2D>(width_render, height_render, 1, light_format, light_flags | RHI_Texture_Transient, "rt_light_specular_transparent");
+                render_target(Renderer_RenderTexture::light_volumetric)           = make_unique<RHI_Texture2D>(width_render, height_render, 1, light_format, light_flags | RHI_Texture_Transient, "rt_light_volumetric");
             }
 
             // ssr
             {
                 uint32_t mip_count_ssr = 5; // we use mips to emulate high roughness, low roughness is emulated via a gaussian blur, therefore we don't need a full mip chain, just enough to get believable results
-                render_target(Renderer_RenderTexture::ssr)           = make_shared<RHI_Texture2D>(width_render, height_render, mip_count_ssr, RHI_Format::R16G16B16A16_Float, flags_standard | RHI_Texture_PerMipViews | RHI_Texture_ClearBlit, "rt_ssr");
-                render_target(Renderer_RenderTexture::ssr_roughness) = make_shared<RHI_Texture2D>(width_render, height_render, 1, RHI_Format::R16_Float, flags_standard, "rt_ssr_roughness");
+                render_target(Renderer_RenderTexture::ssr)           = make_shared<RHI_Texture2D>(width_render, height_render, mip_count_ssr, RHI_Format::R16G16B16A16_Float, flags_standard | RHI_Texture_PerMipViews | RHI_Texture_ClearBlit | RHI_Texture_Transient, "rt_ssr");
+                render_target(Renderer_RenderTexture::ssr_roughness) = make_shared<RHI_Texture2D>(width_render, height_render, 1, RHI_Format::R16_Float, flags_standard | RHI_Texture_Transient, "rt_ssr_roughness");
             }
 
             // sss
             render_target(Renderer_RenderTexture::sss) = make_shared<RHI_Texture2DArray>(width_render, height_render, RHI_Format::R16_Float, 4, flags_standard | RHI_Texture_ClearBlit, "rt_sss");
 
             // ssgi
-            render_target(Renderer_RenderTexture::ssgi) = make_unique<RHI_Texture2D>(width_render, height_render, 1, RHI_Format::R16G16B16A16_Float, flags_standard, "rt_ssgi");
+            render_target(Renderer_RenderTexture::ssgi) = make_unique<RHI_Texture2D>(width_render, height_render, 1, RHI_Format::R16G16B16A16_Float, flags_standard | RHI_Texture_Transient, "rt_ssgi");
 
             // dof
-            render_target(Renderer_RenderTexture::dof_half)   = make_unique<RHI_Texture2D>(width_render / 2, height_render / 2, 1, RHI_Format::R16G16B16A16_Float, flags_standard, "rt_dof_half");
-            render_target(Renderer_RenderTexture::dof_half_2) = make_unique<RHI_Texture2D>(width_render / 2, height_render / 2, 1, RHI_Format::R16G16B16A16_Float, flags_standard, "rt_dof_half_2");
+            render_target(Renderer_RenderTexture::dof_half)   = make_unique<RHI_Texture2D>(width_render / 2, height_render / 2, 1, RHI_Format::R16G16B16A16_Float, flags_standard | RHI_Texture_Transient, "rt_dof_half");
+            render_target(Renderer_RenderTexture::dof_half_2) = make_unique<RHI_Texture2D>(width_render / 2, height_render / 2, 1, RHI_Format::R16G16B16A16_Float, flags_standard | RHI_Texture_Transient, "rt_dof_half_2");
 
             // selection outline
-            render_target(Renderer_RenderTexture::outline) = make_unique<RHI_Texture2D>(width_render, height_render, 1, RHI_Format::R8G8B8A8_Unorm, flags_render_target, "rt_outline");
+            render_target(Renderer_RenderTexture::outline) = make_unique<RHI_Texture2D>(width_render, height_render, 1, RHI_Format::R8G8B8A8_Unorm, flags_render_target | RHI_Texture_Transient, "rt_outline");
         }
 
         // output resolution
@@ -269,10 +278,10 @@ namespace Spartan
             // frame
             uint32_t frame_flags = flags_render_target | RHI_Texture_ClearBlit;
             render_target(Renderer_RenderTexture::frame_output)   = make_unique<RHI_Texture2D>(width_output, height_output, 1, RHI_Format::R16G16B16A16_Float, frame_flags, "rt_frame_output");
-            render_target(Renderer_RenderTexture::frame_output_2) = make_unique<RHI_Texture2D>(width_output, height_output, 1, RHI_Format::R16G16B16A16_Float, frame_flags, "rt_frame_output_2");
+            render_target(Renderer_RenderTexture::frame_output_2) = make_unique<RHI_Texture2D>(width_output, height_output, 1, RHI_Format::R16G16B16A16_Float, frame_flags | RHI_Texture_Transient, "rt_frame_output_2");
 
             // bloom
-            render_target(Renderer_RenderTexture::bloom) = make_shared<RHI_Texture2D>(width_output, height_output, mip_count, RHI_Format::R11G11B10_Float, flags_standard | RHI_Texture_PerMipViews, "rt_bloom");
+            render_target(Renderer_RenderTexture::bloom) = make_shared<RHI_Texture2D>(width_output, height_output, mip_count, RHI_Format::R11G11B10_Float, flags_standard | RHI_Texture_PerMipViews | RHI_Texture_Transient, "rt_bloom");
         }
 
         // fixed resolution - these are only done once
@@ -287,8 +296,8 @@ namespace Spartan
         
         // scratch textures
         {
-            render_target(Renderer_RenderTexture::scratch_blur)        = make_unique<RHI_Texture2D>(4096, 4096, 1, RHI_Format::R16G16B16A16_Float, flags_standard, "rt_scratch_blur");
-            render_target(Renderer_RenderTexture::scratch_antiflicker) = make_unique<RHI_Texture2D>(width_render, height_render, 1, RHI_Format::R16G16B16A16_Float, flags_standard | RHI_Texture_ClearBlit, "rt_scratch_antiflicker");
+            render_target(Renderer_RenderTexture::scratch_blur)        = make_unique<RHI_Texture2D>(4096, 4096, 1, RHI_Format::R16G16B16A16_Float, flags_standard | RHI_Texture_Transient, "rt_scratch_blur");
+            render_target(Renderer_RenderTexture::scratch_antiflicker) = make_unique<RHI_Texture2D>(width_render, height_render, 1, RHI_Format::R16G16B16A16_Float, flags_standard | RHI_Texture_ClearBlit | RHI_Texture_Transient, "rt_scratch_antiflicker");
         }
 
         RHI_Device::QueueWaitAll();
@@ -341,6 +350,15 @@ namespace Spartan
             shader(Renderer_Shader::depth_prepass_alpha_test_p)->Compile(RHI_Shader_Pixel, shader_dir + "depth_prepass.hlsl", async);
         }
 
+        // gpu culling
+        {
+            shader(Renderer_Shader::instance_culling_c) = make_shared<RHI_Shader>();
+            shader(Renderer_Shader::instance_culling_c)->Compile(RHI_Shader_Compute, shader_dir + "instance_culling.hlsl", async);
+
+            shader(Renderer_Shader::cluster_culling_c) = make_shared<RHI_Shader>();
+            shader(Renderer_Shader::cluster_culling_c)->Compile(RHI_Shader_Compute, shader_dir + "cluster_culling.hlsl", async);
+        }
+
         // light depth
         {
             shader(Renderer_Shader::depth_light_v) = make_shared<RHI_Shader>();
@@ -701,7 +719,7 @@ namespace Spartan
         return shaders;
     }
 
-    array<shared_ptr<RHI_StructuredBuffer>, 3>& Renderer::GetStructuredBuffers()
+    array<shared_ptr<RHI_StructuredBuffer>, 4>& Renderer::GetStructuredBuffers()
     {
         return structured_buffers;
     }
@@ -0,0 +1,219 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==========================
+#include "pch.h"
+#include "TextureStreaming.h"
+#include "RenderableRegistry.h"
+#include "Material.h"
+#include "../Core/ThreadPool.h"
+#include "../RHI/RHI_Device.h"
+#include "../RHI/RHI_Texture.h"
+#include "../World/Entity.h"
+#include "../World/Components/Camera.h"
+//=====================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    namespace
+    {
+        const uint32_t requests_in_flight_max = 4;     // streaming is a background activity, it shouldn't occupy the whole thread pool
+        const float distance_min              = 0.1f;  // the camera is inside (or touching) the bounding box
+        const uint64_t mb                     = 1024 * 1024;
+
+        struct StreamedTexture
+        {
+            shared_ptr<RHI_Texture> texture;
+            vector<Material*> materials; // to flag as changed once new mips are swapped in
+            float texels                 = 0.0f; // the most texels which are visible across the texture, over all of its renderables
+            uint32_t mip_top             = 0;    // what the texture should have
+        };
+
+        unordered_map<RHI_Texture*, StreamedTexture> textures;
+        uint64_t memory_usage = 0;
+        uint64_t budget       = 0;
+
+        float get_screen_size_pixels(Camera* camera, const Vector2& resolution, const BoundingBox& box)
+        {
+            // the distance to the closest point of the box, so that large boxes which the camera is near (or in) are considered close
+            const Vector3 position = camera->GetEntity()->GetPosition();
+            const Vector3 min      = box.GetMin();
+            const Vector3 max      = box.GetMax();
+            const Vector3 closest  = Vector3(
+                clamp(position.x, min.x, max.x),
+                clamp(position.y, min.y, max.y),
+                clamp(position.z, min.z, max.z)
+            );
+            const float distance = std::max(Vector3::Distance(position, closest), distance_min);
+
+            return box.GetExtents().Length() * camera->GetProjectionMatrix().m11 / distance * resolution.y;
+        }
+
+        void gather(Camera* camera, const Vector2& resolution)
+        {
+            for (auto& [texture, streamed] : textures)
+            {
+                streamed.materials.clear();
+                streamed.texels = 0.0f;
+            }
+
+            for (uint32_t type = static_cast<uint32_t>(Renderer_Entity::Geometry); type <= static_cast<uint32_t>(Renderer_Entity::GeometryTransparentInstanced); type++)
+            {
+                RenderableList& list = RenderableRegistry::GetList(static_cast<Renderer_Entity>(type));
+                for (uint32_t i = 0; i < list.GetCount(); i++)
+                {
+                    Material* material = list.IsReady(i) ? list.renderables[i]->GetMaterial() : nullptr;
+                    if (!material)
+                        continue;
+
+                    // tiled textures repeat over the surface, so each repetition is smaller on screen
+                    const float tiling = std::max(std::max(material->GetProperty(MaterialProperty::TextureTilingX), material->GetProperty(MaterialProperty::TextureTilingY)), 1.0f);
+                    const float texels = get_screen_size_pixels(camera, resolution, list.bounding_boxes[i]) / tiling;
+
+                    for (uint32_t slot = 0; slot < material_texture_count_support; slot++)
+                    {
+                        shared_ptr<RHI_Texture>& texture = material->GetTexture_PtrShared(static_cast<MaterialTexture>(slot));
+                        if (!texture || !texture->IsReadyForUse() || !texture->IsStreamed())
+                            continue;
+
+                        StreamedTexture& streamed = textures[texture.get()];
+                        streamed.texture          = texture;
+                        streamed.texels           = std::max(streamed.texels, texels);
+                        if (find(streamed.materials.begin(), streamed.materials.end(), material) == streamed.materials.end())
+                        {
+                            streamed.materials.push_back(material);
+                        }
+                    }
+                }
+            }
+
+            // textures which are no longer drawn drop out, they keep their mips until they are drawn again or released
+            for (auto it = textures.begin(); it != textures.end();)
+            {
+                it = it->second.materials.empty() ? textures.erase(it) : next(it);
+            }
+        }
+
+        uint32_t get_mip_top(const StreamedTexture& streamed, const uint32_t bias)
+        {
+            RHI_Texture* texture = streamed.texture.get();
+            const float size     = static_cast<float>(std::max(texture->GetStreamWidth(), texture->GetStreamHeight()));
+            const float mip      = streamed.texels > 0.0f ? floor(log2(size / streamed.texels)) : static_cast<float>(texture->GetStreamMipTopMax());
+
+            return std::min(static_cast<uint32_t>(std::max(mip, 0.0f)) + bias, texture->GetStreamMipTopMax());
+        }
+    }
+
+    void TextureStreaming::Tick(Camera* camera, const Vector2& resolution, const float budget_fraction)
+    {
+        gather(camera, resolution);
+
+        // swap in what finished streaming, the materials re-write their bindless descriptors
+        uint32_t requests_in_flight = 0;
+        memory_usage                = 0;
+        for (auto& [texture, streamed] : textures)
+        {
+            if (texture->StreamApply())
+            {
+                for (Material* material : streamed.materials)
+                {
+                    SP_FIRE_EVENT_DATA(EventType::MaterialOnChanged, static_cast<void*>(material));
+                }
+            }
+
+            requests_in_flight += texture->IsStreaming() ? 1 : 0;
+            memory_usage       += texture->GetStreamSizeGpu(texture->GetStreamMipTop());
+        }
+
+        // the share of the budget, or whatever the rest of the engine leaves, whichever is smaller
+        const uint64_t budget_device = static_cast<uint64_t>(RHI_Device::MemoryGetBudgetMb()) * mb;
+        const uint64_t usage_device  = static_cast<uint64_t>(RHI_Device::MemoryGetUsageMb()) * mb;
+        const uint64_t usage_other   = usage_device > memory_usage ? usage_device - memory_usage : 0;
+        budget                       = std::min(static_cast<uint64_t>(static_cast<double>(budget_device) * budget_fraction), budget_device > usage_other ? budget_device - usage_other : 0);
+
+        // when everything doesn't fit, all textures drop a mip, until it does (or there is nothing left to drop)
+        uint32_t bias = 0;
+        for (; bias < rhi_max_mip_count; bias++)
+        {
+            uint64_t size = 0;
+            for (auto& [texture, streamed] : textures)
+            {
+                streamed.mip_top = get_mip_top(streamed, bias);
+                size            += texture->GetStreamSizeGpu(streamed.mip_top);
+            }
+
+            if (size <= budget)
+                break;
+        }
+
+        // evictions first, they free memory, then the textures which are the furthest from what they should have
+        vector<StreamedTexture*> requests;
+        for (auto& [texture, streamed] : textures)
+        {
+            if (!texture->IsStreaming() && streamed.mip_top != texture->GetStreamMipTop())
+            {
+                requests.push_back(&streamed);
+            }
+        }
+        sort(requests.begin(), requests.end(), [](const StreamedTexture* a, const StreamedTexture* b)
+        {
+            const int32_t a_delta = static_cast<int32_t>(a->mip_top) - static_cast<int32_t>(a->texture->GetStreamMipTop());
+            const int32_t b_delta = static_cast<int32_t>(b->mip_top) - static_cast<int32_t>(b->texture->GetStreamMipTop());
+            if ((a_delta > 0) != (b_delta > 0))
+                return a_delta > 0;
+
+            return abs(a_delta) > abs(b_delta);
+        });
+
+        for (StreamedTexture* streamed : requests)
+        {
+            if (requests_in_flight >= requests_in_flight_max)
+                break;
+
+            streamed->texture->StreamBegin();
+            ThreadPool::AddTask([texture = streamed->texture, mip_top = streamed->mip_top]()
+            {
+                texture->Stream(mip_top);
+            });
+            requests_in_flight++;
+        }
+    }
+
+    void TextureStreaming::Shutdown()
+    {
+        textures.clear();
+    }
+
+    uint64_t TextureStreaming::GetMemoryUsage()
+    {
+        return memory_usage;
+    }
+
+    uint64_t TextureStreaming::GetBudget()
+    {
+        return budget;
+    }
+}
@@ -0,0 +1,46 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==============
+#include <cstdint>
+#include "../Math/Vector2.h"
+//=========================
+
+namespace Spartan
+{
+    class Camera;
+
+    // picks the resident mips of the streamed textures (see RHI_Texture::Stream()), from how large the renderables which use them are on screen
+    // when the textures would exceed their share of the gpu memory budget, every texture gives up mips until they fit
+    class TextureStreaming
+    {
+    public:
+        // main thread, before the bindless materials are updated, since the materials of the textures which were streamed in are flagged as changed
+        static void Tick(Camera* camera, const Math::Vector2& resolution, const float budget_fraction);
+        static void Shutdown();
+
+        // in bytes
+        static uint64_t GetMemoryUsage();
+        static uint64_t GetBudget();
+    };
+}
@@ -86,6 +86,13 @@ namespace Spartan
             m_object_name        = FileSystem::GetFileNameWithoutExtensionFromFilePath(file_path_relative);
         }
         
+        // the engine file which a file is, or is converted to, this is what resources are cached by
+        static std::string GetFilePathNative(const std::string& path)
+        {
+            const std::string file_path_relative = FileSystem::GetRelativePath(path);
+            return FileSystem::IsEngineFile(path) ? file_path_relative : FileSystem::NativizeFilePath(file_path_relative);
+        }
+
         ResourceType GetResourceType()                 const { return m_resource_type; }
         const char* GetResourceTypeCstr()              const { return typeid(*this).name(); }
         bool HasFilePathNative()                       const { return !m_resource_file_path_native.empty(); }
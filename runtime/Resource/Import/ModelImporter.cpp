@@ -23,7 +23,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "pch.h"
 #include "ModelImporter.h"
 #include "../../Core/ProgressTracker.h"
-#include "../../RHI/RHI_Texture.h"
+#include "../../RHI/RHI_Texture2D.h"
+#include "../../Resource/ResourceCache.h"
 #include "../../Rendering/Animation.h"
 #include "../../Rendering/Mesh.h"
 #include "../../World/World.h"
@@ -46,14 +47,15 @@ using namespace Assimp;
 
 namespace Spartan
 {
+    // per thread, so that models can be imported concurrently (by the resource loader)
     namespace
     {
-        std::string model_file_path;
-        std::string model_name;
-        Mesh* mesh               = nullptr;
-        bool model_has_animation = false;
-        bool model_is_gltf       = false;
-        const aiScene* scene     = nullptr;
+        thread_local std::string model_file_path;
+        thread_local std::string model_name;
+        thread_local Mesh* mesh               = nullptr;
+        thread_local bool model_has_animation = false;
+        thread_local bool model_is_gltf       = false;
+        thread_local const aiScene* scene     = nullptr;
     }
 
     static Matrix convert_matrix(const aiMatrix4x4& transform)
@@ -261,9 +263,13 @@ namespace Spartan
         {
             if (shared_ptr<RHI_Texture> texture = material->GetTexture_PtrShared(texture_type))
             {
+                // telling them apart takes the pixels, so wait for the texture to load (it's the same request)
+                const string& texture_file_path = texture->GetResourceFilePath().empty() ? texture->GetResourceFilePathNative() : texture->GetResourceFilePath();
+                texture = ResourceCache::Load<RHI_Texture2D>(texture_file_path, texture->GetFlags());
+
                 MaterialTexture proper_type = texture_type;
-                proper_type = (proper_type == MaterialTexture::Normal && texture->IsGrayscale()) ? MaterialTexture::Height : proper_type;
-                proper_type = (proper_type == MaterialTexture::Height && !texture->IsGrayscale()) ? MaterialTexture::Normal : proper_type;
+                proper_type = (texture && proper_type == MaterialTexture::Normal && texture->IsGrayscale()) ? MaterialTexture::Height : proper_type;
+                proper_type = (texture && proper_type == MaterialTexture::Height && !texture->IsGrayscale()) ? MaterialTexture::Normal : proper_type;
 
                 if (proper_type != texture_type)
                 {
@@ -409,22 +415,8 @@ namespace Spartan
             // recursively parse nodes
             ParseNode(scene->mRootNode);
 
-            // update model geometry
+            // update model geometry (the nodes have been parsed, on this thread)
             {
-                while (ProgressTracker::GetProgress(ProgressType::ModelImporter).GetFraction() != 1.0f)
-                {
-                    SP_LOG_INFO("Waiting for node processing threads to finish before creating GPU buffers...");
-                    this_thread::sleep_for(std::chrono::milliseconds(16));
-                }
-
-                // optimize
-                if ((mesh->GetFlags() & static_cast<uint32_t>(MeshFlags::OptimizeVertexCache)) ||
-                    (mesh->GetFlags() & static_cast<uint32_t>(MeshFlags::OptimizeVertexFetch)) ||
-                    (mesh->GetFlags() & static_cast<uint32_t>(MeshFlags::OptimizeOverdraw)))
-                {
-                    mesh->Optimize();
-                }
-
                 // aabb
                 mesh->ComputeAabb();
 
@@ -647,14 +639,55 @@ namespace Spartan
             }
         }
 
+        // optimize
+        if ((mesh->GetFlags() & static_cast<uint32_t>(MeshFlags::OptimizeVertexCache)) ||
+            (mesh->GetFlags() & static_cast<uint32_t>(MeshFlags::OptimizeVertexFetch)) ||
+            (mesh->GetFlags() & static_cast<uint32_t>(MeshFlags::OptimizeOverdraw)))
+        {
+            mesh->Optimize(indices, vertices);
+        }
+
+        // clusters, which reorder the indices, so they come after the optimizations
+        vector<MeshCluster> clusters;
+        if (mesh->GetFlags() & static_cast<uint32_t>(MeshFlags::ImportClusters))
+        {
+            mesh->BuildClusters(indices, vertices, &clusters);
+        }
+
+        // lods, simplified from the full detail indices and appended after them, they share the vertices
+        vector<vector<uint32_t>> lods;
+        if (mesh->GetFlags() & static_cast<uint32_t>(MeshFlags::ImportLods))
+        {
+            mesh->BuildLods(indices, vertices, &lods);
+        }
+
         // compute AABB (before doing move operation on vertices)
         const BoundingBox aabb = BoundingBox(vertices.data(), static_cast<uint32_t>(vertices.size()));
 
         // add vertex and index data to the mesh
+        const uint32_t index_count_lod_0 = static_cast<uint32_t>(indices.size());
+        for (const vector<uint32_t>& lod : lods)
+        {
+            indices.insert(indices.end(), lod.begin(), lod.end());
+        }
         uint32_t index_offset  = 0;
         uint32_t vertex_offset = 0;
         mesh->AddIndices(indices,  &index_offset);
         mesh->AddVertices(vertices, &vertex_offset);
+        mesh->AddClusters(clusters, index_offset);
+
+        // add the lod ranges, now that the index offset of the sub-mesh is known
+        if (!lods.empty())
+        {
+            vector<MeshLod> mesh_lods;
+            uint32_t lod_index_offset = index_offset + index_count_lod_0;
+            for (const vector<uint32_t>& lod : lods)
+            {
+                mesh_lods.push_back({ index_offset, lod_index_offset, static_cast<uint32_t>(lod.size()) });
+                lod_index_offset += static_cast<uint32_t>(lod.size());
+            }
+            mesh->AddLods(mesh_lods);
+        }
 
         // add a renderable component to this entity
         shared_ptr<Renderable> renderable = entity_parent->AddComponent<Renderable>();
@@ -664,7 +697,7 @@ namespace Spartan
             mesh,
             aabb,
             index_offset,
-            static_cast<uint32_t>(indices.size()),
+            index_count_lod_0,
             vertex_offset,
             static_cast<uint32_t>(vertices.size())
         );
@@ -24,11 +24,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "ResourceCache.h"
 #include "../World/World.h"
 #include "../IO/FileStream.h"
+#include "../IO/AssetArchive.h"
 #include "../RHI/RHI_Texture2D.h"
 #include "../RHI/RHI_Texture2DArray.h"
 #include "../RHI/RHI_TextureCube.h"
 #include "../Audio/AudioClip.h"
 #include "../Rendering/Mesh.h"
+#include <shared_mutex>
 //====================================
 
 //= NAMESPACES ================
@@ -40,11 +42,80 @@ namespace Spartan
 {
     namespace
     {
+        const uint32_t eviction_interval = 60; // ticks between checking the budgets
+
+        // a path or a name, of a given type
+        struct Key
+        {
+            string value;
+            ResourceType type = ResourceType::Unknown;
+
+            bool operator==(const Key& other) const { return type == other.type && value == other.value; }
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const { return hash<string>()(key.value) ^ (static_cast<size_t>(key.type) * 0x9E3779B97F4A7C15ull); }
+        };
+
+        struct Entry
+        {
+            shared_ptr<IResource> resource;
+            Key key_path; // what it was indexed by, in case the resource changes them afterwards
+            Key key_name;
+            atomic<uint64_t> last_used = 0; // tick
+        };
+
         array<string, 6> m_standard_resource_directories;
         string m_project_directory;
-        vector<shared_ptr<IResource>> m_resources;
-        mutex m_mutex;
+        unordered_map<uint64_t, Entry> m_resources; // by id
+        unordered_map<Key, Entry*, KeyHash> m_resources_by_path;
+        unordered_multimap<Key, Entry*, KeyHash> m_resources_by_name;
+        shared_mutex m_mutex;
+        atomic<uint64_t> tick_count = 0;
+        uint64_t memory_budget_cpu  = 0;
+        uint64_t memory_budget_gpu  = 0;
         bool use_root_shader_directory = false;
+
+        // lock held (shared is enough)
+        shared_ptr<IResource> touch(Entry* entry)
+        {
+            entry->last_used.store(tick_count.load(memory_order_relaxed), memory_order_relaxed);
+            return entry->resource;
+        }
+
+        // lock held
+        void erase(const uint64_t id)
+        {
+            auto it = m_resources.find(id);
+            if (it == m_resources.end())
+                return;
+
+            Entry* entry = &it->second;
+            m_resources_by_path.erase(entry->key_path);
+
+            auto range = m_resources_by_name.equal_range(entry->key_name);
+            for (auto it_name = range.first; it_name != range.second; it_name++)
+            {
+                if (it_name->second == entry)
+                {
+                    m_resources_by_name.erase(it_name);
+                    break;
+                }
+            }
+
+            m_resources.erase(it);
+        }
+
+        // renderables point to their mesh and material with raw pointers, so only the resources that their users hold on to can be told apart as unused
+        bool is_evictable(const ResourceType type)
+        {
+            return type == ResourceType::Texture        ||
+                   type == ResourceType::Texture2d      ||
+                   type == ResourceType::Texture2dArray ||
+                   type == ResourceType::TextureCube    ||
+                   type == ResourceType::Audio;
+        }
     }
 
     void ResourceCache::Initialize()
@@ -67,80 +138,120 @@ namespace Spartan
         SP_SUBSCRIBE_TO_EVENT(EventType::WorldClear,     SP_EVENT_HANDLER_STATIC(Shutdown));
     }
 
-    bool ResourceCache::IsCached(const string& resource_file_path_native, const ResourceType resource_type)
+    void ResourceCache::Tick()
     {
-        SP_ASSERT(!resource_file_path_native.empty());
+        const uint64_t tick = tick_count.fetch_add(1, memory_order_relaxed) + 1;
 
-        lock_guard<mutex> guard(m_mutex);
+        if ((memory_budget_cpu != 0 || memory_budget_gpu != 0) && tick % eviction_interval == 0)
+        {
+            Evict();
+        }
+    }
+
+    shared_ptr<IResource> ResourceCache::Add(const shared_ptr<IResource>& resource)
+    {
+        unique_lock lock(m_mutex);
+
+        Key key_path = { resource->GetResourceFilePathNative(), resource->GetResourceType() };
+        auto it      = m_resources_by_path.find(key_path);
+        if (it != m_resources_by_path.end())
+            return touch(it->second);
+
+        Entry& entry    = m_resources[resource->GetObjectId()];
+        entry.resource  = resource;
+        entry.key_path  = move(key_path);
+        entry.key_name  = { resource->GetObjectName(), resource->GetResourceType() };
+        entry.last_used = tick_count.load(memory_order_relaxed);
 
-        for (shared_ptr<IResource>& resource : m_resources)
+        m_resources_by_path.emplace(entry.key_path, &entry);
+        m_resources_by_name.emplace(entry.key_name, &entry);
+
+        return resource;
+    }
+
+    void ResourceCache::Remove(const uint64_t id)
+    {
+        shared_ptr<IResource> resource; // released outside of the lock
         {
-            if (resource->GetResourceType() != resource_type)
-                continue;
+            unique_lock lock(m_mutex);
+
+            auto it = m_resources.find(id);
+            if (it == m_resources.end())
+                return;
 
-            if (resource_file_path_native == resource->GetResourceFilePathNative())
-                return true;
+            resource = it->second.resource;
+            erase(id);
         }
+    }
 
-        return false;
+    bool ResourceCache::IsCached(const string& resource_file_path_native, const ResourceType resource_type)
+    {
+        SP_ASSERT(!resource_file_path_native.empty());
+
+        return GetByPath(resource_file_path_native, resource_type) != nullptr;
     }
 
     bool ResourceCache::IsCached(const uint64_t resource_id)
     {
-        lock_guard<mutex> guard(m_mutex);
+        shared_lock lock(m_mutex);
+        return m_resources.find(resource_id) != m_resources.end();
+    }
 
-        for (shared_ptr<IResource>& resource : m_resources)
-        {
-            if (resource_id == resource->GetObjectId())
-                return true;
-        }
+    shared_ptr<IResource> ResourceCache::GetByName(const string& name, const ResourceType type)
+    {
+        shared_lock lock(m_mutex);
 
-        return false;
+        auto it = m_resources_by_name.find(Key{ name, type });
+        return it != m_resources_by_name.end() ? touch(it->second) : nullptr;
     }
-    
-	shared_ptr<IResource>& ResourceCache::GetByName(const string& name, const ResourceType type)
+
+    shared_ptr<IResource> ResourceCache::GetByPath(const string& path, const ResourceType type)
     {
-        lock_guard<mutex> guard(m_mutex);
+        shared_lock lock(m_mutex);
 
-        for (shared_ptr<IResource>& resource : m_resources)
-        {
-            if (name == resource->GetObjectName())
-                return resource;
-        }
+        auto it = m_resources_by_path.find(Key{ path, type });
+        return it != m_resources_by_path.end() ? touch(it->second) : nullptr;
+    }
 
-        static shared_ptr<IResource> empty;
-        return empty;
+    shared_ptr<IResource> ResourceCache::GetById(const uint64_t id)
+    {
+        shared_lock lock(m_mutex);
+
+        auto it = m_resources.find(id);
+        return it != m_resources.end() ? touch(&it->second) : nullptr;
     }
 
     vector<shared_ptr<IResource>> ResourceCache::GetByType(const ResourceType type /*= ResourceType::Unknown*/)
     {
-        lock_guard<mutex> guard(m_mutex);
-
         vector<shared_ptr<IResource>> resources;
-        for (shared_ptr<IResource>& resource : m_resources)
         {
-            if (resource->GetResourceType() == type || type == ResourceType::Unknown)
+            shared_lock lock(m_mutex);
+
+            for (const auto& [id, entry] : m_resources)
             {
-                resources.emplace_back(resource);
+                if (entry.resource->GetResourceType() == type || type == ResourceType::Unknown)
+                {
+                    resources.emplace_back(entry.resource);
+                }
             }
         }
 
+        // in the order they were created, so that it doesn't change from call to call
+        sort(resources.begin(), resources.end(), [](const shared_ptr<IResource>& a, const shared_ptr<IResource>& b) { return a->GetObjectId() < b->GetObjectId(); });
+
         return resources;
     }
 
     uint64_t ResourceCache::GetMemoryUsageCpu(ResourceType type /*= Resource_Unknown*/)
     {
-        lock_guard<mutex> guard(m_mutex);
+        shared_lock lock(m_mutex);
 
         uint64_t size = 0;
-        for (shared_ptr<IResource>& resource : m_resources)
+        for (const auto& [id, entry] : m_resources)
         {
-            if (resource->GetResourceType() == type || type == ResourceType::Unknown)
+            if (entry.resource->GetResourceType() == type || type == ResourceType::Unknown)
             {
-                if (SpObject* object = dynamic_cast<SpObject*>(resource.get()))
-                {
-                    size += object->GetObjectSizeCpu();
-                }
+                size += entry.resource->GetObjectSizeCpu();
             }
         }
 
@@ -149,21 +260,78 @@ namespace Spartan
 
     uint64_t ResourceCache::GetMemoryUsageGpu(ResourceType type /*= Resource_Unknown*/)
     {
-        lock_guard<mutex> guard(m_mutex);
+        shared_lock lock(m_mutex);
 
         uint64_t size = 0;
-        for (shared_ptr<IResource>& resource : m_resources)
+        for (const auto& [id, entry] : m_resources)
+        {
+            if (entry.resource->GetResourceType() == type || type == ResourceType::Unknown)
+            {
+                size += entry.resource->GetObjectSizeGpu();
+            }
+        }
+
+        return size;
+    }
+
+    void ResourceCache::SetMemoryBudget(const uint64_t budget_cpu, const uint64_t budget_gpu)
+    {
+        memory_budget_cpu = budget_cpu;
+        memory_budget_gpu = budget_gpu;
+    }
+
+    void ResourceCache::Evict()
+    {
+        vector<shared_ptr<IResource>> evicted; // destroyed outside of the lock
         {
-            if (resource->GetResourceType() == type || type == ResourceType::Unknown)
+            unique_lock lock(m_mutex);
+
+            // a resource is a candidate when the cache holds the only reference to it, nothing can take one while the lock is held
+            uint64_t usage_cpu = 0;
+            uint64_t usage_gpu = 0;
+            vector<Entry*> candidates;
+            for (auto& [id, entry] : m_resources)
             {
-                if (SpObject* object = dynamic_cast<SpObject*>(resource.get()))
+                usage_cpu += entry.resource->GetObjectSizeCpu();
+                usage_gpu += entry.resource->GetObjectSizeGpu();
+
+                if (entry.resource.use_count() == 1 && is_evictable(entry.resource->GetResourceType()))
                 {
-                    size += object->GetObjectSizeGpu();
+                    candidates.push_back(&entry);
                 }
             }
+
+            auto is_over_budget = [&usage_cpu, &usage_gpu]()
+            {
+                return (memory_budget_cpu != 0 && usage_cpu > memory_budget_cpu) || (memory_budget_gpu != 0 && usage_gpu > memory_budget_gpu);
+            };
+
+            if (!is_over_budget())
+                return;
+
+            // least recently used first
+            sort(candidates.begin(), candidates.end(), [](const Entry* a, const Entry* b) { return a->last_used.load(memory_order_relaxed) < b->last_used.load(memory_order_relaxed); });
+
+            for (Entry* entry : candidates)
+            {
+                if (!is_over_budget())
+                    break;
+
+                // what is evicted has to be loadable again
+                if (!AssetArchive::Exists(entry->resource->GetResourceFilePathNative()))
+                    continue;
+
+                usage_cpu -= min(usage_cpu, entry->resource->GetObjectSizeCpu());
+                usage_gpu -= min(usage_gpu, entry->resource->GetObjectSizeGpu());
+                evicted.emplace_back(entry->resource);
+                erase(entry->resource->GetObjectId());
+            }
         }
 
-        return size;
+        if (!evicted.empty())
+        {
+            SP_LOG_INFO("Evicted %u resources to stay within the memory budget", static_cast<uint32_t>(evicted.size()));
+        }
     }
 
     void ResourceCache::SaveResourcesToFiles()
@@ -177,18 +345,28 @@ namespace Spartan
             return;
         }
 
-        const uint32_t resource_count = GetResourceCount();
+        // Only resources with a native file can be saved, and loaded back
+        const vector<shared_ptr<IResource>> resources = GetByType();
+        vector<string> file_paths;
+        for (const shared_ptr<IResource>& resource : resources)
+        {
+            if (resource->HasFilePathNative())
+            {
+                file_paths.emplace_back(resource->GetResourceFilePathNative());
+            }
+        }
+        const uint32_t resource_count = static_cast<uint32_t>(file_paths.size());
 
         // Start progress report
-        ProgressTracker::GetProgress(ProgressType::Resource).Start(resource_count, "Loading resources...");
+        ProgressTracker::GetProgress(ProgressType::Resource).Start(resource_count, "Saving resources...");
 
         // Save resource count
         file->Write(resource_count);
 
         // Save all the currently used resources to disk
-        for (shared_ptr<IResource>& resource : m_resources)
+        for (const shared_ptr<IResource>& resource : resources)
         {
-            if (!resource->HasFilePathNative())
+            if (resource->HasFilePathNative())
             {
                 // Save file path
                 file->Write(resource->GetResourceFilePathNative());
@@ -196,10 +374,17 @@ namespace Spartan
                 file->Write(static_cast<uint32_t>(resource->GetResourceType()));
                 // Save resource (to a dedicated file)
                 resource->SaveToFile(resource->GetResourceFilePathNative());
+
+                // Update progress
+                ProgressTracker::GetProgress(ProgressType::Resource).JobDone();
             }
+        }
 
-            // Update progress
-            ProgressTracker::GetProgress(ProgressType::Resource).JobDone();
+        // Pack the resource files, so that loading maps a single file instead of opening one per resource
+        const string archive_path = GetProjectDirectoryAbsolute() + World::GetName() + "_resources.pak";
+        if (AssetArchive::Pack(archive_path, file_paths))
+        {
+            AssetArchive::Mount(archive_path);
         }
     }
 
@@ -211,9 +396,13 @@ namespace Spartan
         if (!file->IsOpen())
             return;
 
+        // Mount the packed resource files, if they were packed (the latest version of them)
+        AssetArchive::Mount(GetProjectDirectoryAbsolute() + World::GetName() + "_resources.pak");
+
         // Load resource count
         const uint32_t resource_count = file->ReadAs<uint32_t>();
 
+        // Start loading them all, so that they are read and decoded in parallel
         for (uint32_t i = 0; i < resource_count; i++)
         {
             // Load resource file path
@@ -225,36 +414,46 @@ namespace Spartan
             switch (type)
             {
             case ResourceType::Mesh:
-                Load<Mesh>(file_path);
+                LoadAsync<Mesh>(file_path);
                 break;
             case ResourceType::Material:
-                Load<Material>(file_path);
+                LoadAsync<Material>(file_path);
                 break;
             case ResourceType::Texture:
-                Load<RHI_Texture>(file_path);
+                LoadAsync<RHI_Texture>(file_path);
                 break;
             case ResourceType::Texture2d:
-                Load<RHI_Texture2D>(file_path);
+                LoadAsync<RHI_Texture2D>(file_path);
                 break;
             case ResourceType::Texture2dArray:
-                Load<RHI_Texture2DArray>(file_path);
+                LoadAsync<RHI_Texture2DArray>(file_path);
                 break;
             case ResourceType::TextureCube:
-                Load<RHI_TextureCube>(file_path);
+                LoadAsync<RHI_TextureCube>(file_path);
                 break;
             case ResourceType::Audio:
-                Load<AudioClip>(file_path);
+                LoadAsync<AudioClip>(file_path);
                 break;
             }
         }
 
+        ResourceLoader::WaitAll();
     }
 
     void ResourceCache::Shutdown()
     {
-        uint32_t resource_count = static_cast<uint32_t>(m_resources.size());
-        m_resources.clear();
-        SP_LOG_INFO("%d resources have been cleared", resource_count);
+        // nothing can be cached past this point
+        ResourceLoader::Flush();
+        AssetArchive::Unmount();
+
+        unordered_map<uint64_t, Entry> resources; // destroyed outside of the lock
+        {
+            unique_lock lock(m_mutex);
+            m_resources_by_path.clear();
+            m_resources_by_name.clear();
+            resources.swap(m_resources);
+        }
+        SP_LOG_INFO("%d resources have been cleared", static_cast<uint32_t>(resources.size()));
     }
 
     uint32_t ResourceCache::GetResourceCount(const ResourceType type)
@@ -307,16 +506,6 @@ namespace Spartan
         return "Data";
     }
 
-    vector<shared_ptr<IResource>>& ResourceCache::GetResources()
-    {
-        return m_resources;
-    }
-
-    mutex& ResourceCache::GetMutex()
-    {
-        return m_mutex;
-    }
-
     bool ResourceCache::GetUseRootShaderDirectory()
     {
         return use_root_shader_directory;
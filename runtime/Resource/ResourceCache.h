@@ -25,6 +25,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <algorithm>
 #include "IResource.h"
 #include "ProgressTracker.h"
+#include "ResourceLoader.h"
+#include "../IO/AssetArchive.h"
 //==========================
 
 namespace Spartan
@@ -41,14 +43,17 @@ namespace Spartan
         Textures
     };
 
+    // resources are indexed by path and type, by name and type, and by id, lookups from any thread can run concurrently
+    // with a memory budget, resources which nothing references anymore are evicted, least recently used first
     class SP_CLASS ResourceCache
     {
     public:
         static void Initialize();
         static void Shutdown();
+        static void Tick();
 
         // Get by name
-        static std::shared_ptr<IResource>& GetByName(const std::string& name, ResourceType type);
+        static std::shared_ptr<IResource> GetByName(const std::string& name, ResourceType type);
         template <class T> 
         static std::shared_ptr<T> GetByName(const std::string& name) 
         { 
@@ -59,18 +64,16 @@ namespace Spartan
         static std::vector<std::shared_ptr<IResource>> GetByType(ResourceType type = ResourceType::Unknown);
 
         // Get by path
+        static std::shared_ptr<IResource> GetByPath(const std::string& path, ResourceType type);
         template <class T>
         static std::shared_ptr<T> GetByPath(const std::string& path)
         {
-            for (std::shared_ptr<IResource>& resource : GetResources())
-            {
-                if (path == resource->GetResourceFilePathNative())
-                    return std::static_pointer_cast<T>(resource);
-            }
-
-            return nullptr;
+            return std::static_pointer_cast<T>(GetByPath(path, IResource::TypeToEnum<T>()));
         }
 
+        // Get by id
+        static std::shared_ptr<IResource> GetById(const uint64_t id);
+
         // Caches resource, or replaces with existing cached resource
         template <class T>
         static std::shared_ptr<T> Cache(const std::shared_ptr<T> resource)
@@ -94,33 +97,30 @@ namespace Spartan
             }
 
             // Ensure that this resource is not already cached
-            if (IsCached(resource->GetResourceFilePathNative(), resource->GetResourceType()))
-                return GetByPath<T>(resource->GetResourceFilePathNative());
-
-            std::lock_guard<std::mutex> guard(GetMutex());
+            if (std::shared_ptr<IResource> resource_cached = GetByPath(resource->GetResourceFilePathNative(), resource->GetResourceType()))
+                return std::static_pointer_cast<T>(resource_cached);
 
-            // In order to guarantee deserialization, we save it now
+            // In order to guarantee deserialization, we save it now (outside of the lock, it can take a while)
             resource->SaveToFile(resource->GetResourceFilePathNative());
 
-            // Cache it
-            return std::static_pointer_cast<T>(GetResources().emplace_back(resource));
+            // Cache it, unless another thread cached it while it was saving
+            return std::static_pointer_cast<T>(Add(resource));
         }
 
-        // Loads a resource and adds it to the resource cache
+        // Starts loading a resource in the background, it's added to the resource cache once loaded
         template <class T>
-        static std::shared_ptr<T> Load(const std::string& file_path, uint32_t flags = 0)
+        static ResourceHandle<T> LoadAsync(const std::string& file_path, uint32_t flags = 0, ResourcePriority priority = ResourcePriority::Normal)
         {
-            if (!FileSystem::Exists(file_path))
+            // Check if the resource is already loaded, before going to the drive
+            if (std::shared_ptr<IResource> resource_cached = GetByPath(IResource::GetFilePathNative(file_path), IResource::TypeToEnum<T>()))
+                return ResourceHandle<T>(resource_cached);
+
+            if (!FileSystem::Exists(file_path) && !AssetArchive::Contains(file_path))
             {
                 SP_LOG_ERROR("\"%s\" doesn't exist.", file_path.c_str());
-                return nullptr;
+                return ResourceHandle<T>();
             }
 
-            // Check if the resource is already loaded
-            const std::string name = FileSystem::GetFileNameWithoutExtensionFromFilePath(file_path);
-            if (IsCached(name, IResource::TypeToEnum<T>()))
-                return GetByName<T>(name);
-
             // Create new resource
             std::shared_ptr<T> resource = std::make_shared<T>();
 
@@ -132,15 +132,16 @@ namespace Spartan
             // Set a default file path in case it's not overridden by LoadFromFile()
             resource->SetResourceFilePath(file_path);
 
-            // Load
-            if (!resource || !resource->LoadFromFile(file_path))
-            {
-                SP_LOG_ERROR("Failed to load \"%s\".", file_path.c_str());
-                return nullptr;
-            }
+            // Requests for a resource which is already loading share the load
+            return ResourceHandle<T>(ResourceLoader::Request(resource, file_path, priority));
+        }
 
+        // Loads a resource and adds it to the resource cache
+        template <class T>
+        static std::shared_ptr<T> Load(const std::string& file_path, uint32_t flags = 0)
+        {
             // Returned cached reference which is guaranteed to be around after deserialization
-            return Cache<T>(resource);
+            return LoadAsync<T>(file_path, flags, ResourcePriority::High).Wait();
         }
 
         template <class T>
@@ -149,26 +150,19 @@ namespace Spartan
             if (!resource)
                 return;
 
-            if (!IsCached(resource->GetObjectName(), resource->GetResourceType()))
-                return;
-
-            GetResources().erase
-            (
-                std::remove_if
-                (
-                    GetResources().begin(),
-                    GetResources().end(),
-                    [](std::shared_ptr<IResource> resource) { return dynamic_cast<SpObject*>(resource.get())->GetObjectId() == resource->GetObjectId(); }
-                ),
-                GetResources().end()
-            );
+            Remove(resource->GetObjectId());
         }
+        static void Remove(const uint64_t id);
 
         // memory
         static uint64_t GetMemoryUsageCpu(ResourceType type = ResourceType::Unknown);
         static uint64_t GetMemoryUsageGpu(ResourceType type = ResourceType::Unknown);
         static uint32_t GetResourceCount(ResourceType type = ResourceType::Unknown);
 
+        // eviction, a budget of 0 is unlimited, the renderer sets them from its options every frame
+        static void SetMemoryBudget(const uint64_t budget_cpu, const uint64_t budget_gpu);
+        static void Evict();
+
         // directories
         static void AddResourceDirectory(ResourceDirectory type, const std::string& directory);
         static std::string GetResourceDirectory(ResourceDirectory type);
@@ -178,14 +172,13 @@ namespace Spartan
         static std::string GetDataDirectory();
 
         // misc
-        static std::vector<std::shared_ptr<IResource>>& GetResources();
-        static std::mutex& GetMutex();
         static bool GetUseRootShaderDirectory();
         static void SetUseRootShaderDirectory(const bool use_root_shader_directory);
 
     private:
+        static std::shared_ptr<IResource> Add(const std::shared_ptr<IResource>& resource);
         static bool IsCached(const uint64_t resource_id);
-        static bool IsCached(const std::string& resource_name, const ResourceType resource_type);
+        static bool IsCached(const std::string& resource_file_path_native, const ResourceType resource_type);
 
         // event handlers
         static void SaveResourcesToFiles();
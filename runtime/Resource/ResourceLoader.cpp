@@ -0,0 +1,349 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===================
+#include "pch.h"
+#include "ResourceLoader.h"
+#include "ResourceCache.h"
+#include "../Core/ThreadPool.h"
+#include "../IO/AssetArchive.h"
+//==============================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    namespace
+    {
+        const uint32_t lanes_read_max = 2;    // the drive is the limit, more would only make it seek
+        const uint64_t page_size      = 4096;
+
+        mutex loader_mutex;
+        condition_variable loader_condition;
+        vector<shared_ptr<ResourceRequest>> queue_read;
+        vector<shared_ptr<ResourceRequest>> queue_decode;
+        unordered_map<string, shared_ptr<ResourceRequest>> requests_in_flight; // by key, so that a resource is only loaded once
+        uint32_t lanes_read   = 0;
+        uint32_t lanes_decode = 0;
+        uint32_t active       = 0; // requests which are out of the queues, but not done yet
+        uint64_t sequence     = 0;
+
+        string get_key(const IResource& resource)
+        {
+            return to_string(static_cast<uint32_t>(resource.GetResourceType())) + "|" + resource.GetResourceFilePathNative();
+        }
+
+        // highest priority first, oldest first within a priority (lock held)
+        shared_ptr<ResourceRequest> pop(vector<shared_ptr<ResourceRequest>>& queue)
+        {
+            if (queue.empty())
+                return nullptr;
+
+            auto it_best = queue.begin();
+            for (auto it = next(queue.begin()); it != queue.end(); it++)
+            {
+                const ResourceRequest& request = **it;
+                const ResourceRequest& best    = **it_best;
+                if (request.priority > best.priority || (request.priority == best.priority && request.sequence < best.sequence))
+                {
+                    it_best = it;
+                }
+            }
+
+            // order is kept by the sequence, so the last one can take its place
+            shared_ptr<ResourceRequest> request = *it_best;
+            *it_best = queue.back();
+            queue.pop_back();
+
+            return request;
+        }
+
+        // lock held
+        bool remove(vector<shared_ptr<ResourceRequest>>& queue, const shared_ptr<ResourceRequest>& request)
+        {
+            auto it = find(queue.begin(), queue.end(), request);
+            if (it == queue.end())
+                return false;
+
+            *it = queue.back();
+            queue.pop_back();
+
+            return true;
+        }
+
+        // lock held
+        void complete(ResourceRequest& request, const shared_ptr<IResource>& resource)
+        {
+            request.resource_cached = resource;
+            request.state           = resource ? ResourceLoadState::Ready : ResourceLoadState::Failed;
+            requests_in_flight.erase(request.key);
+        }
+
+        void read(ResourceRequest& request)
+        {
+            request.state = ResourceLoadState::Reading;
+
+            // touching a byte of every page makes the os read the whole file now, so decoding finds it in memory
+            if (shared_ptr<FileMapping> mapping = AssetArchive::Map(request.file_path))
+            {
+                uint8_t checksum = 0;
+                for (uint64_t offset = 0; offset < mapping->GetSize(); offset += page_size)
+                {
+                    checksum ^= static_cast<uint8_t>(mapping->GetData()[offset]);
+                }
+                volatile uint8_t sink = checksum; // so that the reads aren't optimized away
+                static_cast<void>(sink);
+
+                request.mapping = mapping;
+            }
+
+            request.state = ResourceLoadState::Read;
+        }
+
+        void decode(ResourceRequest& request)
+        {
+            request.state = ResourceLoadState::Decoding;
+
+            // decoding includes creating the gpu resources, which uploads them
+            shared_ptr<IResource> resource;
+            const bool loaded = request.resource->LoadFromFile(request.file_path);
+
+            // unmapped before caching, which saves the resource and may write over the file
+            request.mapping.reset();
+
+            if (loaded)
+            {
+                // returns the resource that was cached first, if it was loaded by other means in the meantime
+                resource = ResourceCache::Cache(request.resource);
+            }
+            else
+            {
+                SP_LOG_ERROR("Failed to load \"%s\".", request.file_path.c_str());
+            }
+
+            {
+                lock_guard lock(loader_mutex);
+                complete(request, resource);
+                active--;
+            }
+            loader_condition.notify_all();
+        }
+
+        void schedule();
+
+        void run_lane_read()
+        {
+            while (true)
+            {
+                shared_ptr<ResourceRequest> request;
+                {
+                    lock_guard lock(loader_mutex);
+                    request = pop(queue_read);
+                    if (!request)
+                    {
+                        lanes_read--;
+                        return;
+                    }
+                    active++;
+                }
+
+                read(*request);
+
+                {
+                    lock_guard lock(loader_mutex);
+                    active--;
+                    queue_decode.push_back(request);
+                    schedule();
+                }
+                // whoever waits for it can now decode it
+                loader_condition.notify_all();
+            }
+        }
+
+        void run_lane_decode()
+        {
+            while (true)
+            {
+                shared_ptr<ResourceRequest> request;
+                {
+                    lock_guard lock(loader_mutex);
+                    request = pop(queue_decode);
+                    if (!request)
+                    {
+                        lanes_decode--;
+                        return;
+                    }
+                    active++;
+                }
+
+                decode(*request);
+            }
+        }
+
+        // starts as many lanes as there is work for, within the limits (lock held)
+        void schedule()
+        {
+            const uint32_t thread_count     = ThreadPool::GetThreadCount();
+            const uint32_t lanes_decode_max = thread_count > lanes_read_max ? thread_count - lanes_read_max : 1;
+
+            while (lanes_read < min(lanes_read_max, static_cast<uint32_t>(queue_read.size())))
+            {
+                lanes_read++;
+                ThreadPool::AddTask(run_lane_read);
+            }
+
+            while (lanes_decode < min(lanes_decode_max, static_cast<uint32_t>(queue_decode.size())))
+            {
+                lanes_decode++;
+                ThreadPool::AddTask(run_lane_decode);
+            }
+        }
+    }
+
+    shared_ptr<ResourceRequest> ResourceLoader::Request(const shared_ptr<IResource>& resource, const string& file_path, const ResourcePriority priority)
+    {
+        SP_ASSERT(resource != nullptr);
+
+        shared_ptr<ResourceRequest> request = make_shared<ResourceRequest>();
+        request->resource                   = resource;
+        request->file_path                  = file_path;
+        request->key                        = get_key(*resource);
+        request->priority                   = priority;
+
+        // already loaded
+        if (shared_ptr<IResource> resource_cached = ResourceCache::GetByPath(resource->GetResourceFilePathNative(), resource->GetResourceType()))
+        {
+            request->resource        = resource_cached;
+            request->resource_cached = resource_cached;
+            request->state           = ResourceLoadState::Ready;
+            return request;
+        }
+
+        lock_guard lock(loader_mutex);
+
+        // already loading, what's needed sooner by anyone is needed sooner by everyone
+        auto it = requests_in_flight.find(request->key);
+        if (it != requests_in_flight.end())
+        {
+            it->second->priority = max(it->second->priority, priority);
+            return it->second;
+        }
+
+        request->sequence = sequence++;
+        requests_in_flight[request->key] = request;
+        queue_read.push_back(request);
+        schedule();
+
+        return request;
+    }
+
+    void ResourceLoader::Wait(const shared_ptr<ResourceRequest>& request)
+    {
+        if (!request)
+            return;
+
+        unique_lock lock(loader_mutex);
+        while (!request->IsDone())
+        {
+            // if no lane has picked it up, it's loaded here, so waiting is never slower than loading synchronously
+            const bool needs_reading = remove(queue_read, request);
+            if (needs_reading || remove(queue_decode, request))
+            {
+                active++;
+                lock.unlock();
+
+                if (needs_reading)
+                {
+                    read(*request);
+                }
+                decode(*request);
+
+                return;
+            }
+
+            loader_condition.wait(lock);
+        }
+    }
+
+    void ResourceLoader::WaitAll()
+    {
+        unique_lock lock(loader_mutex);
+        while (!requests_in_flight.empty())
+        {
+            // decoding first, since it's what keeps the cores busy
+            shared_ptr<ResourceRequest> request = pop(queue_decode);
+            const bool needs_reading            = !request;
+            if (needs_reading)
+            {
+                request = pop(queue_read);
+            }
+
+            if (request)
+            {
+                active++;
+                lock.unlock();
+
+                if (needs_reading)
+                {
+                    read(*request);
+                }
+                decode(*request);
+
+                lock.lock();
+                continue;
+            }
+
+            loader_condition.wait(lock);
+        }
+    }
+
+    void ResourceLoader::Flush()
+    {
+        unique_lock lock(loader_mutex);
+        while (true)
+        {
+            // requests which move from reading to decoding in the meantime are cancelled on the next pass
+            for (vector<shared_ptr<ResourceRequest>>* queue : { &queue_read, &queue_decode })
+            {
+                for (shared_ptr<ResourceRequest>& request : *queue)
+                {
+                    request->mapping.reset();
+                    complete(*request, nullptr);
+                }
+                queue->clear();
+            }
+            loader_condition.notify_all();
+
+            if (active == 0)
+                break;
+
+            loader_condition.wait(lock);
+        }
+    }
+
+    uint32_t ResourceLoader::GetPendingCount()
+    {
+        lock_guard lock(loader_mutex);
+        return static_cast<uint32_t>(requests_in_flight.size());
+    }
+}
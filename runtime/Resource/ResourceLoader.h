@@ -0,0 +1,126 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ======
+#include <atomic>
+#include <memory>
+#include <string>
+//=================
+
+namespace Spartan
+{
+    class IResource;
+    class FileMapping;
+
+    enum class ResourcePriority : uint8_t
+    {
+        Low,
+        Normal,
+        High // what something is waiting for
+    };
+
+    enum class ResourceLoadState : uint8_t
+    {
+        Queued,
+        Reading,
+        Read,     // queued for decoding
+        Decoding,
+        Ready,
+        Failed
+    };
+
+    // a resource which is being loaded, shared by everything which requested it
+    struct ResourceRequest
+    {
+        bool IsDone() const { return state == ResourceLoadState::Ready || state == ResourceLoadState::Failed; }
+
+        std::shared_ptr<IResource> resource;        // what is being loaded, usable as a placeholder in the meantime
+        std::shared_ptr<IResource> resource_cached; // what the cache holds, set before the state becomes ready
+        std::shared_ptr<FileMapping> mapping;       // keeps the file resident between reading and decoding
+        std::string file_path;
+        std::string key;
+        ResourcePriority priority = ResourcePriority::Normal;
+        uint64_t sequence         = 0; // first come first served, within a priority
+        std::atomic<ResourceLoadState> state = ResourceLoadState::Queued;
+    };
+
+    // loads resources in two stages, each with its own priority queue which threads of the pool drain
+    // reading brings the file into memory, a couple at a time since the drive is the limit, decoding (and creating the gpu resources) scales with the cores
+    // requests for a resource which is already loading share the request, and waiting on a request which hasn't started runs it on the waiting thread
+    class ResourceLoader
+    {
+    public:
+        static std::shared_ptr<ResourceRequest> Request(const std::shared_ptr<IResource>& resource, const std::string& file_path, const ResourcePriority priority);
+        static void Wait(const std::shared_ptr<ResourceRequest>& request);
+
+        // waits for everything that is loading, the calling thread helps
+        static void WaitAll();
+
+        // cancels what hasn't started and waits for the rest
+        static void Flush();
+
+        static uint32_t GetPendingCount();
+    };
+
+    // a resource which may still be loading
+    template <class T>
+    class ResourceHandle
+    {
+    public:
+        ResourceHandle() = default;
+        ResourceHandle(const std::shared_ptr<ResourceRequest>& request) : m_request(request) {}
+
+        // a resource which is already loaded
+        ResourceHandle(const std::shared_ptr<IResource>& resource)
+        {
+            m_request                  = std::make_shared<ResourceRequest>();
+            m_request->resource        = resource;
+            m_request->resource_cached = resource;
+            m_request->state           = ResourceLoadState::Ready;
+        }
+
+        bool IsValid()   const { return m_request != nullptr; }
+        bool IsLoading() const { return m_request && !m_request->IsDone(); }
+        bool IsReady()   const { return m_request && m_request->state == ResourceLoadState::Ready; }
+        bool IsFailed()  const { return !m_request || m_request->state == ResourceLoadState::Failed; }
+
+        // the resource that is being loaded, it can be referenced right away but is only usable once ready
+        std::shared_ptr<T> Get() const
+        {
+            if (!m_request)
+                return nullptr;
+
+            return std::static_pointer_cast<T>(IsReady() ? m_request->resource_cached : m_request->resource);
+        }
+
+        // the cached resource, or null if it failed to load
+        std::shared_ptr<T> Wait() const
+        {
+            ResourceLoader::Wait(m_request);
+            return IsReady() ? std::static_pointer_cast<T>(m_request->resource_cached) : nullptr;
+        }
+
+    private:
+        std::shared_ptr<ResourceRequest> m_request;
+    };
+}
@@ -19,7 +19,7 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES ========================
+//= INCLUDES ==================================
 #include "pch.h"
 #include "Camera.h"
 #include "Renderable.h"
@@ -30,9 +30,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../../Input/Input.h"
 #include "../../IO/FileStream.h"
 #include "../../Rendering/Renderer.h"
+#include "../../Rendering/RenderableRegistry.h"
 #include "../../Display/Display.h"
 #include "../RHI/RHI_Vertex.h"
-//===================================
+//=============================================
 
 //= NAMESPACES ===============
 using namespace Spartan::Math;
@@ -173,6 +174,11 @@ namespace Spartan
         return IsInViewFrustum(box);
     }
 
+    void Camera::QueryRenderables(const function<void(Renderable* renderable, uint32_t group_index)>& callback) const
+    {
+        RenderableRegistry::QueryFrustum(m_frustum, false, callback);
+    }
+
 	const Math::Ray Camera::ComputePickingRay()
 	{
         Vector3 ray_start     = GetEntity()->GetPosition();
@@ -191,28 +197,27 @@ namespace Spartan
 
         m_ray = ComputePickingRay();
 
-        // traces ray against all AABBs in the world
+        // traces ray against the bounding volume hierarchy, instanced renderables can be hit once per instance group
         vector<RayHit> hits;
         {
-            const vector<shared_ptr<Entity>>& entities = World::GetAllEntities();
-            for (const shared_ptr<Entity> entity : entities)
+            unordered_map<Entity*, float> distances;
+            RenderableRegistry::QueryRay(m_ray, [&distances](Renderable* renderable, uint32_t /*group_index*/, float distance)
             {
-                // Make sure there entity has a renderable
-                if (!entity->GetComponent<Renderable>())
-                    continue;
-
-                // Get object oriented bounding box
-                const BoundingBox& aabb = entity->GetComponent<Renderable>()->GetBoundingBox(BoundingBoxType::Transformed);
-
-                // Compute hit distance
-                float distance = m_ray.HitDistance(aabb);
-
-                // Don't store hit data if there was no hit
-                if (distance == Helper::INFINITY_)
-                    continue;
+                auto it = distances.find(renderable->GetEntity());
+                if (it == distances.end())
+                {
+                    distances[renderable->GetEntity()] = distance;
+                }
+                else
+                {
+                    it->second = min(it->second, distance);
+                }
+            });
 
+            for (const auto& [entity, distance] : distances)
+            {
                 hits.emplace_back(
-                    entity,                                             // Entity
+                    entity->shared_from_this(),                         // Entity
                     m_ray.GetStart() + m_ray.GetDirection() * distance, // Position
                     distance,                                           // Distance
                     distance == 0.0f                                    // Inside
@@ -119,6 +119,7 @@ namespace Spartan
         // frustum
         bool IsInViewFrustum(const Math::BoundingBox& bounding_box) const;
         bool IsInViewFrustum(std::shared_ptr<Renderable> renderable) const;
+        void QueryRenderables(const std::function<void(Renderable* renderable, uint32_t group_index)>& callback) const; // the ones in the frustum
 
         // first person control
         bool GetIsControlEnabled()             const { return m_first_person_control_enabled; }
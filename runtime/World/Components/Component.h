@@ -76,6 +76,10 @@ namespace Spartan
         // Runs every frame
         virtual void OnTick() {}
 
+        // Whether OnTick() can run in parallel with the other components of the same type (opt-in)
+        // Such a tick can read any transform, but must not set one
+        virtual bool IsTickThreadSafe() const { return false; }
+
         // Runs when the entity is being saved
         virtual void Serialize(FileStream* stream) {}
 
@@ -19,7 +19,7 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES ============================
+//= INCLUDES ==================================
 #include "pch.h"
 #include "Light.h"
 #include "Camera.h"
@@ -27,10 +27,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Entity.h"
 #include "../../IO/FileStream.h"
 #include "../../Rendering/Renderer.h"
+#include "../../Rendering/RenderableRegistry.h"
 #include "../../RHI/RHI_Texture2D.h"
 #include "../../RHI/RHI_TextureCube.h"
 #include "../../RHI/RHI_Texture2DArray.h"
-//=======================================
+//=============================================
 
 //= NAMESPACES ===============
 using namespace Spartan::Math;
@@ -133,7 +134,7 @@ namespace Spartan
         {
             UpdateMatrices();
 
-            SP_FIRE_EVENT(EventType::LightOnChanged);
+            SP_FIRE_EVENT_DATA(EventType::LightOnChanged, static_cast<void*>(this));
         }
     }
 
@@ -200,7 +201,7 @@ namespace Spartan
                 RefreshShadowMap();
             }
 
-            SP_FIRE_EVENT(EventType::LightOnChanged);
+            SP_FIRE_EVENT_DATA(EventType::LightOnChanged, static_cast<void*>(this));
         }
     }
 
@@ -229,7 +230,7 @@ namespace Spartan
         m_temperature_kelvin = temperature_kelvin;
         m_color_rgb          = Color(temperature_kelvin);
 
-        SP_FIRE_EVENT(EventType::LightOnChanged);
+        SP_FIRE_EVENT_DATA(EventType::LightOnChanged, static_cast<void*>(this));
     }
 
     void Light::SetColor(const Color& rgb)
@@ -259,7 +260,7 @@ namespace Spartan
         else if (rgb == Color::light_photo_flash)
             m_temperature_kelvin = 5500.0f;
 
-        SP_FIRE_EVENT(EventType::LightOnChanged);
+        SP_FIRE_EVENT_DATA(EventType::LightOnChanged, static_cast<void*>(this));
     }
 
     void Light::SetIntensity(const LightIntensity intensity)
@@ -315,7 +316,7 @@ namespace Spartan
             m_intensity_lumens = 0.0f;
         }
 
-        SP_FIRE_EVENT(EventType::LightOnChanged);
+        SP_FIRE_EVENT_DATA(EventType::LightOnChanged, static_cast<void*>(this));
     }
 
     void Light::SetIntensityLumens(const float lumens)
@@ -323,7 +324,7 @@ namespace Spartan
         m_intensity_lumens = lumens;
         m_intensity        = LightIntensity::custom;
 
-        SP_FIRE_EVENT(EventType::LightOnChanged);
+        SP_FIRE_EVENT_DATA(EventType::LightOnChanged, static_cast<void*>(this));
     }
 
     float Light::GetIntensityWatt(Camera* camera) const
@@ -375,7 +376,7 @@ namespace Spartan
 	{
         ComputeViewMatrix();
         ComputeProjectionMatrix();
-        SP_FIRE_EVENT(EventType::LightOnChanged);
+        SP_FIRE_EVENT_DATA(EventType::LightOnChanged, static_cast<void*>(this));
 	}
 
 	void Light::ComputeViewMatrix()
@@ -474,6 +475,12 @@ namespace Spartan
         return IsInViewFrustum(box, index);
     }
 
+    void Light::QueryRenderables(const uint32_t index, const function<void(Renderable* renderable, uint32_t group_index)>& callback) const
+    {
+        const bool ignore_depth = m_light_type == LightType::Directional; // orthographic
+        RenderableRegistry::QueryFrustum(m_frustums[index], ignore_depth, callback);
+    }
+
     void Light::RefreshShadowMap()
     {
         if (!IsFlagSet(LightFlags::Shadows))
@@ -80,6 +80,7 @@ namespace Spartan
 
         //= COMPONENT ================================
         void OnTick() override;
+        bool IsTickThreadSafe() const override { return true; } // only writes its own matrices
         void OnTransformChanged() override;
         void Serialize(FileStream* stream) override;
         void Deserialize(FileStream* stream) override;
@@ -132,6 +133,7 @@ namespace Spartan
         // frustum
         bool IsInViewFrustum(const Math::BoundingBox& bounding_box, const uint32_t index) const;
         bool IsInViewFrustum(Renderable* renderable, const uint32_t index) const;
+        void QueryRenderables(const uint32_t index, const std::function<void(Renderable* renderable, uint32_t group_index)>& callback) const; // the ones in the frustum
 
         // index
         void SetIndex(const uint32_t index) { m_index = index; }
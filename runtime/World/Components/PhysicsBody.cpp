@@ -167,7 +167,8 @@ namespace Spartan
     void PhysicsBody::OnTick()
     {
         // when the rigid body is inactive or we are in editor mode, allow the user to move/rotate it
-        if (!EngineFlags::IsFlagSet(EngineMode::Game))
+        // the entity's changed bit saves decomposing both transforms for every body, every frame
+        if (!EngineFlags::IsFlagSet(EngineMode::Game) && GetEntity()->HasTransformChanged())
         {
             if (GetPosition() != GetEntity()->GetPosition())
             {
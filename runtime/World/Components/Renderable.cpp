@@ -25,9 +25,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Entity.h"
 #include "../Rendering/Renderer.h"
 #include "../RHI/RHI_VertexBuffer.h"
+#include "../RHI/RHI_StructuredBuffer.h"
 #include "../../IO/FileStream.h"
 #include "../../Resource/ResourceCache.h"
 #include "../../Rendering/GridPartitioning.h"
+#include "../../Rendering/RenderableRegistry.h"
+#include "../../Rendering/meshoptimizer/meshoptimizer.h"
 //===========================================
 
 //= NAMESPACES ===============
@@ -37,6 +40,17 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    namespace
+    {
+        // occluders are rasterized on the cpu, so they need to be cheap
+        const uint32_t occluder_triangle_count_target = 256;
+        const uint32_t occluder_triangle_count_max    = 2048;
+        const float occluder_simplification_error     = 0.01f; // relative to the mesh extents, keeps the silhouette close to the real one
+
+        // below this many clusters, a compute dispatch costs more than drawing the whole thing
+        const uint32_t cluster_count_min = 32;
+    }
+
     Renderable::Renderable(weak_ptr<Entity> entity) : Component(entity)
     {
         SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_material_default,           bool);
@@ -52,6 +66,7 @@ namespace Spartan
 
     Renderable::~Renderable()
     {
+        RenderableRegistry::Remove(this);
         m_mesh = nullptr;
     }
     
@@ -85,6 +100,7 @@ namespace Spartan
         string model_name;
         stream->Read(&model_name);
         m_mesh = ResourceCache::GetByName<Mesh>(model_name).get();
+        m_occluder_geometry_dirty = true;
 
         // material
         stream->Read(&m_flags);
@@ -101,6 +117,11 @@ namespace Spartan
         }
     }
 
+    void Renderable::OnTransformChanged()
+    {
+        RenderableRegistry::SetDirty(this);
+    }
+
     void Renderable::SetGeometry(
         Mesh* mesh,
         const Math::BoundingBox aabb /*= Math::BoundingBox::Undefined*/,
@@ -114,6 +135,11 @@ namespace Spartan
         m_geometry_index_count       = index_count;
         m_geometry_vertex_offset     = vertex_offset;
         m_geometry_vertex_count      = vertex_count;
+        m_occluder_geometry_dirty    = true;
+        m_bounding_box_dirty         = true;
+        m_clusters_dirty             = true;
+        m_lods_dirty                 = true;
+        RenderableRegistry::SetDirty(this);
 
         if (!m_mesh)
             return;
@@ -152,7 +178,7 @@ namespace Spartan
 	const BoundingBox& Renderable::GetBoundingBox(const BoundingBoxType type, const uint32_t instance_group_index)
 	{
         // compute if dirty
-        if (m_bounding_box_dirty || m_transform_previous != GetEntity()->GetMatrix())
+        if (m_bounding_box_dirty || m_transform_version != GetEntity()->GetTransformVersion())
         {
             Matrix transform = GetEntity()->GetMatrix();
 
@@ -165,11 +191,11 @@ namespace Spartan
             {
                 // loop through each instance and expand the bounding box
                 m_bounding_box_instances = BoundingBox::Undefined;
-                for (const Matrix& instance_transform : m_instances)
+                for (const RHI_Instance& instance : m_instances)
                 {
                     // transform * instance_transform, this is not the order of operation the engine is using but in this case it works
                     // possibly due to how the transform is calculated, the space it's in and relative to what
-                    BoundingBox bounding_box_instance = m_bounding_box_untransformed.Transform(transform * instance_transform);
+                    BoundingBox bounding_box_instance = m_bounding_box_untransformed.Transform(transform * instance.GetMatrix());
                     m_bounding_box_instances.Merge(bounding_box_instance);
                 }
             }
@@ -185,7 +211,7 @@ namespace Spartan
                     BoundingBox bounding_box_group = BoundingBox::Undefined;
                     for (uint32_t i = start_index; i < group_end_index; i++)
                     {
-                        BoundingBox bounding_box_instance = m_bounding_box_untransformed.Transform(transform * m_instances[i]);
+                        BoundingBox bounding_box_instance = m_bounding_box_untransformed.Transform(transform * m_instances[i].GetMatrix());
                         bounding_box_group.Merge(bounding_box_instance);
                     }
 
@@ -194,7 +220,7 @@ namespace Spartan
                 }
             }
 
-            m_transform_previous = transform;
+            m_transform_version  = GetEntity()->GetTransformVersion();
             m_bounding_box_dirty = false;
         }
 
@@ -219,6 +245,65 @@ namespace Spartan
         return BoundingBox::Undefined;
 	}
 
+    const vector<Vector3>& Renderable::GetOccluderGeometry()
+    {
+        if (!m_occluder_geometry_dirty)
+            return m_occluder_geometry;
+
+        m_occluder_geometry.clear();
+        m_occluder_geometry_dirty = false;
+
+        if (!m_mesh || m_geometry_index_count == 0)
+            return m_occluder_geometry;
+
+        // acquire geometry
+        vector<uint32_t> indices;
+        vector<RHI_Vertex_PosTexNorTan> vertices;
+        GetGeometry(&indices, &vertices);
+
+        // simplify
+        if (indices.size() / 3 > occluder_triangle_count_target)
+        {
+            vector<uint32_t> indices_simplified(indices.size());
+            size_t index_count = meshopt_simplify(
+                indices_simplified.data(),
+                indices.data(),
+                indices.size(),
+                &vertices[0].pos[0],
+                vertices.size(),
+                sizeof(RHI_Vertex_PosTexNorTan),
+                occluder_triangle_count_target * 3,
+                occluder_simplification_error
+            );
+            indices_simplified.resize(index_count);
+            indices = move(indices_simplified);
+        }
+
+        // too complex to simplify without changing the silhouette, don't occlude with it
+        if (indices.size() / 3 > occluder_triangle_count_max)
+            return m_occluder_geometry;
+
+        // de-index, the rasterizer consumes triangle lists
+        m_occluder_geometry.reserve(indices.size());
+        for (uint32_t index : indices)
+        {
+            const RHI_Vertex_PosTexNorTan& vertex = vertices[index];
+            m_occluder_geometry.emplace_back(vertex.pos[0], vertex.pos[1], vertex.pos[2]);
+        }
+
+        return m_occluder_geometry;
+    }
+
+    void Renderable::SetInstanceGroupVisible(const uint32_t group_index, const bool visible)
+    {
+        if (m_instance_group_visible.size() != m_instance_group_end_indices.size())
+        {
+            m_instance_group_visible.assign(m_instance_group_end_indices.size(), 1);
+        }
+
+        m_instance_group_visible[group_index] = visible ? 1 : 0;
+    }
+
 	shared_ptr<Material> Renderable::SetMaterial(const shared_ptr<Material>& material)
     {
         SP_ASSERT(material != nullptr);
@@ -231,6 +316,11 @@ namespace Spartan
         // set to false otherwise material won't serialize/deserialize
         m_material_default = false;
 
+        RenderableRegistry::SetDirty(this);
+
+        // the renderer gives the material a bindless slot, if it doesn't have one yet
+        SP_FIRE_EVENT_DATA(EventType::MaterialOnChanged, static_cast<void*>(m_material));
+
         return _material;
     }
 
@@ -275,6 +365,60 @@ namespace Spartan
         return m_mesh->GetVertexBuffer();
     }
 
+    RHI_StructuredBuffer* Renderable::GetClusterBuffer() const
+    {
+        if (!m_mesh)
+            return nullptr;
+
+        return m_mesh->GetClusterBuffer();
+    }
+
+    void Renderable::UpdateClusters()
+    {
+        if (!m_clusters_dirty || !m_mesh)
+            return;
+
+        m_clusters_dirty = false;
+        m_mesh->GetClusters(m_geometry_index_offset, m_geometry_index_count, &m_cluster_offset, &m_cluster_count);
+        if (m_cluster_count < cluster_count_min || !m_mesh->GetClusterBuffer())
+        {
+            m_cluster_count             = 0;
+            m_cluster_args_buffer       = nullptr;
+            m_cluster_draw_count_buffer = nullptr;
+            return;
+        }
+
+        // two sets of draw arguments, which can hold all the clusters, and their counts, with no clusters to start with
+        vector<RHI_IndirectDrawArgsIndexed> args(m_cluster_count * 2);
+        array<uint32_t, 2> draw_counts = { 0, 0 };
+        m_cluster_args_buffer          = make_shared<RHI_StructuredBuffer>(static_cast<uint32_t>(args.size() * sizeof(RHI_IndirectDrawArgsIndexed)), 1, "cluster_args", false, args.data());
+        m_cluster_draw_count_buffer    = make_shared<RHI_StructuredBuffer>(static_cast<uint32_t>(sizeof(draw_counts)), 1, "cluster_draw_count", false, draw_counts.data());
+        m_cluster_args_index           = 0;
+    }
+
+    void Renderable::UpdateLods()
+    {
+        if (!m_lods_dirty || !m_mesh)
+            return;
+
+        m_lods_dirty = false;
+        m_lods.clear();
+
+        vector<MeshLod> lods;
+        m_mesh->GetLods(m_geometry_index_offset, &lods);
+        if (lods.empty())
+            return;
+
+        m_lods.emplace_back(m_geometry_index_offset, m_geometry_index_count);
+        for (const MeshLod& lod : lods)
+        {
+            if (m_lods.size() == mesh_lod_count_max)
+                break;
+
+            m_lods.emplace_back(lod.index_offset, lod.index_count);
+        }
+    }
+
     const string& Renderable::GetMeshName() const
     {
         static string no_mesh = "N/A";
@@ -284,25 +428,41 @@ namespace Spartan
         return m_mesh->GetObjectName();
     }
 
-    void Renderable::SetInstances(const vector<Matrix>& instances)
+    void Renderable::SetInstances(const vector<Matrix>& instances, const float group_cell_size)
     {
-        m_instances = instances;
-
-        grid_partitioning::reorder_instances_into_cell_chunks(m_instances, m_instance_group_end_indices);
+        vector<Matrix> transforms = instances;
+        grid_partitioning::reorder_instances_into_cell_chunks(transforms, m_instance_group_end_indices, group_cell_size);
+
+        // pack the transforms, the shaders rebuild the matrices (see vulkan_pipeline.cpp for the vertex input layout)
+        bool scale_non_uniform = false;
+        m_instances.clear();
+        m_instances.reserve(transforms.size());
+        for (const Matrix& transform : transforms)
+        {
+            const Vector3 scale = transform.GetScale();
+            scale_non_uniform  |= abs(scale.x - scale.y) > 0.001f || abs(scale.x - scale.z) > 0.001f;
+            m_instances.emplace_back(transform.GetTranslation(), transform.GetRotation(), max(scale.x, max(scale.y, scale.z)));
+        }
 
-        // we are mapping 4 Vector4s as 4 rows (see vulkan_pipeline.cpp, line 246) in order to get 1 matrix (HLSL side)
-        // but the matrix memory layout is column-major, so we need to transpose to get it as row-major
-        vector<Matrix> instances_transposed;
-        instances_transposed.reserve(m_instances.size());
-        for (const auto& instance : m_instances)
+        if (scale_non_uniform)
         {
-            instances_transposed.push_back(instance.Transposed());
+            SP_LOG_WARNING("Instances with a non-uniform scale are approximated with their largest scale axis");
         }
 
-        m_instance_buffer = make_shared<RHI_VertexBuffer>(false, "instance_buffer");
-        m_instance_buffer->Create<Matrix>(instances_transposed);
+        // the instances are read by the instance culling pass, but also bound directly as a vertex buffer (when not culled on the gpu)
+        uint32_t size     = static_cast<uint32_t>(sizeof(RHI_Instance) * m_instances.size());
+        m_instance_buffer = make_shared<RHI_StructuredBuffer>(size, 1, "instance_buffer", false, m_instances.data());
+
+        // the culled instances, which are compacted by the instance culling pass, into a region per lod
+        m_instance_buffer_visible = make_shared<RHI_StructuredBuffer>(size * mesh_lod_count_max, 1, "instance_buffer_visible", false);
+
+        // two sets of draw arguments, one per lod, with no instances to start with
+        array<RHI_IndirectDrawArgsIndexed, 2 * mesh_lod_count_max> indirect_args;
+        m_indirect_args_buffer = make_shared<RHI_StructuredBuffer>(static_cast<uint32_t>(sizeof(indirect_args)), 1, "indirect_args", false, indirect_args.data());
+        m_indirect_args_index  = 0;
 
         m_bounding_box_dirty = true;
+        RenderableRegistry::SetDirty(this);
     }
 
 	bool Renderable::ReadyToRender() const
@@ -339,5 +499,11 @@ namespace Spartan
             m_flags  &= ~static_cast<uint32_t>(flag);
             disabled  = true;
         }
+
+        // visibility is written by the renderer, which keeps its own copy in the registry
+        if ((enabled || disabled) && flag == RenderableFlags::CastsShadows)
+        {
+            RenderableRegistry::SetDirty(this);
+        }
     }
 }
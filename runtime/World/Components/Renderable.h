@@ -27,6 +27,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Rendering/Renderer_Definitions.h"
 #include "../../Math/Matrix.h"
 #include "../../Math/BoundingBox.h"
+#include "../../RHI/RHI_Vertex.h"
 //============================================
 
 namespace Spartan
@@ -35,6 +36,7 @@ namespace Spartan
     class Material;
     class RHI_VertexBuffer;
     class RHI_IndexBuffer;
+    class RHI_StructuredBuffer;
 
     enum class BoundingBoxType
     {
@@ -61,6 +63,7 @@ namespace Spartan
         // icomponent
         void Serialize(FileStream* stream) override;
         void Deserialize(FileStream* stream) override;
+        void OnTransformChanged() override;
 
         // geometry
         void SetGeometry(
@@ -96,10 +99,35 @@ namespace Spartan
         const std::string& GetMeshName() const;
 
         // instancing
-        bool HasInstancing() const                  { return !m_instances.empty(); }
-        RHI_VertexBuffer* GetInstanceBuffer() const { return m_instance_buffer.get(); }
-        uint32_t GetInstanceCount()  const          { return static_cast<uint32_t>(m_instances.size()); }
-        void SetInstances(const std::vector<Math::Matrix>& instances);
+        bool HasInstancing() const                      { return !m_instances.empty(); }
+        RHI_StructuredBuffer* GetInstanceBuffer() const { return m_instance_buffer.get(); }
+        uint32_t GetInstanceCount()  const              { return static_cast<uint32_t>(m_instances.size()); }
+        void SetInstances(const std::vector<Math::Matrix>& instances, const float group_cell_size = 0.0f); // 0 for the default cell size
+
+        // gpu driven instancing, a compute pass culls the instances and writes the visible ones along with the draw arguments
+        // the arguments are double buffered, one set is drawn with while the other one is reset for the next cull
+        // each set holds the arguments of every lod, whose visible instances are in their own region of the visible buffer
+        RHI_StructuredBuffer* GetInstanceBufferVisible() const { return m_instance_buffer_visible.get(); }
+        RHI_StructuredBuffer* GetIndirectArgsBuffer() const    { return m_indirect_args_buffer.get(); }
+        uint32_t GetIndirectArgsIndex() const                  { return m_indirect_args_index; }
+        void SwapIndirectArgs()                                { m_indirect_args_index = (m_indirect_args_index + 1) % 2; }
+
+        // gpu driven cluster culling, for large meshes, a compute pass culls the clusters and writes the draw arguments of the visible ones
+        // the arguments are double buffered as well, along with their count
+        void UpdateClusters(); // once the mesh is complete
+        uint32_t GetClusterOffset() const                       { return m_cluster_offset; }
+        uint32_t GetClusterCount() const                        { return m_cluster_count; }
+        RHI_StructuredBuffer* GetClusterBuffer() const;
+        RHI_StructuredBuffer* GetClusterArgsBuffer() const      { return m_cluster_args_buffer.get(); }
+        RHI_StructuredBuffer* GetClusterDrawCountBuffer() const { return m_cluster_draw_count_buffer.get(); }
+        uint32_t GetClusterArgsIndex() const                    { return m_cluster_args_index; }
+        void SwapClusterArgs()                                  { m_cluster_args_index = (m_cluster_args_index + 1) % 2; }
+
+        // levels of detail, the first one is the full detail geometry, the rest are simplified versions of it (if the mesh has any)
+        void UpdateLods(); // once the mesh is complete
+        uint32_t GetLodCount() const                         { return m_lods.empty() ? 1 : static_cast<uint32_t>(m_lods.size()); }
+        uint32_t GetLodIndexOffset(const uint32_t lod) const { return lod < m_lods.size() ? m_lods[lod].first  : m_geometry_index_offset; }
+        uint32_t GetLodIndexCount(const uint32_t lod) const  { return lod < m_lods.size() ? m_lods[lod].second : m_geometry_index_count; }
 
         // properties
         uint32_t GetIndexOffset() const  { return m_geometry_index_offset; }
@@ -109,10 +137,22 @@ namespace Spartan
         bool ReadyToRender() const;
         bool IsVisible() { return IsFlagSet(RenderableFlags::IsInViewFrustum) && !IsFlagSet(RenderableFlags::IsOccluded); }
 
+        // occlusion
+        const std::vector<Math::Vector3>& GetOccluderGeometry(); // a simplified triangle list (object space), empty if the mesh is too complex to be an occluder
+        bool IsInstanceGroupVisible(const uint32_t group_index) const { return group_index >= m_instance_group_visible.size() || m_instance_group_visible[group_index] != 0; }
+        void SetInstanceGroupVisible(const uint32_t group_index, const bool visible);
+
         // flags
         bool IsFlagSet(const RenderableFlags flag) { return m_flags & flag; }
+        uint32_t GetFlags() const                  { return m_flags; }
         void SetFlag(const RenderableFlags flag, const bool enable = true);
 
+        // the slot of this renderable in the RenderableRegistry, if it's registered
+        void SetRegistrySlot(const Renderer_Entity type, const uint32_t index) { m_registry_type = type; m_registry_index = index; }
+        Renderer_Entity GetRegistryType() const                                { return m_registry_type; }
+        uint32_t GetRegistryIndex() const                                      { return m_registry_index; }
+        std::vector<uint32_t>& GetRegistryLeaves()                             { return m_registry_leaves; } // bvh leaves, one per instance group
+
     private:
         // geometry/mesh
         uint32_t m_geometry_index_offset  = 0;
@@ -131,12 +171,37 @@ namespace Spartan
         Material* m_material    = nullptr;
 
         // instancing
-        std::vector<Math::Matrix> m_instances;
+        std::vector<RHI_Instance> m_instances; // what the instance buffer holds, kept for the bounding boxes
         std::vector<uint32_t> m_instance_group_end_indices;
-        std::shared_ptr<RHI_VertexBuffer> m_instance_buffer;
+        std::shared_ptr<RHI_StructuredBuffer> m_instance_buffer;
+        std::shared_ptr<RHI_StructuredBuffer> m_instance_buffer_visible;
+        std::shared_ptr<RHI_StructuredBuffer> m_indirect_args_buffer;
+        uint32_t m_indirect_args_index = 0;
+        std::vector<uint8_t> m_instance_group_visible;
+
+        // clusters
+        uint32_t m_cluster_offset     = 0;
+        uint32_t m_cluster_count      = 0;
+        uint32_t m_cluster_args_index = 0;
+        bool m_clusters_dirty         = true;
+        std::shared_ptr<RHI_StructuredBuffer> m_cluster_args_buffer;
+        std::shared_ptr<RHI_StructuredBuffer> m_cluster_draw_count_buffer;
+
+        // lods
+        std::vector<std::pair<uint32_t, uint32_t>> m_lods; // index offset and index count
+        bool m_lods_dirty = true;
+
+        // occlusion
+        std::vector<Math::Vector3> m_occluder_geometry;
+        bool m_occluder_geometry_dirty = true;
+
+        // registry
+        Renderer_Entity m_registry_type = Renderer_Entity::Geometry;
+        uint32_t m_registry_index       = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> m_registry_leaves;
 
         // misc
-        Math::Matrix m_transform_previous = Math::Matrix::Identity;
-        uint32_t m_flags                  = RenderableFlags::IsInViewFrustum | RenderableFlags::CastsShadows;
+        uint32_t m_transform_version = 0; // the entity's transform version, which the bounding boxes were computed with
+        uint32_t m_flags             = RenderableFlags::IsInViewFrustum | RenderableFlags::CastsShadows;
     };
 }
@@ -46,14 +46,16 @@ namespace Spartan
 
         bool generate_height_points_from_height_map(vector<float>& height_data_out, shared_ptr<RHI_Texture> height_texture, float min_y, float max_y)
         {
-            vector<byte> height_data = height_texture->GetMip(0, 0).bytes;
+            span<const byte> height_bytes = height_texture->GetMip(0, 0).GetBytes();
+            vector<byte> height_data(height_bytes.begin(), height_bytes.end());
 
             // if the data is not there, load it
             if (height_data.empty())
             {
                 if (height_texture->LoadFromFile(height_texture->GetResourceFilePath()))
                 {
-                    height_data = height_texture->GetMip(0, 0).bytes;
+                    height_bytes = height_texture->GetMip(0, 0).GetBytes();
+                    height_data.assign(height_bytes.begin(), height_bytes.end());
 
                     if (height_data.empty())
                     {
@@ -298,7 +300,7 @@ namespace Spartan
             };
 
             uint32_t vertex_count = static_cast<uint32_t>(vertices.size());
-            ThreadPool::ParallelLoop(compute_vertex_normals_tangents, vertex_count);
+            ThreadPool::ParallelFor(compute_vertex_normals_tangents, vertex_count);
         }
 
         float get_random_float(float x, float y)
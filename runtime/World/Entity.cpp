@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "pch.h"
 #include "Entity.h"
 #include "World.h"
+#include "TransformHierarchy.h"
 #include "Components/Camera.h"
 #include "Components/Constraint.h"
 #include "Components/Light.h"
@@ -98,12 +99,13 @@ namespace Spartan
 
     Entity::~Entity()
     {
+        TransformHierarchy::Remove(this);
         m_components.fill(nullptr);
     }
 
     void Entity::Initialize()
     {
-        UpdateTransform();
+        SetTransformDirty();
     }
 
     shared_ptr<Entity> Entity::Clone()
@@ -133,20 +135,6 @@ namespace Spartan
         }
     }
 
-	void Entity::Tick()
-    {
-        if (!m_is_active)
-            return;
-
-        for (shared_ptr<Component>& component : m_components)
-        {
-            if (component)
-            {
-                component->OnTick();
-            }
-        }
-    }
-
     void Entity::Serialize(FileStream* stream)
     {
         // BASIC DATA
@@ -231,7 +219,7 @@ namespace Spartan
                 }
             }
 
-            UpdateTransform();
+            SetTransformDirty();
         }
 
         // COMPONENTS
@@ -293,8 +281,8 @@ namespace Spartan
             AcquireChildren();
         }
 
-        // resolve the world so that systems like the renderer become aware of it
-        SP_FIRE_EVENT(EventType::WorldResolve);
+        // let systems like the renderer become aware of it
+        SP_FIRE_EVENT_DATA(EventType::EntityOnChanged, this);
     }
 
     bool Entity::IsActiveRecursively()
@@ -344,39 +332,45 @@ namespace Spartan
             }
         }
 
-        SP_FIRE_EVENT(EventType::WorldResolve);
+        SP_FIRE_EVENT_DATA(EventType::EntityOnChanged, this);
     }
 
-    void Entity::UpdateTransform()
+    void Entity::SetTransformDirty(const bool propagation_root)
     {
-        // compute local transform
-        m_matrix_local = Matrix(m_position_local, m_rotation_local, m_scale_local);
+        // a dirty entity has dirty descendants and is already covered by a pending propagation
+        if (m_matrix_dirty)
+            return;
 
-        // compute world transform
-        if (!m_parent.expired())
-        {
-            m_matrix = m_matrix_local * m_parent.lock()->GetMatrix();
-        }
-        else
-        {
-            m_matrix = m_matrix_local;
-        }
+        m_matrix_dirty = true;
+        m_transform_version++;
 
-        // update children
         for (Entity* child : m_children)
         {
-            child->UpdateTransform();
+            child->SetTransformDirty(false);
         }
 
-        for (shared_ptr<Component>& component : m_components)
+        // only the root of the subtree is queued, the propagation walks down from it
+        if (propagation_root)
         {
-            if (component)
-            {
-                component->OnTransformChanged();
-            }
+            TransformHierarchy::SetDirty(this);
         }
     }
 
+    void Entity::ResolveTransform() const
+    {
+        // the parent resolves first (if dirty), so this walks up only as far as the stale part of the hierarchy
+        m_matrix_local = Matrix(m_position_local, m_rotation_local, m_scale_local);
+
+        shared_ptr<Entity> parent = m_parent.lock();
+        m_matrix                  = parent ? m_matrix_local * parent->GetMatrix() : m_matrix_local;
+        m_matrix_dirty            = false;
+    }
+
+    bool Entity::HasTransformChanged() const
+    {
+        return m_transform_frame == TransformHierarchy::GetFrame();
+    }
+
     void Entity::SetPosition(const Vector3& position)
     {
         if (GetPosition() == position)
@@ -391,7 +385,7 @@ namespace Spartan
             return;
 
         m_position_local = position;
-        UpdateTransform();
+        SetTransformDirty();
     }
 
     void Entity::SetRotation(const Quaternion& rotation)
@@ -408,7 +402,7 @@ namespace Spartan
             return;
 
         m_rotation_local = rotation;
-        UpdateTransform();
+        SetTransformDirty();
     }
 
     void Entity::SetScale(const Vector3& scale)
@@ -431,7 +425,7 @@ namespace Spartan
         m_scale_local.y = (m_scale_local.y == 0.0f) ? Helper::SMALL_FLOAT : m_scale_local.y;
         m_scale_local.z = (m_scale_local.z == 0.0f) ? Helper::SMALL_FLOAT : m_scale_local.z;
 
-        UpdateTransform();
+        SetTransformDirty();
     }
 
     void Entity::Translate(const Vector3& delta)
@@ -509,8 +503,6 @@ namespace Spartan
 
     void Entity::SetParent(weak_ptr<Entity> new_parent_in)
     {
-        lock_guard lock(m_mutex_parent);
-
         shared_ptr<Entity> new_parent = new_parent_in.lock();
         shared_ptr<Entity> parent     = m_parent.lock();
 
@@ -529,8 +521,8 @@ namespace Spartan
             {
                 for (Entity* child : m_children)
                 {
-                    child->m_parent = m_parent; // directly setting parent
-                    child->UpdateTransform();   // update transform if needed
+                    child->m_parent = m_parent;  // directly setting parent
+                    child->SetTransformDirty(); // update transform if needed
                 }
         
                 m_children.clear();
@@ -550,18 +542,18 @@ namespace Spartan
             new_parent->AddChild(this);
         }
 
-        if ((parent && !new_parent) || (!parent && new_parent))
+        m_parent = new_parent_in;
+
+        // the world transform is relative to the new parent (if any), so it has to be propagated
+        if (parent != new_parent)
         {
-            UpdateTransform();
+            SetTransformDirty();
         }
-
-        m_parent = new_parent_in;
     }
 
     void Entity::AddChild(Entity* child)
     {
         SP_ASSERT(child != nullptr);
-        lock_guard lock(m_mutex_children);
 
         // ensure that the child is not this transform
         if (child->GetObjectId() == GetObjectId())
@@ -582,8 +574,6 @@ namespace Spartan
         if (child->GetObjectId() == GetObjectId())
             return;
 
-        lock_guard lock(m_mutex_children);
-
         // remove the child
         m_children.erase(remove_if(m_children.begin(), m_children.end(), [child](Entity* vec_transform) { return vec_transform->GetObjectId() == child->GetObjectId(); }), m_children.end());
 
@@ -599,7 +589,6 @@ namespace Spartan
     // this is a recursive function, the children will also find their own children and so on
     void Entity::AcquireChildren()
     {
-        lock_guard lock(m_mutex_children);
         m_children.clear();
         m_children.shrink_to_fit();
 
@@ -666,9 +655,4 @@ namespace Spartan
 
         return nullptr;
     }
-
-    Matrix Entity::GetParentTransformMatrix() const
-    {
-        return HasParent() ? GetParent()->GetMatrix() : Matrix::Identity;
-    }
 }
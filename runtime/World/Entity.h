@@ -42,7 +42,6 @@ namespace Spartan
         // core
         void OnStart(); // runs once, before the simulation ends
         void OnStop();  // runs once, after the simulation ends
-        void Tick();    // runs every frame
 
         // io
         void Serialize(FileStream* stream);
@@ -77,8 +76,8 @@ namespace Spartan
             component->SetType(type);
             component->OnInitialize();
 
-            // make the scene resolve
-            SP_FIRE_EVENT(EventType::WorldResolve);
+            // let systems like the renderer know
+            SP_FIRE_EVENT_DATA(EventType::EntityOnChanged, this);
 
             return component;
         }
@@ -101,28 +100,28 @@ namespace Spartan
             const ComponentType component_type = Component::TypeToEnum<T>();
             m_components[static_cast<uint32_t>(component_type)] = nullptr;
 
-            SP_FIRE_EVENT(EventType::WorldResolve);
+            SP_FIRE_EVENT_DATA(EventType::EntityOnChanged, this);
         }
 
         void RemoveComponentById(uint64_t id);
         const auto& GetAllComponents() const { return m_components; }
 
         //= POSITION ======================================================================
-        Math::Vector3 GetPosition()             const { return m_matrix.GetTranslation(); }
+        Math::Vector3 GetPosition()             const { return GetMatrix().GetTranslation(); }
         const Math::Vector3& GetPositionLocal() const { return m_position_local; }
         void SetPosition(const Math::Vector3& position);
         void SetPositionLocal(const Math::Vector3& position);
         //=================================================================================
 
         //= ROTATION ======================================================================
-        Math::Quaternion GetRotation()             const { return m_matrix.GetRotation(); }
+        Math::Quaternion GetRotation()             const { return GetMatrix().GetRotation(); }
         const Math::Quaternion& GetRotationLocal() const { return m_rotation_local; }
         void SetRotation(const Math::Quaternion& rotation);
         void SetRotationLocal(const Math::Quaternion& rotation);
         //=================================================================================
 
         //= SCALE ================================================================
-        Math::Vector3 GetScale()             const { return m_matrix.GetScale(); }
+        Math::Vector3 GetScale()             const { return GetMatrix().GetScale(); }
         const Math::Vector3& GetScaleLocal() const { return m_scale_local; }
         void SetScale(const Math::Vector3& scale);
         void SetScaleLocal(const Math::Vector3& scale);
@@ -160,33 +159,42 @@ namespace Spartan
         std::vector<Entity*>& GetChildren()       { return m_children; }
         //===============================================================================================
 
-        const Math::Matrix& GetMatrix() const              { return m_matrix; }
-        const Math::Matrix& GetLocalMatrix() const         { return m_matrix_local; }
+        //= TRANSFORM =======================================================================================================
+        const Math::Matrix& GetMatrix() const              { if (m_matrix_dirty) ResolveTransform(); return m_matrix; }
+        const Math::Matrix& GetLocalMatrix() const         { if (m_matrix_dirty) ResolveTransform(); return m_matrix_local; }
         const Math::Matrix& GetMatrixPrevious() const      { return m_matrix_previous; }
         void SetMatrixPrevious(const Math::Matrix& matrix) { m_matrix_previous = matrix; }
+        // the version changes whenever the transform does, the changed bit only for the frame in which it was propagated
+        uint32_t GetTransformVersion() const               { return m_transform_version; }
+        bool HasTransformChanged() const;
+        //===================================================================================================================
 
     private:
         std::atomic<bool> m_is_active = true;
         bool m_hierarchy_visibility   = true;
         std::array<std::shared_ptr<Component>, 13> m_components;
 
-        void UpdateTransform();
-        Math::Matrix GetParentTransformMatrix() const;
+        void SetTransformDirty(const bool propagation_root = true);
+        void ResolveTransform() const;
 
         // local
         Math::Vector3 m_position_local    = Math::Vector3::Zero;
         Math::Quaternion m_rotation_local = Math::Quaternion::Identity;
         Math::Vector3 m_scale_local       = Math::Vector3::One;
 
-        Math::Matrix m_matrix          = Math::Matrix::Identity;
-        Math::Matrix m_matrix_previous = Math::Matrix::Identity;
-        Math::Matrix m_matrix_local    = Math::Matrix::Identity;
+        mutable Math::Matrix m_matrix       = Math::Matrix::Identity;
+        mutable Math::Matrix m_matrix_local = Math::Matrix::Identity;
+        Math::Matrix m_matrix_previous      = Math::Matrix::Identity;
+
+        // propagation, see TransformHierarchy
+        mutable bool m_matrix_dirty  = false; // the local or an ancestor's transform changed, the matrices are stale
+        bool m_transform_pending     = false; // waiting for the next propagation, as the root of a changed subtree
+        uint64_t m_transform_frame   = 0;     // the last frame in which the transform was propagated
+        uint32_t m_transform_version = 0;
 
         std::weak_ptr<Entity> m_parent;  // the parent of this entity
         std::vector<Entity*> m_children; // the children of this entity
 
-        // misc
-        std::mutex m_mutex_children;
-        std::mutex m_mutex_parent;
+        friend class TransformHierarchy;
     };
 }
@@ -0,0 +1,251 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==================
+#include "pch.h"
+#include "TransformHierarchy.h"
+#include "Entity.h"
+#include "../Core/ThreadPool.h"
+#include <xmmintrin.h>
+//=============================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    namespace
+    {
+        // below this, a depth is cheaper to do on the calling thread
+        const uint32_t parallel_threshold = 256;
+
+        mutex mutex_pending;
+        vector<Entity*> pending;
+        uint64_t frame = 0;
+
+        // the changed subtrees, flattened depth after depth
+        vector<Entity*> entities;
+        vector<uint32_t> parents; // index into the arrays, or none for the roots
+        vector<Matrix> locals;
+        vector<Matrix> worlds;
+        vector<uint32_t> depth_offsets;
+        vector<Entity*> roots;
+
+        const uint32_t parent_none = numeric_limits<uint32_t>::max();
+
+        // world = local * parent, the matrices are stored column after column (and used with row vectors)
+        // so every column of the result is a combination of the columns of local, weighed by a column of parent
+        void multiply(const Matrix& local, const Matrix& parent, Matrix& world)
+        {
+            const float* a = reinterpret_cast<const float*>(&local);
+            const float* b = reinterpret_cast<const float*>(&parent);
+            float* out     = reinterpret_cast<float*>(&world);
+
+            const __m128 a0 = _mm_loadu_ps(a + 0);
+            const __m128 a1 = _mm_loadu_ps(a + 4);
+            const __m128 a2 = _mm_loadu_ps(a + 8);
+            const __m128 a3 = _mm_loadu_ps(a + 12);
+
+            for (uint32_t column = 0; column < 4; column++)
+            {
+                const float* b_column = b + column * 4;
+
+                __m128 result = _mm_mul_ps(a0, _mm_set1_ps(b_column[0]));
+                result        = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(b_column[1])));
+                result        = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(b_column[2])));
+                result        = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(b_column[3])));
+
+                _mm_storeu_ps(out + column * 4, result);
+            }
+        }
+
+        template<typename Function>
+        void for_range(const uint32_t start, const uint32_t end, Function&& function)
+        {
+            const uint32_t count = end - start;
+            if (count < parallel_threshold)
+            {
+                function(start, end);
+                return;
+            }
+
+            ThreadPool::ParallelFor([start, &function](uint32_t work_start, uint32_t work_end)
+            {
+                function(start + work_start, start + work_end);
+            }, count);
+        }
+    }
+
+    void TransformHierarchy::Tick()
+    {
+        frame++;
+        Propagate();
+    }
+
+    void TransformHierarchy::Propagate()
+    {
+        // take the roots of the changed subtrees, a root with a changed ancestor is covered by that ancestor
+        roots.clear();
+        {
+            lock_guard lock(mutex_pending);
+
+            for (Entity* entity : pending)
+            {
+                bool has_pending_ancestor = false;
+                for (shared_ptr<Entity> parent = entity->GetParent(); parent && !has_pending_ancestor; parent = parent->GetParent())
+                {
+                    has_pending_ancestor = parent->m_transform_pending;
+                }
+
+                if (!has_pending_ancestor)
+                {
+                    roots.emplace_back(entity);
+                }
+            }
+
+            for (Entity* entity : pending)
+            {
+                entity->m_transform_pending = false;
+            }
+
+            pending.clear();
+        }
+
+        if (roots.empty())
+            return;
+
+        // flatten the subtrees, every depth follows the previous one, so parents are always computed before their children
+        entities.clear();
+        parents.clear();
+        depth_offsets.clear();
+        for (Entity* root : roots)
+        {
+            entities.emplace_back(root);
+            parents.emplace_back(parent_none);
+        }
+
+        uint32_t depth_start = 0;
+        while (depth_start < static_cast<uint32_t>(entities.size()))
+        {
+            const uint32_t depth_end = static_cast<uint32_t>(entities.size());
+            depth_offsets.emplace_back(depth_start);
+
+            for (uint32_t i = depth_start; i < depth_end; i++)
+            {
+                for (Entity* child : entities[i]->m_children)
+                {
+                    entities.emplace_back(child);
+                    parents.emplace_back(i);
+                }
+            }
+
+            depth_start = depth_end;
+        }
+        depth_offsets.emplace_back(static_cast<uint32_t>(entities.size()));
+
+        const uint32_t count = static_cast<uint32_t>(entities.size());
+        locals.resize(count);
+        worlds.resize(count);
+
+        // local matrices, independent of each other
+        for_range(0, count, [](uint32_t start, uint32_t end)
+        {
+            for (uint32_t i = start; i < end; i++)
+            {
+                const Entity* entity = entities[i];
+                locals[i]            = Matrix(entity->m_position_local, entity->m_rotation_local, entity->m_scale_local);
+            }
+        });
+
+        // the roots, relative to their (unchanged) parents
+        for (uint32_t i = depth_offsets[0]; i < depth_offsets[1]; i++)
+        {
+            shared_ptr<Entity> parent = entities[i]->GetParent();
+            if (parent)
+            {
+                multiply(locals[i], parent->GetMatrix(), worlds[i]);
+            }
+            else
+            {
+                worlds[i] = locals[i];
+            }
+        }
+
+        // the rest, depth after depth
+        for (uint32_t depth = 1; depth + 1 < static_cast<uint32_t>(depth_offsets.size()); depth++)
+        {
+            for_range(depth_offsets[depth], depth_offsets[depth + 1], [](uint32_t start, uint32_t end)
+            {
+                for (uint32_t i = start; i < end; i++)
+                {
+                    multiply(locals[i], worlds[parents[i]], worlds[i]);
+                }
+            });
+        }
+
+        // write back and notify, components (like renderables) update shared state, so this stays on the calling thread
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Entity* entity            = entities[i];
+            entity->m_matrix_local    = locals[i];
+            entity->m_matrix          = worlds[i];
+            entity->m_matrix_dirty    = false;
+            entity->m_transform_frame = frame;
+
+            for (const shared_ptr<Component>& component : entity->m_components)
+            {
+                if (component)
+                {
+                    component->OnTransformChanged();
+                }
+            }
+        }
+    }
+
+    void TransformHierarchy::SetDirty(Entity* entity)
+    {
+        lock_guard lock(mutex_pending);
+
+        if (!entity->m_transform_pending)
+        {
+            entity->m_transform_pending = true;
+            pending.emplace_back(entity);
+        }
+    }
+
+    void TransformHierarchy::Remove(Entity* entity)
+    {
+        lock_guard lock(mutex_pending);
+
+        if (entity->m_transform_pending)
+        {
+            pending.erase(remove(pending.begin(), pending.end(), entity), pending.end());
+            entity->m_transform_pending = false;
+        }
+    }
+
+    uint64_t TransformHierarchy::GetFrame()
+    {
+        return frame;
+    }
+}
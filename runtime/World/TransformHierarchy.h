@@ -0,0 +1,53 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =========
+#include <cstdint>
+//====================
+
+namespace Spartan
+{
+    class Entity;
+
+    // propagates the transforms of the entities which moved, once per frame
+    // the changed subtrees are flattened into contiguous, depth sorted arrays, so that every depth is a simd loop over matrices
+    // entities resolve their own world matrix lazily in between, so reading a transform right after setting it is still correct
+    class TransformHierarchy
+    {
+    public:
+        // main thread, before the components tick
+        static void Tick();
+
+        // main thread, propagates what changed since, within the same frame
+        // done before components tick in parallel, so that they only read resolved matrices and never resolve one lazily,
+        // and after every tick phase, so that what was moved in the frame is propagated (and seen by the renderer) in the same frame
+        static void Propagate();
+
+        // any thread, the entity and its descendants are propagated by the next Tick()
+        static void SetDirty(Entity* entity);
+        static void Remove(Entity* entity);
+
+        // incremented by every Tick(), entities remember the frame in which they were last propagated
+        static uint64_t GetFrame();
+    };
+}
@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "pch.h"
 #include "World.h"
 #include "Entity.h"
+#include "TransformHierarchy.h"
 #include "Components/Camera.h"
 #include "Components/Light.h"
 #include "Components/AudioListener.h"
@@ -32,6 +33,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Resource/ResourceCache.h"
 #include "../IO/FileStream.h"
 #include "../Profiling/Profiler.h"
+#include "../Core/ThreadPool.h"
 #include "../Physics/Car.h"
 #include "../RHI/RHI_Texture2D.h"
 #include "../Rendering/Mesh.h"
@@ -53,6 +55,93 @@ namespace Spartan
         string m_file_path;
         mutex m_entity_access_mutex;
         bool m_resolve            = false;
+
+        // entities which gained/lost components or were removed, since the last tick
+        mutex m_entities_changed_mutex;
+        vector<shared_ptr<Entity>> m_entities_changed;
+        unordered_set<Entity*> m_entities_changed_set; // to avoid duplicates
+        vector<shared_ptr<Entity>> m_entities_removed;
+
+        // the world ticks in phases, and each phase ticks its component types in the listed order, so that the order is deterministic
+        // the components of a type tick in entity order, except for those which opt in to ticking in parallel (Component::IsTickThreadSafe())
+        // note: component types which override OnTick() have to be listed here
+        const vector<ComponentType> phase_update = // the camera goes first, as the lights and the audio depend on it
+        {
+            ComponentType::Camera,
+            ComponentType::Light,
+            ComponentType::AudioListener,
+            ComponentType::AudioSource,
+            ComponentType::Constraint
+        };
+        const vector<ComponentType> phase_physics_sync = // after Physics::Tick() has moved the entities, push any editor changes back to the bodies
+        {
+            ComponentType::PhysicsBody
+        };
+
+        // the components of each type, gathered once whenever components are added or removed
+        array<vector<shared_ptr<Component>>, static_cast<uint32_t>(ComponentType::Undefined)> m_components;
+        atomic<bool> m_components_dirty = true;
+
+        void components_gather()
+        {
+            for (vector<shared_ptr<Component>>& components : m_components)
+            {
+                components.clear();
+            }
+
+            for (const shared_ptr<Entity>& entity : m_entities)
+            {
+                for (const shared_ptr<Component>& component : entity->GetAllComponents())
+                {
+                    if (component && component->GetType() != ComponentType::Undefined)
+                    {
+                        m_components[static_cast<uint32_t>(component->GetType())].emplace_back(component);
+                    }
+                }
+            }
+        }
+
+        void tick_phase(const vector<ComponentType>& types)
+        {
+            static vector<Component*> components_parallel;
+
+            for (ComponentType type : types)
+            {
+                components_parallel.clear();
+
+                for (const shared_ptr<Component>& component : m_components[static_cast<uint32_t>(type)])
+                {
+                    if (!component->GetEntity()->IsActive())
+                        continue;
+
+                    if (component->IsTickThreadSafe())
+                    {
+                        components_parallel.emplace_back(component.get());
+                    }
+                    else
+                    {
+                        component->OnTick();
+                    }
+                }
+
+                if (components_parallel.empty())
+                    continue;
+
+                // what the components ticked so far have moved is resolved here, lazily resolving it from several threads would race
+                TransformHierarchy::Propagate();
+
+                ThreadPool::ParallelFor([](uint32_t start, uint32_t end)
+                {
+                    for (uint32_t i = start; i < end; i++)
+                    {
+                        components_parallel[i]->OnTick();
+                    }
+                }, static_cast<uint32_t>(components_parallel.size()));
+            }
+
+            // what the phase moved (e.g. the wheels a car places after physics) is resolved within the frame, before the renderer reads it
+            TransformHierarchy::Propagate();
+        }
         bool m_was_in_editor_mode = false;
 
         // default worlds resources
@@ -162,6 +251,18 @@ namespace Spartan
         (
             m_resolve = true;
         ));
+
+        SP_SUBSCRIBE_TO_EVENT(EventType::EntityOnChanged, SP_EVENT_HANDLER_EXPRESSION_STATIC
+        (
+            Entity* entity     = get<Entity*>(var);
+            m_components_dirty = true;
+
+            lock_guard lock(m_entities_changed_mutex);
+            if (m_entities_changed_set.insert(entity).second)
+            {
+                m_entities_changed.emplace_back(entity->shared_from_this());
+            }
+        ));
     }
 
     void World::Shutdown()
@@ -215,18 +316,45 @@ namespace Spartan
                 }
             }
 
+            // propagate whatever moved since the last tick (physics, editor, scripts), so that the components see this frame's transforms
+            TransformHierarchy::Tick();
+
             // tick
-            for (shared_ptr<Entity>& entity : m_entities)
+            if (m_components_dirty)
             {
-                entity->Tick();
+                m_components_dirty = false;
+                components_gather();
             }
+            tick_phase(phase_update);
+            tick_phase(phase_physics_sync);
         }
 
         // notify Renderer
-        if (m_resolve)
         {
-            SP_FIRE_EVENT_DATA(EventType::WorldResolved, m_entities);
-            m_resolve = false;
+            lock_guard lock_changed(m_entities_changed_mutex);
+
+            if (m_resolve)
+            {
+                // a full resolve covers any individual changes
+                SP_FIRE_EVENT_DATA(EventType::WorldResolved, &m_entities);
+                m_resolve = false;
+            }
+            else
+            {
+                if (!m_entities_removed.empty())
+                {
+                    SP_FIRE_EVENT_DATA(EventType::WorldEntitiesRemoved, &m_entities_removed);
+                }
+
+                if (!m_entities_changed.empty())
+                {
+                    SP_FIRE_EVENT_DATA(EventType::WorldEntitiesChanged, &m_entities_changed);
+                }
+            }
+
+            m_entities_removed.clear();
+            m_entities_changed.clear();
+            m_entities_changed_set.clear();
         }
 
         TickDefaultWorlds();
@@ -389,13 +517,28 @@ namespace Spartan
                 ids_to_remove.insert(entity->GetObjectId());
             }
 
+            // keep them alive until the next tick, so that the renderer can let go of them
+            lock_guard lock_changed(m_entities_changed_mutex);
+            for (const shared_ptr<Entity>& entity : m_entities)
+            {
+                if (ids_to_remove.count(entity->GetObjectId()) > 0)
+                {
+                    m_entities_removed.emplace_back(entity);
+                }
+            }
+
             // remove entities using a single loop
-            m_entities.erase(remove_if(m_entities.begin(), m_entities.end(),
-            [&](const shared_ptr<Entity>& entity)
+            auto is_removed = [&](const shared_ptr<Entity>& entity)
             {
                 return ids_to_remove.count(entity->GetObjectId()) > 0;
-            }),
-            m_entities.end());
+            };
+            m_entities.erase(remove_if(m_entities.begin(), m_entities.end(), is_removed), m_entities.end());
+            m_components_dirty = true;
+            for (const shared_ptr<Entity>& entity : m_entities_removed)
+            {
+                m_entities_changed_set.erase(entity.get());
+            }
+            m_entities_changed.erase(remove_if(m_entities_changed.begin(), m_entities_changed.end(), is_removed), m_entities_changed.end());
 
             // if there was a parent, update it
             if (shared_ptr<Entity> parent = entity_to_remove->GetParent())
@@ -403,8 +546,6 @@ namespace Spartan
                 parent->AcquireChildren();
             }
         }
-
-        m_resolve = true;
     }
 
     vector<shared_ptr<Entity>> World::GetRootEntities()
@@ -465,6 +606,17 @@ namespace Spartan
         m_entities.clear();
         m_name.clear();
         m_file_path.clear();
+        for (vector<shared_ptr<Component>>& components : m_components)
+        {
+            components.clear();
+        }
+        m_components_dirty = true;
+        {
+            lock_guard lock(m_entities_changed_mutex);
+            m_entities_changed.clear();
+            m_entities_changed_set.clear();
+            m_entities_removed.clear();
+        }
 
         // Mark for resolve
         m_resolve = true;
@@ -957,8 +1109,14 @@ namespace Spartan
                     }
                 }
 
+                // the vegetation is imported in parallel, and set up in turn as it's done
+                ResourceHandle<Mesh> mesh_tree_1  = ResourceCache::LoadAsync<Mesh>("project\\terrain\\vegetation_tree_1\\tree.fbx", 0, ResourcePriority::High);
+                ResourceHandle<Mesh> mesh_tree_2  = ResourceCache::LoadAsync<Mesh>("project\\terrain\\vegetation_tree_2\\tree.fbx", 0, ResourcePriority::High);
+                ResourceHandle<Mesh> mesh_plant_1 = ResourceCache::LoadAsync<Mesh>("project\\terrain\\vegetation_plant_1\\ormbunke.obj", 0, ResourcePriority::High);
+                ResourceHandle<Mesh> mesh_grass_1 = ResourceCache::LoadAsync<Mesh>("project\\terrain\\vegetation_grass_1\\grass.fbx", 0, ResourcePriority::High);
+
                 // vegetation_tree_1
-                if (shared_ptr<Mesh> mesh = ResourceCache::Load<Mesh>("project\\terrain\\vegetation_tree_1\\tree.fbx"))
+                if (shared_ptr<Mesh> mesh = mesh_tree_1.Wait())
                 {
                     shared_ptr<Entity> entity = mesh->GetRootEntity().lock();
                     entity->SetObjectName("tree_1");
@@ -992,7 +1150,7 @@ namespace Spartan
                 }
 
                 // vegetation_tree_2
-                if (shared_ptr<Mesh> mesh = ResourceCache::Load<Mesh>("project\\terrain\\vegetation_tree_2\\tree.fbx"))
+                if (shared_ptr<Mesh> mesh = mesh_tree_2.Wait())
                 {
                     shared_ptr<Entity> entity = mesh->GetRootEntity().lock();
                     entity->SetObjectName("tree_2");
@@ -1037,7 +1195,7 @@ namespace Spartan
                 }
 
                 // vegetation_plant_1
-                if (shared_ptr<Mesh> mesh = ResourceCache::Load<Mesh>("project\\terrain\\vegetation_plant_1\\ormbunke.obj"))
+                if (shared_ptr<Mesh> mesh = mesh_plant_1.Wait())
                 {
                     shared_ptr<Entity> entity = mesh->GetRootEntity().lock();
                     entity->SetObjectName("plant_1");
@@ -1061,12 +1219,12 @@ namespace Spartan
                         // generate instances
                         vector<Matrix> instances;
                         terrain->GenerateTransforms(&instances, 20000, TerrainProp::Plant);
-                        renderable->SetInstances(instances);
+                        renderable->SetInstances(instances, 64.0f); // small and dense, smaller cells cull tighter
                     }
                 }
 
                 // vegetation_grass_1
-                if (shared_ptr<Mesh> mesh = ResourceCache::Load<Mesh>("project\\terrain\\vegetation_grass_1\\grass.fbx"))
+                if (shared_ptr<Mesh> mesh = mesh_grass_1.Wait())
                 {
                     shared_ptr<Entity> entity = mesh->GetRootEntity().lock();
                     entity->SetObjectName("grass_1");
@@ -1119,6 +1277,9 @@ namespace Spartan
             light->SetFlag(LightFlags::Volumetric, false); // volumetric fog looks bad with point lights
         }
 
+        // the curtains are imported while the main model is
+        ResourceHandle<Mesh> mesh_curtains = ResourceCache::LoadAsync<Mesh>("project\\models\\sponza\\curtains\\NewSponza_Curtains_glTF.gltf", 0, ResourcePriority::High);
+
         // 3d model - Sponza
         if (m_default_model_sponza = ResourceCache::Load<Mesh>("project\\models\\sponza\\main\\NewSponza_Main_Blender_glTF.gltf"))
         {
@@ -1147,7 +1308,7 @@ namespace Spartan
             }
 
             // 3d model - sponza curtains
-            if (m_default_model_sponza_curtains = ResourceCache::Load<Mesh>("project\\models\\sponza\\curtains\\NewSponza_Curtains_glTF.gltf"))
+            if (m_default_model_sponza_curtains = mesh_curtains.Wait())
             {
                 entity = m_default_model_sponza_curtains->GetRootEntity().lock();
                 entity->SetObjectName("sponza_curtains");